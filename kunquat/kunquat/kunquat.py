@@ -125,6 +125,38 @@ class BaseHandle(object):
         _kunquat.kqt_Handle_set_audio_buffer_size(self._handle, value)
         self._audio_buffer_size = value
 
+    @property
+    def thread_count(self):
+        """The number of threads used for rendering voices."""
+        return self._thread_count
+
+    @thread_count.setter
+    def thread_count(self, value):
+        """Set the number of threads used for rendering voices.
+
+        The default value 1 renders all voices in the calling thread.
+
+        """
+        _kunquat.kqt_Handle_set_thread_count(self._handle, value)
+        self._thread_count = value
+
+    @property
+    def seek_cache_enabled(self):
+        """Whether seeking uses cached snapshots of the playback state."""
+        return self._seek_cache_enabled
+
+    @seek_cache_enabled.setter
+    def seek_cache_enabled(self, value):
+        """Enable or disable the seek cache.
+
+        The seek cache speeds up repeated seeking within long
+        compositions at the cost of memory.  It is disabled by default.
+
+        """
+        _kunquat.kqt_Handle_set_seek_cache_enabled(self._handle,
+                                                   1 if value else 0)
+        self._seek_cache_enabled = bool(value)
+
     def get_duration(self, track=None):
         """Count the duration of the composition in nanoseconds.
 
@@ -264,6 +296,10 @@ class Kunquat(BaseHandle):
         self._nanoseconds = 0
         self._audio_buffer_size = _kunquat.kqt_Handle_get_audio_buffer_size(
                 self._handle)
+        self._thread_count = _kunquat.kqt_Handle_get_thread_count(
+                self._handle)
+        self._seek_cache_enabled = bool(
+                _kunquat.kqt_Handle_get_seek_cache_enabled(self._handle))
         if audio_rate <= 0:
             raise KunquatArgumentError('Mixing rate must be positive')
         self.audio_rate = audio_rate
@@ -442,6 +478,19 @@ _kunquat.kqt_Handle_set_audio_buffer_size.errcheck = _error_check
 _kunquat.kqt_Handle_get_audio_buffer_size.argtypes = [kqt_Handle]
 _kunquat.kqt_Handle_get_audio_buffer_size.restype = ctypes.c_long
 _kunquat.kqt_Handle_get_audio_buffer_size.errcheck = _error_check
+_kunquat.kqt_Handle_set_thread_count.argtypes = [kqt_Handle, ctypes.c_int]
+_kunquat.kqt_Handle_set_thread_count.restype = ctypes.c_int
+_kunquat.kqt_Handle_set_thread_count.errcheck = _error_check
+_kunquat.kqt_Handle_get_thread_count.argtypes = [kqt_Handle]
+_kunquat.kqt_Handle_get_thread_count.restype = ctypes.c_int
+_kunquat.kqt_Handle_get_thread_count.errcheck = _error_check
+_kunquat.kqt_Handle_set_seek_cache_enabled.argtypes = [kqt_Handle,
+                                                     ctypes.c_int]
+_kunquat.kqt_Handle_set_seek_cache_enabled.restype = ctypes.c_int
+_kunquat.kqt_Handle_set_seek_cache_enabled.errcheck = _error_check
+_kunquat.kqt_Handle_get_seek_cache_enabled.argtypes = [kqt_Handle]
+_kunquat.kqt_Handle_get_seek_cache_enabled.restype = ctypes.c_int
+_kunquat.kqt_Handle_get_seek_cache_enabled.errcheck = _error_check
 
 _kunquat.kqt_Handle_get_duration.argtypes = [kqt_Handle, ctypes.c_int]
 _kunquat.kqt_Handle_get_duration.restype = ctypes.c_longlong
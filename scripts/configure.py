@@ -65,6 +65,9 @@ def test_add_external_deps(builder, options, cc):
         if not _test_add_lib_with_header(builder, cc, 'm', 'math.h'):
             conf_errors.append('Math library was not found.')
 
+    if not _test_add_lib_with_header(builder, cc, 'pthread', 'pthread.h'):
+        conf_errors.append('libpthread was not found.')
+
     if conf_errors:
         print('\nCould not configure Kunquat due to the following error{}:\n'.format(
             's' if len(conf_errors) != 1 else ''), file=sys.stderr)
@@ -67,6 +67,29 @@ typedef int kqt_Handle;
 kqt_Handle kqt_new_Handle(void);
 
 
+/**
+ * Create a Kunquat Handle that shares the composition of another Handle.
+ *
+ * The composition is loaded only once and is read-only while it is shared,
+ * i.e. kqt_Handle_set_data fails in all Handles that share it. The new
+ * Handle uses the audio rate and buffer size of \a source, and the audio
+ * rate cannot be changed while the composition is shared. Each Handle
+ * has its own playback state, so different sharing Handles may be played
+ * from different threads in parallel. The composition is released when the
+ * last Handle sharing it is destroyed.
+ *
+ * This function must not be called while any Handle sharing the composition
+ * is being accessed in another thread.
+ *
+ * \param source   The Kunquat Handle that contains the composition -- must
+ *                 be valid and validated.
+ *
+ * \return   The new Kunquat Handle if successful, otherwise \c 0
+ *           (check kqt_Handle_get_error(\a source) for error message).
+ */
+kqt_Handle kqt_new_Handle_shared(kqt_Handle source);
+
+
 /**
  * Set data of the Kunquat Handle associated with the given key.
  *
@@ -75,6 +98,11 @@ kqt_Handle kqt_new_Handle(void);
  * functions can be called successfully on the handle:
  *
  * \li kqt_Handle_set_data
+ * \li kqt_Handle_set_data_batch
+ * \li kqt_Handle_load_archive
+ * \li kqt_Handle_load_archive_data
+ * \li kqt_Handle_stage_data
+ * \li kqt_Handle_commit_data
  * \li kqt_Handle_get_error
  * \li kqt_Handle_clear_error
  * \li kqt_Handle_validate
@@ -97,6 +125,171 @@ int kqt_Handle_set_data(
         long length);
 
 
+/**
+ * Set data of the Kunquat Handle associated with several keys.
+ *
+ * The result is the same as calling kqt_Handle_set_data for each key in the
+ * given order, but loading is faster: compressed samples are decoded in
+ * parallel using the number of threads set with kqt_Handle_set_thread_count,
+ * and the Device connections are updated only once at the end.
+ *
+ * \param handle    The Kunquat Handle -- should be valid and should support
+ *                  writing.
+ * \param count     The number of keys -- should be >= \c 0.
+ * \param keys      The keys of the data -- should not be \c NULL if
+ *                  \a count is positive.
+ * \param data      The data of each key -- should not be \c NULL if
+ *                  \a count is positive.
+ * \param lengths   The lengths of each data -- should not be \c NULL if
+ *                  \a count is positive.
+ *
+ * \return   \c 1 if successful. Otherwise, \c 0 is returned and the Kunquat
+ *           Handle error is set accordingly. The keys preceding the failed
+ *           key remain set in case of failure.
+ */
+int kqt_Handle_set_data_batch(
+        kqt_Handle handle,
+        long count,
+        const char* const keys[],
+        const void* const data[],
+        const long lengths[]);
+
+
+/**
+ * Load a composition archive into the Kunquat Handle.
+ *
+ * The archive is an uncompressed tar file in the ustar format that contains
+ * the composition inside a directory named "kqtcXX", where XX is the format
+ * version. The archive file is mapped into memory and its contents are
+ * parsed in place, so this is faster than setting each key separately. The
+ * result is the same as calling kqt_Handle_set_data_batch with all the files
+ * of the archive, and the Handle needs to be validated afterwards.
+ *
+ * \param handle   The Kunquat Handle -- should be valid and should support
+ *                 writing.
+ * \param path     The path of the archive file -- should not be \c NULL.
+ *
+ * \return   \c 1 if successful. Otherwise, \c 0 is returned and the Kunquat
+ *           Handle error is set accordingly.
+ */
+int kqt_Handle_load_archive(kqt_Handle handle, const char* path);
+
+
+/**
+ * Load a composition archive stored in memory into the Kunquat Handle.
+ *
+ * This function works like kqt_Handle_load_archive but reads the archive
+ * from \a data. The data is not copied and does not need to be retained
+ * after the call.
+ *
+ * \param handle   The Kunquat Handle -- should be valid and should support
+ *                 writing.
+ * \param data     The archive data -- should not be \c NULL.
+ * \param length   The length of \a data -- should be positive and must not
+ *                 exceed the real length.
+ *
+ * \return   \c 1 if successful. Otherwise, \c 0 is returned and the Kunquat
+ *           Handle error is set accordingly.
+ */
+int kqt_Handle_load_archive_data(
+        kqt_Handle handle, const void* data, long length);
+
+
+/**
+ * Stage data to be applied to the Kunquat Handle while it is being played.
+ *
+ * Staged data has no effect until it is published with
+ * kqt_Handle_commit_data. Unlike the other functions that modify the
+ * Handle, this function and kqt_Handle_commit_data may be called from one
+ * thread while another thread calls kqt_Handle_play on the same Handle.
+ * The data is copied, so it does not need to be retained after the call.
+ *
+ * Only the headers and columns of existing patterns can be staged, i.e. the
+ * keys pat_XXX/p_pattern.json and pat_XXX/col_XX/p_triggers.json. Other
+ * data must be set with kqt_Handle_set_data while the Handle is not being
+ * played. Staged edits are not supported in a composition shared by several
+ * Handles.
+ *
+ * This function and kqt_Handle_commit_data report their errors through
+ * kqt_Handle_get_edit_error instead of kqt_Handle_get_error. If this
+ * function fails to store the data, all the data staged since the last
+ * commit is discarded.
+ *
+ * \param handle   The Kunquat Handle -- should be valid and should support
+ *                 writing.
+ * \param key      The key of the data -- should not be \c NULL.
+ * \param data     The data to be set -- should not be \c NULL unless
+ *                 \a length is \c 0.
+ * \param length   The length of \a data -- must not exceed the real length.
+ *
+ * \return   \c 1 if successful. Otherwise, \c 0 is returned and the edit
+ *           error of the Kunquat Handle is set accordingly.
+ */
+int kqt_Handle_stage_data(
+        kqt_Handle handle,
+        const char* key,
+        const void* data,
+        long length);
+
+
+/**
+ * Publish the staged data of the Kunquat Handle.
+ *
+ * The staged data is parsed by this function apart from the composition
+ * that is being played. If any of the data is invalid, none of it is
+ * published and the staged data is discarded. Published data is taken into
+ * use as a whole at the start of the next call of kqt_Handle_play, which
+ * only replaces the changed parts of the composition. If the playing thread
+ * does not get the data immediately, the data is taken into use at a later
+ * call of kqt_Handle_play; kqt_Handle_play never waits for this function
+ * to finish.
+ *
+ * \param handle   The Kunquat Handle -- should be valid and should support
+ *                 writing.
+ *
+ * \return   \c 1 if successful. Otherwise, \c 0 is returned and the edit
+ *           error of the Kunquat Handle is set accordingly.
+ */
+int kqt_Handle_commit_data(kqt_Handle handle);
+
+
+/**
+ * Get an error message from the latest call of kqt_Handle_stage_data or
+ * kqt_Handle_commit_data.
+ *
+ * The message has the same format as the messages returned by
+ * kqt_Handle_get_error. It is cleared at the start of each call of the
+ * two functions, so it can be read in the editing thread while another
+ * thread plays the Handle.
+ *
+ * \param handle   The Kunquat Handle.
+ *
+ * \return   The error message, or an empty string if the latest call
+ *           succeeded. If \a handle is invalid, the message returned by
+ *           kqt_Handle_get_error(\a handle) is returned.
+ */
+const char* kqt_Handle_get_edit_error(kqt_Handle handle);
+
+
+/**
+ * Set the maximum amount of decoded sample data kept in memory.
+ *
+ * By default, compressed samples are decoded when they are loaded. If the
+ * limit is positive, compressed samples loaded after this call are stored in
+ * compressed form and decoded on their first use, and the decoded data is
+ * kept in a cache of the given size. When the cache is full, the samples that
+ * have been used least recently are discarded and decoded again when needed.
+ * A limit of \c 0 restores the default behaviour for samples loaded later.
+ *
+ * \param handle   The Handle -- should be valid.
+ * \param size     The maximum size of decoded sample data in bytes -- should
+ *                 be >= \c 0.
+ *
+ * \return   \c 1 if successful, otherwise \c 0.
+ */
+int kqt_Handle_set_sample_cache_limit(kqt_Handle handle, long long size);
+
+
 /**
  * Get an error message from the Kunquat Handle.
  *
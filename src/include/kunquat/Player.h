@@ -183,15 +183,118 @@ int kqt_Handle_set_audio_buffer_size(kqt_Handle handle, long size);
 long kqt_Handle_get_audio_buffer_size(kqt_Handle handle);
 
 
+/**
+ * Set the number of threads used for rendering Voices.
+ *
+ * By default, the Kunquat Handle renders all Voices in the calling thread.
+ * With a thread count greater than \c 1, Voices are rendered in parallel
+ * using \a count - \c 1 additional worker threads. The output may differ
+ * from serial rendering by floating-point rounding in Generators whose
+ * Voices are distributed across several threads.
+ *
+ * \param handle   The Handle -- should be valid.
+ * \param count    The number of threads -- should be > \c 0 and
+ *                 <= \c KQT_THREADS_MAX.
+ *
+ * \return   \c 1 if successful, otherwise \c 0.
+ */
+int kqt_Handle_set_thread_count(kqt_Handle handle, int count);
+
+
+/**
+ * Get the number of threads used for rendering Voices.
+ *
+ * \param handle   The Handle -- should be valid.
+ *
+ * \return   The number of threads, or \c 0 if \a handle is invalid.
+ */
+int kqt_Handle_get_thread_count(kqt_Handle handle);
+
+
+/**
+ * Enable or disable the seek cache of the Kunquat Handle.
+ *
+ * The seek cache makes kqt_Handle_set_position faster by storing snapshots
+ * of the playback state at regular intervals while seeking. Subsequent seeks
+ * continue from the nearest earlier snapshot instead of the beginning of
+ * the composition. The snapshots are discarded whenever the composition
+ * data is changed. The seek cache is disabled by default.
+ *
+ * \param handle    The Handle -- should be valid.
+ * \param enabled   \c 1 to enable the seek cache, or \c 0 to disable it.
+ *
+ * \return   \c 1 if successful, otherwise \c 0.
+ */
+int kqt_Handle_set_seek_cache_enabled(kqt_Handle handle, int enabled);
+
+
+/**
+ * Tell whether the seek cache of the Kunquat Handle is enabled.
+ *
+ * \param handle   The Handle -- should be valid.
+ *
+ * \return   \c 1 if the seek cache is enabled, otherwise \c 0.
+ */
+int kqt_Handle_get_seek_cache_enabled(kqt_Handle handle);
+
+
+/**
+ * Enable or disable profiling of the Kunquat Handle.
+ *
+ * While profiling is enabled, the Handle measures the time spent in each
+ * device during kqt_Handle_play. The collected statistics are cleared
+ * whenever profiling is enabled or disabled. Profiling is disabled by
+ * default.
+ *
+ * \param handle    The Handle -- should be valid.
+ * \param enabled   \c 1 to enable profiling, or \c 0 to disable it.
+ *
+ * \return   \c 1 if successful, otherwise \c 0.
+ */
+int kqt_Handle_set_profiling_enabled(kqt_Handle handle, int enabled);
+
+
+/**
+ * Tell whether profiling of the Kunquat Handle is enabled.
+ *
+ * \param handle   The Handle -- should be valid.
+ *
+ * \return   \c 1 if profiling is enabled, otherwise \c 0.
+ */
+int kqt_Handle_get_profiling_enabled(kqt_Handle handle);
+
+
+/**
+ * Return the profile collected by the Kunquat Handle as a JSON list.
+ *
+ * Each entry of the list has the form [device, nanoseconds, calls, frames],
+ * where device is the key prefix of the device (e.g. "ins_00/gen_00"),
+ * nanoseconds is the total processing time, calls is the number of times
+ * the device was processed and frames is the total number of frames
+ * processed. The time of an effect includes the time of its DSPs, and the
+ * time of a generator is the sum of the times of its Voices. Only devices
+ * that have been processed are included.
+ *
+ * \param handle   The Handle -- should be valid.
+ *
+ * \return   The profile if successful, or \c NULL if an error occurred.
+ *           The returned string is valid until the next call of this
+ *           function.
+ */
+const char* kqt_Handle_get_profile(kqt_Handle handle);
+
+
 /**
  * Estimate the duration of a track in the Kunquat Handle.
  *
  * This function will not calculate the length of a track further
- * than 30 days.
+ * than 30 days. The duration of each track is calculated only once until
+ * the composition data affecting playback order or timing is changed.
  *
  * \param handle   The Handle -- should be valid.
  * \param track    The track number -- should be >= \c -1 and
- *                 < \c KQT_TRACKS_MAX (\c -1 denotes all tracks).
+ *                 < \c KQT_TRACKS_MAX (\c -1 denotes the sum of all
+ *                 tracks).
  *
  * \return   The length in nanoseconds, or KQT_MAX_CALC_DURATION if the
  *           length is 30 days or longer, or \c -1 if failed.
@@ -262,6 +365,65 @@ int kqt_Handle_fire_event(kqt_Handle handle, int channel, const char* event);
 const char* kqt_Handle_receive_events(kqt_Handle handle);
 
 
+/**
+ * Argument types of event records.
+ */
+typedef enum
+{
+    KQT_EVENT_ARG_NONE = 0, ///< No argument.
+    KQT_EVENT_ARG_BOOL,     ///< A boolean value stored in \a bool_value.
+    KQT_EVENT_ARG_INT,      ///< An integer stored in \a int_value.
+    KQT_EVENT_ARG_FLOAT,    ///< A floating-point value stored in \a float_value.
+    KQT_EVENT_ARG_TSTAMP,   ///< A timestamp stored in \a tstamp_value.
+    KQT_EVENT_ARG_STRING,   ///< A string stored in \a string_value.
+    KQT_EVENT_ARG_PAT,      ///< A pattern instance reference in \a pat_value.
+} kqt_Event_arg_type;
+
+
+/**
+ * An event in binary form.
+ */
+typedef struct kqt_Event_record
+{
+    int channel;                    ///< The channel number.
+    int event;                      ///< The index of the event name in the
+                                    ///  list returned by kqt_get_event_names.
+    kqt_Event_arg_type arg_type;    ///< The argument type.
+    union
+    {
+        int bool_value;
+        long long int_value;
+        double float_value;
+        long long tstamp_value[2];  ///< Beats and beat remainder.
+        char string_value[ENV_VAR_NAME_MAX];
+        int pat_value[2];           ///< Pattern and instance numbers.
+    } arg;
+} kqt_Event_record;
+
+
+/**
+ * Return an array of event records.
+ *
+ * This function returns the same events as kqt_Handle_receive_events but
+ * without converting them to JSON. The two functions share the same event
+ * queue, so an event returned by one of them is not returned by the other.
+ *
+ * The returned array is valid until the next call of a function that
+ * modifies the Handle.
+ *
+ * \param handle   The Handle -- should be valid.
+ * \param count    A location where the number of returned records is
+ *                 stored -- should not be \c NULL.
+ *
+ * \return   The event records if successful, or \c NULL if an error
+ *           occurred. A record count of \c 0 indicates that all events
+ *           have been returned.
+ */
+const kqt_Event_record* kqt_Handle_receive_event_records(
+        kqt_Handle handle,
+        long* count);
+
+
 /* \} */
 
 
@@ -68,6 +68,12 @@ extern "C" {
 #define KQT_VOICES_MAX 1024
 
 
+/**
+ * Maximum number of threads used for mixing.
+ */
+#define KQT_THREADS_MAX 32
+
+
 /**
  * Maximum number of songs in a Kunquat Handle.
  */
@@ -19,6 +19,7 @@
 #include <limits.h>
 #include <string.h>
 #include <math.h>
+#include <pthread.h>
 
 #include <containers/AAtree.h>
 #include <Connections.h>
@@ -26,17 +27,87 @@
 #include <Device_node.h>
 #include <devices/DSP_table.h>
 #include <devices/Effect.h>
+#include <mathnum/common.h>
 #include <memory.h>
+#include <player/Thread_pool.h>
 #include <string/common.h>
 
 
+typedef struct Plan_edge
+{
+    int sender;             ///< The plan index of the sending node.
+    int send_port;
+    int receive_port;
+} Plan_edge;
+
+
+typedef struct Plan_step
+{
+    Device_node* node;
+    const Device* device;   ///< The Device of the node, or \c NULL.
+    Connections* sub_graph; ///< The Connections of an Instrument or Effect.
+    bool is_instrument;
+    int edge_start;
+    int edge_stop;
+} Plan_step;
+
+
+typedef struct Plan_step_state
+{
+    // Resolved from the Device states
+    Device_state* ds;
+    bool clear;
+
+    // Mixing state of the current block
+    bool reached;
+} Plan_step_state;
+
+
+typedef struct Plan_edge_state
+{
+    const Audio_buffer* in; ///< The resolved send buffer of the sender.
+    Audio_buffer* out;      ///< The resolved receive buffer.
+} Plan_edge_state;
+
+
+/**
+ * The mixing plan resolved against the Device states of one Player.
+ *
+ * This is stored in the Device state of the master Device of the
+ * Connections, so that several Players can share the same Connections.
+ */
+struct Connections_state
+{
+    uint64_t plan_id;
+    uint64_t generation;
+    int step_capacity;
+    int edge_capacity;
+    Plan_step_state* steps;
+    Plan_edge_state* edges;
+};
+
+
 struct Connections
 {
     AAtree* nodes;
     AAiter* iter;
+
+    // Mixing plan, sorted by dependency level
+    int plan_size;
+    int plan_level_count;
+    Plan_step* plan;
+    int* plan_level_starts;
+    Plan_edge* plan_edges;
+    int plan_edge_count;
+    uint64_t plan_id; ///< A unique identifier of the plan, or \c 0 if none.
 };
 
 
+// Plan identifiers are never reused, so stale Connections states are detected
+static uint64_t next_plan_id = 1;
+static pthread_mutex_t plan_id_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
 /**
  * Resets the graph for searching purposes.
  *
@@ -57,6 +128,83 @@ static void Connections_reset(Connections* graph);
 static bool Connections_is_cyclic(Connections* graph);
 
 
+/**
+ * Builds the mixing plan of the Connections.
+ *
+ * The plan contains all nodes reachable from the master node, grouped by
+ * their dependency levels, and the connections between them. Nodes within
+ * the same level do not depend on each other and may be mixed in parallel.
+ * The Devices of the nodes are resolved here, so the plan must be rebuilt
+ * whenever Devices are added or removed. The plans of Instrument and Effect
+ * Connections are built recursively.
+ *
+ * \param graph   The Connections -- must not be \c NULL.
+ *
+ * \return   \c true if successful, or \c false if memory allocation failed.
+ */
+static bool Connections_build_plan(Connections* graph);
+
+
+/**
+ * Allocates the Connections state needed for mixing the plan.
+ *
+ * \param graph    The Connections -- must not be \c NULL and must have a
+ *                 mixing plan.
+ * \param states   The Device states -- must not be \c NULL.
+ *
+ * \return   The Connections state, or \c NULL if memory allocation failed
+ *           or the master Device has no state in \a states.
+ */
+static Connections_state* Connections_init_state(
+        Connections* graph, Device_states* states);
+
+
+/**
+ * Gets the state of the master Device of the Connections.
+ *
+ * \param graph    The Connections -- must not be \c NULL and must have a
+ *                 mixing plan.
+ * \param states   The Device states -- must not be \c NULL.
+ *
+ * \return   The Device state, or \c NULL if not found.
+ */
+static Device_state* Connections_get_master_state(
+        const Connections* graph, Device_states* states);
+
+
+/**
+ * Resolves the Device states and Audio buffers of the mixing plan.
+ *
+ * \param graph    The Connections -- must not be \c NULL and must have a
+ *                 mixing plan.
+ * \param cstate   The Connections state -- must not be \c NULL and must
+ *                 have room for the plan.
+ * \param states   The Device states -- must not be \c NULL.
+ */
+static void Connections_resolve_plan(
+        const Connections* graph,
+        Connections_state* cstate,
+        Device_states* states);
+
+
+/**
+ * Gets the mixing plan resolved against the given Device states.
+ *
+ * The Device states and Audio buffers of the plan are resolved again if
+ * the plan has been rebuilt or if Device states have been replaced since
+ * the last call. This function does not allocate memory, see
+ * Connections_init_state.
+ *
+ * \param graph    The Connections -- must not be \c NULL.
+ * \param states   The Device states -- must not be \c NULL.
+ *
+ * \return   The Connections state, or \c NULL if the graph must be
+ *           traversed instead.
+ */
+static Connections_state* Connections_get_state(
+        Connections* graph, Device_states* states);
+
+
 /**
  * Validates a connection path.
  *
@@ -225,6 +373,13 @@ Connections* new_Connections_from_string(
 
     graph->nodes = NULL;
     graph->iter = NULL;
+    graph->plan_size = 0;
+    graph->plan_level_count = 0;
+    graph->plan = NULL;
+    graph->plan_level_starts = NULL;
+    graph->plan_edges = NULL;
+    graph->plan_edge_count = 0;
+    graph->plan_id = 0;
     graph->nodes = new_AAtree(
             (int (*)(const void*, const void*))Device_node_cmp,
             (void (*)(void*))del_Device_node);
@@ -285,7 +440,56 @@ bool Connections_prepare(Connections* graph, Device_states* states)
     assert(graph != NULL);
     assert(states != NULL);
 
-    return Connections_init_buffers(graph, states);
+    return Connections_build_plan(graph) &&
+        Connections_init_buffers(graph, states);
+}
+
+
+static bool Connections_add_plan_buffers(
+        const Connections* graph, Connections_state* cstate)
+{
+    assert(graph != NULL);
+    assert(graph->plan != NULL);
+    assert(cstate != NULL);
+
+    // Connect the nodes reachable through senders of a complete type
+    for (int i = 0; i < graph->plan_size - 1; ++i)
+        cstate->steps[i].reached = false;
+    cstate->steps[graph->plan_size - 1].reached =
+        (graph->plan[graph->plan_size - 1].device != NULL);
+
+    for (int i = graph->plan_size - 1; i >= 0; --i)
+    {
+        const Plan_step* step = &graph->plan[i];
+        const Plan_step_state* step_state = &cstate->steps[i];
+        if (!step_state->reached || step->is_instrument)
+            continue;
+
+        for (int k = step->edge_start; k < step->edge_stop; ++k)
+        {
+            const Plan_edge* edge = &graph->plan_edges[k];
+            const Device* send_device = graph->plan[edge->sender].device;
+            if (send_device == NULL || !Device_has_complete_type(send_device))
+                continue;
+
+            if (step_state->ds != NULL &&
+                    !Device_state_add_audio_buffer(
+                        step_state->ds,
+                        DEVICE_PORT_TYPE_RECEIVE,
+                        edge->receive_port))
+                return false;
+
+            Plan_step_state* sender = &cstate->steps[edge->sender];
+            if (sender->ds != NULL &&
+                    !Device_state_add_audio_buffer(
+                        sender->ds, DEVICE_PORT_TYPE_SEND, edge->send_port))
+                return false;
+
+            sender->reached = true;
+        }
+    }
+
+    return true;
 }
 
 
@@ -294,14 +498,27 @@ bool Connections_init_buffers(Connections* graph, Device_states* states)
     assert(graph != NULL);
     assert(states != NULL);
 
-    Device_node* master = AAtree_get_exact(graph->nodes, "");
-    assert(master != NULL);
-    Device_node_reset(master);
-    if (!Device_node_init_buffers_simple(master, states))
+    if (graph->plan == NULL)
+        return true;
+
+    for (int i = 0; i < graph->plan_size; ++i)
+    {
+        Connections* sub_graph = graph->plan[i].sub_graph;
+        if (sub_graph != NULL && !Connections_init_buffers(sub_graph, states))
+            return false;
+    }
+
+    if (Connections_get_master_state(graph, states) == NULL)
+        return true;
+
+    Connections_state* cstate = Connections_init_state(graph, states);
+    if (cstate == NULL || !Connections_add_plan_buffers(graph, cstate))
         return false;
 
-    Device_node_reset(master);
-    return Device_node_init_effect_buffers(master, states);
+    // Resolve the added buffers
+    Connections_resolve_plan(graph, cstate, states);
+
+    return true;
 }
 
 
@@ -314,13 +531,234 @@ void Connections_clear_buffers(
     assert(graph != NULL);
     assert(states != NULL);
 
-    Device_node* master = AAtree_get_exact(graph->nodes, "");
-    assert(master != NULL);
     if (start >= until)
         return;
 
-    Device_node_reset(master);
-    Device_node_clear_buffers(master, states, start, until);
+    // Connections that are not prepared for the Device states have no buffers
+    const Connections_state* cstate = Connections_get_state(graph, states);
+    if (cstate == NULL)
+        return;
+
+    for (int i = 0; i < graph->plan_size; ++i)
+    {
+        const Plan_step* step = &graph->plan[i];
+        const Plan_step_state* step_state = &cstate->steps[i];
+        if (!step_state->clear)
+            continue;
+
+        if (step->is_instrument)
+        {
+            if (step->sub_graph != NULL)
+                Connections_clear_buffers(
+                        step->sub_graph, states, start, until);
+        }
+        else if (step_state->ds != NULL)
+        {
+            Device_state_clear_audio_buffers(step_state->ds, start, until);
+        }
+    }
+
+    return;
+}
+
+
+static bool Plan_step_is_live(
+        const Plan_step* step, const Plan_step_state* step_state)
+{
+    assert(step != NULL);
+    assert(step_state != NULL);
+    return (step->device != NULL) &&
+        Device_is_existent(step->device) &&
+        (step_state->ds != NULL);
+}
+
+
+static void Connections_mix_step(
+        Connections* graph,
+        const Connections_state* cstate,
+        int index,
+        Device_states* states,
+        uint32_t start,
+        uint32_t until,
+        uint32_t freq,
+        double tempo)
+{
+    assert(graph != NULL);
+    assert(cstate != NULL);
+    assert(index >= 0);
+    assert(index < graph->plan_size);
+    assert(states != NULL);
+
+    const Plan_step* step = &graph->plan[index];
+    const Plan_step_state* step_state = &cstate->steps[index];
+    if (!step_state->reached || !Plan_step_is_live(step, step_state))
+        return;
+
+    if (step->is_instrument)
+    {
+        if (step->sub_graph == NULL)
+            return;
+
+        // Mix audio inside the instrument
+        Connections_mix(
+                step->sub_graph, states, NULL, start, until, freq, tempo);
+
+        // Copy audio to instrument front end
+        Device_state* ds = step_state->ds;
+        const int buffer_count = Device_state_get_audio_buffer_count(ds);
+        for (int i = 0; i < buffer_count; ++i)
+        {
+            Device_port_type type = DEVICE_PORT_TYPE_RECEIVE;
+            int port = 0;
+            const Audio_buffer* receive = Device_state_get_audio_buffer_at(
+                    ds, i, &type, &port);
+            if (type != DEVICE_PORT_TYPE_RECEIVE)
+                break;
+
+            Audio_buffer* send = Device_state_get_audio_buffer(
+                    ds, DEVICE_PORT_TYPE_SEND, port);
+
+            if (send != NULL)
+                Audio_buffer_mix(send, receive, start, until);
+        }
+
+        return;
+    }
+
+    for (int i = step->edge_start; i < step->edge_stop; ++i)
+    {
+        const Plan_edge_state* edge_state = &cstate->edges[i];
+        if (edge_state->in != NULL && edge_state->out != NULL)
+            Audio_buffer_mix(
+                    edge_state->out, edge_state->in, start, until);
+    }
+
+    Device_process(step->device, states, start, until, freq, tempo);
+
+    return;
+}
+
+
+typedef struct Plan_level_job
+{
+    Connections* graph;
+    const Connections_state* cstate;
+    Device_states* states;
+    int level_start;
+    int level_stop;
+    int thread_count;
+    uint32_t start;
+    uint32_t until;
+    uint32_t freq;
+    double tempo;
+} Plan_level_job;
+
+
+static void Connections_mix_level_in_thread(void* data, int index)
+{
+    assert(data != NULL);
+    assert(index >= 0);
+
+    const Plan_level_job* job = data;
+
+    for (int i = job->level_start + index;
+            i < job->level_stop; i += job->thread_count)
+        Connections_mix_step(
+                job->graph,
+                job->cstate,
+                i,
+                job->states,
+                job->start,
+                job->until,
+                job->freq,
+                job->tempo);
+
+    return;
+}
+
+
+static void Connections_mix_plan(
+        Connections* graph,
+        Connections_state* cstate,
+        Device_states* states,
+        Thread_pool* pool,
+        uint32_t start,
+        uint32_t until,
+        uint32_t freq,
+        double tempo)
+{
+    assert(graph != NULL);
+    assert(graph->plan_size > 0);
+    assert(cstate != NULL);
+    assert(cstate->plan_id == graph->plan_id);
+    assert(states != NULL);
+
+    // Find the nodes that a recursive mix would visit
+    for (int i = 0; i < graph->plan_size - 1; ++i)
+        cstate->steps[i].reached = false;
+    cstate->steps[graph->plan_size - 1].reached = true;
+
+    for (int i = graph->plan_size - 1; i >= 0; --i)
+    {
+        const Plan_step* step = &graph->plan[i];
+        const Plan_step_state* step_state = &cstate->steps[i];
+        if (!step_state->reached ||
+                step->is_instrument ||
+                !Plan_step_is_live(step, step_state))
+            continue;
+
+        for (int k = step->edge_start; k < step->edge_stop; ++k)
+        {
+            const int sender = graph->plan_edges[k].sender;
+            if (graph->plan[sender].device != NULL &&
+                    cstate->steps[sender].ds != NULL)
+                cstate->steps[sender].reached = true;
+        }
+    }
+
+    const int thread_count =
+        (pool != NULL) ? Thread_pool_get_thread_count(pool) : 1;
+
+    Plan_level_job job =
+    {
+        .graph = graph,
+        .cstate = cstate,
+        .states = states,
+        .level_start = 0,
+        .level_stop = 0,
+        .thread_count = thread_count,
+        .start = start,
+        .until = until,
+        .freq = freq,
+        .tempo = tempo,
+    };
+
+    for (int level = 0; level < graph->plan_level_count; ++level)
+    {
+        job.level_start = graph->plan_level_starts[level];
+        job.level_stop = graph->plan_level_starts[level + 1];
+
+        int reached_count = 0;
+        if (thread_count > 1)
+        {
+            for (int i = job.level_start; i < job.level_stop; ++i)
+            {
+                if (cstate->steps[i].reached)
+                    ++reached_count;
+            }
+        }
+
+        if (reached_count > 1)
+        {
+            Thread_pool_run(pool, Connections_mix_level_in_thread, &job);
+        }
+        else
+        {
+            for (int i = job.level_start; i < job.level_stop; ++i)
+                Connections_mix_step(
+                        graph, cstate, i, states, start, until, freq, tempo);
+        }
+    }
 
     return;
 }
@@ -329,6 +767,7 @@ void Connections_clear_buffers(
 void Connections_mix(
         Connections* graph,
         Device_states* states,
+        Thread_pool* pool,
         uint32_t start,
         uint32_t until,
         uint32_t freq,
@@ -340,8 +779,6 @@ void Connections_mix(
     assert(isfinite(tempo));
     assert(tempo > 0);
 
-    Device_node* master = AAtree_get_exact(graph->nodes, "");
-    assert(master != NULL);
     if (start >= until)
         return;
 
@@ -355,8 +792,13 @@ void Connections_mix(
 //    fprintf(stderr, "Mix process:\n");
 #endif
 
-    Device_node_reset(master);
-    Device_node_mix(master, states, start, until, freq, tempo);
+    // Connections that are not prepared for the Device states produce no audio
+    Connections_state* cstate = Connections_get_state(graph, states);
+    if (cstate == NULL)
+        return;
+
+    Connections_mix_plan(
+            graph, cstate, states, pool, start, until, freq, tempo);
 
     return;
 }
@@ -397,6 +839,361 @@ static bool Connections_is_cyclic(Connections* graph)
 }
 
 
+static int Connections_find_step(const Connections* graph, const Device_node* node)
+{
+    assert(graph != NULL);
+    assert(node != NULL);
+
+    for (int i = 0; i < graph->plan_size; ++i)
+    {
+        if (graph->plan[i].node == node)
+            return i;
+    }
+
+    assert(false);
+    return -1;
+}
+
+
+static bool Connections_build_plan(Connections* graph)
+{
+    assert(graph != NULL);
+
+    Device_node* master = AAtree_get_exact(graph->nodes, "");
+    assert(master != NULL);
+
+    memory_free(graph->plan);
+    memory_free(graph->plan_level_starts);
+    memory_free(graph->plan_edges);
+    graph->plan_size = 0;
+    graph->plan_level_count = 0;
+    graph->plan = NULL;
+    graph->plan_level_starts = NULL;
+    graph->plan_edges = NULL;
+    graph->plan_edge_count = 0;
+    graph->plan_id = 0;
+
+    Connections_reset(graph);
+    const int level_count = Device_node_calc_level(master) + 1;
+
+    // Count reachable nodes and their connections
+    int plan_size = 0;
+    int edge_count = 0;
+    const char* name = "";
+    Device_node* node = AAiter_get_at_least(graph->iter, name);
+    while (node != NULL)
+    {
+        if (Device_node_get_state(node) == DEVICE_NODE_STATE_VISITED)
+        {
+            ++plan_size;
+
+            if (!Device_node_is_instrument(node))
+            {
+                for (int port = 0; port < KQT_DEVICE_PORTS_MAX; ++port)
+                {
+                    Device_node* sender =
+                        Device_node_get_sender(node, port, NULL);
+                    while (sender != NULL)
+                    {
+                        ++edge_count;
+                        sender = Device_node_get_next(node, NULL);
+                    }
+                }
+            }
+        }
+
+        node = AAiter_get_next(graph->iter);
+    }
+
+    Plan_step* plan = memory_alloc_items(Plan_step, plan_size);
+    int* level_starts = memory_alloc_items(int, level_count + 1);
+    Plan_edge* edges = memory_alloc_items(Plan_edge, max(edge_count, 1));
+    if (plan == NULL || level_starts == NULL || edges == NULL)
+    {
+        memory_free(plan);
+        memory_free(level_starts);
+        memory_free(edges);
+        return false;
+    }
+
+    // Sort the nodes by level
+    for (int i = 0; i <= level_count; ++i)
+        level_starts[i] = 0;
+
+    node = AAiter_get_at_least(graph->iter, name);
+    while (node != NULL)
+    {
+        if (Device_node_get_state(node) == DEVICE_NODE_STATE_VISITED)
+            ++level_starts[Device_node_get_level(node) + 1];
+
+        node = AAiter_get_next(graph->iter);
+    }
+
+    for (int i = 0; i < level_count; ++i)
+        level_starts[i + 1] += level_starts[i];
+
+    node = AAiter_get_at_least(graph->iter, name);
+    while (node != NULL)
+    {
+        if (Device_node_get_state(node) == DEVICE_NODE_STATE_VISITED)
+        {
+            // Use the level start as the fill position, restored below
+            const int level = Device_node_get_level(node);
+            Plan_step* step = &plan[level_starts[level]];
+            step->node = node;
+            step->device = Device_node_get_device(node);
+            step->sub_graph = (step->device != NULL)
+                ? Device_node_get_sub_graph(node) : NULL;
+            step->is_instrument = Device_node_is_instrument(node);
+            step->edge_start = 0;
+            step->edge_stop = 0;
+            ++level_starts[level];
+        }
+
+        node = AAiter_get_next(graph->iter);
+    }
+
+    for (int i = level_count; i > 0; --i)
+        level_starts[i] = level_starts[i - 1];
+    level_starts[0] = 0;
+
+    assert(level_starts[level_count] == plan_size);
+    assert(plan[plan_size - 1].node == master);
+
+    graph->plan_size = plan_size;
+    graph->plan_level_count = level_count;
+    graph->plan = plan;
+    graph->plan_level_starts = level_starts;
+    graph->plan_edges = edges;
+
+    // Store the connections in the mixing order of the receiving node
+    int edge_index = 0;
+    for (int i = 0; i < plan_size; ++i)
+    {
+        Plan_step* step = &plan[i];
+        step->edge_start = edge_index;
+
+        if (!step->is_instrument)
+        {
+            for (int port = 0; port < KQT_DEVICE_PORTS_MAX; ++port)
+            {
+                int send_port = -1;
+                Device_node* sender =
+                    Device_node_get_sender(step->node, port, &send_port);
+                while (sender != NULL)
+                {
+                    Plan_edge* edge = &edges[edge_index];
+                    edge->sender = Connections_find_step(graph, sender);
+                    assert(edge->sender < i);
+                    edge->send_port = send_port;
+                    edge->receive_port = port;
+                    ++edge_index;
+
+                    sender = Device_node_get_next(step->node, &send_port);
+                }
+            }
+        }
+
+        step->edge_stop = edge_index;
+    }
+
+    assert(edge_index == edge_count);
+
+    graph->plan_edge_count = edge_count;
+
+    // Instruments and Effects are not prepared separately
+    for (int i = 0; i < plan_size; ++i)
+    {
+        Connections* sub_graph = plan[i].sub_graph;
+        if (sub_graph != NULL && !Connections_build_plan(sub_graph))
+            return false;
+    }
+
+    // Handles that share a Module may build their plans concurrently
+    pthread_mutex_lock(&plan_id_lock);
+    graph->plan_id = next_plan_id;
+    ++next_plan_id;
+    pthread_mutex_unlock(&plan_id_lock);
+
+    return true;
+}
+
+
+static void Connections_resolve_plan(
+        const Connections* graph,
+        Connections_state* cstate,
+        Device_states* states)
+{
+    assert(graph != NULL);
+    assert(graph->plan != NULL);
+    assert(cstate != NULL);
+    assert(cstate->step_capacity >= graph->plan_size);
+    assert(cstate->edge_capacity >= graph->plan_edge_count);
+    assert(states != NULL);
+
+    for (int i = 0; i < graph->plan_size; ++i)
+    {
+        const Plan_step* step = &graph->plan[i];
+        Plan_step_state* step_state = &cstate->steps[i];
+        step_state->ds = NULL;
+        if (step->device != NULL)
+        {
+            // The states of new Devices may not have been added yet
+            const uint32_t id = Device_get_id(step->device);
+            if (Device_states_has_state(states, id))
+                step_state->ds = Device_states_get_state(states, id);
+        }
+        step_state->clear = false;
+        step_state->reached = false;
+    }
+
+    for (int i = 0; i < graph->plan_size; ++i)
+    {
+        const Plan_step* step = &graph->plan[i];
+        const Plan_step_state* step_state = &cstate->steps[i];
+        for (int k = step->edge_start; k < step->edge_stop; ++k)
+        {
+            const Plan_edge* edge = &graph->plan_edges[k];
+            Plan_edge_state* edge_state = &cstate->edges[k];
+            const Plan_step_state* sender = &cstate->steps[edge->sender];
+            edge_state->in = (sender->ds != NULL)
+                ? Device_state_get_audio_buffer(
+                        sender->ds, DEVICE_PORT_TYPE_SEND, edge->send_port)
+                : NULL;
+            edge_state->out = (step_state->ds != NULL)
+                ? Device_state_get_audio_buffer(
+                        step_state->ds,
+                        DEVICE_PORT_TYPE_RECEIVE,
+                        edge->receive_port)
+                : NULL;
+        }
+    }
+
+    // Find the nodes that a recursive buffer clear would visit
+    cstate->steps[graph->plan_size - 1].clear =
+        (graph->plan[graph->plan_size - 1].device != NULL);
+    for (int i = graph->plan_size - 1; i >= 0; --i)
+    {
+        const Plan_step* step = &graph->plan[i];
+        if (!cstate->steps[i].clear || step->is_instrument)
+            continue;
+
+        for (int k = step->edge_start; k < step->edge_stop; ++k)
+        {
+            const int sender = graph->plan_edges[k].sender;
+            if (graph->plan[sender].device != NULL)
+                cstate->steps[sender].clear = true;
+        }
+    }
+
+    cstate->plan_id = graph->plan_id;
+    cstate->generation = Device_states_get_generation(states);
+
+    return;
+}
+
+
+static Device_state* Connections_get_master_state(
+        const Connections* graph, Device_states* states)
+{
+    assert(graph != NULL);
+    assert(graph->plan != NULL);
+    assert(states != NULL);
+
+    const Device* master_device = graph->plan[graph->plan_size - 1].device;
+    if (master_device == NULL ||
+            !Device_states_has_state(states, Device_get_id(master_device)))
+        return NULL;
+
+    return Device_states_get_state(states, Device_get_id(master_device));
+}
+
+
+static Connections_state* Connections_init_state(
+        Connections* graph, Device_states* states)
+{
+    assert(graph != NULL);
+    assert(graph->plan != NULL);
+    assert(states != NULL);
+
+    Device_state* master_ds = Connections_get_master_state(graph, states);
+    if (master_ds == NULL)
+        return NULL;
+
+    if (master_ds->graph_state == NULL)
+    {
+        master_ds->graph_state = memory_alloc_item(Connections_state);
+        if (master_ds->graph_state == NULL)
+            return NULL;
+
+        Connections_state* cstate = master_ds->graph_state;
+        cstate->plan_id = 0;
+        cstate->generation = 0;
+        cstate->step_capacity = 0;
+        cstate->edge_capacity = 0;
+        cstate->steps = NULL;
+        cstate->edges = NULL;
+    }
+
+    Connections_state* cstate = master_ds->graph_state;
+
+    // Make room for the plan
+    if (cstate->step_capacity < graph->plan_size)
+    {
+        Plan_step_state* steps = memory_realloc_items(
+                Plan_step_state, graph->plan_size, cstate->steps);
+        if (steps == NULL)
+            return NULL;
+
+        cstate->steps = steps;
+        cstate->step_capacity = graph->plan_size;
+    }
+
+    if (cstate->edge_capacity < graph->plan_edge_count)
+    {
+        Plan_edge_state* edges = memory_realloc_items(
+                Plan_edge_state, graph->plan_edge_count, cstate->edges);
+        if (edges == NULL)
+            return NULL;
+
+        cstate->edges = edges;
+        cstate->edge_capacity = graph->plan_edge_count;
+    }
+
+    Connections_resolve_plan(graph, cstate, states);
+
+    return cstate;
+}
+
+
+static Connections_state* Connections_get_state(
+        Connections* graph, Device_states* states)
+{
+    assert(graph != NULL);
+    assert(states != NULL);
+
+    if (graph->plan == NULL)
+        return NULL;
+
+    Device_state* master_ds = Connections_get_master_state(graph, states);
+    if (master_ds == NULL || master_ds->graph_state == NULL)
+        return NULL;
+
+    Connections_state* cstate = master_ds->graph_state;
+
+    // The state is too small if the plan has been rebuilt for other states
+    if (cstate->step_capacity < graph->plan_size ||
+            cstate->edge_capacity < graph->plan_edge_count)
+        return NULL;
+
+    if (cstate->plan_id != graph->plan_id ||
+            cstate->generation != Device_states_get_generation(states))
+        Connections_resolve_plan(graph, cstate, states);
+
+    return cstate;
+}
+
+
 void Connections_print(Connections* graph, FILE* out)
 {
     assert(graph != NULL);
@@ -412,11 +1209,27 @@ void Connections_print(Connections* graph, FILE* out)
 }
 
 
+void del_Connections_state(Connections_state* cstate)
+{
+    if (cstate == NULL)
+        return;
+
+    memory_free(cstate->steps);
+    memory_free(cstate->edges);
+    memory_free(cstate);
+
+    return;
+}
+
+
 void del_Connections(Connections* graph)
 {
     if (graph == NULL)
         return;
 
+    memory_free(graph->plan);
+    memory_free(graph->plan_level_starts);
+    memory_free(graph->plan_edges);
     del_AAiter(graph->iter);
     del_AAtree(graph->nodes);
     memory_free(graph);
@@ -27,6 +27,7 @@
 #include <module/Effect_table.h>
 #include <module/Ins_table.h>
 #include <player/Device_states.h>
+#include <player/Thread_pool.h>
 #include <string/Streader.h>
 
 
@@ -85,6 +86,9 @@ Device_node* Connections_get_master(Connections* graph);
 /**
  * Prepare the Connections for mixing.
  *
+ * This initialises the Audio buffers, creates the mixing plan and allocates
+ * the mixing state of the plan in \a states.
+ *
  * \param graph    The Connections -- must not be \c NULL.
  * \param states   The Device states -- must not be \c NULL.
  *
@@ -96,6 +100,9 @@ bool Connections_prepare(Connections* graph, Device_states* states);
 /**
  * Initialise all Audio buffers in the Connections.
  *
+ * This also allocates the mixing state of an existing mixing plan in
+ * \a states.
+ *
  * \param graph    The Connections -- must not be \c NULL.
  * \param states   The Device states -- must not be \c NULL.
  *
@@ -125,8 +132,14 @@ void Connections_clear_buffers(
 /**
  * Mix the audio in the Connections.
  *
+ * If a Thread pool with more than one thread is given, independent Devices
+ * are mixed in parallel according to the mixing plan created by
+ * Connections_prepare. The result is identical to serial mixing.
+ *
  * \param graph    The Connections -- must not be \c NULL.
  * \param states   The Device states -- must not be \c NULL.
+ * \param pool     The Thread pool, or \c NULL for serial mixing. This must be
+ *                 \c NULL when called from a thread of the pool.
  * \param start    The first frame to be mixed -- must be less than the
  *                 buffer size.
  * \param until    The first frame not to be mixed -- must be less than or
@@ -138,6 +151,7 @@ void Connections_clear_buffers(
 void Connections_mix(
         Connections* graph,
         Device_states* device_states,
+        Thread_pool* pool,
         uint32_t start,
         uint32_t until,
         uint32_t freq,
@@ -153,6 +167,14 @@ void Connections_mix(
 void Connections_print(Connections* graph, FILE* out);
 
 
+/**
+ * Destroy an existing Connections state.
+ *
+ * \param cstate   The Connections state, or \c NULL.
+ */
+void del_Connections_state(Connections_state* cstate);
+
+
 /**
  * Destroy existing Connections.
  *
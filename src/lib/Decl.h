@@ -17,9 +17,11 @@
 
 
 typedef struct Connections Connections;
+typedef struct Connections_state Connections_state;
 typedef struct Device Device;
 typedef struct Device_impl Device_impl;
 typedef struct Module Module;
+typedef struct Sample_source Sample_source;
 
 
 #endif // K_DECL_H
@@ -22,6 +22,7 @@
 #include <Device_node.h>
 #include <devices/Generator.h>
 #include <kunquat/limits.h>
+#include <mathnum/common.h>
 #include <memory.h>
 #include <string/common.h>
 
@@ -59,6 +60,7 @@ struct Device_node
     int index;
     //Device* device;
     Device_node_state state;
+    int level;
     Connection* iter;
     Connection* receive[KQT_DEVICE_PORTS_MAX];
     Connection* send[KQT_DEVICE_PORTS_MAX];
@@ -139,6 +141,7 @@ Device_node* new_Device_node(
     //node->device = NULL;
     node->name[KQT_DEVICE_NODE_NAME_MAX - 1] = '\0';
     node->state = DEVICE_NODE_STATE_NEW;
+    node->level = 0;
     node->iter = NULL;
     for (int port = 0; port < KQT_DEVICE_PORTS_MAX; ++port)
     {
@@ -159,414 +162,48 @@ int Device_node_cmp(const Device_node* n1, const Device_node* n2)
 }
 
 
-void Device_node_reset(Device_node* node)
-{
-    assert(node != NULL);
-
-    if (Device_node_get_state(node) == DEVICE_NODE_STATE_NEW)
-        return;
-
-    Device_node_set_state(node, DEVICE_NODE_STATE_NEW);
-
-    if (node->type == DEVICE_TYPE_INSTRUMENT)
-    {
-        Instrument* ins = Ins_table_get(node->insts, node->index);
-        if (ins == NULL)
-        {
-            Device_node_set_state(node, DEVICE_NODE_STATE_VISITED);
-            return;
-        }
-
-        Connections* ins_graph = Instrument_get_connections(ins);
-        Device_node* ins_node = NULL;
-        if (ins_graph == NULL ||
-                (ins_node = Connections_get_master(ins_graph)) == NULL)
-        {
-            Device_node_set_state(node, DEVICE_NODE_STATE_VISITED);
-            return;
-        }
-
-        Device_node_set_state(ins_node, DEVICE_NODE_STATE_NEW);
-        node = ins_node;
-    }
-
-    for (int port = 0; port < KQT_DEVICE_PORTS_MAX; ++port)
-    {
-        Connection* edge = node->receive[port];
-        while (edge != NULL)
-        {
-            Device_node_reset(edge->node);
-            edge = edge->next;
-        }
-    }
-
-    return;
-}
-
-
-bool Device_node_init_buffers_simple(Device_node* node, Device_states* states)
+int Device_node_calc_level(Device_node* node)
 {
     assert(node != NULL);
     assert(Device_node_get_state(node) != DEVICE_NODE_STATE_REACHED);
-    assert(states != NULL);
 
     if (Device_node_get_state(node) == DEVICE_NODE_STATE_VISITED)
-        return true;
-
-    Device_node_set_state(node, DEVICE_NODE_STATE_REACHED);
-
-    const Device* node_device = Device_node_get_device(node);
-    if (node_device == NULL)
-    {
-        Device_node_set_state(node, DEVICE_NODE_STATE_VISITED);
-        return true;
-    }
-
-    if (node->type == DEVICE_TYPE_INSTRUMENT)
-    {
-        Instrument* ins = Ins_table_get(node->insts, node->index);
-        if (ins == NULL)
-        {
-            Device_node_set_state(node, DEVICE_NODE_STATE_VISITED);
-            return true;
-        }
-
-        Connections* ins_graph = Instrument_get_connections(ins);
-        Device_node* ins_node = NULL;
-        if (ins_graph == NULL ||
-                (ins_node = Connections_get_master(ins_graph)) == NULL)
-        {
-            Device_node_set_state(node, DEVICE_NODE_STATE_VISITED);
-            return true;
-        }
-
-        Device_node_set_state(node, DEVICE_NODE_STATE_VISITED);
-        Device_node_set_state(ins_node, DEVICE_NODE_STATE_REACHED);
-        node = ins_node;
-    }
-
-    for (int port = 0; port < KQT_DEVICE_PORTS_MAX; ++port)
-    {
-        Connection* edge = node->receive[port];
-        while (edge != NULL)
-        {
-            assert(edge->node != NULL);
-            const Device* send_device = Device_node_get_device(edge->node);
-            if (send_device == NULL || !Device_has_complete_type(send_device))
-            {
-                edge = edge->next;
-                continue;
-            }
-
-            // Add receive buffer
-            Device_state* receive_state = Device_states_get_state(
-                    states,
-                    Device_get_id(node_device));
-            if (!Device_state_add_audio_buffer(
-                        receive_state,
-                        DEVICE_PORT_TYPE_RECEIVE,
-                        port))
-                return false;
-
-            // Add send buffer
-            Device_state* send_state = Device_states_get_state(
-                    states,
-                    Device_get_id(send_device));
-            if (send_state != NULL &&
-                    !Device_state_add_audio_buffer(
-                        send_state,
-                        DEVICE_PORT_TYPE_SEND,
-                        edge->port))
-                return false;
-
-            // Recurse to the sender
-            if (!Device_node_init_buffers_simple(edge->node, states))
-                return false;
-
-            edge = edge->next;
-        }
-    }
-
-    Device_node_set_state(node, DEVICE_NODE_STATE_VISITED);
-    return true;
-}
-
-
-bool Device_node_init_effect_buffers(Device_node* node, Device_states* states)
-{
-    assert(node != NULL);
-    assert(states != NULL);
-
-    if (Device_node_get_state(node) > DEVICE_NODE_STATE_NEW)
-    {
-        assert(Device_node_get_state(node) != DEVICE_NODE_STATE_REACHED);
-        return true;
-    }
+        return node->level;
 
     Device_node_set_state(node, DEVICE_NODE_STATE_REACHED);
-    if (Device_node_get_device(node) == NULL)
-    {
-        Device_node_set_state(node, DEVICE_NODE_STATE_VISITED);
-        return true;
-    }
-
-    if (node->type == DEVICE_TYPE_INSTRUMENT)
-    {
-        Instrument* ins = Ins_table_get(node->insts, node->index);
-        if (ins == NULL)
-        {
-            Device_node_set_state(node, DEVICE_NODE_STATE_VISITED);
-            return true;
-        }
-
-        Connections* ins_graph = Instrument_get_connections(ins);
-        Device_node* ins_node = NULL;
-        if (ins_graph == NULL ||
-                (ins_node = Connections_get_master(ins_graph)) == NULL)
-        {
-            Device_node_set_state(node, DEVICE_NODE_STATE_VISITED);
-            return true;
-        }
+    node->level = 0;
 
-        Device_node_set_state(node, DEVICE_NODE_STATE_VISITED);
-        Device_node_set_state(ins_node, DEVICE_NODE_STATE_REACHED);
-        node = ins_node;
-    }
-    else if (node->type == DEVICE_TYPE_EFFECT)
+    // Instruments mix their own subgraphs
+    if (node->type != DEVICE_TYPE_INSTRUMENT)
     {
-        const Effect* eff = Effect_table_get(node->effects, node->index);
-        if (eff == NULL)
-        {
-            Device_node_set_state(node, DEVICE_NODE_STATE_VISITED);
-            return true;
-        }
-
-        if (!Effect_prepare_connections(eff, states))
-            return false;
-    }
-
-    for (int port = 0; port < KQT_DEVICE_PORTS_MAX; ++port)
-    {
-        Connection* edge = node->receive[port];
-        while (edge != NULL)
+        for (int port = 0; port < KQT_DEVICE_PORTS_MAX; ++port)
         {
-            if (Device_node_get_device(edge->node) == NULL)
+            Connection* edge = node->receive[port];
+            while (edge != NULL)
             {
+                const int sender_level = Device_node_calc_level(edge->node);
+                node->level = max(node->level, sender_level + 1);
                 edge = edge->next;
-                continue;
             }
-
-            if (!Device_node_init_effect_buffers(edge->node, states))
-                return false;
-
-            edge = edge->next;
         }
     }
 
     Device_node_set_state(node, DEVICE_NODE_STATE_VISITED);
-    return true;
+    return node->level;
 }
 
 
-void Device_node_clear_buffers(
-        Device_node* node,
-        Device_states* states,
-        uint32_t start,
-        uint32_t until)
+int Device_node_get_level(const Device_node* node)
 {
     assert(node != NULL);
-    assert(states != NULL);
-
-    if (Device_node_get_state(node) > DEVICE_NODE_STATE_NEW)
-    {
-        assert(Device_node_get_state(node) == DEVICE_NODE_STATE_VISITED);
-        return;
-    }
-
-    Device_node_set_state(node, DEVICE_NODE_STATE_REACHED);
-
-    if (Device_node_get_device(node) == NULL)
-    {
-        Device_node_set_state(node, DEVICE_NODE_STATE_VISITED);
-        return;
-    }
-
-    if (node->type == DEVICE_TYPE_INSTRUMENT)
-    {
-        Device_node* ins_node = Device_node_get_ins_dual(node);
-        if (ins_node == NULL)
-        {
-            Device_node_set_state(node, DEVICE_NODE_STATE_VISITED);
-            return;
-        }
-
-        Device_node_set_state(node, DEVICE_NODE_STATE_VISITED);
-        Device_node_set_state(ins_node, DEVICE_NODE_STATE_REACHED);
-        node = ins_node;
-    }
-
-    //fprintf(stderr, "Clearing buffers of %p\n", (void*)Device_node_get_device(node));
-    const Device* device = Device_node_get_device(node);
-    Device_state* ds = Device_states_get_state(states, Device_get_id(device));
-
-    if (ds != NULL)
-        Device_state_clear_audio_buffers(ds, start, until);
-
-    for (int port = 0; port < KQT_DEVICE_PORTS_MAX; ++port)
-    {
-        Connection* edge = node->receive[port];
-        while (edge != NULL)
-        {
-            Device_node_clear_buffers(edge->node, states, start, until);
-            edge = edge->next;
-        }
-    }
-
-    Device_node_set_state(node, DEVICE_NODE_STATE_VISITED);
-    return;
+    return node->level;
 }
 
 
-void Device_node_mix(
-        Device_node* node,
-        Device_states* states,
-        uint32_t start,
-        uint32_t until,
-        uint32_t freq,
-        double tempo)
+bool Device_node_is_instrument(const Device_node* node)
 {
     assert(node != NULL);
-    assert(states != NULL);
-    assert(freq > 0);
-    assert(isfinite(tempo));
-    assert(tempo > 0);
-
-    //fprintf(stderr, "Entering node %p %s\n", (void*)node, node->name);
-    if (Device_node_get_state(node) > DEVICE_NODE_STATE_NEW)
-    {
-        assert(Device_node_get_state(node) == DEVICE_NODE_STATE_VISITED);
-        return;
-    }
-
-    Device_node_set_state(node, DEVICE_NODE_STATE_REACHED);
-    const Device* node_device = Device_node_get_device(node);
-    Device_state* ds = Device_states_get_state(
-            states,
-            Device_get_id(node_device));
-    if (node_device == NULL ||
-            !Device_is_existent(node_device) ||
-            ds == NULL)
-    {
-        Device_node_set_state(node, DEVICE_NODE_STATE_VISITED);
-        return;
-    }
-
-    if (node->type == DEVICE_TYPE_INSTRUMENT)
-    {
-        Instrument* ins = Ins_table_get(node->insts, node->index);
-        if (ins == NULL)
-        {
-            Device_node_set_state(node, DEVICE_NODE_STATE_VISITED);
-            return;
-        }
-
-        Connections* ins_graph = Instrument_get_connections(ins);
-        Device_node* ins_node = NULL;
-        Device_state* ins_state = Device_states_get_state(
-                states,
-                Device_get_id((Device*)ins));
-        if (ins_graph == NULL ||
-                (ins_node = Connections_get_master(ins_graph)) == NULL ||
-                ins_state == NULL)
-        {
-            Device_node_set_state(node, DEVICE_NODE_STATE_VISITED);
-            return;
-        }
-
-        // Mix audio inside the instrument
-        Device_node_mix(ins_node, states, start, until, freq, tempo);
-
-        // Copy audio to instrument front end
-        for (int port = 0; port < KQT_DEVICE_PORTS_MAX; ++port)
-        {
-            Audio_buffer* receive = Device_state_get_audio_buffer(
-                    ins_state,
-                    DEVICE_PORT_TYPE_RECEIVE,
-                    port);
-            Audio_buffer* send = Device_state_get_audio_buffer(
-                    ins_state,
-                    DEVICE_PORT_TYPE_SEND,
-                    port);
-
-            if (receive != NULL && send != NULL)
-                Audio_buffer_mix(send, receive, start, until);
-        }
-
-        Device_node_set_state(node, DEVICE_NODE_STATE_VISITED);
-        return;
-    }
-
-    for (int port = 0; port < KQT_DEVICE_PORTS_MAX; ++port)
-    {
-        Connection* edge = node->receive[port];
-        while (edge != NULL)
-        {
-            const Device* send_device = Device_node_get_device(edge->node);
-            if (send_device == NULL)
-            {
-                edge = edge->next;
-                continue;
-            }
-
-            Device_state* send_state = Device_states_get_state(
-                    states,
-                    Device_get_id(send_device));
-            if (send_state == NULL)
-            {
-                edge = edge->next;
-                continue;
-            }
-
-            Device_node_mix(edge->node, states, start, until, freq, tempo);
-
-            Audio_buffer* send = Device_state_get_audio_buffer(
-                    send_state,
-                    DEVICE_PORT_TYPE_SEND,
-                    edge->port);
-            Audio_buffer* receive = Device_state_get_audio_buffer(
-                    ds,
-                    DEVICE_PORT_TYPE_RECEIVE,
-                    port);
-            if (receive == NULL || send == NULL)
-            {
-#if 0
-                if (receive != NULL)
-                {
-                    fprintf(stderr, "receive %p of %p %s, but no send from %p!\n",
-                            (void*)receive, (void*)node, node->name, (void*)edge->node);
-                }
-                else if (send != NULL)
-                {
-                    fprintf(stderr, "send %p, but no receive!\n", (void*)send);
-                }
-#endif
-                edge = edge->next;
-                continue;
-            }
-
-            //fprintf(stderr, "%s %.1f\n",
-            //        send_device->name,
-            //        Audio_buffer_get_buffer(send, 0)[0]);
-            Audio_buffer_mix(receive, send, start, until);
-
-            edge = edge->next;
-        }
-    }
-
-    //fprintf(stderr, "Calling Device_process on %p %s\n", (void*)node, node->name);
-    Device_process(node_device, states, start, until, freq, tempo);
-    Device_node_set_state(node, DEVICE_NODE_STATE_VISITED);
-    return;
+    return node->type == DEVICE_TYPE_INSTRUMENT;
 }
 
 
@@ -704,7 +341,10 @@ Device_node* Device_node_get_next(Device_node* node, int* port)
         return NULL;
 
     node->iter = node->iter->next;
-    if (node->iter != NULL && port != NULL)
+    if (node->iter == NULL)
+        return NULL;
+
+    if (port != NULL)
         *port = node->iter->port;
 
     return node->iter->node;
@@ -847,16 +487,31 @@ void del_Device_node(Device_node* node)
 }
 
 
+Connections* Device_node_get_sub_graph(const Device_node* node)
+{
+    assert(node != NULL);
+
+    if (node->type == DEVICE_TYPE_INSTRUMENT)
+    {
+        Instrument* ins = Ins_table_get(node->insts, node->index);
+        return (ins != NULL) ? Instrument_get_connections(ins) : NULL;
+    }
+    else if (node->type == DEVICE_TYPE_EFFECT)
+    {
+        const Effect* eff = Effect_table_get(node->effects, node->index);
+        return (eff != NULL) ? Effect_get_connections(eff) : NULL;
+    }
+
+    return NULL;
+}
+
+
 static Device_node* Device_node_get_ins_dual(const Device_node* node)
 {
     assert(node != NULL);
     assert(node->type == DEVICE_TYPE_INSTRUMENT);
 
-    Instrument* ins = Ins_table_get(node->insts, node->index);
-    if (ins == NULL)
-        return NULL;
-
-    Connections* ins_graph = Instrument_get_connections(ins);
+    Connections* ins_graph = Device_node_get_sub_graph(node);
     if (ins_graph == NULL)
         return NULL;
 
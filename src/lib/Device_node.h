@@ -20,6 +20,7 @@
 #include <stdint.h>
 #include <stdio.h>
 
+#include <Decl.h>
 #include <devices/Device.h>
 #include <module/Effect_table.h>
 #include <module/Ins_table.h>
@@ -85,76 +86,52 @@ int Device_node_cmp(const Device_node* n1, const Device_node* n2);
 
 
 /**
- * Reset the Device node and its subgraph.
+ * Calculate the dependency levels of the Device node and its subgraph.
  *
- * This function assumes that if the underlying Connections graph is not
- * reset, all its nodes have been marked at least reached.
+ * A node without senders has level \c 0 and every other node has a level
+ * greater than the levels of all its senders. The states of the nodes in
+ * the subgraph must be reset to \c DEVICE_NODE_STATE_NEW before calling
+ * this function.
  *
  * \param node   The Device node -- must not be \c NULL.
+ *
+ * \return   The level of \a node.
  */
-void Device_node_reset(Device_node* node);
+int Device_node_calc_level(Device_node* node);
 
 
 /**
- * Initialise all Audio buffers in the Device node and its subgraph.
+ * Get the dependency level of the Device node.
  *
- * \param node     The Device node -- must not be \c NULL.
- * \param states   The Device states -- must not be \c NULL.
+ * \param node   The Device node -- must not be \c NULL.
  *
- * \return   \c true if successful, or \c false if memory allocation failed.
+ * \return   The level calculated by Device_node_calc_level.
  */
-bool Device_node_init_buffers_simple(Device_node* node, Device_states* states);
+int Device_node_get_level(const Device_node* node);
 
 
 /**
- * Initialise the graphs of the Effects in the subgraph.
+ * Tell whether the Device node is an Instrument node.
  *
- * \param node     The Device node -- must not be \c NULL.
- * \param states   The Device states -- must not be \c NULL.
+ * Instrument nodes mix their own Connections instead of their senders.
  *
- * \return   \c true if successful, or \c false if memory allocation failed.
- */
-bool Device_node_init_effect_buffers(Device_node* node, Device_states* states);
-
-
-/**
- * Clear the audio buffers in the Device node and its subgraph.
+ * \param node   The Device node -- must not be \c NULL.
  *
- * \param node     The Device node -- must not be \c NULL.
- * \param states   The Device states -- must not be \c NULL.
- * \param start    The first frame to be cleared -- must be less than the
- *                 buffer size.
- * \param until    The first frame not to be cleared -- must be less than or
- *                 equal to the buffer size. If \a until <= \a start, nothing
- *                 will be cleared.
+ * \return   \c true if \a node is an Instrument node, otherwise \c false.
  */
-void Device_node_clear_buffers(
-        Device_node* node,
-        Device_states* states,
-        uint32_t start,
-        uint32_t until);
+bool Device_node_is_instrument(const Device_node* node);
 
 
 /**
- * Mix audio in the Device node and its subgraph.
+ * Get the Connections mixed by the Device of the Device node.
  *
- * \param node     The Device node -- must not be \c NULL.
- * \param states   The Device states -- must not be \c NULL.
- * \param start    The first frame to be mixed -- must be less than the
- *                  buffer size.
- * \param until    The first frame not to be mixed -- must be less than or
- *                 equal to the buffer size. If \a until <= \a start, nothing
- *                 will be mixed.
- * \param freq     The mixing frequency -- must be > \c 0.
- * \param tempo    The tempo -- must be > \c 0 and finite.
+ * \param node   The Device node -- must not be \c NULL.
+ *
+ * \return   The Connections of the Instrument or Effect of \a node, or
+ *           \c NULL if the Device or its Connections do not exist or if
+ *           \a node is not an Instrument or Effect node.
  */
-void Device_node_mix(
-        Device_node* node,
-        Device_states* states,
-        uint32_t start,
-        uint32_t until,
-        uint32_t freq,
-        double tempo);
+Connections* Device_node_get_sub_graph(const Device_node* node);
 
 
 /**
@@ -120,6 +120,80 @@ kqt_Handle kqt_new_Handle(void)
 }
 
 
+kqt_Handle kqt_new_Handle_shared(kqt_Handle source)
+{
+    check_handle(source, 0);
+
+    Handle* src = get_handle(source);
+    check_data_is_valid(src, 0);
+    check_data_is_validated(src, 0);
+
+    Handle* handle = memory_alloc_item(Handle);
+    if (handle == NULL)
+    {
+        Handle_set_error(src, ERROR_MEMORY, "Couldn't allocate memory");
+        return 0;
+    }
+
+    handle->data_is_valid = true;
+    handle->data_is_validated = true;
+    handle->module = src->module;
+    Module_add_handle(handle->module);
+    handle->error = *ERROR_AUTO;
+    handle->validation_error = *ERROR_AUTO;
+    memset(handle->position, '\0', POSITION_LENGTH);
+    handle->player = NULL;
+    handle->length_counter = NULL;
+    handle->edits = NULL;
+    handle->defer_connections = false;
+    handle->connections_changed = false;
+    handle->validate_all = false;
+    for (int i = 0; i < KQT_SONGS_MAX; ++i)
+        handle->changed_songs[i] = false;
+    for (int i = 0; i < KQT_PATTERNS_MAX; ++i)
+        handle->changed_pats[i] = false;
+    for (int i = 0; i < KQT_TRACKS_MAX; ++i)
+        handle->track_durations[i] = src->track_durations[i];
+    handle->profile = NULL;
+    handle->profile_capacity = 0;
+
+    handle->edits = new_Edit_queue();
+
+    // Create players with the playback state of the shared Module
+    handle->player = new_Player(
+            handle->module,
+            Player_get_audio_rate(src->player),
+            Player_get_audio_buffer_size(src->player),
+            16384,
+            256);
+    handle->length_counter = new_Player(handle->module, 1000000000L, 0, 0, 0);
+    if (handle->edits == NULL ||
+            handle->player == NULL ||
+            handle->length_counter == NULL ||
+            !Player_prepare_shared_module(handle->player, src->player) ||
+            !Player_prepare_shared_module(
+                handle->length_counter, src->length_counter))
+    {
+        Handle_set_error(src, ERROR_MEMORY, "Couldn't allocate memory");
+        Handle_deinit(handle);
+        memory_free(handle);
+        return 0;
+    }
+
+    Handle_stop(handle);
+
+    kqt_Handle id = add_handle(handle);
+    if (id == 0)
+    {
+        Handle_deinit(handle);
+        memory_free(handle);
+        return 0;
+    }
+
+    return id;
+}
+
+
 int kqt_Handle_set_data(
         kqt_Handle handle,
         const char* key,
@@ -154,6 +228,15 @@ int kqt_Handle_set_data(
         return 0;
     }
 
+    if (Module_is_shared(h->module))
+    {
+        Handle_set_error(
+                h,
+                ERROR_ARGUMENT,
+                "Cannot modify a composition shared by several Handles");
+        return 0;
+    }
+
     if (!parse_data(h, key, data, length))
         return 0;
 
@@ -163,6 +246,104 @@ int kqt_Handle_set_data(
 }
 
 
+int kqt_Handle_set_data_batch(
+        kqt_Handle handle,
+        long count,
+        const char* const keys[],
+        const void* const data[],
+        const long lengths[])
+{
+    check_handle(handle, 0);
+
+    Handle* h = get_handle(handle);
+    check_data_is_valid(h, 0);
+
+    if (count < 0)
+    {
+        Handle_set_error(
+                h, ERROR_ARGUMENT, "Number of keys must be non-negative");
+        return 0;
+    }
+
+    if (count > 0 && (keys == NULL || data == NULL || lengths == NULL))
+    {
+        Handle_set_error(
+                h,
+                ERROR_ARGUMENT,
+                "Keys, data and lengths must not be null if given count"
+                    " (%ld) is positive",
+                count);
+        return 0;
+    }
+
+    for (long i = 0; i < count; ++i)
+        check_key(h, keys[i], 0);
+
+    // Short-circuit if we have already got invalid data
+    if (Error_is_set(&h->validation_error))
+        return 1;
+
+    for (long i = 0; i < count; ++i)
+    {
+        if (lengths[i] < 0)
+        {
+            Handle_set_error(
+                    h, ERROR_ARGUMENT, "Data length must be non-negative");
+            return 0;
+        }
+
+        if (data[i] == NULL && lengths[i] > 0)
+        {
+            Handle_set_error(
+                    h,
+                    ERROR_ARGUMENT,
+                    "Data of key %s must not be null if given length (%ld)"
+                        " is positive",
+                    keys[i],
+                    lengths[i]);
+            return 0;
+        }
+    }
+
+    if (Module_is_shared(h->module))
+    {
+        Handle_set_error(
+                h,
+                ERROR_ARGUMENT,
+                "Cannot modify a composition shared by several Handles");
+        return 0;
+    }
+
+    if (!parse_data_batch(h, count, keys, data, lengths))
+        return 0;
+
+    h->data_is_validated = false;
+
+    return 1;
+}
+
+
+int kqt_Handle_set_sample_cache_limit(kqt_Handle handle, long long size)
+{
+    check_handle(handle, 0);
+
+    Handle* h = get_handle(handle);
+
+    if (size < 0)
+    {
+        Handle_set_error(
+                h,
+                ERROR_ARGUMENT,
+                "Sample cache limit must be non-negative");
+        return 0;
+    }
+
+    Sample_cache_set_limit(h->module->sample_cache, (uint64_t)size);
+
+    return 1;
+}
+
+
 bool Handle_init(Handle* handle)
 {
     assert(handle != NULL);
@@ -175,6 +356,18 @@ bool Handle_init(Handle* handle)
     memset(handle->position, '\0', POSITION_LENGTH);
     handle->player = NULL;
     handle->length_counter = NULL;
+    handle->edits = NULL;
+    handle->defer_connections = false;
+    handle->connections_changed = false;
+    handle->validate_all = false;
+    for (int i = 0; i < KQT_SONGS_MAX; ++i)
+        handle->changed_songs[i] = false;
+    for (int i = 0; i < KQT_PATTERNS_MAX; ++i)
+        handle->changed_pats[i] = false;
+    for (int i = 0; i < KQT_TRACKS_MAX; ++i)
+        handle->track_durations[i] = -1;
+    handle->profile = NULL;
+    handle->profile_capacity = 0;
 
 //    int buffer_count = SONG_DEFAULT_BUF_COUNT;
 //    int voice_count = 256;
@@ -186,6 +379,15 @@ bool Handle_init(Handle* handle)
         Handle_deinit(handle);
         return false;
     }
+    Module_add_handle(handle->module);
+
+    handle->edits = new_Edit_queue();
+    if (handle->edits == NULL)
+    {
+        Handle_set_error(NULL, ERROR_MEMORY, "Couldn't allocate memory");
+        Handle_deinit(handle);
+        return false;
+    }
 
     // Create players
     handle->player = new_Player(
@@ -208,6 +410,20 @@ bool Handle_init(Handle* handle)
 }
 
 
+void Handle_clear_sequence_caches(Handle* handle)
+{
+    assert(handle != NULL);
+
+    for (int i = 0; i < KQT_TRACKS_MAX; ++i)
+        handle->track_durations[i] = -1;
+
+    if (handle->player != NULL)
+        Player_clear_seek_cache(handle->player);
+
+    return;
+}
+
+
 const char* kqt_Handle_get_error(kqt_Handle handle)
 {
     if (!kqt_Handle_is_valid(handle))
@@ -273,31 +489,56 @@ int kqt_Handle_validate(kqt_Handle handle)
                 "Album has no tracks");
     }
 
+    Module* module = h->module;
+    const Track_list* tl = module->track_list;
+
+    // Count the occurrences of songs in the album
+    int song_track_counts[KQT_SONGS_MAX] = { 0 };
+    if (module->album_is_existent)
+    {
+        for (size_t i = 0; i < Track_list_get_len(tl); ++i)
+            ++song_track_counts[Track_list_get_song_index(tl, i)];
+    }
+
+    // Only check the parts that have changed since the last validation
+    if (h->validate_all)
+    {
+        for (int i = 0; i < KQT_SONGS_MAX; ++i)
+            h->changed_songs[i] = true;
+        for (int i = 0; i < KQT_PATTERNS_MAX; ++i)
+            h->changed_pats[i] = true;
+    }
+
     // Check songs
     for (int i = 0; i < KQT_SONGS_MAX; ++i)
     {
-        if (!Song_table_get_existent(h->module->songs, i))
+        if (!h->changed_songs[i])
             continue;
 
-        // Check for orphans
-        const Track_list* tl = h->module->track_list;
-        set_invalid_if(
-                !h->module->album_is_existent || tl == NULL,
-                "Module contains song %d but no album", i);
-
-        bool found = false;
-        for (size_t k = 0; k < Track_list_get_len(tl); ++k)
+        // Patterns used in the song must also be checked
+        const Order_list* ol = module->order_lists[i];
+        if (ol != NULL)
         {
-            if (Track_list_get_song_index(tl, k) == i)
+            for (size_t system = 0; system < Order_list_get_len(ol); ++system)
             {
-                found = true;
-                break;
+                const Pat_inst_ref* piref =
+                    Order_list_get_pat_inst_ref(ol, system);
+                h->changed_pats[piref->pat] = true;
             }
         }
-        set_invalid_if(!found, "Song %d is not included in the album", i);
+
+        if (!Song_table_get_existent(module->songs, i))
+            continue;
+
+        // Check for orphans
+        set_invalid_if(
+                !module->album_is_existent || tl == NULL,
+                "Module contains song %d but no album", i);
+        set_invalid_if(
+                song_track_counts[i] == 0,
+                "Song %d is not included in the album", i);
 
         // Check for empty songs
-        const Order_list* ol = h->module->order_lists[i];
         set_invalid_if(
                 ol == NULL || Order_list_get_len(ol) == 0,
                 "Song %d does not contain systems", i);
@@ -306,39 +547,51 @@ int kqt_Handle_validate(kqt_Handle handle)
         for (size_t system = 0; system < Order_list_get_len(ol); ++system)
         {
             const Pat_inst_ref* piref = Order_list_get_pat_inst_ref(ol, system);
-            Pattern* pat = Pat_table_get(h->module->pats, piref->pat);
-
             set_invalid_if(
-                    !Pat_table_get_existent(h->module->pats, piref->pat) ||
-                    pat == NULL ||
-                    !Pattern_get_inst_existent(pat, piref->inst),
+                    Module_get_pattern(module, piref) == NULL,
                     "Missing pattern instance [%" PRId16 ", %" PRId16 "]",
                     piref->pat, piref->inst);
         }
     }
 
     // Check for nonexistent songs in the track list
-    if (h->module->album_is_existent)
+    if (module->album_is_existent)
     {
-        const Track_list* tl = h->module->track_list;
         assert(tl != NULL);
 
         for (size_t i = 0; i < Track_list_get_len(tl); ++i)
         {
             set_invalid_if(
-                    !Song_table_get_existent(h->module->songs,
+                    !Song_table_get_existent(module->songs,
                         Track_list_get_song_index(tl, i)),
                     "Album includes nonexistent song %d", i);
         }
     }
 
-    // Check existing patterns
+    // Check patterns
+    const Pat_inst_index* index = module->pat_inst_index;
     for (int i = 0; i < KQT_PATTERNS_MAX; ++i)
     {
-        if (!Pat_table_get_existent(h->module->pats, i))
+        if (!h->changed_pats[i])
             continue;
 
-        Pattern* pat = Pat_table_get(h->module->pats, i);
+        // Check for missing instances used in existing songs
+        const Pat_inst_location* loc = Pat_inst_index_get_at_least(
+                index, &(Pat_inst_ref){ .pat = i, .inst = 0 }, 0);
+        while (loc != NULL && loc->piref.pat == i)
+        {
+            set_invalid_if(
+                    Song_table_get_existent(module->songs, loc->song) &&
+                        Module_get_pattern(module, &loc->piref) == NULL,
+                    "Missing pattern instance [%" PRId16 ", %" PRId16 "]",
+                    loc->piref.pat, loc->piref.inst);
+            loc = Pat_inst_index_get_next(index, loc);
+        }
+
+        if (!Pat_table_get_existent(module->pats, i))
+            continue;
+
+        Pattern* pat = Pat_table_get(module->pats, i);
         set_invalid_if(
                 pat == NULL,
                 "Pattern %d exists but contains no data", i);
@@ -346,54 +599,36 @@ int kqt_Handle_validate(kqt_Handle handle)
         bool pattern_has_instance = false;
         for (int k = 0; k < KQT_PAT_INSTANCES_MAX; ++k)
         {
-            if (Pattern_get_inst_existent(pat, k))
+            if (!Pattern_get_inst_existent(pat, k))
+                continue;
+
+            // Mark found instance
+            pattern_has_instance = true;
+
+            // Check that the instance is used in the album exactly once
+            set_invalid_if(
+                    !module->album_is_existent,
+                    "Pattern instance [%d, %d] exists but no album"
+                    " is present", i, k);
+
+            const Pat_inst_ref* piref = &(Pat_inst_ref){ .pat = i, .inst = k };
+            int occurrences = 0;
+            loc = Pat_inst_index_get_at_least(index, piref, 0);
+            while (loc != NULL && Pat_inst_ref_cmp(&loc->piref, piref) == 0)
             {
-                // Mark found instance
-                pattern_has_instance = true;
-
-                // Check that the instance is used in the album
-                set_invalid_if(
-                        !h->module->album_is_existent,
-                        "Pattern instance [%d, %d] exists but no album"
-                        " is present", i, k);
-
-                bool instance_found = false;
-
-                const Track_list* tl = h->module->track_list;
-                assert(tl != NULL);
-
-                for (size_t track = 0; track < Track_list_get_len(tl); ++track)
-                {
-                    const int song_index = Track_list_get_song_index(tl, track);
-
-                    if (!Song_table_get_existent(
-                                h->module->songs,
-                                song_index))
-                        continue;
-
-                    const Order_list* ol = h->module->order_lists[song_index];
-                    assert(ol != NULL);
-
-                    for (size_t system = 0; system < Order_list_get_len(ol); ++system)
-                    {
-                        const Pat_inst_ref* piref = Order_list_get_pat_inst_ref(
-                                ol, system);
-                        if (piref->pat == i && piref->inst == k)
-                        {
-                            set_invalid_if(
-                                    instance_found,
-                                    "Duplicate occurrence of pattern instance"
-                                    " [%d, %d]", i, k);
-                            instance_found = true;
-                        }
-                    }
-                }
-
-                set_invalid_if(
-                        !instance_found,
-                        "Pattern instance [%d, %d] exists but is not used",
-                        i, k);
+                if (Song_table_get_existent(module->songs, loc->song))
+                    occurrences += song_track_counts[loc->song];
+                loc = Pat_inst_index_get_next(index, loc);
             }
+
+            set_invalid_if(
+                    occurrences > 1,
+                    "Duplicate occurrence of pattern instance"
+                    " [%d, %d]", i, k);
+            set_invalid_if(
+                    occurrences == 0,
+                    "Pattern instance [%d, %d] exists but is not used",
+                    i, k);
         }
 
         set_invalid_if(
@@ -409,6 +644,12 @@ int kqt_Handle_validate(kqt_Handle handle)
                 "Control map uses nonexistent controls");
     }
 
+    h->validate_all = false;
+    for (int i = 0; i < KQT_SONGS_MAX; ++i)
+        h->changed_songs[i] = false;
+    for (int i = 0; i < KQT_PATTERNS_MAX; ++i)
+        h->changed_pats[i] = false;
+
     h->data_is_validated = true;
 
     return 1;
@@ -484,13 +725,13 @@ void Handle_set_validation_error_from_Error(Handle* handle, const Error* error)
 }
 
 
-bool key_is_valid(Handle* handle, const char* key)
+bool key_format_is_valid(const char* key, Error* error)
 {
-    assert(handle != NULL);
+    assert(error != NULL);
 
     if (key == NULL)
     {
-        Handle_set_error(handle, ERROR_ARGUMENT, "No key given");
+        Error_set(error, ERROR_ARGUMENT, "No key given");
         return false;
     }
 
@@ -499,7 +740,7 @@ bool key_is_valid(Handle* handle, const char* key)
         char key_repr[KQT_KEY_LENGTH_MAX + 3] = { '\0' };
         strncpy(key_repr, key, KQT_KEY_LENGTH_MAX - 1);
         strcat(key_repr, "...");
-        Handle_set_error(handle, ERROR_ARGUMENT, "Key %s is too long"
+        Error_set(error, ERROR_ARGUMENT, "Key %s is too long"
                 " (over %d characters)", key_repr, KQT_KEY_LENGTH_MAX);
         return false;
     }
@@ -513,7 +754,7 @@ bool key_is_valid(Handle* handle, const char* key)
         if (!(*key_iter >= '0' && *key_iter <= '9') &&
                 strchr("abcdefghijklmnopqrstuvwxyz_./X", *key_iter) == NULL)
         {
-            Handle_set_error(handle, ERROR_ARGUMENT, "Key %s contains an"
+            Error_set(error, ERROR_ARGUMENT, "Key %s contains an"
                     " illegal character \'%c\'", key, *key_iter);
             return false;
         }
@@ -530,13 +771,13 @@ bool key_is_valid(Handle* handle, const char* key)
         {
             if (!valid_element)
             {
-                Handle_set_error(handle, ERROR_ARGUMENT, "Key %s contains"
+                Error_set(error, ERROR_ARGUMENT, "Key %s contains"
                         " an invalid component", key);
                 return false;
             }
             else if (element_has_period)
             {
-                Handle_set_error(handle, ERROR_ARGUMENT, "Key %s contains"
+                Error_set(error, ERROR_ARGUMENT, "Key %s contains"
                         " an intermediate component with a period", key);
                 return false;
             }
@@ -549,7 +790,7 @@ bool key_is_valid(Handle* handle, const char* key)
 
     if (!element_has_period)
     {
-        Handle_set_error(handle, ERROR_ARGUMENT, "The final element of"
+        Error_set(error, ERROR_ARGUMENT, "The final element of"
                 " key %s does not have a period", key);
         return false;
     }
@@ -558,6 +799,21 @@ bool key_is_valid(Handle* handle, const char* key)
 }
 
 
+bool key_is_valid(Handle* handle, const char* key)
+{
+    assert(handle != NULL);
+
+    Error* error = ERROR_AUTO;
+    if (!key_format_is_valid(key, error))
+    {
+        Handle_set_error_from_Error(handle, error);
+        return false;
+    }
+
+    return true;
+}
+
+
 Module* Handle_get_module(Handle* handle)
 {
     assert(handle != NULL);
@@ -573,9 +829,18 @@ void Handle_deinit(Handle* handle)
     handle->length_counter = NULL;
     del_Player(handle->player);
     handle->player = NULL;
+    del_Edit_queue(handle->edits);
+    handle->edits = NULL;
+    memory_free(handle->profile);
+    handle->profile = NULL;
+    handle->profile_capacity = 0;
 
-    del_Module(handle->module);
-    handle->module = NULL;
+    if (handle->module != NULL)
+    {
+        if (Module_remove_handle(handle->module))
+            del_Module(handle->module);
+        handle->module = NULL;
+    }
 
     return;
 }
@@ -0,0 +1,286 @@
+
+
+/*
+ * Author: Tomi Jylhä-Ollila, Finland 2014
+ *
+ * This file is part of Kunquat.
+ *
+ * CC0 1.0 Universal, http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * To the extent possible under law, Kunquat Affirmers have waived all
+ * copyright and related or neighboring rights to Kunquat.
+ */
+
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <debug/assert.h>
+#include <Handle_private.h>
+#include <kunquat/Handle.h>
+#include <kunquat/limits.h>
+#include <memory.h>
+#include <module/Parse_manager.h>
+#include <string/common.h>
+#include <string/Tar_reader.h>
+
+
+#define KEY_BUF_SIZE (KQT_KEY_LENGTH_MAX + 1)
+
+
+static bool check_archive_is_writable(Handle* handle)
+{
+    assert(handle != NULL);
+
+    if (Module_is_shared(handle->module))
+    {
+        Handle_set_error(
+                handle,
+                ERROR_ARGUMENT,
+                "Cannot modify a composition shared by several Handles");
+        return false;
+    }
+
+    return true;
+}
+
+
+static bool archive_is_compressed(const char* data, size_t length)
+{
+    assert(data != NULL || length == 0);
+
+    const bool is_gzip = (length >= 2) &&
+        ((unsigned char)data[0] == 0x1f) && ((unsigned char)data[1] == 0x8b);
+    const bool is_bzip2 = (length >= 3) && (strncmp(data, "BZh", 3) == 0);
+
+    return is_gzip || is_bzip2;
+}
+
+
+static bool load_archive(Handle* handle, const char* data, size_t length)
+{
+    assert(handle != NULL);
+    assert(data != NULL);
+    assert(length > 0);
+
+    if (archive_is_compressed(data, length))
+    {
+        Handle_set_error(
+                handle,
+                ERROR_FORMAT,
+                "Compressed archives are not supported,"
+                    " please decompress the archive first");
+        return false;
+    }
+
+    // Count the files
+    long count = 0;
+    Tar_reader* reader = Tar_reader_init(TAR_READER_AUTO, data, length);
+    Tar_entry* entry = &(Tar_entry){ .is_file = false };
+    while (Tar_reader_read_entry(reader, entry))
+    {
+        if (entry->is_file)
+            ++count;
+    }
+
+    if (Tar_reader_is_error_set(reader))
+    {
+        Handle_set_error_from_Error(handle, Tar_reader_get_error(reader));
+        return false;
+    }
+
+    if (count == 0)
+        return true;
+
+    char* key_bufs = memory_alloc_items(char, count * KEY_BUF_SIZE);
+    const char** keys = memory_alloc_items(const char*, count);
+    const void** values = memory_alloc_items(const void*, count);
+    long* lengths = memory_alloc_items(long, count);
+    if (key_bufs == NULL || keys == NULL || values == NULL || lengths == NULL)
+    {
+        memory_free(key_bufs);
+        memory_free(keys);
+        memory_free(values);
+        memory_free(lengths);
+        Handle_set_error(handle, ERROR_MEMORY,
+                "Couldn't allocate memory for archive entries");
+        return false;
+    }
+
+    // Collect the keys, the values point directly to the archive data
+    bool success = true;
+    long index = 0;
+    reader = Tar_reader_init(TAR_READER_AUTO, data, length);
+    while (success && Tar_reader_read_entry(reader, entry))
+    {
+        if (!entry->is_file)
+            continue;
+
+        assert(index < count);
+
+        const char* key = strchr(entry->path, '/');
+        if (!string_has_prefix(entry->path, "kqtc") || key == NULL)
+        {
+            Handle_set_error(
+                    handle,
+                    ERROR_FORMAT,
+                    "Archive entry %s is not inside a composition directory",
+                    entry->path);
+            success = false;
+            break;
+        }
+        ++key;
+
+        if (strlen(key) > KQT_KEY_LENGTH_MAX || entry->size > LONG_MAX)
+        {
+            Handle_set_error(
+                    handle,
+                    ERROR_FORMAT,
+                    "Archive entry %s is not a valid composition entry",
+                    entry->path);
+            success = false;
+            break;
+        }
+
+        char* key_buf = &key_bufs[index * KEY_BUF_SIZE];
+        strcpy(key_buf, key);
+        if (!key_is_valid(handle, key_buf))
+        {
+            success = false;
+            break;
+        }
+
+        keys[index] = key_buf;
+        values[index] = entry->data;
+        lengths[index] = (long)entry->size;
+        ++index;
+    }
+
+    if (success)
+    {
+        assert(!Tar_reader_is_error_set(reader));
+        assert(index == count);
+        success = parse_data_batch(handle, count, keys, values, lengths);
+    }
+
+    memory_free(key_bufs);
+    memory_free(keys);
+    memory_free(values);
+    memory_free(lengths);
+
+    return success;
+}
+
+
+int kqt_Handle_load_archive_data(
+        kqt_Handle handle, const void* data, long length)
+{
+    check_handle(handle, 0);
+
+    Handle* h = get_handle(handle);
+    check_data_is_valid(h, 0);
+
+    if (data == NULL)
+    {
+        Handle_set_error(h, ERROR_ARGUMENT, "Archive data must not be null");
+        return 0;
+    }
+
+    if (length <= 0)
+    {
+        Handle_set_error(
+                h, ERROR_ARGUMENT, "Archive data length must be positive");
+        return 0;
+    }
+
+    // Short-circuit if we have already got invalid data
+    if (Error_is_set(&h->validation_error))
+        return 1;
+
+    if (!check_archive_is_writable(h))
+        return 0;
+
+    if (!load_archive(h, data, (size_t)length))
+        return 0;
+
+    h->data_is_validated = false;
+
+    return 1;
+}
+
+
+int kqt_Handle_load_archive(kqt_Handle handle, const char* path)
+{
+    check_handle(handle, 0);
+
+    Handle* h = get_handle(handle);
+    check_data_is_valid(h, 0);
+
+    if (path == NULL)
+    {
+        Handle_set_error(h, ERROR_ARGUMENT, "No archive path given");
+        return 0;
+    }
+
+    // Short-circuit if we have already got invalid data
+    if (Error_is_set(&h->validation_error))
+        return 1;
+
+    if (!check_archive_is_writable(h))
+        return 0;
+
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        Handle_set_error(h, ERROR_RESOURCE,
+                "Couldn't open %s: %s", path, strerror(errno));
+        return 0;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0)
+    {
+        Handle_set_error(h, ERROR_RESOURCE,
+                "Couldn't get the size of %s: %s", path, strerror(errno));
+        close(fd);
+        return 0;
+    }
+
+    if (info.st_size <= 0)
+    {
+        Handle_set_error(h, ERROR_FORMAT, "Archive %s is empty", path);
+        close(fd);
+        return 0;
+    }
+
+    // Map the archive so that the entries can be parsed without copying
+    const size_t length = (size_t)info.st_size;
+    void* data = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+    {
+        Handle_set_error(h, ERROR_RESOURCE,
+                "Couldn't map %s: %s", path, strerror(errno));
+        return 0;
+    }
+
+    const bool success = load_archive(h, data, length);
+    munmap(data, length);
+    if (!success)
+        return 0;
+
+    h->data_is_validated = false;
+
+    return 1;
+}
+
+
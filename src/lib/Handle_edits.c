@@ -0,0 +1,585 @@
+
+
+/*
+ * Author: Tomi Jylhä-Ollila, Finland 2014
+ *
+ * This file is part of Kunquat.
+ *
+ * CC0 1.0 Universal, http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * To the extent possible under law, Kunquat Affirmers have waived all
+ * copyright and related or neighboring rights to Kunquat.
+ */
+
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <debug/assert.h>
+#include <Error.h>
+#include <Handle_private.h>
+#include <kunquat/Handle.h>
+#include <memory.h>
+#include <module/Parse_manager.h>
+#include <module/sheet/Pat_table.h>
+#include <module/sheet/Pattern.h>
+
+
+/**
+ * Data staged by the editor, stored in the order it was staged.
+ */
+typedef struct Edit_batch
+{
+    long count;
+    long capacity;
+    char** keys;
+    char** data;
+    long* lengths;
+} Edit_batch;
+
+
+/**
+ * Edits parsed from committed data.
+ *
+ * Before the playing thread takes the edits into use, the Columns of the
+ * edits are new ones. Afterwards, the edits hold the replaced Columns that
+ * are destroyed by the editor.
+ */
+typedef struct Edit_list
+{
+    long count;
+    long capacity;
+    Pattern_edit* edits;
+    struct Edit_list* next;
+} Edit_list;
+
+
+struct Edit_queue
+{
+    Edit_batch* staged;     ///< Data being staged, owned by the editor.
+    Error error;            ///< The error of the latest editing call.
+    pthread_mutex_t lock;   ///< Protects the edit lists below.
+    Edit_list* published;   ///< Edits waiting for the playing thread.
+    Edit_list* retired;     ///< Replaced data to be destroyed by the editor.
+};
+
+
+static Edit_batch* new_Edit_batch(void)
+{
+    Edit_batch* batch = memory_alloc_item(Edit_batch);
+    if (batch == NULL)
+        return NULL;
+
+    batch->count = 0;
+    batch->capacity = 0;
+    batch->keys = NULL;
+    batch->data = NULL;
+    batch->lengths = NULL;
+
+    return batch;
+}
+
+
+static bool Edit_batch_reserve(Edit_batch* batch, long count)
+{
+    assert(batch != NULL);
+    assert(count >= 0);
+
+    if (count <= batch->capacity)
+        return true;
+
+    long new_capacity = (batch->capacity > 0) ? batch->capacity : 16;
+    while (new_capacity < count)
+        new_capacity *= 2;
+
+    char** new_keys = memory_realloc_items(char*, new_capacity, batch->keys);
+    if (new_keys == NULL)
+        return false;
+    batch->keys = new_keys;
+
+    char** new_data = memory_realloc_items(char*, new_capacity, batch->data);
+    if (new_data == NULL)
+        return false;
+    batch->data = new_data;
+
+    long* new_lengths = memory_realloc_items(
+            long, new_capacity, batch->lengths);
+    if (new_lengths == NULL)
+        return false;
+    batch->lengths = new_lengths;
+
+    batch->capacity = new_capacity;
+
+    return true;
+}
+
+
+static bool Edit_batch_append(
+        Edit_batch* batch, const char* key, const void* data, long length)
+{
+    assert(batch != NULL);
+    assert(key != NULL);
+    assert(data != NULL || length == 0);
+    assert(length >= 0);
+
+    if (!Edit_batch_reserve(batch, batch->count + 1))
+        return false;
+
+    char* key_copy = memory_alloc_items(char, strlen(key) + 1);
+    char* data_copy = memory_alloc_items(char, (length > 0) ? length : 1);
+    if (key_copy == NULL || data_copy == NULL)
+    {
+        memory_free(key_copy);
+        memory_free(data_copy);
+        return false;
+    }
+
+    strcpy(key_copy, key);
+    if (length > 0)
+        memcpy(data_copy, data, length);
+
+    batch->keys[batch->count] = key_copy;
+    batch->data[batch->count] = data_copy;
+    batch->lengths[batch->count] = length;
+    ++batch->count;
+
+    return true;
+}
+
+
+static void del_Edit_batch(Edit_batch* batch)
+{
+    if (batch == NULL)
+        return;
+
+    for (long i = 0; i < batch->count; ++i)
+    {
+        memory_free(batch->keys[i]);
+        memory_free(batch->data[i]);
+    }
+
+    memory_free(batch->keys);
+    memory_free(batch->data);
+    memory_free(batch->lengths);
+    memory_free(batch);
+
+    return;
+}
+
+
+static Edit_list* new_Edit_list(long capacity)
+{
+    assert(capacity > 0);
+
+    Edit_list* list = memory_alloc_item(Edit_list);
+    if (list == NULL)
+        return NULL;
+
+    list->count = 0;
+    list->capacity = capacity;
+    list->next = NULL;
+    list->edits = memory_alloc_items(Pattern_edit, capacity);
+    if (list->edits == NULL)
+    {
+        memory_free(list);
+        return NULL;
+    }
+
+    return list;
+}
+
+
+static bool Edit_list_merge(Edit_list* list, Edit_list* next)
+{
+    assert(list != NULL);
+    assert(next != NULL);
+
+    const long count = list->count + next->count;
+    if (count > list->capacity)
+    {
+        Pattern_edit* new_edits = memory_realloc_items(
+                Pattern_edit, count, list->edits);
+        if (new_edits == NULL)
+            return false;
+
+        list->edits = new_edits;
+        list->capacity = count;
+    }
+
+    for (long i = 0; i < next->count; ++i)
+        list->edits[list->count + i] = next->edits[i];
+    list->count = count;
+
+    memory_free(next->edits);
+    memory_free(next);
+
+    return true;
+}
+
+
+static void del_Edit_list(Edit_list* list)
+{
+    while (list != NULL)
+    {
+        Edit_list* next = list->next;
+
+        for (long i = 0; i < list->count; ++i)
+            del_Column(list->edits[i].col);
+
+        memory_free(list->edits);
+        memory_free(list);
+
+        list = next;
+    }
+
+    return;
+}
+
+
+Edit_queue* new_Edit_queue(void)
+{
+    Edit_queue* queue = memory_alloc_item(Edit_queue);
+    if (queue == NULL)
+        return NULL;
+
+    if (pthread_mutex_init(&queue->lock, NULL) != 0)
+    {
+        memory_free(queue);
+        return NULL;
+    }
+
+    queue->staged = NULL;
+    queue->error = *ERROR_AUTO;
+    queue->published = NULL;
+    queue->retired = NULL;
+
+    return queue;
+}
+
+
+void Handle_apply_edits(Handle* handle)
+{
+    assert(handle != NULL);
+    assert(handle->edits != NULL);
+
+    Edit_queue* queue = handle->edits;
+
+    // Never wait for the editor, the edits will be applied at the next block
+    if (pthread_mutex_trylock(&queue->lock) != 0)
+        return;
+
+    Edit_list* list = queue->published;
+    if (list == NULL)
+    {
+        pthread_mutex_unlock(&queue->lock);
+        return;
+    }
+
+    queue->published = NULL;
+
+    Pat_table* pats = Module_get_pats(handle->module);
+    for (long i = 0; i < list->count; ++i)
+    {
+        Pattern_edit* edit = &list->edits[i];
+
+        // The Pattern may have been removed after the commit
+        Pattern* pat = Pat_table_get(pats, edit->pat_index);
+        if (pat == NULL)
+            continue;
+
+        if (edit->type == PATTERN_EDIT_LENGTH)
+        {
+            Pattern_set_length(pat, &edit->length);
+        }
+        else
+        {
+            assert(edit->type == PATTERN_EDIT_COLUMN);
+            edit->col = Pattern_swap_column(pat, edit->col_index, edit->col);
+        }
+    }
+
+    list->next = queue->retired;
+    queue->retired = list;
+
+    pthread_mutex_unlock(&queue->lock);
+
+    Handle_clear_sequence_caches(handle);
+
+    return;
+}
+
+
+void del_Edit_queue(Edit_queue* queue)
+{
+    if (queue == NULL)
+        return;
+
+    del_Edit_batch(queue->staged);
+    del_Edit_list(queue->published);
+    del_Edit_list(queue->retired);
+    pthread_mutex_destroy(&queue->lock);
+    memory_free(queue);
+
+    return;
+}
+
+
+static bool check_edits_are_supported(Handle* handle)
+{
+    assert(handle != NULL);
+
+    if (Module_is_shared(handle->module))
+    {
+        Error_set(
+                &handle->edits->error,
+                ERROR_ARGUMENT,
+                "Staged edits are not supported in a composition shared"
+                " by several Handles");
+        return false;
+    }
+
+    return true;
+}
+
+
+static const Tstamp* get_pattern_length(
+        const Edit_list* published,
+        const Edit_list* list,
+        const Pattern* pat,
+        int pat_index)
+{
+    assert(list != NULL);
+    assert(pat != NULL);
+
+    // Use the latest length that precedes the edit in commit order
+    for (long i = list->count - 1; i >= 0; --i)
+    {
+        const Pattern_edit* edit = &list->edits[i];
+        if (edit->type == PATTERN_EDIT_LENGTH && edit->pat_index == pat_index)
+            return &edit->length;
+    }
+
+    if (published != NULL)
+    {
+        for (long i = published->count - 1; i >= 0; --i)
+        {
+            const Pattern_edit* edit = &published->edits[i];
+            if (edit->type == PATTERN_EDIT_LENGTH &&
+                    edit->pat_index == pat_index)
+                return &edit->length;
+        }
+    }
+
+    return Pattern_get_length(pat);
+}
+
+
+static bool parse_edits(Handle* handle, Edit_batch* batch, Edit_list* list)
+{
+    assert(handle != NULL);
+    assert(batch != NULL);
+    assert(list != NULL);
+    assert(list->capacity >= batch->count);
+
+    Edit_queue* queue = handle->edits;
+    Pat_table* pats = Module_get_pats(handle->module);
+
+    for (long i = 0; i < batch->count; ++i)
+    {
+        const char* key = batch->keys[i];
+        Pattern_edit* edit = &list->edits[list->count];
+
+        if (!find_pattern_edit(edit, key))
+        {
+            Error_set(
+                    &queue->error,
+                    ERROR_ARGUMENT,
+                    "Key %s cannot be staged: only the headers and columns"
+                    " of existing patterns can be changed during playback",
+                    key);
+            return false;
+        }
+
+        if (edit->type == PATTERN_EDIT_NONE)
+            continue;
+
+        const Pattern* pat = Pat_table_get(pats, edit->pat_index);
+        if (pat == NULL)
+        {
+            Error_set(
+                    &queue->error,
+                    ERROR_ARGUMENT,
+                    "Key %s cannot be staged: pattern %d does not exist",
+                    key, edit->pat_index);
+            return false;
+        }
+
+        const Tstamp* pat_length = get_pattern_length(
+                queue->published, list, pat, edit->pat_index);
+
+        if (!parse_pattern_edit(
+                    handle,
+                    edit,
+                    batch->data[i],
+                    batch->lengths[i],
+                    pat_length,
+                    &queue->error))
+            return false;
+
+        ++list->count;
+    }
+
+    return true;
+}
+
+
+int kqt_Handle_stage_data(
+        kqt_Handle handle,
+        const char* key,
+        const void* data,
+        long length)
+{
+    check_handle(handle, 0);
+
+    Handle* h = get_handle(handle);
+    check_data_is_valid(h, 0);
+
+    Edit_queue* queue = h->edits;
+    Error_clear(&queue->error);
+
+    if (!key_format_is_valid(key, &queue->error))
+        return 0;
+
+    if (length < 0)
+    {
+        Error_set(
+                &queue->error,
+                ERROR_ARGUMENT,
+                "Data length must be non-negative");
+        return 0;
+    }
+
+    if (data == NULL && length > 0)
+    {
+        Error_set(
+                &queue->error,
+                ERROR_ARGUMENT,
+                "Data must not be null if given length (%ld) is positive",
+                length);
+        return 0;
+    }
+
+    if (!check_edits_are_supported(h))
+        return 0;
+
+    if (queue->staged == NULL)
+    {
+        queue->staged = new_Edit_batch();
+        if (queue->staged == NULL)
+        {
+            Error_set(&queue->error, ERROR_MEMORY,
+                    "Couldn't allocate memory for staged data");
+            return 0;
+        }
+    }
+
+    if (!Edit_batch_append(queue->staged, key, data, length))
+    {
+        // Never commit a part of the staged data
+        del_Edit_batch(queue->staged);
+        queue->staged = NULL;
+
+        Error_set(&queue->error, ERROR_MEMORY,
+                "Couldn't allocate memory for staged data");
+        return 0;
+    }
+
+    return 1;
+}
+
+
+int kqt_Handle_commit_data(kqt_Handle handle)
+{
+    check_handle(handle, 0);
+
+    Handle* h = get_handle(handle);
+    check_data_is_valid(h, 0);
+
+    Edit_queue* queue = h->edits;
+    Error_clear(&queue->error);
+
+    // Destroy the data replaced by the previous commits
+    pthread_mutex_lock(&queue->lock);
+    Edit_list* retired = queue->retired;
+    queue->retired = NULL;
+    pthread_mutex_unlock(&queue->lock);
+    del_Edit_list(retired);
+
+    Edit_batch* batch = queue->staged;
+    queue->staged = NULL;
+
+    if (!check_edits_are_supported(h))
+    {
+        del_Edit_batch(batch);
+        return 0;
+    }
+
+    if (batch == NULL || batch->count == 0)
+    {
+        del_Edit_batch(batch);
+        return 1;
+    }
+
+    Edit_list* list = new_Edit_list(batch->count);
+    if (list == NULL)
+    {
+        del_Edit_batch(batch);
+        Error_set(&queue->error, ERROR_MEMORY,
+                "Couldn't allocate memory for committed data");
+        return 0;
+    }
+
+    // The playing thread only modifies the composition while holding the lock
+    pthread_mutex_lock(&queue->lock);
+
+    bool success = parse_edits(h, batch, list);
+    if (success && list->count > 0)
+    {
+        if (queue->published == NULL)
+        {
+            queue->published = list;
+            list = NULL;
+        }
+        else if (Edit_list_merge(queue->published, list))
+        {
+            list = NULL;
+        }
+        else
+        {
+            Error_set(&queue->error, ERROR_MEMORY,
+                    "Couldn't allocate memory for committed data");
+            success = false;
+        }
+    }
+
+    pthread_mutex_unlock(&queue->lock);
+
+    del_Edit_list(list);
+    del_Edit_batch(batch);
+
+    return success ? 1 : 0;
+}
+
+
+const char* kqt_Handle_get_edit_error(kqt_Handle handle)
+{
+    if (!kqt_Handle_is_valid(handle))
+        return kqt_Handle_get_error(handle);
+
+    Handle* h = get_handle(handle);
+    return Error_get_desc(&h->edits->error);
+}
+
+
@@ -25,6 +25,7 @@
 #include <mathnum/common.h>
 #include <module/Env_var.h>
 #include <module/Module.h>
+#include <module/sheet/Track_list.h>
 #include <string/common.h>
 
 
@@ -43,6 +44,9 @@ int kqt_Handle_play(kqt_Handle handle, long nframes)
         return 0;
     }
 
+    // Take published edits into use at the block boundary
+    Handle_apply_edits(h);
+
     Player_play(h->player, nframes);
 
     return 1;
@@ -87,6 +91,16 @@ int kqt_Handle_set_audio_rate(kqt_Handle handle, long rate)
         return 0;
     }
 
+    // Some Devices store data that depends on the audio rate
+    if (Module_is_shared(h->module) && rate != Player_get_audio_rate(h->player))
+    {
+        Handle_set_error(
+                h,
+                ERROR_ARGUMENT,
+                "Cannot change the audio rate of a shared composition");
+        return 0;
+    }
+
     if (!Device_set_audio_rate(
                 (Device*)h->module,
                 Player_get_device_states(h->player),
@@ -161,6 +175,80 @@ long kqt_Handle_get_audio_buffer_size(kqt_Handle handle)
 }
 
 
+int kqt_Handle_set_thread_count(kqt_Handle handle, int count)
+{
+    check_handle(handle, 0);
+
+    Handle* h = get_handle(handle);
+    check_data_is_valid(h, 0);
+    check_data_is_validated(h, 0);
+
+    if (count <= 0)
+    {
+        Handle_set_error(h, ERROR_ARGUMENT, "Thread count must be positive");
+        return 0;
+    }
+    if (count > KQT_THREADS_MAX)
+    {
+        Handle_set_error(h, ERROR_ARGUMENT, "Thread count must not be"
+                " greater than %d", KQT_THREADS_MAX);
+        return 0;
+    }
+
+    if (!Player_set_thread_count(h->player, count))
+    {
+        Handle_set_error(h, ERROR_MEMORY,
+                "Couldn't allocate memory for rendering threads");
+        return 0;
+    }
+
+    return 1;
+}
+
+
+int kqt_Handle_get_thread_count(kqt_Handle handle)
+{
+    check_handle(handle, 0);
+
+    Handle* h = get_handle(handle);
+    check_data_is_valid(h, 0);
+    check_data_is_validated(h, 0);
+
+    return Player_get_thread_count(h->player);
+}
+
+
+int kqt_Handle_set_seek_cache_enabled(kqt_Handle handle, int enabled)
+{
+    check_handle(handle, 0);
+
+    Handle* h = get_handle(handle);
+    check_data_is_valid(h, 0);
+    check_data_is_validated(h, 0);
+
+    if (!Player_set_seek_cache_enabled(h->player, enabled != 0))
+    {
+        Handle_set_error(h, ERROR_MEMORY,
+                "Couldn't allocate memory for the seek cache");
+        return 0;
+    }
+
+    return 1;
+}
+
+
+int kqt_Handle_get_seek_cache_enabled(kqt_Handle handle)
+{
+    check_handle(handle, 0);
+
+    Handle* h = get_handle(handle);
+    check_data_is_valid(h, 0);
+    check_data_is_validated(h, 0);
+
+    return Player_get_seek_cache_enabled(h->player) ? 1 : 0;
+}
+
+
 #if 0
 int kqt_Handle_get_buffer_count(kqt_Handle handle)
 {
@@ -194,6 +282,24 @@ const float* kqt_Handle_get_audio(kqt_Handle handle, int index)
 }
 
 
+static int64_t Handle_get_track_duration(Handle* handle, int track)
+{
+    assert(handle != NULL);
+    assert(track >= 0);
+    assert(track < KQT_TRACKS_MAX);
+
+    if (handle->track_durations[track] < 0)
+    {
+        Player_reset(handle->length_counter, track);
+        Player_skip(handle->length_counter, KQT_MAX_CALC_DURATION);
+        handle->track_durations[track] =
+            Player_get_nanoseconds(handle->length_counter);
+    }
+
+    return handle->track_durations[track];
+}
+
+
 long long kqt_Handle_get_duration(kqt_Handle handle, int track)
 {
     check_handle(handle, -1);
@@ -209,10 +315,18 @@ long long kqt_Handle_get_duration(kqt_Handle handle, int track)
         return -1;
     }
 
-    Player_reset(h->length_counter);
-    Player_skip(h->length_counter, KQT_MAX_CALC_DURATION);
+    if (track >= 0)
+        return Handle_get_track_duration(h, track);
+
+    // Sum up the durations of all tracks
+    const Track_list* tl = Module_get_track_list(h->module);
+    const int track_count = (tl != NULL) ? (int)Track_list_get_len(tl) : 0;
 
-    return Player_get_nanoseconds(h->length_counter);
+    int64_t total = 0;
+    for (int i = 0; i < track_count && total < KQT_MAX_CALC_DURATION; ++i)
+        total += Handle_get_track_duration(h, i);
+
+    return min(total, KQT_MAX_CALC_DURATION);
 }
 
 
@@ -246,8 +360,8 @@ int kqt_Handle_set_position(
             (Device*)h->module,
             Player_get_device_states(h->player));
 
-    Player_reset(h->player);
-    Player_skip(h->player, skip_frames);
+    Player_reset(h->player, -1);
+    Player_seek(h->player, skip_frames);
 
     return 1;
 }
@@ -312,11 +426,36 @@ const char* kqt_Handle_receive_events(kqt_Handle handle)
 }
 
 
+const kqt_Event_record* kqt_Handle_receive_event_records(
+        kqt_Handle handle,
+        long* count)
+{
+    check_handle(handle, NULL);
+
+    Handle* h = get_handle(handle);
+    check_data_is_valid(h, NULL);
+    check_data_is_validated(h, NULL);
+
+    if (count == NULL)
+    {
+        Handle_set_error(h, ERROR_ARGUMENT, "No record count location given.");
+        return NULL;
+    }
+
+    int record_count = 0;
+    const kqt_Event_record* records =
+        Player_get_event_records(h->player, &record_count);
+    *count = record_count;
+
+    return records;
+}
+
+
 void Handle_stop(Handle* handle)
 {
     assert(handle != NULL);
 
-    Player_reset(handle->player);
+    Player_reset(handle->player, -1);
 
 #if 0
     handle->module->play_state->mode = STOP;
@@ -17,6 +17,7 @@
 
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #include <Error.h>
 #include <kunquat/Handle.h>
@@ -37,6 +38,9 @@ typedef enum
 } Error_delay_type;
 
 
+typedef struct Edit_queue Edit_queue;
+
+
 typedef struct Handle
 {
     bool data_is_valid;
@@ -48,6 +52,25 @@ typedef struct Handle
 
     Player* player;
     Player* length_counter;
+
+    // Connection preparation is postponed while a batch of data is parsed
+    bool defer_connections;
+    bool connections_changed;
+
+    // Edits staged and published for the playing thread
+    Edit_queue* edits;
+
+    // Parts of the composition changed since the last successful validation
+    bool validate_all;
+    bool changed_songs[KQT_SONGS_MAX];
+    bool changed_pats[KQT_PATTERNS_MAX];
+
+    // Cached track durations, negative if not calculated
+    int64_t track_durations[KQT_TRACKS_MAX];
+
+    // The latest profile returned by kqt_Handle_get_profile
+    char* profile;
+    size_t profile_capacity;
 } Handle;
 
 
@@ -62,6 +85,48 @@ typedef struct Handle
 bool Handle_init(Handle* handle);
 
 
+/**
+ * Create a new Edit queue.
+ *
+ * \return   The new Edit queue if successful, or \c NULL if memory
+ *           allocation failed.
+ */
+Edit_queue* new_Edit_queue(void);
+
+
+/**
+ * Take the edits published by kqt_Handle_commit_data into use.
+ *
+ * This is called by the thread that plays the Handle at a block boundary.
+ * The edits have been parsed by kqt_Handle_commit_data, so this call only
+ * replaces the changed parts of the composition. The call never waits for
+ * the thread that commits the edits; if the edits are being published at
+ * the same time, they are taken into use at the next call.
+ *
+ * \param handle   The Kunquat Handle -- must not be \c NULL.
+ */
+void Handle_apply_edits(Handle* handle);
+
+
+/**
+ * Destroy an existing Edit queue.
+ *
+ * \param queue   The Edit queue, or \c NULL.
+ */
+void del_Edit_queue(Edit_queue* queue);
+
+
+/**
+ * Discard cached information derived from the sequencing of the composition.
+ *
+ * This must be called whenever data that affects the playback order or
+ * timing of the composition changes.
+ *
+ * \param handle   The Kunquat Handle -- must not be \c NULL.
+ */
+void Handle_clear_sequence_caches(Handle* handle);
+
+
 /**
  * Set an error message for a Kunquat Handle.
  *
@@ -208,6 +273,19 @@ Handle* get_handle(kqt_Handle id);
     } else (void)0
 
 
+/**
+ * Check the format of a key.
+ *
+ * \param key     The key, or \c NULL.
+ * \param error   Destination for the error description -- must not be
+ *                \c NULL.
+ *
+ * \return   \c true if \a key is valid. Otherwise, \c false is returned and
+ *           \a error is set to indicate the error.
+ */
+bool key_format_is_valid(const char* key, Error* error);
+
+
 bool key_is_valid(Handle* handle, const char* key);
 
 
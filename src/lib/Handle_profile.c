@@ -0,0 +1,250 @@
+
+
+/*
+ * Author: Tomi Jylhä-Ollila, Finland 2014
+ *
+ * This file is part of Kunquat.
+ *
+ * CC0 1.0 Universal, http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * To the extent possible under law, Kunquat Affirmers have waived all
+ * copyright and related or neighboring rights to Kunquat.
+ */
+
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <debug/assert.h>
+#include <devices/Device.h>
+#include <devices/Effect.h>
+#include <devices/Instrument.h>
+#include <Handle_private.h>
+#include <kunquat/limits.h>
+#include <kunquat/Player.h>
+#include <memory.h>
+#include <module/Effect_table.h>
+#include <module/Ins_table.h>
+#include <module/Module.h>
+#include <player/Device_profile.h>
+#include <player/Device_states.h>
+#include <player/Player.h>
+
+
+#define PROFILE_ENTRY_LENGTH_MAX 128
+
+
+typedef struct Profile_writer
+{
+    Handle* handle;
+    const Device_states* states;
+    size_t length;
+} Profile_writer;
+
+
+static bool Profile_writer_append(Profile_writer* pw, const char* str)
+{
+    assert(pw != NULL);
+    assert(str != NULL);
+
+    Handle* handle = pw->handle;
+    const size_t str_length = strlen(str);
+
+    if (pw->length + str_length + 1 > handle->profile_capacity)
+    {
+        size_t new_capacity = (handle->profile_capacity > 0) ?
+            handle->profile_capacity : 1024;
+        while (new_capacity < pw->length + str_length + 1)
+            new_capacity *= 2;
+
+        char* new_profile = memory_realloc_items(
+                char, new_capacity, handle->profile);
+        if (new_profile == NULL)
+            return false;
+
+        handle->profile = new_profile;
+        handle->profile_capacity = new_capacity;
+    }
+
+    strcpy(handle->profile + pw->length, str);
+    pw->length += str_length;
+
+    return true;
+}
+
+
+static bool Profile_writer_add_device(
+        Profile_writer* pw, const Device* device, const char* name)
+{
+    assert(pw != NULL);
+    assert(name != NULL);
+
+    if (device == NULL)
+        return true;
+
+    const uint32_t id = Device_get_id(device);
+    if (!Device_states_has_state(pw->states, id))
+        return true;
+
+    const Device_state* ds = Device_states_get_state(pw->states, id);
+    const Device_profile* profile = &ds->profile;
+    if (profile->call_count == 0)
+        return true;
+
+    char entry[PROFILE_ENTRY_LENGTH_MAX] = "";
+    snprintf(
+            entry,
+            PROFILE_ENTRY_LENGTH_MAX,
+            "%s[\"%s\", %" PRId64 ", %" PRId64 ", %" PRId64 "]",
+            (pw->length > 1) ? ", " : "",
+            name,
+            profile->nanoseconds,
+            profile->call_count,
+            profile->frame_count);
+
+    return Profile_writer_append(pw, entry);
+}
+
+
+static bool Profile_writer_add_effect(
+        Profile_writer* pw, const Effect* eff, const char* name)
+{
+    assert(pw != NULL);
+    assert(name != NULL);
+
+    if (eff == NULL)
+        return true;
+
+    if (!Profile_writer_add_device(pw, (const Device*)eff, name))
+        return false;
+
+    for (int i = 0; i < KQT_DSPS_MAX; ++i)
+    {
+        char dsp_name[PROFILE_ENTRY_LENGTH_MAX] = "";
+        snprintf(dsp_name, PROFILE_ENTRY_LENGTH_MAX, "%s/dsp_%02x", name, i);
+        if (!Profile_writer_add_device(
+                    pw, (const Device*)Effect_get_dsp(eff, i), dsp_name))
+            return false;
+    }
+
+    return true;
+}
+
+
+static bool Profile_writer_add_instrument(
+        Profile_writer* pw, const Instrument* ins, const char* name)
+{
+    assert(pw != NULL);
+    assert(name != NULL);
+
+    if (ins == NULL)
+        return true;
+
+    for (int i = 0; i < KQT_GENERATORS_MAX; ++i)
+    {
+        char gen_name[PROFILE_ENTRY_LENGTH_MAX] = "";
+        snprintf(gen_name, PROFILE_ENTRY_LENGTH_MAX, "%s/gen_%02x", name, i);
+        if (!Profile_writer_add_device(
+                    pw, (const Device*)Instrument_get_gen(ins, i), gen_name))
+            return false;
+    }
+
+    for (int i = 0; i < KQT_INST_EFFECTS_MAX; ++i)
+    {
+        char eff_name[PROFILE_ENTRY_LENGTH_MAX] = "";
+        snprintf(eff_name, PROFILE_ENTRY_LENGTH_MAX, "%s/eff_%02x", name, i);
+        if (!Profile_writer_add_effect(
+                    pw, Instrument_get_effect(ins, i), eff_name))
+            return false;
+    }
+
+    return true;
+}
+
+
+static bool Handle_write_profile(Handle* handle)
+{
+    assert(handle != NULL);
+
+    Profile_writer* pw = &(Profile_writer){
+        .handle = handle,
+        .states = Player_get_device_states(handle->player),
+        .length = 0,
+    };
+
+    if (!Profile_writer_append(pw, "["))
+        return false;
+
+    Ins_table* insts = Module_get_insts(handle->module);
+    for (int i = 0; i < KQT_INSTRUMENTS_MAX; ++i)
+    {
+        char name[PROFILE_ENTRY_LENGTH_MAX] = "";
+        snprintf(name, PROFILE_ENTRY_LENGTH_MAX, "ins_%02x", i);
+        if (!Profile_writer_add_instrument(pw, Ins_table_get(insts, i), name))
+            return false;
+    }
+
+    const Effect_table* effects = Module_get_effects(handle->module);
+    for (int i = 0; i < KQT_EFFECTS_MAX; ++i)
+    {
+        char name[PROFILE_ENTRY_LENGTH_MAX] = "";
+        snprintf(name, PROFILE_ENTRY_LENGTH_MAX, "eff_%02x", i);
+        if (!Profile_writer_add_effect(pw, Effect_table_get(effects, i), name))
+            return false;
+    }
+
+    return Profile_writer_append(pw, "]");
+}
+
+
+int kqt_Handle_set_profiling_enabled(kqt_Handle handle, int enabled)
+{
+    check_handle(handle, 0);
+
+    Handle* h = get_handle(handle);
+    check_data_is_valid(h, 0);
+    check_data_is_validated(h, 0);
+
+    Device_states_set_profiling_enabled(
+            Player_get_device_states(h->player), enabled != 0);
+
+    return 1;
+}
+
+
+int kqt_Handle_get_profiling_enabled(kqt_Handle handle)
+{
+    check_handle(handle, 0);
+
+    Handle* h = get_handle(handle);
+    check_data_is_valid(h, 0);
+    check_data_is_validated(h, 0);
+
+    return Device_states_is_profiling_enabled(
+            Player_get_device_states(h->player)) ? 1 : 0;
+}
+
+
+const char* kqt_Handle_get_profile(kqt_Handle handle)
+{
+    check_handle(handle, NULL);
+
+    Handle* h = get_handle(handle);
+    check_data_is_valid(h, NULL);
+    check_data_is_validated(h, NULL);
+
+    if (!Handle_write_profile(h))
+    {
+        Handle_set_error(h, ERROR_MEMORY,
+                "Couldn't allocate memory for the profile");
+        return NULL;
+    }
+
+    return h->profile;
+}
+
+
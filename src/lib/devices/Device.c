@@ -21,6 +21,8 @@
 #include <devices/Device.h>
 #include <devices/Device_impl.h>
 #include <mathnum/common.h>
+#include <player/Device_profile.h>
+#include <player/Device_states.h>
 #include <string/common.h>
 
 
@@ -485,8 +487,25 @@ void Device_process(
     assert(isfinite(tempo));
     assert(tempo > 0);
 
-    if (device->process != NULL)
+    if (device->process == NULL)
+        return;
+
+    if (!Device_states_is_profiling_enabled(states))
+    {
         device->process(device, states, start, until, freq, tempo);
+        return;
+    }
+
+    // Each Device is processed by one thread at a time, so no locking needed
+    const int64_t start_time = Device_profile_get_time();
+    device->process(device, states, start, until, freq, tempo);
+    const int64_t elapsed = Device_profile_get_time() - start_time;
+
+    Device_states_add_profile(
+            states,
+            Device_get_id(device),
+            max(elapsed, 0),
+            (until > start) ? (int64_t)(until - start) : 0);
 
     return;
 }
@@ -134,7 +134,8 @@ Device_field* new_Device_field(const char* key, void* data)
 }
 
 
-Device_field* new_Device_field_from_data(const char* key, Streader* sr)
+Device_field* new_Device_field_from_data(
+        const char* key, Streader* sr, Sample_cache* cache)
 {
     assert(key != NULL);
     assert(sr != NULL);
@@ -150,7 +151,7 @@ Device_field* new_Device_field_from_data(const char* key, Streader* sr)
         return NULL;
     }
 
-    if (!Device_field_change(field, sr))
+    if (!Device_field_change(field, sr, cache))
     {
         del_Device_field(field);
         return NULL;
@@ -167,7 +168,8 @@ const char* Device_field_get_key(const Device_field* field)
 }
 
 
-bool Device_field_change(Device_field* field, Streader* sr)
+bool Device_field_change(
+        Device_field* field, Streader* sr, Sample_cache* cache)
 {
     assert(field != NULL);
     assert(field->type != DEVICE_FIELD_NONE);
@@ -245,13 +247,21 @@ bool Device_field_change(Device_field* field, Streader* sr)
         case DEVICE_FIELD_WAVPACK:
         {
             Sample* sample = NULL;
-            if (data != NULL)
+            if (data != NULL && cache != NULL)
+                sample = Sample_cache_take_decoded(cache, sr->str, sr->len);
+
+            if (data != NULL && sample == NULL)
             {
                 sample = new_Sample();
                 if (sample == NULL)
                     return false;
 
-                if (!Sample_parse_wavpack(sample, sr))
+                const bool lazy =
+                    (cache != NULL) && (Sample_cache_get_limit(cache) > 0);
+                const bool success = lazy
+                    ? Sample_parse_wavpack_lazy(sample, sr, cache)
+                    : Sample_parse_wavpack(sample, sr);
+                if (!success)
                 {
                     del_Sample(sample);
                     return false;
@@ -24,6 +24,7 @@
 #include <devices/param_types/Note_map.h>
 #include <devices/param_types/Num_list.h>
 #include <devices/param_types/Sample.h>
+#include <devices/param_types/Sample_cache.h>
 #include <devices/param_types/Sample_params.h>
 #include <mathnum/Real.h>
 #include <string/Streader.h>
@@ -80,12 +81,15 @@ Device_field* new_Device_field(const char* key, void* data);
 /**
  * Create a new Device field from data.
  *
- * \param key   The key of the field -- must be a valid Device field key.
- * \param sr    The Streader of the data -- must not be \c NULL.
+ * \param key     The key of the field -- must be a valid Device field key.
+ * \param sr      The Streader of the data -- must not be \c NULL.
+ * \param cache   The Sample cache used for decoding Samples lazily, or
+ *                \c NULL if Samples should be decoded immediately.
  *
  * \return   The new Device field if successful, otherwise \c NULL.
  */
-Device_field* new_Device_field_from_data(const char* key, Streader* sr);
+Device_field* new_Device_field_from_data(
+        const char* key, Streader* sr, Sample_cache* cache);
 
 
 /**
@@ -105,10 +109,13 @@ const char* Device_field_get_key(const Device_field* field);
  *
  * \param field   The Device field -- must not be \c NULL.
  * \param sr      The Streader of the data -- must not be \c NULL.
+ * \param cache   The Sample cache used for decoding Samples lazily, or
+ *                \c NULL if Samples should be decoded immediately.
  *
  * \return   \c true if successful, otherwise \c false.
  */
-bool Device_field_change(Device_field* field, Streader* sr);
+bool Device_field_change(
+        Device_field* field, Streader* sr, Sample_cache* cache);
 
 
 /**
@@ -92,6 +92,7 @@ struct Device_params
 {
     AAtree* implement;       ///< The implementation part of the device.
     AAtree* config;          ///< The configuration part of the device.
+    Sample_cache* sample_cache; ///< The cache for lazily decoded Samples.
 #if 0
     AAtree* slow_sync;       ///< Keys that require explicit synchronisation.
     AAiter* slow_sync_iter;  ///< Iterator for slow_sync.
@@ -230,6 +231,7 @@ Device_params* new_Device_params(void)
 
     params->implement = NULL;
     params->config = NULL;
+    params->sample_cache = NULL;
 #if 0
     params->slow_sync = NULL;
     params->slow_sync_iter = NULL;
@@ -263,6 +265,14 @@ Device_params* new_Device_params(void)
 }
 
 
+void Device_params_set_sample_cache(Device_params* params, Sample_cache* cache)
+{
+    assert(params != NULL);
+    params->sample_cache = cache;
+    return;
+}
+
+
 #if 0
 bool Device_params_set_key(Device_params* params, const char* key)
 {
@@ -559,11 +569,11 @@ bool Device_params_parse_value(
     bool success = true;
     if (field != NULL)
     {
-        success = Device_field_change(field, sr);
+        success = Device_field_change(field, sr, params->sample_cache);
     }
     else
     {
-        field = new_Device_field_from_data(key, sr);
+        field = new_Device_field_from_data(key, sr, params->sample_cache);
         if (field == NULL)
             return false;
 
@@ -113,6 +113,16 @@ bool key_is_text_device_param(const char* key);
 Device_params* new_Device_params(void);
 
 
+/**
+ * Set the Sample cache used for decoding Samples lazily.
+ *
+ * \param params   The Device parameters -- must not be \c NULL.
+ * \param cache    The Sample cache, or \c NULL if Samples should always be
+ *                 decoded immediately.
+ */
+void Device_params_set_sample_cache(Device_params* params, Sample_cache* cache);
+
+
 /**
  * Allocate memory for a key.
  *
@@ -180,15 +180,10 @@ void Effect_set_connections(Effect* eff, Connections* graph)
 }
 
 
-bool Effect_prepare_connections(const Effect* eff, Device_states* states)
+Connections* Effect_get_connections(const Effect* eff)
 {
     assert(eff != NULL);
-    assert(states != NULL);
-
-    if (eff->connections == NULL)
-        return true;
-
-    return Connections_prepare(eff->connections, states);
+    return eff->connections;
 }
 
 
@@ -392,11 +387,6 @@ static void Effect_process(
     }
     else if (eff->connections != NULL)
     {
-#ifndef NDEBUG
-        static bool in_effect = false;
-        assert(!in_effect);
-        in_effect = true;
-#endif
         Connections_clear_buffers(eff->connections, states, start, until);
 
         // Fill input interface buffers
@@ -407,15 +397,13 @@ static void Effect_process(
         mix_interface_connection(in_iface_ds, ds, start, until);
 
         // Process effect graph
-        Connections_mix(eff->connections, states, start, until, freq, tempo);
+        Connections_mix(
+                eff->connections, states, NULL, start, until, freq, tempo);
 
         // Fill output interface buffers
         Device_state* out_iface_ds = Device_states_get_state(
                 states, Device_get_id(Effect_get_output_interface(eff)));
         mix_interface_connection(ds, out_iface_ds, start, until);
-#ifndef NDEBUG
-        in_effect = false;
-#endif
     }
 
     return;
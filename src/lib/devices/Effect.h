@@ -92,17 +92,13 @@ void Effect_set_connections(Effect* eff, Connections* graph);
 
 
 /**
- * Prepare the Connections of the Effect.
+ * Get the Connections of the Effect.
  *
- * This function assumes that the outer input and output buffers of the Effect
- * have been allocated.
- *
- * \param eff      The Effect -- must not be \c NULL.
- * \param states   The Device states -- must not be \c NULL.
+ * \param eff   The Effect -- must not be \c NULL.
  *
- * \return   \c true if successful, or \c false if memory allocation failed.
+ * \return   The Connections, or \c NULL if not set.
  */
-bool Effect_prepare_connections(const Effect* eff, Device_states* states);
+Connections* Effect_get_connections(const Effect* eff);
 
 
 /**
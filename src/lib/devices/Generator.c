@@ -84,6 +84,7 @@ Generator* new_Generator(const Instrument_params* ins_params)
     gen->ins_params = ins_params;
 
     gen->init_vstate = NULL;
+    gen->clear_vstate = NULL;
     gen->mix = NULL;
 
     Device_set_state_creator(
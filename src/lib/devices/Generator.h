@@ -46,6 +46,7 @@ typedef struct Generator
             const struct Generator*,
             const Gen_state*,
             Voice_state*);
+    void (*clear_vstate)(const struct Generator*, Voice_state*);
     uint32_t (*mix)(
             const struct Generator*,
             Gen_state*,
@@ -23,7 +23,9 @@
 #include <devices/DSP.h>
 #include <devices/dsps/DSP_common.h>
 #include <devices/dsps/DSP_conv.h>
+#include <devices/param_types/Sample_cache.h>
 #include <mathnum/common.h>
+#include <mathnum/Part_conv.h>
 #include <memory.h>
 #include <string/common.h>
 
@@ -50,13 +52,67 @@ typedef struct Conv_state
 {
     DSP_state parent;
 
-    Audio_buffer* history;
-    int32_t history_pos;
+    // Impulse response partitioned for the audio rate of the state
+    Part_conv* pc;
 
     double scale;
 } Conv_state;
 
 
+static bool Conv_state_update_ir(
+        Conv_state* cstate, const DSP_conv* conv, int32_t audio_rate)
+{
+    assert(cstate != NULL);
+    assert(conv != NULL);
+    assert(audio_rate > 0);
+
+    if (conv->actual_ir_len <= 0)
+        return Part_conv_set_ir(cstate->pc, (float*[]){ NULL, NULL }, 0);
+
+    // Resample the impulse response to the audio rate of the state
+    const int32_t ir_size = Audio_buffer_get_size(conv->ir);
+    const int32_t tap_count_max =
+        max(1L, (long)(conv->max_ir_len * audio_rate));
+    const double ir_scale_fac = (double)ir_size / (double)tap_count_max;
+
+    int32_t tap_count = 0;
+    while (tap_count < tap_count_max &&
+            (int32_t)(ir_scale_fac * tap_count) < conv->actual_ir_len)
+        ++tap_count;
+
+    float* taps = memory_alloc_items(float, tap_count * 2);
+    if (taps == NULL)
+        return false;
+
+    float* ir[] = { taps, taps + tap_count };
+
+    const kqt_frame* ir_data[] =
+    {
+        Audio_buffer_get_buffer(conv->ir, 0),
+        Audio_buffer_get_buffer(conv->ir, 1),
+    };
+
+    for (int32_t tap = 0; tap < tap_count; ++tap)
+    {
+        const double ir_pos = ir_scale_fac * tap;
+        const int32_t ir_sample_pos = (int32_t)ir_pos;
+        const double ir_sample_rem = ir_pos - floor(ir_pos);
+
+        const bool has_next = (ir_sample_pos + 1 < ir_size);
+        for (int ch = 0; ch < 2; ++ch)
+            ir[ch][tap] = lerp(
+                    ir_data[ch][ir_sample_pos],
+                    has_next ? ir_data[ch][ir_sample_pos + 1] : 0.0f,
+                    ir_sample_rem);
+    }
+
+    const bool success = Part_conv_set_ir(cstate->pc, ir, tap_count);
+    memory_free(taps);
+
+    return success;
+}
+
+
 static void Conv_state_reset(Conv_state* cstate, const DSP_conv* conv)
 {
     assert(cstate != NULL);
@@ -64,10 +120,7 @@ static void Conv_state_reset(Conv_state* cstate, const DSP_conv* conv)
 
     DSP_state_reset(&cstate->parent);
 
-    Audio_buffer_clear(
-            cstate->history,
-            0, Audio_buffer_get_size(cstate->history));
-    cstate->history_pos = 0;
+    Part_conv_clear(cstate->pc);
 
     cstate->scale = conv->scale;
 
@@ -80,11 +133,8 @@ static void del_Conv_state(Device_state* dev_state)
     assert(dev_state != NULL);
 
     Conv_state* cstate = (Conv_state*)dev_state;
-    if (cstate->history != NULL)
-    {
-        del_Audio_buffer(cstate->history);
-        cstate->history = NULL;
-    }
+    del_Part_conv(cstate->pc);
+    cstate->pc = NULL;
 
     return;
 }
@@ -95,7 +145,7 @@ static Device_state* DSP_conv_create_state(
         int32_t audio_rate,
         int32_t audio_buffer_size);
 
-static void DSP_conv_update_ir(DSP_conv* conv);
+static bool DSP_conv_update_ir(DSP_conv* conv);
 
 static void DSP_conv_reset(const Device_impl* dimpl, Device_state* dstate);
 
@@ -114,6 +164,12 @@ static bool DSP_conv_set_volume(
         Device_key_indices indices,
         double value);
 
+static bool DSP_conv_set_state_ir(
+        const Device_impl* dimpl,
+        Device_state* dstate,
+        Device_key_indices indices,
+        const Sample* value);
+
 static bool DSP_conv_set_state_volume(
         const Device_impl* dimpl,
         Device_state* dstate,
@@ -183,7 +239,11 @@ Device_impl* new_DSP_conv(DSP* dsp)
             DSP_conv_set_max_ir_len,
             DSP_conv_set_state_max_ir_len);
     reg_success &= Device_impl_register_set_sample(
-            &conv->parent, "p_ir.wv", NULL, DSP_conv_set_ir, NULL);
+            &conv->parent,
+            "p_ir.wv",
+            NULL,
+            DSP_conv_set_ir,
+            DSP_conv_set_state_ir);
     reg_success &= Device_impl_register_set_float(
             &conv->parent,
             "p_f_volume.json",
@@ -237,17 +297,16 @@ static Device_state* DSP_conv_create_state(
     cstate->parent.parent.destroy = del_Conv_state;
 
     // Sanitise fields
-    cstate->history = NULL;
-    cstate->history_pos = 0;
+    cstate->pc = NULL;
     cstate->scale = 1.0;
 
     const DSP_conv* conv = (const DSP_conv*)device->dimpl;
 
-    const long buf_size = conv->max_ir_len * audio_rate;
-    cstate->history = new_Audio_buffer(buf_size);
-    if (cstate->history == NULL)
+    cstate->pc = new_Part_conv();
+    if (cstate->pc == NULL ||
+            !Conv_state_update_ir(cstate, conv, audio_rate))
     {
-        del_Audio_buffer(cstate->history);
+        del_Device_state(&cstate->parent.parent);
         return NULL;
     }
 
@@ -282,9 +341,7 @@ static bool DSP_conv_set_max_ir_len(
     conv->max_ir_len = (value > 0 && value <= MAX_BUF_TIME)
         ? value : DEFAULT_IR_LEN;
 
-    DSP_conv_update_ir(conv);
-
-    return true;
+    return DSP_conv_update_ir(conv);
 }
 
 
@@ -313,9 +370,7 @@ static bool DSP_conv_set_ir(
     else if (!Audio_buffer_resize(conv->ir, buf_size))
         return false;
 
-    DSP_conv_update_ir((DSP_conv*)dimpl);
-
-    return true;
+    return DSP_conv_update_ir((DSP_conv*)dimpl);
 }
 
 
@@ -342,6 +397,26 @@ static bool DSP_conv_set_volume(
 }
 
 
+static bool DSP_conv_set_state_ir(
+        const Device_impl* dimpl,
+        Device_state* dstate,
+        Device_key_indices indices,
+        const Sample* value)
+{
+    assert(dimpl != NULL);
+    assert(dstate != NULL);
+    assert(indices != NULL);
+    (void)indices;
+    (void)value;
+
+    const DSP_conv* conv = (const DSP_conv*)dimpl;
+    Conv_state* cstate = (Conv_state*)dstate;
+
+    return Conv_state_update_ir(
+            cstate, conv, Device_state_get_audio_rate(dstate));
+}
+
+
 static bool DSP_conv_set_state_volume(
         const Device_impl* dimpl,
         Device_state* dstate,
@@ -367,20 +442,14 @@ static bool DSP_conv_set_state_max_ir_len(
     assert(dimpl != NULL);
     assert(dstate != NULL);
     assert(indices != NULL);
-    (void)dimpl;
     (void)indices;
+    (void)value;
 
+    const DSP_conv* conv = (const DSP_conv*)dimpl;
     Conv_state* cstate = (Conv_state*)dstate;
 
-    int32_t buf_size = max(
-            Audio_buffer_get_size(cstate->history),
-            value * Device_state_get_audio_rate(dstate));
-    assert(buf_size > 0);
-
-    if (!Audio_buffer_resize(cstate->history, buf_size))
-        return false;
-
-    return true;
+    return Conv_state_update_ir(
+            cstate, conv, Device_state_get_audio_rate(dstate));
 }
 
 
@@ -412,9 +481,7 @@ static void DSP_conv_clear_history(
     (void)dimpl;
 
     Conv_state* cstate = (Conv_state*)dsp_state;
-    Audio_buffer_clear(
-            cstate->history,
-            0, Audio_buffer_get_size(cstate->history));
+    Part_conv_clear(cstate->pc);
 
     return;
 }
@@ -432,19 +499,7 @@ static bool DSP_conv_set_audio_rate(
     const DSP_conv* conv = (const DSP_conv*)dimpl;
     Conv_state* cstate = (Conv_state*)dstate;
 
-    long buf_size = conv->max_ir_len * audio_rate;
-    if (buf_size <= 0)
-        buf_size = 1;
-
-    assert(cstate->history != NULL);
-    if (!Audio_buffer_resize(cstate->history, buf_size))
-        return false;
-
-    Audio_buffer_clear(conv->ir, 0, buf_size);
-    Audio_buffer_clear(cstate->history, 0, buf_size);
-    cstate->history_pos = 0;
-
-    return true;
+    return Conv_state_update_ir(cstate, conv, audio_rate);
 }
 
 
@@ -458,7 +513,7 @@ static bool DSP_conv_set_audio_rate(
         val_r /= divisor;                            \
     } else (void)0
 
-static void DSP_conv_update_ir(DSP_conv* conv)
+static bool DSP_conv_update_ir(DSP_conv* conv)
 {
     assert(conv != NULL);
 
@@ -466,14 +521,26 @@ static void DSP_conv_update_ir(DSP_conv* conv)
     if (params == NULL)
     {
         conv->actual_ir_len = 0;
-        return;
+        return true;
     }
 
-    const Sample* sample = Device_params_get_sample(params, "p_ir.wv");
-    if (sample == NULL)
+    const Sample* stored = Device_params_get_sample(params, "p_ir.wv");
+    if (stored == NULL || conv->ir == NULL)
     {
         conv->actual_ir_len = 0;
-        return;
+        return true;
+    }
+
+    // Decode the impulse response if it is loaded lazily
+    const Sample* sample = stored;
+    if (stored->source != NULL)
+    {
+        sample = Sample_source_acquire(stored->source);
+        if (sample == NULL)
+        {
+            conv->actual_ir_len = 0;
+            return true;
+        }
     }
 
     int32_t ir_size = Audio_buffer_get_size(conv->ir);
@@ -505,7 +572,10 @@ static void DSP_conv_update_ir(DSP_conv* conv)
         ir_data[1][i] = val_r;
     }
 
-    return;
+    if (stored->source != NULL)
+        Sample_source_release(stored->source);
+
+    return true;
 }
 
 #undef get_values
@@ -530,76 +600,14 @@ static void DSP_conv_process(
             dstates,
             Device_get_id(device));
 
-    DSP_conv* conv = (DSP_conv*)device->dimpl;
     //assert(string_eq(conv->parent.type, "convolution"));
     kqt_frame* in_data[] = { NULL, NULL };
     kqt_frame* out_data[] = { NULL, NULL };
     DSP_get_raw_input(&cstate->parent.parent, 0, in_data);
     DSP_get_raw_output(&cstate->parent.parent, 0, out_data);
 
-    kqt_frame* ir_data[] =
-    {
-        Audio_buffer_get_buffer(conv->ir, 0),
-        Audio_buffer_get_buffer(conv->ir, 1),
-    };
-    kqt_frame* history_data[] =
-    {
-        Audio_buffer_get_buffer(cstate->history, 0),
-        Audio_buffer_get_buffer(cstate->history, 1),
-    };
-
-    const int32_t ir_size = Audio_buffer_get_size(conv->ir);
-    const int32_t history_size = Audio_buffer_get_size(cstate->history);
-
-    const double ir_scale_fac = (double)ir_size / (double)history_size;
-
-    for (int32_t out_pos = start; out_pos < (int32_t)until; ++out_pos)
-    {
-        kqt_frame out_l = 0;
-        kqt_frame out_r = 0;
-        int32_t history_pos = cstate->history_pos;
-        history_data[0][history_pos] = in_data[0][out_pos];
-        history_data[1][history_pos] = in_data[1][out_pos];
-
-        for (int32_t i = 0; i < history_size; ++i)
-        {
-            // Get ir position
-            double ir_pos = ir_scale_fac * i;
-            int32_t ir_sample_pos = (int32_t)ir_pos;
-            double ir_sample_rem = ir_pos - floor(ir_pos);
-
-            if (ir_sample_pos >= ir_size)
-                break;
-
-            // Get ir value
-            float cur_val_l = ir_data[0][ir_sample_pos];
-            float cur_val_r = ir_data[1][ir_sample_pos];
-            float next_val_l = 0.0;
-            float next_val_r = 0.0;
-            if (ir_sample_pos + 1 < ir_size)
-            {
-                next_val_l = ir_data[0][ir_sample_pos + 1];
-                next_val_r = ir_data[1][ir_sample_pos + 1];
-            }
-
-            float ir_val_l = lerp(cur_val_l, next_val_l, ir_sample_rem);
-            float ir_val_r = lerp(cur_val_r, next_val_r, ir_sample_rem);
-
-            out_l += history_data[0][history_pos] * ir_val_l * cstate->scale;
-            out_r += history_data[1][history_pos] * ir_val_r * cstate->scale;
-
-            --history_pos;
-            if (history_pos < 0)
-                history_pos = conv->actual_ir_len - 1;
-        }
-
-        out_data[0][out_pos] += out_l;
-        out_data[1][out_pos] += out_r;
-
-        ++cstate->history_pos;
-        if (cstate->history_pos >= conv->actual_ir_len)
-            cstate->history_pos = 0;
-    }
+    Part_conv_process(
+            cstate->pc, in_data, out_data, start, until, cstate->scale);
 
     return;
 }
@@ -25,8 +25,8 @@
 /**
  * Create a new convolution DSP.
  *
- * The convolution algorithm used in this DSP is only suitable for very short
- * impulse responses.
+ * The impulse response is applied with uniformly partitioned FFT convolution.
+ * Each DSP state keeps its own partitions for its audio rate.
  *
  * \param buffer_size   The size of the buffers -- must be > \c 0 and
  *                      <= \c KQT_BUFFER_SIZE_MAX.
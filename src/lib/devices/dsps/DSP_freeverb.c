@@ -33,6 +33,7 @@
 
 #define FREEVERB_COMBS 8
 #define FREEVERB_ALLPASSES 4
+#define FREEVERB_CHUNK_SIZE 256
 
 
 static const double initial_reflect = 20;
@@ -550,30 +551,51 @@ static void DSP_freeverb_process(
     DSP_get_raw_input(&fstate->parent.parent, 0, in_data);
     DSP_get_raw_output(&fstate->parent.parent, 0, out_data);
 
-    for (uint32_t i = start; i < until; ++i)
+    // Process the filter bank in chunks that fit in our local buffers
+    for (uint32_t chunk_start = start; chunk_start < until;
+            chunk_start += FREEVERB_CHUNK_SIZE)
     {
-        kqt_frame out_l = 0;
-        kqt_frame out_r = 0;
-        kqt_frame input = (in_data[0][i] + in_data[1][i]) * freeverb->gain;
+        const uint32_t chunk_size = min(
+                until - chunk_start, FREEVERB_CHUNK_SIZE);
+
+        kqt_frame input[FREEVERB_CHUNK_SIZE];
+        kqt_frame out_l[FREEVERB_CHUNK_SIZE];
+        kqt_frame out_r[FREEVERB_CHUNK_SIZE];
+
+        for (uint32_t i = 0; i < chunk_size; ++i)
+        {
+            const uint32_t in_i = chunk_start + i;
+            input[i] = (in_data[0][in_i] + in_data[1][in_i]) * freeverb->gain;
+            out_l[i] = 0;
+            out_r[i] = 0;
+        }
 
         for (int comb = 0; comb < FREEVERB_COMBS; ++comb)
         {
-            out_l += Freeverb_comb_process(fstate->comb_left[comb], input);
-            out_r += Freeverb_comb_process(fstate->comb_right[comb], input);
+            Freeverb_comb_process_buffer(
+                    fstate->comb_left[comb], input, out_l, 0, chunk_size);
+            Freeverb_comb_process_buffer(
+                    fstate->comb_right[comb], input, out_r, 0, chunk_size);
         }
 
         for (int allpass = 0; allpass < FREEVERB_ALLPASSES; ++allpass)
         {
-            out_l = Freeverb_allpass_process(
-                    fstate->allpass_left[allpass], out_l);
-            out_r = Freeverb_allpass_process(
-                    fstate->allpass_right[allpass], out_r);
+            Freeverb_allpass_process_buffer(
+                    fstate->allpass_left[allpass], out_l, 0, chunk_size);
+            Freeverb_allpass_process_buffer(
+                    fstate->allpass_right[allpass], out_r, 0, chunk_size);
         }
 
-        out_data[0][i] += out_l * freeverb->wet1 + out_r * freeverb->wet2
-                                  /* + in_data[0][i] * freeverb->dry */;
-        out_data[1][i] += out_r * freeverb->wet1 + out_l * freeverb->wet2
-                                  /* + in_data[1][i] * freeverb->dry */;
+        for (uint32_t i = 0; i < chunk_size; ++i)
+        {
+            const uint32_t out_i = chunk_start + i;
+            out_data[0][out_i] += out_l[i] * freeverb->wet1 +
+                                  out_r[i] * freeverb->wet2
+                                  /* + in_data[0][out_i] * freeverb->dry */;
+            out_data[1][out_i] += out_r[i] * freeverb->wet1 +
+                                  out_l[i] * freeverb->wet2
+                                  /* + in_data[1][out_i] * freeverb->dry */;
+        }
     }
 
     return;
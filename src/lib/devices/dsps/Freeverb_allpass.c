@@ -82,6 +82,47 @@ kqt_frame Freeverb_allpass_process(Freeverb_allpass* allpass, kqt_frame input)
 }
 
 
+void Freeverb_allpass_process_buffer(
+        Freeverb_allpass* allpass,
+        kqt_frame* buf,
+        uint32_t start,
+        uint32_t until)
+{
+    assert(allpass != NULL);
+    assert(buf != NULL);
+    assert(start <= until);
+
+    const kqt_frame feedback = allpass->feedback;
+
+    uint32_t i = start;
+    while (i < until)
+    {
+        // Process up to the end of the internal buffer without wrapping
+        const uint32_t seg_len = min(
+                until - i, allpass->buffer_size - allpass->buffer_pos);
+        kqt_frame* buffer = allpass->buffer + allpass->buffer_pos;
+        kqt_frame* seg = buf + i;
+
+        for (uint32_t k = 0; k < seg_len; ++k)
+        {
+            const kqt_frame input = seg[k];
+            kqt_frame bufout = buffer[k];
+            bufout = undenormalise(bufout);
+            buffer[k] = input + (bufout * feedback);
+            seg[k] = -input + bufout;
+        }
+
+        allpass->buffer_pos += seg_len;
+        if (allpass->buffer_pos >= allpass->buffer_size)
+            allpass->buffer_pos = 0;
+
+        i += seg_len;
+    }
+
+    return;
+}
+
+
 bool Freeverb_allpass_resize_buffer(Freeverb_allpass* allpass, uint32_t new_size)
 {
     assert(allpass != NULL);
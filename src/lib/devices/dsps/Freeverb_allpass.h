@@ -61,6 +61,23 @@ void Freeverb_allpass_set_feedback(Freeverb_allpass* allpass, kqt_frame feedback
 kqt_frame Freeverb_allpass_process(Freeverb_allpass* allpass, kqt_frame input);
 
 
+/**
+ * Process a range of frames in place.
+ *
+ * \param allpass   The Freeverb allpass filter -- must not be \c NULL.
+ * \param buf       The buffer containing the input, replaced with the output
+ *                  -- must not be \c NULL.
+ * \param start     The first frame to be processed -- must be less than or
+ *                  equal to \a until.
+ * \param until     The first frame not to be processed.
+ */
+void Freeverb_allpass_process_buffer(
+        Freeverb_allpass* allpass,
+        kqt_frame* buf,
+        uint32_t start,
+        uint32_t until);
+
+
 /**
  * Resize the internal buffer of the Freeverb allpass filter.
  *
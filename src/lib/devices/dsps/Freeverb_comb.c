@@ -108,6 +108,57 @@ kqt_frame Freeverb_comb_process(Freeverb_comb* comb, kqt_frame input)
 }
 
 
+void Freeverb_comb_process_buffer(
+        Freeverb_comb* comb,
+        const kqt_frame* in_buf,
+        kqt_frame* out_buf,
+        uint32_t start,
+        uint32_t until)
+{
+    assert(comb != NULL);
+    assert(in_buf != NULL);
+    assert(out_buf != NULL);
+    assert(in_buf != out_buf);
+    assert(start <= until);
+
+    const kqt_frame feedback = comb->feedback;
+    const kqt_frame damp1 = comb->damp1;
+    const kqt_frame damp2 = comb->damp2;
+    kqt_frame filter_store = comb->filter_store;
+
+    uint32_t i = start;
+    while (i < until)
+    {
+        // Process up to the end of the internal buffer without wrapping
+        const uint32_t seg_len = min(
+                until - i, comb->buffer_size - comb->buffer_pos);
+        kqt_frame* buffer = comb->buffer + comb->buffer_pos;
+        const kqt_frame* seg_in = in_buf + i;
+        kqt_frame* seg_out = out_buf + i;
+
+        for (uint32_t k = 0; k < seg_len; ++k)
+        {
+            kqt_frame output = buffer[k];
+            output = undenormalise(output);
+            filter_store = (output * damp2) + (filter_store * damp1);
+            filter_store = undenormalise(filter_store);
+            buffer[k] = seg_in[k] + (filter_store * feedback);
+            seg_out[k] += output;
+        }
+
+        comb->buffer_pos += seg_len;
+        if (comb->buffer_pos >= comb->buffer_size)
+            comb->buffer_pos = 0;
+
+        i += seg_len;
+    }
+
+    comb->filter_store = filter_store;
+
+    return;
+}
+
+
 bool Freeverb_comb_resize_buffer(Freeverb_comb* comb, uint32_t new_size)
 {
     assert(comb != NULL);
@@ -68,6 +68,27 @@ void Freeverb_comb_set_feedback(Freeverb_comb* comb, kqt_frame feedback);
 kqt_frame Freeverb_comb_process(Freeverb_comb* comb, kqt_frame input);
 
 
+/**
+ * Process a range of frames.
+ *
+ * The output of the Freeverb comb filter is added to the existing contents
+ * of \a out_buf.
+ *
+ * \param comb      The Freeverb comb filter -- must not be \c NULL.
+ * \param in_buf    The input buffer -- must not be \c NULL.
+ * \param out_buf   The output buffer -- must not be \c NULL or \a in_buf.
+ * \param start     The first frame to be processed -- must be less than or
+ *                  equal to \a until.
+ * \param until     The first frame not to be processed.
+ */
+void Freeverb_comb_process_buffer(
+        Freeverb_comb* comb,
+        const kqt_frame* in_buf,
+        kqt_frame* out_buf,
+        uint32_t start,
+        uint32_t until);
+
+
 /**
  * Resize the internal buffer of the Freeverb comb filter.
  *
@@ -32,6 +32,7 @@
 
 
 #define BASE_FUNC_SIZE 4096
+#define ADD_BLOCK_SIZE 64
 
 
 typedef struct Add_tone
@@ -356,7 +357,7 @@ static void Generator_add_init_vstate(
             continue;
 
         add_state->tone_limit = h + 1;
-        add_state->tones[h].phase = 0;
+        add_state->tone_phases[h] = 0;
     }
 
     for (int h = 0; h < HARMONICS_MAX; ++h)
@@ -366,7 +367,7 @@ static void Generator_add_init_vstate(
             continue;
 
         add_state->mod_tone_limit = h + 1;
-        add_state->mod_tones[h].phase = 0;
+        add_state->mod_tone_phases[h] = 0;
     }
 
     add_state->mod_active = add->mod_mode != MOD_DISABLED;
@@ -380,6 +381,210 @@ static void Generator_add_init_vstate(
 }
 
 
+/**
+ * The active tones of a Voice in structure-of-arrays form.
+ *
+ * The tones are gathered at the start of each block so that the inner loops
+ * process contiguous arrays without skipping disabled tones.
+ */
+typedef struct Add_tone_block
+{
+    int count;
+    int indices[HARMONICS_MAX];
+    double phases[HARMONICS_MAX];
+    double pitch_factors[HARMONICS_MAX];
+    double volumes[KQT_BUFFERS_MAX][HARMONICS_MAX];
+} Add_tone_block;
+
+
+static void Add_tone_block_init(
+        Add_tone_block* block,
+        const Add_tone* tones,
+        int tone_limit,
+        const double* phases,
+        double volume)
+{
+    assert(block != NULL);
+    assert(tones != NULL);
+    assert(tone_limit >= 0);
+    assert(tone_limit <= HARMONICS_MAX);
+    assert(phases != NULL);
+
+    block->count = 0;
+
+    for (int h = 0; h < tone_limit; ++h)
+    {
+        if (tones[h].pitch_factor <= 0 || tones[h].volume_factor <= 0)
+            continue;
+
+        const int i = block->count;
+        block->indices[i] = h;
+        block->phases[i] = phases[h];
+        block->pitch_factors[i] = tones[h].pitch_factor;
+        block->volumes[0][i] =
+            tones[h].volume_factor * volume * (1 - tones[h].panning);
+        block->volumes[1][i] =
+            tones[h].volume_factor * volume * (1 + tones[h].panning);
+        ++block->count;
+    }
+
+    return;
+}
+
+
+static void Add_tone_block_store_phases(
+        const Add_tone_block* block, double* phases)
+{
+    assert(block != NULL);
+    assert(phases != NULL);
+
+    for (int i = 0; i < block->count; ++i)
+        phases[block->indices[i]] = block->phases[i];
+
+    return;
+}
+
+
+static inline double get_base_value(const float* buf, double phase)
+{
+    assert(buf != NULL);
+
+    const double pos = phase * BASE_FUNC_SIZE;
+    const int32_t pos_int = (int32_t)pos;
+    const int32_t pos1 = pos_int & (BASE_FUNC_SIZE - 1);
+    const int32_t pos2 = (pos1 + 1) & (BASE_FUNC_SIZE - 1);
+    const float frame = buf[pos1];
+    const float frame_diff = buf[pos2] - frame;
+
+    // Branch-free equivalent of pos - floor(pos)
+    double remainder = pos - pos_int;
+    remainder += (remainder < 0);
+
+    return frame + remainder * frame_diff;
+}
+
+
+// Note: The loops below contain no branches so that they can be vectorised
+
+static double Add_tone_block_sum(
+        Add_tone_block* restrict block,
+        const float* restrict buf,
+        double phase_step)
+{
+    assert(block != NULL);
+    assert(buf != NULL);
+
+    const int count = block->count;
+    double* restrict phases = block->phases;
+    const double* restrict pitch_factors = block->pitch_factors;
+    const double* restrict volumes = block->volumes[0];
+
+    double sum = 0;
+
+    for (int i = 0; i < count; ++i)
+    {
+        sum += get_base_value(buf, phases[i]) * volumes[i];
+
+        // Phases are non-negative, so truncation equals floor here
+        phases[i] += phase_step * pitch_factors[i];
+        phases[i] -= (int32_t)phases[i];
+    }
+
+    return sum;
+}
+
+
+static void Add_tone_block_mix(
+        Add_tone_block* restrict block,
+        const float* restrict buf,
+        double phase_offset,
+        double phase_step,
+        double* restrict vals)
+{
+    assert(block != NULL);
+    assert(buf != NULL);
+    assert(vals != NULL);
+
+    const int count = block->count;
+    double* restrict phases = block->phases;
+    const double* restrict pitch_factors = block->pitch_factors;
+    const double* restrict volumes_l = block->volumes[0];
+    const double* restrict volumes_r = block->volumes[1];
+
+    double left = 0;
+    double right = 0;
+
+    for (int i = 0; i < count; ++i)
+    {
+        // FIXME: + phase_offset is specifically phase modulation
+        const double val = get_base_value(buf, phases[i] + phase_offset);
+        left += val * volumes_l[i];
+        right += val * volumes_r[i];
+
+        phases[i] += phase_step * pitch_factors[i];
+        phases[i] -= (int32_t)phases[i];
+    }
+
+    vals[0] = left;
+    vals[1] = right;
+
+    return;
+}
+
+
+static double Generator_add_get_mod_env_scale(
+        const Generator_add* add,
+        Voice_state_add* add_state,
+        uint32_t freq)
+{
+    assert(add != NULL);
+    assert(add->mod_env != NULL);
+    assert(add_state != NULL);
+    assert(freq > 0);
+
+    double* next_node = Envelope_get_node(
+            add->mod_env,
+            add_state->mod_env_next_node);
+    assert(next_node != NULL);
+
+    double scale = NAN;
+
+    if (add_state->mod_env_pos >= next_node[0])
+    {
+        ++add_state->mod_env_next_node;
+        scale = Envelope_get_value(add->mod_env, add_state->mod_env_pos);
+
+        if (!isfinite(scale))
+        {
+            scale = Envelope_get_node(add->mod_env,
+                    Envelope_node_count(add->mod_env) - 1)[1];
+            if (scale == 0)
+                add_state->mod_active = false;
+        }
+        else
+        {
+            double next_scale = Envelope_get_value(add->mod_env,
+                                        add_state->mod_env_pos +
+                                        1.0 / freq);
+            add_state->mod_env_value = scale;
+            add_state->mod_env_update = next_scale - scale;
+        }
+    }
+    else
+    {
+        assert(isfinite(add_state->mod_env_update));
+        add_state->mod_env_value += add_state->mod_env_update *
+                                    add_state->mod_env_scale;
+        scale = add_state->mod_env_value;
+        if (scale < 0)
+            scale = 0;
+    }
+    add_state->mod_env_pos += add_state->mod_env_scale / freq;
+
+    return scale;
+}
+
+
 static uint32_t Generator_add_mix(
         const Generator* gen,
         Gen_state* gen_state,
@@ -407,147 +612,133 @@ static uint32_t Generator_add_mix(
     uint32_t mixed = offset;
     assert(is_p2(BASE_FUNC_SIZE));
 
-    for (; mixed < nframes && vstate->active; ++mixed)
+    const float* base_buf = Sample_get_buffer(add->base, 0);
+    assert(base_buf != NULL);
+
+    Add_tone_block tone_block;
+    Add_tone_block mod_tone_block;
+
+    while (mixed < nframes && vstate->active)
     {
-        Generator_common_handle_pitch(gen, vstate);
+        const int32_t block_len = min(nframes - mixed, ADD_BLOCK_SIZE);
 
-        double vals[KQT_BUFFERS_MAX] = { 0 };
-        vals[0] = 0;
-        double mod_val = 0;
+        // Update pitch at audio rate
+        Gen_block block;
+        Generator_common_handle_pitch(gen, vstate, &block, block_len);
+        const double* actual_pitches = block.actual_pitches;
+
+        bool pitch_changed = (actual_pitches[0] != block.prev_actual_pitch);
+        for (int32_t i = 1; i < block_len; ++i)
+        {
+            if (actual_pitches[i] != actual_pitches[i - 1])
+                pitch_changed = true;
+        }
+
+        // Calculate phase modulation
+        double mod_vals[ADD_BLOCK_SIZE] = { 0 };
 
         if (add_state->mod_active)
         {
-            float* mod_buf = Sample_get_buffer(add->mod, 0);
+            const float* mod_buf = Sample_get_buffer(add->mod, 0);
             assert(mod_buf != NULL);
 
-            for (int h = 0; h < add_state->mod_tone_limit; ++h)
-            {
-                if (add->mod_tones[h].pitch_factor <= 0 ||
-                        add->mod_tones[h].volume_factor <= 0)
-                    continue;
-
-                double pos = add_state->mod_tones[h].phase * BASE_FUNC_SIZE;
-                int32_t pos1 = (int)pos & (BASE_FUNC_SIZE - 1);
-                int32_t pos2 = (pos1 + 1) & (BASE_FUNC_SIZE - 1);
-                float frame = mod_buf[pos1];
-                float frame_diff = mod_buf[pos2] - frame;
-                double remainder = pos - floor(pos);
-                mod_val += (frame + remainder * frame_diff) *
-                           add->mod_tones[h].volume_factor * add->mod_volume;
-
-                add_state->mod_tones[h].phase +=
-                    vstate->actual_pitch *
-                    add->mod_tones[h].pitch_factor / freq;
-
-                if (add_state->mod_tones[h].phase >= 1)
-                    add_state->mod_tones[h].phase -=
-                            floor(add_state->mod_tones[h].phase);
-            }
+            Add_tone_block_init(
+                    &mod_tone_block,
+                    add->mod_tones,
+                    add_state->mod_tone_limit,
+                    add_state->mod_tone_phases,
+                    add->mod_volume);
 
+            // Force and pitch scaling are updated at block rate
+            double force_factor = 1;
             if (add->force_mod_env != NULL)
             {
                 double force = min(1, vstate->actual_force);
-                double factor = Envelope_get_value(add->force_mod_env, force);
-                assert(isfinite(factor));
-                mod_val *= factor;
+                force_factor = Envelope_get_value(add->force_mod_env, force);
+                assert(isfinite(force_factor));
             }
 
             if (add->mod_env != NULL)
             {
                 if (add->mod_env_scale_amount != 0 &&
-                        (vstate->actual_pitch != vstate->prev_actual_pitch ||
-                         isnan(add_state->mod_env_scale)))
+                        (pitch_changed || isnan(add_state->mod_env_scale)))
                     add_state->mod_env_scale = pow(
-                            vstate->actual_pitch / add->mod_env_center,
+                            actual_pitches[block_len - 1] /
+                                add->mod_env_center,
                             add->mod_env_scale_amount);
                 else if (isnan(add_state->mod_env_scale))
                     add_state->mod_env_scale = 1;
+            }
+
+            for (int32_t i = 0; i < block_len && add_state->mod_active; ++i)
+            {
+                double mod_val = Add_tone_block_sum(
+                        &mod_tone_block,
+                        mod_buf,
+                        actual_pitches[i] / freq);
+                mod_val *= force_factor;
 
-                double* next_node = Envelope_get_node(
-                        add->mod_env,
-                        add_state->mod_env_next_node);
-                assert(next_node != NULL);
-
-                double scale = NAN;
-
-                if (add_state->mod_env_pos >= next_node[0])
-                {
-                    ++add_state->mod_env_next_node;
-                    scale = Envelope_get_value(add->mod_env,
-                                               add_state->mod_env_pos);
-
-                    if (!isfinite(scale))
-                    {
-                        scale = Envelope_get_node(add->mod_env,
-                                Envelope_node_count(add->mod_env) - 1)[1];
-                        if (scale == 0)
-                            add_state->mod_active = false;
-                    }
-                    else
-                    {
-                        double next_scale = Envelope_get_value(add->mod_env,
-                                                    add_state->mod_env_pos +
-                                                    1.0 / freq);
-                        add_state->mod_env_value = scale;
-                        add_state->mod_env_update = next_scale - scale;
-                    }
-                }
-                else
-                {
-                    assert(isfinite(add_state->mod_env_update));
-                    add_state->mod_env_value += add_state->mod_env_update *
-                                                add_state->mod_env_scale;
-                    scale = add_state->mod_env_value;
-                    if (scale < 0)
-                        scale = 0;
-                }
-                add_state->mod_env_pos += add_state->mod_env_scale / freq;
-                mod_val *= scale;
+                if (add->mod_env != NULL)
+                    mod_val *= Generator_add_get_mod_env_scale(
+                            add, add_state, freq);
+
+                if (mod_val < 0)
+                    mod_val += floor(mod_val);
+
+                mod_vals[i] = mod_val;
             }
 
-            if (mod_val < 0)
-                mod_val += floor(mod_val);
+            Add_tone_block_store_phases(
+                    &mod_tone_block, add_state->mod_tone_phases);
         }
 
-        float* base_buf = Sample_get_buffer(add->base, 0);
-        assert(base_buf != NULL);
-        for (int h = 0; h < add_state->tone_limit; ++h)
+        // Mix the tones
+        double vals[KQT_BUFFERS_MAX][GEN_BLOCK_FRAMES];
+
+        Add_tone_block_init(
+                &tone_block,
+                add->tones,
+                add_state->tone_limit,
+                add_state->tone_phases,
+                1.0);
+
+        for (int32_t i = 0; i < block_len; ++i)
         {
-            if (add->tones[h].pitch_factor <= 0 ||
-                    add->tones[h].volume_factor <= 0)
-                continue;
-
-            // FIXME: + mod_val is specifically phase modulation
-            double actual_phase = add_state->tones[h].phase + mod_val;
-            double pos = actual_phase * BASE_FUNC_SIZE;
-            int32_t pos1 = (int)pos & (BASE_FUNC_SIZE - 1);
-            int32_t pos2 = (pos1 + 1) & (BASE_FUNC_SIZE - 1);
-            float frame = base_buf[pos1];
-            float frame_diff = base_buf[pos2] - frame;
-            double remainder = pos - floor(pos);
-            double val =
-                (frame + remainder * frame_diff) *
-                add->tones[h].volume_factor;
-
-            vals[0] += val * (1 - add->tones[h].panning);
-            vals[1] += val * (1 + add->tones[h].panning);
-
-            add_state->tones[h].phase += vstate->actual_pitch *
-                                         add->tones[h].pitch_factor / freq;
-            if (add_state->tones[h].phase >= 1)
-                add_state->tones[h].phase -= floor(add_state->tones[h].phase);
+            double tone_frame[KQT_BUFFERS_MAX] = { 0 };
+            Add_tone_block_mix(
+                    &tone_block,
+                    base_buf,
+                    mod_vals[i],
+                    actual_pitches[i] / freq,
+                    tone_frame);
+            vals[0][i] = tone_frame[0];
+            vals[1][i] = tone_frame[1];
         }
 
-        Generator_common_handle_force(gen, ins_state, vstate, vals, 2, freq);
-        Generator_common_handle_filter(gen, vstate, vals, 2, freq);
-        Generator_common_ramp_attack(gen, vstate, vals, 2, freq);
+        Add_tone_block_store_phases(&tone_block, add_state->tone_phases);
+
+        // Apply the processing of the Voice
+        double* frames[KQT_BUFFERS_MAX] = { vals[0], vals[1] };
+
+        const int32_t frame_count = Generator_common_handle_force(
+                gen, ins_state, vstate, &block, frames, 2, freq);
+        Generator_common_handle_filter(
+                gen, vstate, &block, frames, 2, frame_count, freq);
+        Generator_common_ramp_attack(
+                gen, vstate, &block, frames, 2, frame_count, freq);
 
         vstate->pos = 1; // XXX: hackish
 
-        Generator_common_handle_panning(gen, vstate, vals, 2);
+        Generator_common_handle_panning(
+                gen, vstate, &block, frames, frame_count);
+
+        for (int32_t i = 0; i < frame_count; ++i)
+        {
+            bufs[0][mixed + i] += vals[0][i];
+            bufs[1][mixed + i] += vals[1][i];
+        }
 
-        bufs[0][mixed] += vals[0];
-        bufs[1][mixed] += vals[1];
+        mixed += frame_count;
     }
 
     return mixed;
@@ -76,16 +76,27 @@ void Generator_common_check_relative_lengths(
 }
 
 
-void Generator_common_handle_pitch(const Generator* gen, Voice_state* vstate)
+static void Generator_common_fill(double* values, int32_t count, double value)
+{
+    assert(values != NULL);
+    assert(count >= 0);
+
+    for (int32_t i = 0; i < count; ++i)
+        values[i] = value;
+
+    return;
+}
+
+
+static void Generator_common_update_pitch(
+        const Generator* gen, Voice_state* vstate, double pitch, double vibrato)
 {
     assert(gen != NULL);
     assert(vstate != NULL);
     (void)gen;
 
     vstate->prev_pitch = vstate->pitch;
-
-    if (Slider_in_progress(&vstate->pitch_slider))
-        vstate->pitch = Slider_step(&vstate->pitch_slider);
+    vstate->pitch = pitch;
 
     vstate->prev_actual_pitch = vstate->actual_pitch;
     vstate->actual_pitch = vstate->pitch;
@@ -139,35 +150,79 @@ void Generator_common_handle_pitch(const Generator* gen, Voice_state* vstate)
 #endif
         }
 
-        if (LFO_active(&vstate->vibrato))
-            vstate->actual_pitch *= LFO_step(&vstate->vibrato);
+        vstate->actual_pitch *= vibrato;
     }
 
     return;
 }
 
 
-void Generator_common_handle_force(
+void Generator_common_handle_pitch(
+        const Generator* gen,
+        Voice_state* vstate,
+        Gen_block* block,
+        int32_t frame_count)
+{
+    assert(gen != NULL);
+    assert(vstate != NULL);
+    assert(block != NULL);
+    assert(frame_count > 0);
+    assert(frame_count <= GEN_BLOCK_FRAMES);
+
+    block->frame_count = frame_count;
+    block->started = (vstate->pos > 0);
+    block->prev_actual_pitch = vstate->actual_pitch;
+
+    // Get the control values of the whole block
+    if (Slider_in_progress(&vstate->pitch_slider))
+        Slider_fill(&vstate->pitch_slider, block->pitches, frame_count);
+    else
+        Generator_common_fill(block->pitches, frame_count, vstate->pitch);
+
+    double vibrato[GEN_BLOCK_FRAMES];
+    LFO_fill(&vstate->vibrato, vibrato, frame_count);
+
+    for (int32_t i = 0; i < frame_count; ++i)
+    {
+        Generator_common_update_pitch(
+                gen, vstate, block->pitches[i], vibrato[i]);
+        block->pitches[i] = vstate->pitch;
+        block->actual_pitches[i] = vstate->actual_pitch;
+    }
+
+    return;
+}
+
+
+/**
+ * Update the force of the Voice for one frame.
+ *
+ * \param release_gain   Destination for the gain of the release ramp
+ *                       -- must not be \c NULL.
+ *
+ * \return   \c true if the note continues, or \c false if it has ended.
+ */
+static bool Generator_common_update_force(
         const Generator* gen,
         Ins_state* ins_state,
         Voice_state* vstate,
-        double frames[],
-        int frame_count,
-        uint32_t freq)
+        double actual_pitch,
+        double prev_actual_pitch,
+        double force,
+        double tremolo,
+        uint32_t freq,
+        double* release_gain)
 {
     assert(gen != NULL);
     assert(ins_state != NULL);
     assert(vstate != NULL);
-    assert(frames != NULL);
-    assert(frame_count > 0);
+    assert(release_gain != NULL);
 
-    if (Slider_in_progress(&vstate->force_slider))
-        vstate->force = Slider_step(&vstate->force_slider);
+    *release_gain = 1;
 
+    vstate->force = force;
     vstate->actual_force = vstate->force * gen->ins_params->global_force;
-
-    if (LFO_active(&vstate->tremolo))
-        vstate->actual_force *= LFO_step(&vstate->tremolo);
+    vstate->actual_force *= tremolo;
 
     if (gen->ins_params->env_force_enabled)
     {
@@ -183,10 +238,10 @@ void Generator_common_handle_force(
             Envelope_get_node(env, loop_end_index);
 
         if (gen->ins_params->env_force_scale_amount != 0 &&
-                vstate->actual_pitch != vstate->prev_actual_pitch)
+                actual_pitch != prev_actual_pitch)
         {
             vstate->fe_scale = pow(
-                    vstate->actual_pitch / gen->ins_params->env_force_center,
+                    actual_pitch / gen->ins_params->env_force_center,
                     gen->ins_params->env_force_scale_amount);
         }
 
@@ -267,11 +322,7 @@ void Generator_common_handle_force(
                 if (vstate->fe_pos > last[0] && last[1] == 0)
                 {
                     vstate->active = false;
-
-                    for (int i = 0; i < frame_count; ++i)
-                        frames[i] = 0;
-
-                    return;
+                    return false;
                 }
             }
         }
@@ -283,11 +334,11 @@ void Generator_common_handle_force(
         if (gen->ins_params->env_force_rel_enabled)
         {
             if (gen->ins_params->env_force_rel_scale_amount != 0 &&
-                    (vstate->actual_pitch != vstate->prev_actual_pitch ||
+                    (actual_pitch != prev_actual_pitch ||
                      isnan(vstate->rel_fe_scale)))
             {
                 vstate->rel_fe_scale = pow(
-                        vstate->actual_pitch /
+                        actual_pitch /
                             gen->ins_params->env_force_rel_center,
                         gen->ins_params->env_force_rel_scale_amount);
             }
@@ -315,11 +366,7 @@ void Generator_common_handle_force(
                 if (!isfinite(scale))
                 {
                     vstate->active = false;
-
-                    for (int i = 0; i < frame_count; ++i)
-                        frames[i] = 0;
-
-                    return;
+                    return false;
                 }
                 double next_scale = Envelope_get_value(
                         env,
@@ -345,11 +392,7 @@ void Generator_common_handle_force(
             if (!isfinite(scale))
             {
                 vstate->active = false;
-
-                for (int i = 0; i < frame_count; ++i)
-                    frames[i] = 0;
-
-                return;
+                return false;
             }
 #endif
 
@@ -361,55 +404,122 @@ void Generator_common_handle_force(
         {
             if (vstate->ramp_release < 1)
             {
-                for (int i = 0; i < frame_count; ++i)
-                    frames[i] *= 1 - vstate->ramp_release;
+                *release_gain = 1 - vstate->ramp_release;
             }
             else
             {
                 vstate->active = false;
-
-                for (int i = 0; i < frame_count; ++i)
-                    frames[i] = 0;
-
-                return;
+                return false;
             }
 
             vstate->ramp_release += RAMP_RELEASE_TIME / freq;
         }
     }
 
-    for (int i = 0; i < frame_count; ++i)
-        frames[i] *= vstate->actual_force;
-
-    return;
+    return true;
 }
 
 
-void Generator_common_handle_filter(
+int32_t Generator_common_handle_force(
         const Generator* gen,
+        Ins_state* ins_state,
         Voice_state* vstate,
-        double frames[],
-        int frame_count,
+        Gen_block* block,
+        double* const frames[],
+        int channels,
         uint32_t freq)
 {
     assert(gen != NULL);
+    assert(ins_state != NULL);
     assert(vstate != NULL);
+    assert(block != NULL);
+    assert(block->frame_count > 0);
     assert(frames != NULL);
-    assert(frame_count > 0);
+    assert(channels > 0);
+    assert(channels <= KQT_BUFFERS_MAX);
     assert(freq > 0);
 
-    if (Slider_in_progress(&vstate->lowpass_slider))
-        vstate->lowpass = Slider_step(&vstate->lowpass_slider);
+    double* forces = block->forces;
+    double* release_gains = block->gains;
 
-    vstate->actual_lowpass = vstate->lowpass;
+    // Get the control values of the whole block
+    int32_t frame_count = block->frame_count;
+    if (Slider_in_progress(&vstate->force_slider))
+        Slider_fill(&vstate->force_slider, forces, frame_count);
+    else
+        Generator_common_fill(forces, frame_count, vstate->force);
+
+    double tremolo[GEN_BLOCK_FRAMES];
+    LFO_fill(&vstate->tremolo, tremolo, frame_count);
+
+    // Calculate the force curve
+    for (int32_t i = 0; i < frame_count; ++i)
+    {
+        const double prev_actual_pitch = (i > 0) ?
+            block->actual_pitches[i - 1] : block->prev_actual_pitch;
+
+        if (!Generator_common_update_force(
+                    gen,
+                    ins_state,
+                    vstate,
+                    block->actual_pitches[i],
+                    prev_actual_pitch,
+                    forces[i],
+                    tremolo[i],
+                    freq,
+                    &release_gains[i]))
+        {
+            // Silence the last frame of the note
+            release_gains[i] = 0;
+            forces[i] = vstate->actual_force;
+            frame_count = i + 1;
+            break;
+        }
+
+        forces[i] = vstate->actual_force;
+    }
 
-    if (LFO_active(&vstate->autowah))
-        vstate->actual_lowpass *= LFO_step(&vstate->autowah);
+    // Apply the force curve
+    for (int ch = 0; ch < channels; ++ch)
+    {
+        double* buf = frames[ch];
+        assert(buf != NULL);
+
+        for (int32_t i = 0; i < frame_count; ++i)
+        {
+            buf[i] *= release_gains[i];
+            buf[i] *= forces[i];
+        }
+    }
+
+    return frame_count;
+}
+
+
+/**
+ * Update the lowpass cutoff of the Voice for one frame.
+ *
+ * \return   \c true if the filter needs to be recreated with
+ *           \a Generator_common_create_lowpass, otherwise \c false.
+ */
+static bool Generator_common_update_lowpass(
+        const Generator* gen,
+        Voice_state* vstate,
+        double lowpass,
+        double autowah,
+        double actual_force)
+{
+    assert(gen != NULL);
+    assert(vstate != NULL);
+
+    vstate->lowpass = lowpass;
+    vstate->actual_lowpass = vstate->lowpass;
+    vstate->actual_lowpass *= autowah;
 
     if (gen->ins_params->env_force_filter_enabled &&
             vstate->lowpass_xfade_pos >= 1)
     {
-        double force = vstate->actual_force;
+        double force = actual_force;
         if (force > 1)
             force = 1;
 
@@ -420,134 +530,374 @@ void Generator_common_handle_filter(
         vstate->actual_lowpass = min(vstate->actual_lowpass, 16384) * factor;
     }
 
-    if (!vstate->lowpass_update &&
-            vstate->lowpass_xfade_pos >= 1 &&
-            (vstate->actual_lowpass < vstate->effective_lowpass * 0.98566319864018759 ||
-             vstate->actual_lowpass > vstate->effective_lowpass * 1.0145453349375237 ||
-             vstate->lowpass_resonance != vstate->effective_resonance))
-    {
-        vstate->lowpass_update = true;
-        vstate->lowpass_xfade_state_used = vstate->lowpass_state_used;
+    return !vstate->lowpass_update &&
+        vstate->lowpass_xfade_pos >= 1 &&
+        (vstate->actual_lowpass < vstate->effective_lowpass * 0.98566319864018759 ||
+         vstate->actual_lowpass > vstate->effective_lowpass * 1.0145453349375237 ||
+         vstate->lowpass_resonance != vstate->effective_resonance);
+}
 
-        if (vstate->pos > 0)
-            vstate->lowpass_xfade_pos = 0;
-        else
-            vstate->lowpass_xfade_pos = 1;
 
-        vstate->lowpass_xfade_update = 200.0 / freq; // FIXME: / freq
+static void Generator_common_create_lowpass(
+        Voice_state* vstate, bool started, uint32_t freq)
+{
+    assert(vstate != NULL);
+    assert(freq > 0);
+
+    vstate->lowpass_update = true;
+    vstate->lowpass_xfade_state_used = vstate->lowpass_state_used;
+
+    if (started)
+        vstate->lowpass_xfade_pos = 0;
+    else
+        vstate->lowpass_xfade_pos = 1;
 
-        if (vstate->actual_lowpass < freq / 2)
+    vstate->lowpass_xfade_update = 200.0 / freq; // FIXME: / freq
+
+    if (vstate->actual_lowpass < freq / 2)
+    {
+        int new_state = 1 - abs(vstate->lowpass_state_used);
+        double lowpass = max(vstate->actual_lowpass, 1);
+        two_pole_filter_create(lowpass / freq,
+                vstate->lowpass_resonance,
+                0,
+                vstate->lowpass_state[new_state].coeffs,
+                &vstate->lowpass_state[new_state].mul);
+        for (int i = 0; i < KQT_BUFFERS_MAX; ++i)
         {
-            int new_state = 1 - abs(vstate->lowpass_state_used);
-            double lowpass = max(vstate->actual_lowpass, 1);
-            two_pole_filter_create(lowpass / freq,
-                    vstate->lowpass_resonance,
-                    0,
-                    vstate->lowpass_state[new_state].coeffs,
-                    &vstate->lowpass_state[new_state].mul);
-            for (int i = 0; i < KQT_BUFFERS_MAX; ++i)
+            for (int k = 0; k < FILTER_ORDER; ++k)
             {
-                for (int k = 0; k < FILTER_ORDER; ++k)
-                {
-                    vstate->lowpass_state[new_state].history1[i][k] = 0;
-                    vstate->lowpass_state[new_state].history2[i][k] = 0;
-                }
+                vstate->lowpass_state[new_state].history1[i][k] = 0;
+                vstate->lowpass_state[new_state].history2[i][k] = 0;
             }
-            vstate->lowpass_state_used = new_state;
+        }
+        vstate->lowpass_state_used = new_state;
 //            fprintf(stderr, "created filter with cutoff %f\n", vstate->actual_filter);
+    }
+    else
+    {
+        if (vstate->lowpass_state_used == -1)
+            vstate->lowpass_xfade_pos = 1;
+
+        vstate->lowpass_state_used = -1;
+    }
+
+    vstate->effective_lowpass = vstate->actual_lowpass;
+    vstate->effective_resonance = vstate->lowpass_resonance;
+    vstate->lowpass_update = false;
+
+    return;
+}
+
+
+#if FILTER_ORDER % 2 != 0
+#error "Lowpass_bank assumes an even filter order"
+#endif
+
+#define LOWPASS_LANES_MAX (KQT_BUFFERS_MAX * 2)
+
+
+/**
+ * Filter channels that are processed side by side.
+ *
+ * Each lane filters one channel with one Filter_state. The lanes are stored
+ * in structure-of-arrays form so that the compiler can process several lanes
+ * with one instruction.
+ *
+ * A bank only covers the channels of one Voice and its crossfaded filter.
+ * Voices are not batched together: the force of a Voice is applied before
+ * its filter and also drives its cutoff, and Voices are mixed independently
+ * of each other, possibly in different threads.
+ */
+typedef struct Lowpass_bank
+{
+    int lane_count;
+    Filter_state* states[LOWPASS_LANES_MAX];
+    int channels[LOWPASS_LANES_MAX];
+    const double* inputs[LOWPASS_LANES_MAX];
+    double* outputs[LOWPASS_LANES_MAX];
+} Lowpass_bank;
+
+
+static void Lowpass_bank_add_lane(
+        Lowpass_bank* bank,
+        Filter_state* fst,
+        int channel,
+        const double* input,
+        double* output)
+{
+    assert(bank != NULL);
+    assert(bank->lane_count < LOWPASS_LANES_MAX);
+    assert(fst != NULL);
+    assert(channel >= 0);
+    assert(channel < KQT_BUFFERS_MAX);
+    assert(input != NULL);
+    assert(output != NULL);
+
+    const int lane = bank->lane_count;
+    bank->states[lane] = fst;
+    bank->channels[lane] = channel;
+    bank->inputs[lane] = input;
+    bank->outputs[lane] = output;
+    ++bank->lane_count;
+
+    return;
+}
+
+
+/**
+ * Run the first \a lane_count lanes of the Lowpass bank.
+ *
+ * This matches \a nq_zero_filter followed by \a iir_filter_strict_cascade
+ * for each lane.
+ */
+static void Lowpass_bank_process(
+        Lowpass_bank* bank, int lane_count, int32_t start, int32_t stop)
+{
+    assert(bank != NULL);
+    assert(lane_count >= 0);
+    assert(lane_count <= bank->lane_count);
+    assert(start >= 0);
+    assert(stop >= start);
+
+    if (lane_count == 0 || start == stop)
+        return;
+
+    double coeffs[FILTER_ORDER][LOWPASS_LANES_MAX] = { { 0 } };
+    double mul[LOWPASS_LANES_MAX] = { 0 };
+    double history1[FILTER_ORDER][LOWPASS_LANES_MAX] = { { 0 } };
+    double history2[FILTER_ORDER][LOWPASS_LANES_MAX] = { { 0 } };
+
+    // Gather the lanes
+    for (int lane = 0; lane < lane_count; ++lane)
+    {
+        const Filter_state* fst = bank->states[lane];
+        const int ch = bank->channels[lane];
+        for (int k = 0; k < FILTER_ORDER; ++k)
+        {
+            coeffs[k][lane] = fst->coeffs[k];
+            history1[k][lane] = fst->history1[ch][k];
+            history2[k][lane] = fst->history2[ch][k];
         }
-        else
+        mul[lane] = fst->mul;
+    }
+
+    for (int32_t i = start; i < stop; ++i)
+    {
+        double values[LOWPASS_LANES_MAX];
+        for (int lane = 0; lane < lane_count; ++lane)
+            values[lane] = bank->inputs[lane][i];
+
+        for (int k = 0; k < FILTER_ORDER; ++k)
         {
-            if (vstate->lowpass_state_used == -1)
-                vstate->lowpass_xfade_pos = 1;
+            for (int lane = 0; lane < lane_count; ++lane)
+            {
+                const double temp = history1[k][lane];
+                history1[k][lane] = values[lane];
+                values[lane] += temp;
+            }
+        }
 
-            vstate->lowpass_state_used = -1;
+        for (int k = 0; k < FILTER_ORDER; k += 2)
+        {
+            for (int lane = 0; lane < lane_count; ++lane)
+            {
+                values[lane] -= coeffs[k][lane] * history2[k][lane] +
+                                coeffs[k + 1][lane] * history2[k + 1][lane];
+                history2[k][lane] = history2[k + 1][lane];
+                history2[k + 1][lane] = values[lane];
+            }
         }
 
-        vstate->effective_lowpass = vstate->actual_lowpass;
-        vstate->effective_resonance = vstate->lowpass_resonance;
-        vstate->lowpass_update = false;
+        for (int lane = 0; lane < lane_count; ++lane)
+            bank->outputs[lane][i] = values[lane] * mul[lane];
     }
 
-    if (vstate->lowpass_state_used > -1 || vstate->lowpass_xfade_state_used > -1)
+    // Scatter the lanes
+    for (int lane = 0; lane < lane_count; ++lane)
     {
-        assert(vstate->lowpass_state_used != vstate->lowpass_xfade_state_used);
-        double result[KQT_BUFFERS_MAX] = { 0 };
+        Filter_state* fst = bank->states[lane];
+        const int ch = bank->channels[lane];
+        for (int k = 0; k < FILTER_ORDER; ++k)
+        {
+            fst->history1[ch][k] = history1[k][lane];
+            fst->history2[ch][k] = history2[k][lane];
+        }
+    }
+
+    return;
+}
 
-        if (vstate->lowpass_state_used > -1)
+
+/**
+ * Filter frames with constant filter states of the Voice.
+ *
+ * \param vols         The volumes of the current filter.
+ * \param xfade_vols   The volumes of the crossfaded filter.
+ * \param xfade_stop   The end of the crossfade in the frames.
+ */
+static void Generator_common_apply_lowpass(
+        Voice_state* vstate,
+        double* const frames[],
+        int channels,
+        const double vols[],
+        const double xfade_vols[],
+        int32_t start,
+        int32_t xfade_stop,
+        int32_t stop)
+{
+    assert(vstate != NULL);
+    assert(frames != NULL);
+    assert(channels > 0);
+    assert(channels <= KQT_BUFFERS_MAX);
+    assert(vols != NULL);
+    assert(xfade_vols != NULL);
+    assert(start >= 0);
+    assert(xfade_stop >= start);
+    assert(stop >= xfade_stop);
+
+    if (start == stop ||
+            (vstate->lowpass_state_used == -1 &&
+             vstate->lowpass_xfade_state_used == -1))
+        return;
+
+    assert(vstate->lowpass_state_used != vstate->lowpass_xfade_state_used);
+
+    Filter_state* fst = (vstate->lowpass_state_used > -1) ?
+        &vstate->lowpass_state[vstate->lowpass_state_used] : NULL;
+    Filter_state* xfade_fst = (vstate->lowpass_xfade_state_used > -1) ?
+        &vstate->lowpass_state[vstate->lowpass_xfade_state_used] : NULL;
+
+    double filtered[KQT_BUFFERS_MAX][GEN_BLOCK_FRAMES];
+    double xfade_filtered[KQT_BUFFERS_MAX][GEN_BLOCK_FRAMES];
+
+    // The current filter runs in the first lanes so that the crossfaded
+    // filter lanes can be dropped when the crossfade ends
+    Lowpass_bank* bank = &(Lowpass_bank){ .lane_count = 0 };
+    if (fst != NULL)
+    {
+        for (int ch = 0; ch < channels; ++ch)
+            Lowpass_bank_add_lane(bank, fst, ch, frames[ch], filtered[ch]);
+    }
+    const int main_lane_count = bank->lane_count;
+
+    if (xfade_fst != NULL && xfade_stop > start)
+    {
+        for (int ch = 0; ch < channels; ++ch)
+            Lowpass_bank_add_lane(
+                    bank, xfade_fst, ch, frames[ch], xfade_filtered[ch]);
+    }
+
+    Lowpass_bank_process(bank, bank->lane_count, start, xfade_stop);
+    Lowpass_bank_process(bank, main_lane_count, xfade_stop, stop);
+
+    for (int ch = 0; ch < channels; ++ch)
+    {
+        double* buf = frames[ch];
+        const double* result = (fst != NULL) ? filtered[ch] : buf;
+        const double* fade_result =
+            (xfade_fst != NULL) ? xfade_filtered[ch] : buf;
+
+        for (int32_t i = start; i < xfade_stop; ++i)
         {
-            Filter_state* fst =
-                    &vstate->lowpass_state[vstate->lowpass_state_used];
+            double value = result[i] * vols[i];
+            if (xfade_vols[i] > 0)
+                value += fade_result[i] * xfade_vols[i];
 
-            for (int i = 0; i < frame_count; ++i)
-            {
-                result[i] = nq_zero_filter(
-                        FILTER_ORDER,
-                        fst->history1[i],
-                        frames[i]);
-                result[i] = iir_filter_strict_cascade(
-                        FILTER_ORDER,
-                        fst->coeffs,
-                        fst->history2[i],
-                        result[i]);
-                result[i] *= fst->mul;
-            }
+            buf[i] = value;
         }
-        else
+
+        for (int32_t i = xfade_stop; i < stop; ++i)
+            buf[i] = result[i] * vols[i];
+    }
+
+    return;
+}
+
+
+void Generator_common_handle_filter(
+        const Generator* gen,
+        Voice_state* vstate,
+        const Gen_block* block,
+        double* const frames[],
+        int channels,
+        int32_t frame_count,
+        uint32_t freq)
+{
+    assert(gen != NULL);
+    assert(vstate != NULL);
+    assert(block != NULL);
+    assert(frames != NULL);
+    assert(channels > 0);
+    assert(channels <= KQT_BUFFERS_MAX);
+    assert(frame_count > 0);
+    assert(frame_count <= block->frame_count);
+    assert(freq > 0);
+
+    // Get the control values of the whole block
+    double lowpasses[GEN_BLOCK_FRAMES];
+    if (Slider_in_progress(&vstate->lowpass_slider))
+        Slider_fill(&vstate->lowpass_slider, lowpasses, frame_count);
+    else
+        Generator_common_fill(lowpasses, frame_count, vstate->lowpass);
+
+    double autowah[GEN_BLOCK_FRAMES];
+    LFO_fill(&vstate->autowah, autowah, frame_count);
+
+    // Filter the block in segments that use the same filter states
+    double vols[GEN_BLOCK_FRAMES];
+    double xfade_vols[GEN_BLOCK_FRAMES];
+    int32_t seg_start = 0;
+    int32_t xfade_stop = 0;
+
+    for (int32_t i = 0; i < frame_count; ++i)
+    {
+        if (Generator_common_update_lowpass(
+                    gen, vstate, lowpasses[i], autowah[i], block->forces[i]))
         {
-            for (int i = 0; i < frame_count; ++i)
-                result[i] = frames[i];
+            Generator_common_apply_lowpass(
+                    vstate,
+                    frames,
+                    channels,
+                    vols,
+                    xfade_vols,
+                    seg_start,
+                    xfade_stop,
+                    i);
+
+            Generator_common_create_lowpass(
+                    vstate, block->started || (i > 0), freq);
+            seg_start = i;
+            xfade_stop = i;
         }
 
+        if (vstate->lowpass_state_used == -1 &&
+                vstate->lowpass_xfade_state_used == -1)
+            continue;
+
         double vol = vstate->lowpass_xfade_pos;
         if (vol > 1)
             vol = 1;
-
-        for (int i = 0; i < frame_count; ++i)
-            result[i] *= vol;
+        vols[i] = vol;
 
         if (vstate->lowpass_xfade_pos < 1)
         {
-            double fade_result[KQT_BUFFERS_MAX] = { 0 };
-
-            if (vstate->lowpass_xfade_state_used > -1)
-            {
-                Filter_state* fst =
-                        &vstate->lowpass_state[vstate->lowpass_xfade_state_used];
-                for (int i = 0; i < frame_count; ++i)
-                {
-                    fade_result[i] = nq_zero_filter(
-                            FILTER_ORDER,
-                            fst->history1[i],
-                            frames[i]);
-                    fade_result[i] = iir_filter_strict_cascade(
-                            FILTER_ORDER,
-                            fst->coeffs,
-                            fst->history2[i],
-                            fade_result[i]);
-                    fade_result[i] *= fst->mul;
-                }
-            }
-            else
-            {
-                for (int i = 0; i < frame_count; ++i)
-                    fade_result[i] = frames[i];
-            }
-
-            double vol = 1 - vstate->lowpass_xfade_pos;
-            if (vol > 0)
-            {
-                for (int i = 0; i < frame_count; ++i)
-                    result[i] += fade_result[i] * vol;
-            }
-
+            xfade_vols[i] = 1 - vstate->lowpass_xfade_pos;
+            xfade_stop = i + 1;
             vstate->lowpass_xfade_pos += vstate->lowpass_xfade_update;
         }
-
-        for (int i = 0; i < frame_count; ++i)
-            frames[i] = result[i];
     }
 
+    Generator_common_apply_lowpass(
+            vstate,
+            frames,
+            channels,
+            vols,
+            xfade_vols,
+            seg_start,
+            xfade_stop,
+            frame_count);
+
     return;
 }
 
@@ -555,25 +905,45 @@ void Generator_common_handle_filter(
 void Generator_common_ramp_attack(
         const Generator* gen,
         Voice_state* vstate,
-        double frames[],
-        int frame_count,
+        Gen_block* block,
+        double* const frames[],
+        int channels,
+        int32_t frame_count,
         uint32_t freq)
 {
     assert(gen != NULL);
     assert(vstate != NULL);
+    assert(block != NULL);
     assert(frames != NULL);
+    assert(channels > 0);
+    assert(channels <= KQT_BUFFERS_MAX);
     assert(frame_count > 0);
+    assert(frame_count <= block->frame_count);
     assert(freq > 0);
     (void)gen;
 
-    if (vstate->ramp_attack < 1)
-    {
-        for (int i = 0; i < frame_count; ++i)
-            frames[i] *= vstate->ramp_attack;
+    if (vstate->ramp_attack >= 1)
+        return;
 
+    // Calculate the ramp
+    double* gains = block->gains;
+    int32_t ramp_stop = 0;
+    for (; ramp_stop < frame_count && vstate->ramp_attack < 1; ++ramp_stop)
+    {
+        gains[ramp_stop] = vstate->ramp_attack;
         vstate->ramp_attack += RAMP_ATTACK_TIME / freq;
     }
 
+    // Apply the ramp
+    for (int ch = 0; ch < channels; ++ch)
+    {
+        double* buf = frames[ch];
+        assert(buf != NULL);
+
+        for (int32_t i = 0; i < ramp_stop; ++i)
+            buf[i] *= gains[i];
+    }
+
     return;
 }
 
@@ -581,32 +951,73 @@ void Generator_common_ramp_attack(
 void Generator_common_handle_panning(
         const Generator* gen,
         Voice_state* vstate,
-        double frames[],
-        int frame_count)
+        Gen_block* block,
+        double* const frames[],
+        int32_t frame_count)
 {
     assert(gen != NULL);
     assert(vstate != NULL);
+    assert(block != NULL);
     assert(frames != NULL);
+    assert(frames[0] != NULL);
+    assert(frames[1] != NULL);
     assert(frame_count > 0);
+    assert(frame_count <= block->frame_count);
+
+    double* left = frames[0];
+    double* right = frames[1];
 
-    if ((frame_count) >= 2)
+    const bool pitch_pan_enabled = gen->ins_params->env_pitch_pan_enabled;
+
+    // Use a constant gain pair if the panning does not change in the block
+    if (!Slider_in_progress(&vstate->panning_slider) && !pitch_pan_enabled)
     {
-        if (Slider_in_progress(&vstate->panning_slider))
-            vstate->panning = Slider_step(&vstate->panning_slider);
+        vstate->actual_panning = vstate->panning;
+
+        const double left_gain = 1 - vstate->actual_panning;
+        const double right_gain = 1 + vstate->actual_panning;
+        for (int32_t i = 0; i < frame_count; ++i)
+        {
+            left[i] *= left_gain;
+            right[i] *= right_gain;
+        }
 
+        return;
+    }
+
+    // Calculate the panning curve
+    double* pannings = block->gains;
+    if (Slider_in_progress(&vstate->panning_slider))
+        Slider_fill(&vstate->panning_slider, pannings, frame_count);
+    else
+        Generator_common_fill(pannings, frame_count, vstate->panning);
+
+    double pan_pitch = NAN;
+    double pan = 0;
+
+    for (int32_t i = 0; i < frame_count; ++i)
+    {
+        vstate->panning = pannings[i];
         vstate->actual_panning = vstate->panning;
 
-        if (gen->ins_params->env_pitch_pan_enabled)
+        if (pitch_pan_enabled)
         {
-            Envelope* env = gen->ins_params->env_pitch_pan;
-            double cents = log2(vstate->pitch / 440) * 1200;
-            if (cents < -6000)
-                cents = -6000;
-            else if (cents > 6000)
-                cents = 6000;
-
-            double pan = Envelope_get_value(env, cents);
-            assert(isfinite(pan));
+            // The pitch usually stays the same for many frames
+            if (block->pitches[i] != pan_pitch)
+            {
+                pan_pitch = block->pitches[i];
+
+                Envelope* env = gen->ins_params->env_pitch_pan;
+                double cents = log2(pan_pitch / 440) * 1200;
+                if (cents < -6000)
+                    cents = -6000;
+                else if (cents > 6000)
+                    cents = 6000;
+
+                pan = Envelope_get_value(env, cents);
+                assert(isfinite(pan));
+            }
+
             double separation = 1 - fabs(vstate->actual_panning);
             vstate->actual_panning += pan * separation;
 
@@ -616,8 +1027,14 @@ void Generator_common_handle_panning(
                 vstate->actual_panning = 1;
         }
 
-        frames[0] *= 1 - vstate->actual_panning;
-        frames[1] *= 1 + vstate->actual_panning;
+        pannings[i] = vstate->actual_panning;
+    }
+
+    // Apply the panning curve
+    for (int32_t i = 0; i < frame_count; ++i)
+    {
+        left[i] *= 1 - pannings[i];
+        right[i] *= 1 + pannings[i];
     }
 
     return;
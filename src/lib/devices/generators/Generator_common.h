@@ -12,8 +12,13 @@
  */
 
 
+#ifndef K_GENERATOR_COMMON_H
+#define K_GENERATOR_COMMON_H
+
+
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <math.h>
 
@@ -26,12 +31,17 @@
 
 /**
  * Get the output buffers.
+ *
+ * The output override of the Voice state is used instead of the Generator
+ * output if set.
  */
 #define Generator_common_get_buffers(gs, vstate, mixed, bufs) \
     if (true)                                                 \
     {                                                         \
-        Audio_buffer* buffer = Device_state_get_audio_buffer( \
-                &(gs)->parent, DEVICE_PORT_TYPE_SEND, 0);     \
+        Audio_buffer* buffer = (vstate)->out_buffer;          \
+        if (buffer == NULL)                                   \
+            buffer = Device_state_get_audio_buffer(           \
+                    &(gs)->parent, DEVICE_PORT_TYPE_SEND, 0); \
         if (buffer == NULL)                                   \
         {                                                     \
             (vstate)->active = false;                         \
@@ -79,83 +89,144 @@ void Generator_common_check_relative_lengths(
 
 
 /**
- * Handle pitch.
+ * The maximum number of frames processed as one block.
+ */
+#define GEN_BLOCK_FRAMES 128
+
+
+/**
+ * Control values of a Voice for a block of frames.
  *
- * \param gen     The Generator -- must not be \c NULL.
- * \param vstate   The Voice state -- must not be \c NULL.
+ * The values are calculated by Generator_common_handle_pitch and
+ * Generator_common_handle_force, and used by the functions that apply the
+ * Voice processing to the frames of the block.
  */
-void Generator_common_handle_pitch(const Generator* gen, Voice_state* vstate);
+typedef struct Gen_block
+{
+    int32_t frame_count;        ///< The number of frames.
+    bool started;               ///< Whether the Voice was mixed before.
+    double prev_actual_pitch;   ///< The actual pitch before the block.
+
+    // Per-frame values
+    double pitches[GEN_BLOCK_FRAMES];
+    double actual_pitches[GEN_BLOCK_FRAMES];
+    double forces[GEN_BLOCK_FRAMES];
+    double gains[GEN_BLOCK_FRAMES]; ///< Scratch space for gain curves.
+} Gen_block;
 
 
 /**
- * Handle force.
+ * Handle pitch for a block of frames.
+ *
+ * This should be called before the Generator renders the frames of the
+ * block, and before the playback position of the block is updated.
  *
  * \param gen           The Generator -- must not be \c NULL.
  * \param vstate        The Voice state -- must not be \c NULL.
- * \param frames        The frames to be modified -- must not be \c NULL.
- * \param frame_count   The number of frames to be modified -- must be > \c 0.
- * \param freq          The mixing frequency -- must be > \c 0.
+ * \param block         The control block -- must not be \c NULL.
+ * \param frame_count   The number of frames in the block -- must be > \c 0
+ *                      and <= \c GEN_BLOCK_FRAMES.
+ */
+void Generator_common_handle_pitch(
+        const Generator* gen,
+        Voice_state* vstate,
+        Gen_block* block,
+        int32_t frame_count);
+
+
+/**
+ * Handle force for a block of frames.
+ *
+ * If the note ends within the block, the frames after the end are not
+ * processed, and the Voice state is marked inactive.
+ *
+ * \param gen         The Generator -- must not be \c NULL.
+ * \param ins_state   The Instrument state -- must not be \c NULL.
+ * \param vstate      The Voice state -- must not be \c NULL.
+ * \param block       The control block -- must not be \c NULL.
+ * \param frames      The channel buffers of the block -- must not be \c NULL.
+ * \param channels    The number of channels to be modified -- must be > \c 0.
+ * \param freq        The mixing frequency -- must be > \c 0.
+ *
+ * \return   The number of frames left to be mixed in the block.
  */
-void Generator_common_handle_force(
+int32_t Generator_common_handle_force(
         const Generator* gen,
         Ins_state* ins_state,
         Voice_state* vstate,
-        double frames[],
-        int frame_count,
+        Gen_block* block,
+        double* const frames[],
+        int channels,
         uint32_t freq);
 
 
 /**
- * Handle filter.
+ * Handle filter for a block of frames.
  *
  * This should be called after force handling.
  *
  * \param gen           The Generator -- must not be \c NULL.
  * \param vstate        The Voice state -- must not be \c NULL.
- * \param frames        The frames to be modified -- must not be \c NULL.
+ * \param block         The control block -- must not be \c NULL.
+ * \param frames        The channel buffers of the block -- must not be
+ *                      \c NULL.
+ * \param channels      The number of channels to be modified -- must be > \c 0.
  * \param frame_count   The number of frames to be modified -- must be > \c 0.
  * \param freq          The mixing frequency -- must be > \c 0.
  */
 void Generator_common_handle_filter(
         const Generator* gen,
         Voice_state* vstate,
-        double frames[],
-        int frame_count,
+        const Gen_block* block,
+        double* const frames[],
+        int channels,
+        int32_t frame_count,
         uint32_t freq);
 
 
 /**
- * Ramp volume for note start and end.
+ * Ramp volume for note start in a block of frames.
  *
  * This should be called after force handling if needed (not all Generators
  * need this).
  *
  * \param gen           The Generator -- must not be \c NULL.
  * \param vstate        The Voice state -- must not be \c NULL.
- * \param frames        The frames to be modified -- must not be \c NULL.
+ * \param block         The control block -- must not be \c NULL.
+ * \param frames        The channel buffers of the block -- must not be
+ *                      \c NULL.
+ * \param channels      The number of channels to be modified -- must be > \c 0.
  * \param frame_count   The number of frames to be modified -- must be > \c 0.
  * \param freq          The mixing frequency -- must be > \c 0.
  */
 void Generator_common_ramp_attack(
         const Generator* gen,
         Voice_state* vstate,
-        double frames[],
-        int frame_count,
+        Gen_block* block,
+        double* const frames[],
+        int channels,
+        int32_t frame_count,
         uint32_t freq);
 
 
 /**
- * Handle panning.
+ * Handle panning for a block of stereo frames.
  *
  * \param gen           The Generator -- must not be \c NULL.
  * \param vstate        The Voice state -- must not be \c NULL.
- * \param frames        The frames to be modified -- must not be \c NULL.
+ * \param block         The control block -- must not be \c NULL.
+ * \param frames        The left and right channel buffers of the block
+ *                      -- must not be \c NULL.
  * \param frame_count   The number of frames to be modified -- must be > \c 0.
  */
 void Generator_common_handle_panning(
         const Generator* gen,
         Voice_state* vstate,
-        double frames[],
-        int frame_count);
+        Gen_block* block,
+        double* const frames[],
+        int32_t frame_count);
+
+
+#endif // K_GENERATOR_COMMON_H
 
 
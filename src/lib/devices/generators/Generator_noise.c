@@ -34,7 +34,6 @@
 typedef struct Noise_state
 {
     Gen_state parent;
-    int order;
 } Noise_state;
 
 
@@ -130,7 +129,6 @@ static Device_state* Generator_noise_create_state(
         return NULL;
 
     Gen_state_init(&noise_state->parent, device, audio_rate, audio_buffer_size);
-    noise_state->order = 0;
 
     return &noise_state->parent.parent;
 }
@@ -149,6 +147,7 @@ static void Generator_noise_init_vstate(
     assert(vstate != NULL);
 
     Voice_state_noise* noise_vstate = (Voice_state_noise*)vstate;
+    noise_vstate->order = 0;
     memset(noise_vstate->buf[0], 0, NOISE_MAX * sizeof(double));
     memset(noise_vstate->buf[1], 0, NOISE_MAX * sizeof(double));
 
@@ -181,7 +180,6 @@ static uint32_t Generator_noise_mix(
 //    double max_amp = 0;
 //  fprintf(stderr, "bufs are %p and %p\n", ins->bufs[0], ins->bufs[1]);
 
-    Noise_state* noise_state = (Noise_state*)gen_state;
     Voice_state_noise* noise_vstate = (Voice_state_noise*)vstate;
 
     if (vstate->note_on)
@@ -189,53 +187,66 @@ static uint32_t Generator_noise_mix(
         const int64_t* order_arg = Channel_gen_state_get_int(
                 vstate->cgstate, "o");
         if (order_arg != NULL)
-            noise_state->order = *order_arg;
+            noise_vstate->order = *order_arg;
         else
-            noise_state->order = 0;
+            noise_vstate->order = 0;
     }
 
     uint32_t mixed = offset;
-    for (; mixed < nframes && vstate->active; ++mixed)
+    while (mixed < nframes && vstate->active)
     {
-        Generator_common_handle_pitch(gen, vstate);
-        double vals[KQT_BUFFERS_MAX] = { 0 };
+        const int32_t block_len = min(nframes - mixed, GEN_BLOCK_FRAMES);
 
-        if(noise_state->order < 0)
-        {
-            vals[0] = dc_pole_filter(
-                    -noise_state->order,
-                    noise_vstate->buf[0],
-                    Random_get_float_signal(vstate->rand_s));
-            vals[1] = dc_pole_filter(
-                    -noise_state->order,
-                    noise_vstate->buf[1],
-                    Random_get_float_signal(vstate->rand_s));
-        }
-        else
+        Gen_block block;
+        Generator_common_handle_pitch(gen, vstate, &block, block_len);
+
+        double vals[KQT_BUFFERS_MAX][GEN_BLOCK_FRAMES];
+        double* frames[KQT_BUFFERS_MAX] = { vals[0], vals[1] };
+
+        for (int32_t i = 0; i < block_len; ++i)
         {
-            vals[0] = dc_zero_filter(
-                    noise_state->order,
-                    noise_vstate->buf[0],
-                    Random_get_float_signal(vstate->rand_s));
-            vals[1] = dc_zero_filter(
-                    noise_state->order,
-                    noise_vstate->buf[1],
-                    Random_get_float_signal(vstate->rand_s));
+            if (noise_vstate->order < 0)
+            {
+                vals[0][i] = dc_pole_filter(
+                        -noise_vstate->order,
+                        noise_vstate->buf[0],
+                        Random_get_float_signal(vstate->rand_s));
+                vals[1][i] = dc_pole_filter(
+                        -noise_vstate->order,
+                        noise_vstate->buf[1],
+                        Random_get_float_signal(vstate->rand_s));
+            }
+            else
+            {
+                vals[0][i] = dc_zero_filter(
+                        noise_vstate->order,
+                        noise_vstate->buf[0],
+                        Random_get_float_signal(vstate->rand_s));
+                vals[1][i] = dc_zero_filter(
+                        noise_vstate->order,
+                        noise_vstate->buf[1],
+                        Random_get_float_signal(vstate->rand_s));
+            }
         }
 
-        Generator_common_handle_force(gen, ins_state, vstate, vals, 2, freq);
-        Generator_common_handle_filter(gen, vstate, vals, 2, freq);
-        Generator_common_ramp_attack(gen, vstate, vals, 2, freq);
+        const int32_t frame_count = Generator_common_handle_force(
+                gen, ins_state, vstate, &block, frames, 2, freq);
+        Generator_common_handle_filter(
+                gen, vstate, &block, frames, 2, frame_count, freq);
+        Generator_common_ramp_attack(
+                gen, vstate, &block, frames, 2, frame_count, freq);
         vstate->pos = 1; // XXX: hackish
 
-//        Generator_common_handle_note_off(gen, vstate, vals, 2, freq);
-        Generator_common_handle_panning(gen, vstate, vals, 2);
-        bufs[0][mixed] += vals[0];
-        bufs[1][mixed] += vals[1];
-/*      if (fabs(val_l) > max_amp)
+        Generator_common_handle_panning(
+                gen, vstate, &block, frames, frame_count);
+
+        for (int32_t i = 0; i < frame_count; ++i)
         {
-            max_amp = fabs(val_l);
-        } */
+            bufs[0][mixed + i] += vals[0][i];
+            bufs[1][mixed + i] += vals[1][i];
+        }
+
+        mixed += frame_count;
     }
 
 //  fprintf(stderr, "max_amp is %lf\n", max_amp);
@@ -26,6 +26,7 @@
 #include <devices/generators/Voice_state_pcm.h>
 #include <devices/param_types/Hit_map.h>
 #include <devices/param_types/Sample.h>
+#include <devices/param_types/Sample_cache.h>
 #include <devices/param_types/Sample_mix.h>
 #include <devices/param_types/Wavpack.h>
 #include <memory.h>
@@ -44,6 +45,10 @@ static void Generator_pcm_init_vstate(
         const Gen_state* gen_state,
         Voice_state* vstate);
 
+static void Generator_pcm_clear_vstate(
+        const Generator* gen,
+        Voice_state* vstate);
+
 static uint32_t Generator_pcm_mix(
         const Generator* gen,
         Gen_state* gen_state,
@@ -72,6 +77,7 @@ Device_impl* new_Generator_pcm(Generator* gen)
     pcm->parent.device = (Device*)gen;
 
     gen->init_vstate = Generator_pcm_init_vstate;
+    gen->clear_vstate = Generator_pcm_clear_vstate;
     gen->mix = Generator_pcm_mix;
 
     return &pcm->parent;
@@ -126,6 +132,28 @@ static void Generator_pcm_init_vstate(
     pcm_state->source = 0;
     pcm_state->expr = 0;
     pcm_state->middle_tone = 0;
+    pcm_state->sample_source = NULL;
+    pcm_state->sample_data = NULL;
+
+    return;
+}
+
+
+static void Generator_pcm_clear_vstate(
+        const Generator* gen,
+        Voice_state* vstate)
+{
+    assert(gen != NULL);
+    (void)gen;
+    assert(vstate != NULL);
+
+    Voice_state_pcm* pcm_state = (Voice_state_pcm*)vstate;
+    if (pcm_state->sample_source != NULL)
+    {
+        Sample_source_release(pcm_state->sample_source);
+        pcm_state->sample_source = NULL;
+        pcm_state->sample_data = NULL;
+    }
 
     return;
 }
@@ -296,6 +324,27 @@ uint32_t Generator_pcm_mix(
         return offset;
     }
 
+    if (sample->source != NULL)
+    {
+        // Keep the decoded data for the whole note so that it is not evicted
+        // and the Sample cache is not locked for every block
+        if (pcm_state->sample_source != sample->source)
+        {
+            Generator_pcm_clear_vstate(gen, vstate);
+            const Sample* decoded = Sample_source_acquire(sample->source);
+            if (decoded == NULL)
+            {
+                vstate->active = false;
+                return offset;
+            }
+
+            pcm_state->sample_source = sample->source;
+            pcm_state->sample_data = decoded;
+        }
+
+        sample = pcm_state->sample_data;
+    }
+
     if (vstate->hit_index >= 0)
         pcm_state->middle_tone = 440;
 
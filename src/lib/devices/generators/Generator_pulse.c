@@ -25,6 +25,7 @@
 #include <devices/generators/Generator_pulse.h>
 #include <devices/generators/Voice_state_pulse.h>
 #include <kunquat/limits.h>
+#include <mathnum/common.h>
 #include <memory.h>
 #include <string/common.h>
 
@@ -198,32 +199,50 @@ uint32_t Generator_pulse_mix(
     }
 
     uint32_t mixed = offset;
-    for (; mixed < nframes && vstate->active; ++mixed)
+    while (mixed < nframes && vstate->active)
     {
-        Generator_common_handle_pitch(gen, vstate);
+        const int32_t block_len = min(nframes - mixed, GEN_BLOCK_FRAMES);
 
-        double vals[KQT_BUFFERS_MAX] = { 0 };
-        vals[0] = pulse(pulse_vstate->phase, pulse_vstate->pulse_width) / 6;
+        Gen_block block;
+        Generator_common_handle_pitch(gen, vstate, &block, block_len);
 
-        Generator_common_handle_force(gen, ins_state, vstate, vals, 1, freq);
-        Generator_common_handle_filter(gen, vstate, vals, 1, freq);
-        Generator_common_ramp_attack(gen, vstate, vals, 1, freq);
+        double vals[KQT_BUFFERS_MAX][GEN_BLOCK_FRAMES];
+        double* frames[KQT_BUFFERS_MAX] = { vals[0], vals[1] };
 
-        pulse_vstate->phase += vstate->actual_pitch / freq;
-        if (pulse_vstate->phase >= 1)
-            pulse_vstate->phase -= floor(pulse_vstate->phase);
+        for (int32_t i = 0; i < block_len; ++i)
+        {
+            vals[0][i] =
+                pulse(pulse_vstate->phase, pulse_vstate->pulse_width) / 6;
+
+            pulse_vstate->phase += block.actual_pitches[i] / freq;
+            if (pulse_vstate->phase >= 1)
+                pulse_vstate->phase -= floor(pulse_vstate->phase);
+        }
+
+        const int32_t frame_count = Generator_common_handle_force(
+                gen, ins_state, vstate, &block, frames, 1, freq);
+        Generator_common_handle_filter(
+                gen, vstate, &block, frames, 1, frame_count, freq);
+        Generator_common_ramp_attack(
+                gen, vstate, &block, frames, 1, frame_count, freq);
 
         vstate->pos = 1; // XXX: hackish
-//        Generator_common_handle_note_off(gen, vstate, vals, 1, freq);
-        vals[1] = vals[0];
-        Generator_common_handle_panning(gen, vstate, vals, 2);
-        bufs[0][mixed] += vals[0];
-        bufs[1][mixed] += vals[1];
-/*        if (fabs(val_l) > max_amp)
+
+        for (int32_t i = 0; i < frame_count; ++i)
+            vals[1][i] = vals[0][i];
+
+        Generator_common_handle_panning(
+                gen, vstate, &block, frames, frame_count);
+
+        for (int32_t i = 0; i < frame_count; ++i)
         {
-            max_amp = fabs(val_l);
-        } */
+            bufs[0][mixed + i] += vals[0][i];
+            bufs[1][mixed + i] += vals[1][i];
+        }
+
+        mixed += frame_count;
     }
+
 //  fprintf(stderr, "max_amp is %lf\n", max_amp);
 
     return mixed;
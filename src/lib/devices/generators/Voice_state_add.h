@@ -22,19 +22,6 @@
 #define HARMONICS_MAX 32
 
 
-typedef struct Add_tone_state
-{
-    double phase;
-#if 0
-    uint64_t pos;
-    double pos_rem;
-    uint64_t rel_pos;
-    double rel_pos_rem;
-    Filter_state lowpass_state[2];
-#endif
-} Add_tone_state;
-
-
 typedef struct Voice_state_add
 {
     Voice_state parent;
@@ -49,8 +36,8 @@ typedef struct Voice_state_add
     double mod_env_update;
     double mod_env_scale;
 
-    Add_tone_state tones[HARMONICS_MAX];
-    Add_tone_state mod_tones[HARMONICS_MAX];
+    double tone_phases[HARMONICS_MAX];
+    double mod_tone_phases[HARMONICS_MAX];
 } Voice_state_add;
 
 
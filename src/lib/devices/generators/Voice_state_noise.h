@@ -26,6 +26,7 @@
 typedef struct Voice_state_noise
 {
     Voice_state parent;
+    int order;
     double buf[2][NOISE_MAX];
 } Voice_state_noise;
 
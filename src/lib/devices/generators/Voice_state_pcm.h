@@ -16,6 +16,8 @@
 #define K_VOICE_STATE_PCM_H
 
 
+#include <Decl.h>
+#include <devices/param_types/Sample.h>
 #include <player/Voice_state.h>
 
 
@@ -29,6 +31,8 @@ typedef struct Voice_state_pcm
     uint8_t source;
     uint8_t expr;
     double middle_tone;
+    Sample_source* sample_source; ///< The acquired lazily decoded Sample.
+    const Sample* sample_data;    ///< The decoded data of \a sample_source.
 } Voice_state_pcm;
 
 
@@ -22,6 +22,7 @@
 #include <debug/assert.h>
 #include <devices/generators/Generator_common.h>
 #include <devices/param_types/Sample.h>
+#include <devices/param_types/Sample_cache.h>
 #include <devices/param_types/Sample_mix.h>
 #include <devices/param_types/Sample_params.h>
 #include <kunquat/limits.h>
@@ -29,6 +30,12 @@
 #include <memory.h>
 
 
+/**
+ * The maximum number of frames rendered by one pass of the block kernel.
+ */
+#define SAMPLE_BLOCK_FRAMES GEN_BLOCK_FRAMES
+
+
 Sample* new_Sample(void)
 {
     Sample* sample = memory_alloc_item(Sample);
@@ -45,6 +52,7 @@ Sample* new_Sample(void)
     sample->len = 0;
     sample->data[0] = NULL;
     sample->data[1] = NULL;
+    sample->source = NULL;
 
     return sample;
 }
@@ -181,6 +189,200 @@ void* Sample_get_buffer(Sample* sample, int ch)
 }
 
 
+#define SAMPLE_INTERPOLATE(name, type, divisor)                          \
+    static void name(                                                    \
+            const Sample* sample,                                        \
+            const uint64_t* restrict positions,                          \
+            const double* restrict rems,                                 \
+            int32_t count,                                               \
+            double* restrict out_l,                                      \
+            double* restrict out_r)                                      \
+    {                                                                    \
+        const type* restrict buf_l = sample->data[0];                    \
+        for (int32_t i = 0; i < count; ++i)                              \
+        {                                                                \
+            const double cur = buf_l[positions[i]];                      \
+            const double next = buf_l[positions[i] + 1];                 \
+            out_l[i] = (cur + rems[i] * (next - cur)) / (divisor);       \
+        }                                                                \
+                                                                         \
+        if (sample->channels > 1)                                        \
+        {                                                                \
+            const type* restrict buf_r = sample->data[1];                \
+            for (int32_t i = 0; i < count; ++i)                          \
+            {                                                            \
+                const double cur = buf_r[positions[i]];                  \
+                const double next = buf_r[positions[i] + 1];             \
+                out_r[i] = (cur + rems[i] * (next - cur)) / (divisor);   \
+            }                                                            \
+        }                                                                \
+        else                                                             \
+        {                                                                \
+            for (int32_t i = 0; i < count; ++i)                          \
+                out_r[i] = out_l[i];                                     \
+        }                                                                \
+                                                                         \
+        return;                                                          \
+    }
+
+SAMPLE_INTERPOLATE(Sample_interpolate_float, float, 1)
+SAMPLE_INTERPOLATE(Sample_interpolate_8, int8_t, 0x80)
+SAMPLE_INTERPOLATE(Sample_interpolate_16, int16_t, 0x8000UL)
+SAMPLE_INTERPOLATE(Sample_interpolate_32, int32_t, 0x80000000UL)
+
+#undef SAMPLE_INTERPOLATE
+
+
+/**
+ * Mix frames that can be rendered without per-frame loop handling.
+ *
+ * This function handles the frames at the beginning of the area that play
+ * forwards at a constant pitch without reaching a loop boundary or the end of
+ * the Sample. The read positions of these frames are known in advance, so
+ * the Sample data is interpolated by a type-specialised kernel before the
+ * per-frame processing.
+ *
+ * \return   The number of frames mixed, or \c 0 if the next frame requires
+ *           the per-frame path.
+ */
+static uint32_t Sample_mix_block(
+        const Sample* sample,
+        const Sample_params* params,
+        const Generator* gen,
+        Ins_state* ins_state,
+        Voice_state* vstate,
+        uint32_t nframes,
+        uint32_t offset,
+        uint32_t freq,
+        kqt_frame** bufs,
+        double middle_tone,
+        double middle_freq,
+        double vol_scale)
+{
+    assert(sample != NULL);
+    assert(params != NULL);
+    assert(gen != NULL);
+    assert(ins_state != NULL);
+    assert(vstate != NULL);
+    assert(offset < nframes);
+    assert(bufs != NULL);
+
+    // Pitch changes would make the read positions unpredictable
+    if (Slider_in_progress(&vstate->pitch_slider) ||
+            vstate->arpeggio ||
+            LFO_active(&vstate->vibrato))
+        return 0;
+
+    // Find the limits of forward playback without a wrap-around
+    uint64_t read_limit = sample->len;
+    uint64_t pos_limit = sample->len;
+    if (params->loop != SAMPLE_LOOP_OFF)
+    {
+        if (vstate->dir <= 0 || params->loop_start + 1 >= params->loop_end)
+            return 0;
+
+        read_limit = params->loop_end;
+        pos_limit = (params->loop == SAMPLE_LOOP_UNI)
+            ? params->loop_end : params->loop_end - 1;
+    }
+
+    if (vstate->rel_pos + 1 >= read_limit)
+        return 0;
+
+    const double advance = (vstate->pitch / middle_tone) * middle_freq / freq;
+    const uint64_t adv = floor(advance);
+    const double adv_rem = advance - adv;
+
+    // Plan the read positions
+    uint64_t positions[SAMPLE_BLOCK_FRAMES];
+    double rems[SAMPLE_BLOCK_FRAMES];
+
+    const int32_t max_count = min(nframes - offset, SAMPLE_BLOCK_FRAMES);
+    int32_t count = 0;
+
+    uint64_t rel_pos = vstate->rel_pos;
+    double rel_pos_rem = vstate->rel_pos_rem;
+    while (count < max_count && rel_pos + 1 < read_limit)
+    {
+        uint64_t next_rel_pos = rel_pos + adv;
+        double next_rel_pos_rem = rel_pos_rem + adv_rem;
+        if (next_rel_pos_rem >= 1)
+        {
+            next_rel_pos += floor(next_rel_pos_rem);
+            next_rel_pos_rem -= floor(next_rel_pos_rem);
+        }
+
+        if (next_rel_pos >= pos_limit)
+            break;
+
+        positions[count] = rel_pos;
+        rems[count] = rel_pos_rem;
+        ++count;
+
+        rel_pos = next_rel_pos;
+        rel_pos_rem = next_rel_pos_rem;
+    }
+
+    if (count == 0)
+        return 0;
+
+    // Interpolate
+    double vals_l[SAMPLE_BLOCK_FRAMES];
+    double vals_r[SAMPLE_BLOCK_FRAMES];
+
+    if (sample->is_float)
+        Sample_interpolate_float(sample, positions, rems, count, vals_l, vals_r);
+    else if (sample->bits == 8)
+        Sample_interpolate_8(sample, positions, rems, count, vals_l, vals_r);
+    else if (sample->bits == 16)
+        Sample_interpolate_16(sample, positions, rems, count, vals_l, vals_r);
+    else if (sample->bits == 32)
+        Sample_interpolate_32(sample, positions, rems, count, vals_l, vals_r);
+    else
+        assert(false);
+
+    // Apply the Voice processing
+    Gen_block block;
+    Generator_common_handle_pitch(gen, vstate, &block, count);
+    assert(vstate->actual_pitch == vstate->pitch);
+
+    double* frames[KQT_BUFFERS_MAX] = { vals_l, vals_r };
+    const int32_t frame_count = Generator_common_handle_force(
+            gen, ins_state, vstate, &block, frames, 2, freq);
+    Generator_common_handle_filter(
+            gen, vstate, &block, frames, 2, frame_count, freq);
+    Generator_common_handle_panning(gen, vstate, &block, frames, frame_count);
+
+    for (int32_t i = 0; i < frame_count; ++i)
+    {
+        bufs[0][offset + i] += vals_l[i] * vol_scale;
+        bufs[1][offset + i] += vals_r[i] * vol_scale;
+    }
+
+    // Move forwards
+    for (int32_t i = 0; i < frame_count; ++i)
+    {
+        const uint64_t prev_pos = vstate->pos;
+        vstate->pos += adv;
+        vstate->pos_rem += adv_rem;
+
+        if (vstate->pos_rem >= 1)
+        {
+            vstate->pos += floor(vstate->pos_rem);
+            vstate->pos_rem -= floor(vstate->pos_rem);
+        }
+
+        vstate->rel_pos += vstate->pos - prev_pos;
+        vstate->rel_pos_rem = vstate->pos_rem;
+    }
+
+    if (params->loop != SAMPLE_LOOP_OFF)
+        vstate->dir = 1;
+
+    return (uint32_t)frame_count;
+}
+
+
 uint32_t Sample_mix(
         const Sample* sample,
         const Sample_params* params,
@@ -198,6 +400,7 @@ uint32_t Sample_mix(
         double vol_scale)
 {
     assert(sample != NULL);
+    assert(sample->source == NULL);
     assert(params != NULL);
     assert(gen != NULL);
     assert(ins_state != NULL);
@@ -215,7 +418,7 @@ uint32_t Sample_mix(
     Generator_common_check_relative_lengths(gen, vstate, freq, tempo);
 
     uint32_t mixed = offset;
-    for (; mixed < nframes && vstate->active; ++mixed)
+    while (mixed < nframes && vstate->active)
     {
         if (vstate->rel_pos >= sample->len)
         {
@@ -223,7 +426,27 @@ uint32_t Sample_mix(
             break;
         }
 
-        Generator_common_handle_pitch(gen, vstate);
+        const uint32_t block_mixed = Sample_mix_block(
+                sample,
+                params,
+                gen,
+                ins_state,
+                vstate,
+                nframes,
+                mixed,
+                freq,
+                bufs,
+                middle_tone,
+                middle_freq,
+                vol_scale);
+        if (block_mixed > 0)
+        {
+            mixed += block_mixed;
+            continue;
+        }
+
+        Gen_block block;
+        Generator_common_handle_pitch(gen, vstate, &block, 1);
 
         bool next_exists = false;
         uint64_t next_pos = 0;
@@ -337,14 +560,17 @@ uint32_t Sample_mix(
                     vals[0] /= 0x80000000UL;
                     vals[1] /= 0x80000000UL;
                 }
+                break;
                 default:
                     assert(false);
             }
         }
 #undef get_items
 
-        Generator_common_handle_force(gen, ins_state, vstate, vals, 2, freq);
-        Generator_common_handle_filter(gen, vstate, vals, 2, freq);
+        double* frames[KQT_BUFFERS_MAX] = { &vals[0], &vals[1] };
+        Generator_common_handle_force(
+                gen, ins_state, vstate, &block, frames, 2, freq);
+        Generator_common_handle_filter(gen, vstate, &block, frames, 2, 1, freq);
 
         double advance = (vstate->actual_pitch / middle_tone) * middle_freq / freq;
         uint64_t adv = floor(advance);
@@ -353,7 +579,7 @@ uint32_t Sample_mix(
         vstate->pos += adv;
         vstate->pos_rem += adv_rem;
 //        Generator_common_handle_note_off(gen, vstate, vals, 2, freq);
-        Generator_common_handle_panning(gen, vstate, vals, 2);
+        Generator_common_handle_panning(gen, vstate, &block, frames, 1);
 
         bufs[0][mixed] += vals[0] * vol_scale;
         bufs[1][mixed] += vals[1] * vol_scale;
@@ -428,6 +654,8 @@ uint32_t Sample_mix(
         }
 
         assert(vstate->rel_pos < sample->len);
+
+        ++mixed;
     }
 
     return mixed;
@@ -463,6 +691,7 @@ void del_Sample(Sample* sample)
     if (sample == NULL)
         return;
 
+    del_Sample_source(sample->source);
     memory_free(sample->data[0]);
     memory_free(sample->data[1]);
     memory_free(sample);
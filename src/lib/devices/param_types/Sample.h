@@ -20,6 +20,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#include <Decl.h>
 #include <devices/param_types/Sample_params.h>
 #include <frame.h>
 
@@ -38,6 +39,7 @@ typedef struct Sample
     bool is_float;        ///< Whether this sample is in floating point format.
     uint64_t len;         ///< The length of the sample (in amplitude values per channel).
     void* data[2];        ///< The sample data.
+    Sample_source* source; ///< The encoded data if decoded lazily.
 } Sample;
 
 
@@ -0,0 +1,424 @@
+
+
+/*
+ * Author: Tomi Jylhä-Ollila, Finland 2014
+ *
+ * This file is part of Kunquat.
+ *
+ * CC0 1.0 Universal, http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * To the extent possible under law, Kunquat Affirmers have waived all
+ * copyright and related or neighboring rights to Kunquat.
+ */
+
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <debug/assert.h>
+#include <devices/param_types/Sample_cache.h>
+#include <memory.h>
+
+
+struct Sample_source
+{
+    Sample_cache* cache;
+    char* data;
+    size_t length;
+    Sample_decoder* decode;
+
+    Sample* sample;
+    uint64_t size;
+    int pin_count;
+    bool orphaned; ///< Destroy after the last release.
+
+    Sample_source* prev; ///< The next more recently used decoded source.
+    Sample_source* next; ///< The next less recently used decoded source.
+};
+
+
+typedef struct Decoded_entry
+{
+    const char* data;
+    size_t length;
+    Sample* sample;
+} Decoded_entry;
+
+
+struct Sample_cache
+{
+    pthread_mutex_t lock;
+    uint64_t limit;
+    uint64_t size;
+    int source_count;
+
+    Sample_source* first; ///< The most recently used decoded source.
+    Sample_source* last;  ///< The least recently used decoded source.
+
+    int decoded_count;
+    int decoded_capacity;
+    Decoded_entry* decoded; ///< Samples decoded in advance.
+};
+
+
+static void Sample_cache_unlink(Sample_cache* cache, Sample_source* source)
+{
+    assert(cache != NULL);
+    assert(source != NULL);
+
+    if (source->prev != NULL)
+        source->prev->next = source->next;
+    else
+        cache->first = source->next;
+
+    if (source->next != NULL)
+        source->next->prev = source->prev;
+    else
+        cache->last = source->prev;
+
+    source->prev = NULL;
+    source->next = NULL;
+
+    return;
+}
+
+
+static void Sample_cache_push_front(Sample_cache* cache, Sample_source* source)
+{
+    assert(cache != NULL);
+    assert(source != NULL);
+    assert(source->prev == NULL);
+    assert(source->next == NULL);
+
+    source->next = cache->first;
+    if (cache->first != NULL)
+        cache->first->prev = source;
+    else
+        cache->last = source;
+    cache->first = source;
+
+    return;
+}
+
+
+static void Sample_source_discard(Sample_source* source)
+{
+    assert(source != NULL);
+    assert(source->sample != NULL);
+    assert(source->pin_count == 0);
+
+    Sample_cache* cache = source->cache;
+    Sample_cache_unlink(cache, source);
+    assert(cache->size >= source->size);
+    cache->size -= source->size;
+
+    del_Sample(source->sample);
+    source->sample = NULL;
+    source->size = 0;
+
+    return;
+}
+
+
+static void Sample_cache_evict(Sample_cache* cache)
+{
+    assert(cache != NULL);
+
+    Sample_source* cur = cache->last;
+    while (cache->size > cache->limit && cur != NULL)
+    {
+        Sample_source* prev = cur->prev;
+        if (cur->pin_count == 0)
+            Sample_source_discard(cur);
+        cur = prev;
+    }
+
+    return;
+}
+
+
+Sample_cache* new_Sample_cache(uint64_t limit)
+{
+    Sample_cache* cache = memory_alloc_item(Sample_cache);
+    if (cache == NULL)
+        return NULL;
+
+    if (pthread_mutex_init(&cache->lock, NULL) != 0)
+    {
+        memory_free(cache);
+        return NULL;
+    }
+
+    cache->limit = limit;
+    cache->size = 0;
+    cache->source_count = 0;
+    cache->first = NULL;
+    cache->last = NULL;
+    cache->decoded_count = 0;
+    cache->decoded_capacity = 0;
+    cache->decoded = NULL;
+
+    return cache;
+}
+
+
+void Sample_cache_set_limit(Sample_cache* cache, uint64_t limit)
+{
+    assert(cache != NULL);
+
+    pthread_mutex_lock(&cache->lock);
+    cache->limit = limit;
+    Sample_cache_evict(cache);
+    pthread_mutex_unlock(&cache->lock);
+
+    return;
+}
+
+
+uint64_t Sample_cache_get_limit(const Sample_cache* cache)
+{
+    assert(cache != NULL);
+    return cache->limit;
+}
+
+
+uint64_t Sample_cache_get_size(const Sample_cache* cache)
+{
+    assert(cache != NULL);
+    return cache->size;
+}
+
+
+bool Sample_cache_add_decoded(
+        Sample_cache* cache, const char* data, size_t length, Sample* sample)
+{
+    assert(cache != NULL);
+    assert(data != NULL);
+    assert(sample != NULL);
+
+    if (cache->decoded_count >= cache->decoded_capacity)
+    {
+        const int new_capacity = (cache->decoded_capacity > 0) ?
+            cache->decoded_capacity * 2 : 16;
+        Decoded_entry* new_decoded = memory_realloc_items(
+                Decoded_entry, new_capacity, cache->decoded);
+        if (new_decoded == NULL)
+            return false;
+
+        cache->decoded = new_decoded;
+        cache->decoded_capacity = new_capacity;
+    }
+
+    Decoded_entry* entry = &cache->decoded[cache->decoded_count];
+    entry->data = data;
+    entry->length = length;
+    entry->sample = sample;
+    ++cache->decoded_count;
+
+    return true;
+}
+
+
+Sample* Sample_cache_take_decoded(
+        Sample_cache* cache, const char* data, size_t length)
+{
+    assert(cache != NULL);
+    assert(data != NULL);
+
+    for (int i = 0; i < cache->decoded_count; ++i)
+    {
+        Decoded_entry* entry = &cache->decoded[i];
+        if (entry->data == data && entry->length == length)
+        {
+            Sample* sample = entry->sample;
+            --cache->decoded_count;
+            *entry = cache->decoded[cache->decoded_count];
+            return sample;
+        }
+    }
+
+    return NULL;
+}
+
+
+void Sample_cache_clear_decoded(Sample_cache* cache)
+{
+    assert(cache != NULL);
+
+    for (int i = 0; i < cache->decoded_count; ++i)
+        del_Sample(cache->decoded[i].sample);
+    cache->decoded_count = 0;
+
+    return;
+}
+
+
+void del_Sample_cache(Sample_cache* cache)
+{
+    if (cache == NULL)
+        return;
+
+    assert(cache->source_count == 0);
+    Sample_cache_clear_decoded(cache);
+    memory_free(cache->decoded);
+    pthread_mutex_destroy(&cache->lock);
+    memory_free(cache);
+
+    return;
+}
+
+
+Sample_source* new_Sample_source(
+        Sample_cache* cache,
+        const char* data,
+        size_t length,
+        Sample_decoder* decode)
+{
+    assert(cache != NULL);
+    assert(data != NULL);
+    assert(length > 0);
+    assert(decode != NULL);
+
+    Sample_source* source = memory_alloc_item(Sample_source);
+    if (source == NULL)
+        return NULL;
+
+    source->data = memory_alloc_items(char, length);
+    if (source->data == NULL)
+    {
+        memory_free(source);
+        return NULL;
+    }
+
+    memcpy(source->data, data, length);
+    source->cache = cache;
+    source->length = length;
+    source->decode = decode;
+    source->sample = NULL;
+    source->size = 0;
+    source->pin_count = 0;
+    source->orphaned = false;
+    source->prev = NULL;
+    source->next = NULL;
+
+    pthread_mutex_lock(&cache->lock);
+    ++cache->source_count;
+    pthread_mutex_unlock(&cache->lock);
+
+    return source;
+}
+
+
+const Sample* Sample_source_acquire(Sample_source* source)
+{
+    assert(source != NULL);
+
+    Sample_cache* cache = source->cache;
+    pthread_mutex_lock(&cache->lock);
+
+    if (source->sample == NULL)
+    {
+        Sample* sample = new_Sample();
+        if (sample == NULL)
+        {
+            pthread_mutex_unlock(&cache->lock);
+            return NULL;
+        }
+
+        Streader* sr = Streader_init(
+                STREADER_AUTO, source->data, source->length);
+        if (!source->decode(sample, sr))
+        {
+            del_Sample(sample);
+            pthread_mutex_unlock(&cache->lock);
+            return NULL;
+        }
+
+        source->sample = sample;
+        source->size = sample->len * (uint64_t)(sample->bits / 8) *
+            (uint64_t)sample->channels;
+        cache->size += source->size;
+    }
+    else
+    {
+        Sample_cache_unlink(cache, source);
+    }
+
+    Sample_cache_push_front(cache, source);
+    ++source->pin_count;
+    Sample_cache_evict(cache);
+
+    const Sample* sample = source->sample;
+    pthread_mutex_unlock(&cache->lock);
+
+    return sample;
+}
+
+
+void Sample_source_release(Sample_source* source)
+{
+    assert(source != NULL);
+
+    Sample_cache* cache = source->cache;
+    pthread_mutex_lock(&cache->lock);
+
+    assert(source->sample != NULL);
+    assert(source->pin_count > 0);
+    --source->pin_count;
+
+    const bool destroy = (source->pin_count == 0) && source->orphaned;
+    if (destroy)
+    {
+        Sample_source_discard(source);
+        --cache->source_count;
+    }
+    else if (source->pin_count == 0)
+    {
+        Sample_cache_evict(cache);
+    }
+
+    pthread_mutex_unlock(&cache->lock);
+
+    if (destroy)
+    {
+        memory_free(source->data);
+        memory_free(source);
+    }
+
+    return;
+}
+
+
+void del_Sample_source(Sample_source* source)
+{
+    if (source == NULL)
+        return;
+
+    Sample_cache* cache = source->cache;
+    pthread_mutex_lock(&cache->lock);
+
+    assert(!source->orphaned);
+    if (source->pin_count > 0)
+    {
+        // Still used by Voices, the last release destroys the source
+        source->orphaned = true;
+        pthread_mutex_unlock(&cache->lock);
+        return;
+    }
+
+    if (source->sample != NULL)
+        Sample_source_discard(source);
+    --cache->source_count;
+
+    pthread_mutex_unlock(&cache->lock);
+
+    memory_free(source->data);
+    memory_free(source);
+
+    return;
+}
+
+
@@ -0,0 +1,205 @@
+
+
+/*
+ * Author: Tomi Jylhä-Ollila, Finland 2014
+ *
+ * This file is part of Kunquat.
+ *
+ * CC0 1.0 Universal, http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * To the extent possible under law, Kunquat Affirmers have waived all
+ * copyright and related or neighboring rights to Kunquat.
+ */
+
+
+#ifndef K_SAMPLE_CACHE_H
+#define K_SAMPLE_CACHE_H
+
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <Decl.h>
+#include <devices/param_types/Sample.h>
+#include <string/Streader.h>
+
+
+/**
+ * Sample cache keeps the decoded data of lazily decoded Samples.
+ *
+ * The amount of decoded data in the cache is bounded. When a Sample needs to
+ * be decoded and the limit is exceeded, the least recently used Samples that
+ * are not acquired by anyone are discarded. A Sample cache with a limit of \c 0
+ * disables lazy decoding of new Samples.
+ *
+ * The Sample cache also holds Samples that have been decoded in advance
+ * while loading, until the parser of the encoded data claims them.
+ *
+ * Sample_cache_set_limit and the functions that access Sample sources are
+ * thread-safe.
+ */
+typedef struct Sample_cache Sample_cache;
+
+
+/**
+ * A function that decodes Sample data.
+ *
+ * \param sample   The destination Sample -- must not be \c NULL.
+ * \param sr       The Streader of the encoded data -- must not be \c NULL.
+ *
+ * \return   \c true if successful, otherwise \c false.
+ */
+typedef bool Sample_decoder(Sample* sample, Streader* sr);
+
+
+/**
+ * Create a new Sample cache.
+ *
+ * \param limit   The maximum amount of decoded data in bytes.
+ *
+ * \return   The new Sample cache if successful, or \c NULL if memory
+ *           allocation failed.
+ */
+Sample_cache* new_Sample_cache(uint64_t limit);
+
+
+/**
+ * Set the maximum amount of decoded data in the Sample cache.
+ *
+ * Unused Samples are discarded immediately if the new limit is exceeded.
+ *
+ * \param cache   The Sample cache -- must not be \c NULL.
+ * \param limit   The maximum amount of decoded data in bytes.
+ */
+void Sample_cache_set_limit(Sample_cache* cache, uint64_t limit);
+
+
+/**
+ * Get the maximum amount of decoded data in the Sample cache.
+ *
+ * \param cache   The Sample cache -- must not be \c NULL.
+ *
+ * \return   The limit in bytes.
+ */
+uint64_t Sample_cache_get_limit(const Sample_cache* cache);
+
+
+/**
+ * Get the amount of decoded data in the Sample cache.
+ *
+ * \param cache   The Sample cache -- must not be \c NULL.
+ *
+ * \return   The amount of decoded data in bytes.
+ */
+uint64_t Sample_cache_get_size(const Sample_cache* cache);
+
+
+/**
+ * Add a Sample decoded in advance to the Sample cache.
+ *
+ * \param cache    The Sample cache -- must not be \c NULL.
+ * \param data     The encoded data -- must not be \c NULL. The data is only
+ *                 used for identifying the Sample and must remain unchanged
+ *                 until the Sample is claimed or discarded.
+ * \param length   The length of \a data in bytes.
+ * \param sample   The decoded Sample -- must not be \c NULL. The Sample
+ *                 cache assumes ownership of the Sample.
+ *
+ * \return   \c true if successful, or \c false if memory allocation failed.
+ *           The Sample is not added in case of failure.
+ */
+bool Sample_cache_add_decoded(
+        Sample_cache* cache, const char* data, size_t length, Sample* sample);
+
+
+/**
+ * Claim a Sample decoded in advance.
+ *
+ * \param cache    The Sample cache -- must not be \c NULL.
+ * \param data     The encoded data -- must not be \c NULL.
+ * \param length   The length of \a data in bytes.
+ *
+ * \return   The Sample decoded from \a data, or \c NULL if not found. The
+ *           caller assumes ownership of the returned Sample.
+ */
+Sample* Sample_cache_take_decoded(
+        Sample_cache* cache, const char* data, size_t length);
+
+
+/**
+ * Discard all unclaimed Samples decoded in advance.
+ *
+ * \param cache   The Sample cache -- must not be \c NULL.
+ */
+void Sample_cache_clear_decoded(Sample_cache* cache);
+
+
+/**
+ * Destroy an existing Sample cache.
+ *
+ * All Sample sources of the Sample cache must be destroyed first.
+ *
+ * \param cache   The Sample cache, or \c NULL.
+ */
+void del_Sample_cache(Sample_cache* cache);
+
+
+/**
+ * Create a new Sample source.
+ *
+ * Sample source contains the encoded data of a lazily decoded Sample.
+ *
+ * \param cache    The Sample cache -- must not be \c NULL.
+ * \param data     The encoded data -- must not be \c NULL. The data is copied.
+ * \param length   The length of \a data in bytes -- must be > \c 0.
+ * \param decode   The decoder of \a data -- must not be \c NULL.
+ *
+ * \return   The new Sample source if successful, or \c NULL if memory
+ *           allocation failed.
+ */
+Sample_source* new_Sample_source(
+        Sample_cache* cache,
+        const char* data,
+        size_t length,
+        Sample_decoder* decode);
+
+
+/**
+ * Get the decoded Sample of the Sample source.
+ *
+ * The Sample is decoded if it is not in the Sample cache. The returned
+ * Sample remains valid and is not discarded from the Sample cache until a
+ * matching call of Sample_source_release. A Voice typically acquires its
+ * Sample once at the start of the note and releases it when the Voice is
+ * reset, as acquiring locks the Sample cache.
+ *
+ * \param source   The Sample source -- must not be \c NULL.
+ *
+ * \return   The decoded Sample, or \c NULL if decoding failed.
+ */
+const Sample* Sample_source_acquire(Sample_source* source);
+
+
+/**
+ * Release a Sample returned by Sample_source_acquire.
+ *
+ * \param source   The Sample source -- must not be \c NULL.
+ */
+void Sample_source_release(Sample_source* source);
+
+
+/**
+ * Destroy an existing Sample source.
+ *
+ * If the Sample source is still acquired, it is destroyed by the last call
+ * of Sample_source_release instead.
+ *
+ * \param source   The Sample source, or \c NULL.
+ */
+void del_Sample_source(Sample_source* source);
+
+
+#endif // K_SAMPLE_CACHE_H
+
+
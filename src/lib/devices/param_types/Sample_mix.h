@@ -27,7 +27,9 @@
 /**
  * Mix a Sample.
  *
- * \param sample        The Sample -- must not be \c NULL.
+ * \param sample        The Sample -- must not be \c NULL and must contain the
+ *                      decoded data. Lazily decoded Samples must be acquired
+ *                      from their Sample sources first.
  * \param params        The Sample parameters -- must not be \c NULL.
  * \param gen           The Generator containing the Sample -- must not be
  *                      \c NULL.
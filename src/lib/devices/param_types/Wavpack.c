@@ -19,6 +19,7 @@
 
 #include <debug/assert.h>
 #include <devices/param_types/Sample.h>
+#include <devices/param_types/Sample_cache.h>
 #include <devices/param_types/Wavpack.h>
 #include <mathnum/common.h>
 #include <memory.h>
@@ -41,6 +42,16 @@ bool Sample_parse_wavpack(Sample* sample, Streader* sr)
     return false;
 }
 
+
+bool Sample_parse_wavpack_lazy(
+        Sample* sample, Streader* sr, Sample_cache* cache)
+{
+    assert(cache != NULL);
+    (void)cache;
+
+    return Sample_parse_wavpack(sample, sr);
+}
+
 #else // WITH_WAVPACK
 
 
@@ -215,39 +226,17 @@ static WavpackStreamReader reader_str =
 };
 
 
-#define read_wp_samples(count, offset, buf_l, buf_r, src, channels, lshift) \
-    if (true)                                                               \
-    {                                                                       \
-        assert(buf_l != NULL);                                              \
-        for (uint32_t i = 0; i < count; ++i)                                \
-            buf_l[offset + i] = src[i * channels] << lshift;                \
-                                                                            \
-        if (channels == 2)                                                  \
-        {                                                                   \
-            assert(buf_r != NULL);                                          \
-            for (uint32_t i = 0; i < count; ++i)                            \
-                buf_r[offset + i] = src[i * channels + 1] << lshift;        \
-        }                                                                   \
-    } else (void)0
-
-bool Sample_parse_wavpack(Sample* sample, Streader* sr)
+static WavpackContext* Sample_open_wavpack(
+        Sample* sample, Streader* sr, String_context* sc)
 {
     assert(sample != NULL);
     assert(sr != NULL);
+    assert(sc != NULL);
 
-    if (Streader_is_error_set(sr))
-        return false;
-
-    const void* data = sr->str;
-    const size_t length = sr->len;
-
-    String_context* sc =
-        &(String_context) {
-            .data = data,
-            .length = length,
-            .pos = 0,
-            .push_back = EOF
-        };
+    sc->data = sr->str;
+    sc->length = sr->len;
+    sc->pos = 0;
+    sc->push_back = EOF;
 
     char err_str[80] = { '\0' };
     WavpackContext* context = WavpackOpenFileInputEx(
@@ -260,14 +249,13 @@ bool Sample_parse_wavpack(Sample* sample, Streader* sr)
     if (context == NULL)
     {
         Streader_set_error(sr, err_str);
-        return false;
+        return NULL;
     }
 
     int mode = WavpackGetMode(context);
     int channels = WavpackGetReducedChannels(context);
 //    uint32_t freq = WavpackGetSampleRate(context);
     int bits = WavpackGetBitsPerSample(context);
-    int bytes = WavpackGetBytesPerSample(context);
     uint32_t len = WavpackGetNumSamples(context);
 //    uint32_t file_size = WavpackGetFileSize(context);
 
@@ -275,7 +263,7 @@ bool Sample_parse_wavpack(Sample* sample, Streader* sr)
     {
         WavpackCloseFile(context);
         Streader_set_error(sr, "Couldn't determine WavPack file length");
-        return false;
+        return NULL;
     }
 
 //    sample->params.format = SAMPLE_FORMAT_WAVPACK;
@@ -301,6 +289,41 @@ bool Sample_parse_wavpack(Sample* sample, Streader* sr)
         sample->bits = 32;
     }
 
+    return context;
+}
+
+
+#define read_wp_samples(count, offset, buf_l, buf_r, src, channels, lshift) \
+    if (true)                                                               \
+    {                                                                       \
+        assert(buf_l != NULL);                                              \
+        for (uint32_t i = 0; i < count; ++i)                                \
+            buf_l[offset + i] = src[i * channels] << lshift;                \
+                                                                            \
+        if (channels == 2)                                                  \
+        {                                                                   \
+            assert(buf_r != NULL);                                          \
+            for (uint32_t i = 0; i < count; ++i)                            \
+                buf_r[offset + i] = src[i * channels + 1] << lshift;        \
+        }                                                                   \
+    } else (void)0
+
+bool Sample_parse_wavpack(Sample* sample, Streader* sr)
+{
+    assert(sample != NULL);
+    assert(sr != NULL);
+
+    if (Streader_is_error_set(sr))
+        return false;
+
+    String_context* sc = &(String_context){ .data = NULL };
+    WavpackContext* context = Sample_open_wavpack(sample, sr, sc);
+    if (context == NULL)
+        return false;
+
+    const int channels = sample->channels;
+    const int bytes = WavpackGetBytesPerSample(context);
+
     int req_bytes = sample->bits / 8;
     sample->data[0] = sample->data[1] = NULL;
     void* nbuf_l = memory_alloc_items(char, sample->len * req_bytes);
@@ -415,6 +438,41 @@ bool Sample_parse_wavpack(Sample* sample, Streader* sr)
 #undef read_wp_samples
 
 
+bool Sample_parse_wavpack_lazy(
+        Sample* sample, Streader* sr, Sample_cache* cache)
+{
+    assert(sample != NULL);
+    assert(sr != NULL);
+    assert(cache != NULL);
+
+    if (Streader_is_error_set(sr))
+        return false;
+
+    // Only read the header here, the data is decoded on first use
+    String_context* sc = &(String_context){ .data = NULL };
+    WavpackContext* context = Sample_open_wavpack(sample, sr, sc);
+    if (context == NULL)
+        return false;
+
+    WavpackCloseFile(context);
+
+    if (sample->len == 0)
+        return true;
+
+    Sample_source* source = new_Sample_source(
+            cache, sr->str, sr->len, Sample_parse_wavpack);
+    if (source == NULL)
+    {
+        Streader_set_memory_error(sr, "Could not allocate memory for sample");
+        return false;
+    }
+
+    sample->source = source;
+
+    return true;
+}
+
+
 #endif // WITH_WAVPACK
 
 
@@ -19,12 +19,27 @@
 #include <stdbool.h>
 
 #include <devices/param_types/Sample.h>
+#include <devices/param_types/Sample_cache.h>
 #include <string/Streader.h>
 
 
 bool Sample_parse_wavpack(Sample* sample, Streader* sr);
 
 
+/**
+ * Parse the header of WavPack data and defer the decoding to first use.
+ *
+ * \param sample   The destination Sample -- must not be \c NULL.
+ * \param sr       The Streader of the WavPack data -- must not be \c NULL.
+ * \param cache    The Sample cache that stores the decoded data -- must not
+ *                 be \c NULL.
+ *
+ * \return   \c true if successful, otherwise \c false.
+ */
+bool Sample_parse_wavpack_lazy(
+        Sample* sample, Streader* sr, Sample_cache* cache);
+
+
 #endif // K_WAVPACK_H
 
 
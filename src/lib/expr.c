@@ -23,6 +23,7 @@
 #include <debug/assert.h>
 #include <expr.h>
 #include <mathnum/common.h>
+#include <memory.h>
 #include <Pat_inst_ref.h>
 #include <string/common.h>
 
@@ -165,6 +166,51 @@ static Func_desc funcs[] =
 };
 
 
+typedef enum
+{
+    EXPR_PUSH_CONST,
+    EXPR_PUSH_VAR,
+    EXPR_PUSH_META,
+    EXPR_NOT,
+    EXPR_NEG,
+    EXPR_BINARY,
+    EXPR_CALL,
+} Expr_op;
+
+
+typedef struct Expr_instr
+{
+    Expr_op op;
+    Op_func binary;
+    Func func;
+    int arg_count;
+    Value value; ///< The constant, or the variable name in \a string_type.
+} Expr_instr;
+
+
+struct Expr
+{
+    bool is_const;
+    int length;
+    int capacity;
+    Expr_instr* instrs;
+};
+
+
+typedef struct Expr_builder
+{
+    Expr* expr;
+    int height;
+} Expr_builder;
+
+
+static bool compile_expr_(
+        Streader* sr,
+        Expr_builder* eb,
+        int depth,
+        bool func_arg);
+
+
 bool evaluate_expr(
         Streader* sr,
         Env_state* estate,
@@ -497,6 +543,576 @@ static bool evaluate_expr_(
 #undef check_stack
 
 
+static bool Expr_builder_emit(
+        Expr_builder* eb, const Expr_instr* instr, Streader* sr)
+{
+    assert(eb != NULL);
+    assert(eb->expr != NULL);
+    assert(instr != NULL);
+    assert(sr != NULL);
+
+    Expr* expr = eb->expr;
+
+    // Track the height of the value stack used during evaluation
+    int new_height = eb->height;
+    switch (instr->op)
+    {
+        case EXPR_PUSH_CONST:
+        case EXPR_PUSH_VAR:
+        case EXPR_PUSH_META:
+            ++new_height;
+            break;
+
+        case EXPR_NOT:
+        case EXPR_NEG:
+            assert(new_height >= 1);
+            break;
+
+        case EXPR_BINARY:
+            assert(new_height >= 2);
+            --new_height;
+            break;
+
+        case EXPR_CALL:
+            assert(new_height >= instr->arg_count);
+            new_height += 1 - instr->arg_count;
+            break;
+
+        default:
+            assert(false);
+    }
+
+    if (new_height > STACK_SIZE)
+    {
+        Streader_set_error(sr, "Stack overflow");
+        return false;
+    }
+
+    if (expr->length >= expr->capacity)
+    {
+        const int new_capacity = (expr->capacity > 0) ? expr->capacity * 2 : 8;
+        Expr_instr* new_instrs = memory_realloc_items(
+                Expr_instr, new_capacity, expr->instrs);
+        if (new_instrs == NULL)
+        {
+            Streader_set_memory_error(
+                    sr, "Could not allocate memory for expression");
+            return false;
+        }
+
+        expr->instrs = new_instrs;
+        expr->capacity = new_capacity;
+    }
+
+    if (instr->op == EXPR_PUSH_VAR ||
+            instr->op == EXPR_PUSH_META ||
+            (instr->op == EXPR_CALL && instr->func == func_rand))
+        expr->is_const = false;
+
+    expr->instrs[expr->length] = *instr;
+    ++expr->length;
+    eb->height = new_height;
+
+    return true;
+}
+
+
+static bool Expr_builder_emit_unary(
+        Expr_builder* eb, bool found_not, bool found_minus, Streader* sr)
+{
+    assert(eb != NULL);
+    assert(!(found_not && found_minus));
+    assert(sr != NULL);
+
+    if (found_not)
+        return Expr_builder_emit(eb, &(Expr_instr){ .op = EXPR_NOT }, sr);
+    else if (found_minus)
+        return Expr_builder_emit(eb, &(Expr_instr){ .op = EXPR_NEG }, sr);
+
+    return true;
+}
+
+
+Expr* new_Expr_from_string(Streader* sr)
+{
+    assert(sr != NULL);
+
+    if (Streader_is_error_set(sr))
+        return NULL;
+
+    if (!Streader_match_char(sr, '"'))
+        return NULL;
+
+    Expr* expr = memory_alloc_item(Expr);
+    if (expr == NULL)
+    {
+        Streader_set_memory_error(
+                sr, "Could not allocate memory for expression");
+        return NULL;
+    }
+
+    expr->is_const = true;
+    expr->length = 0;
+    expr->capacity = 0;
+    expr->instrs = NULL;
+
+    Expr_builder* eb = &(Expr_builder){ .expr = expr, .height = 0 };
+    if (!compile_expr_(sr, eb, 0, false) || !Streader_match_char(sr, '"'))
+    {
+        del_Expr(expr);
+        return NULL;
+    }
+
+    assert(eb->height == 1);
+
+    // Fold constant expressions
+    if (expr->is_const && expr->length > 1)
+    {
+        Value* result = VALUE_AUTO;
+        Streader* fold_sr = Streader_init(STREADER_AUTO, "", 0);
+        if (Expr_evaluate(expr, NULL, NULL, result, NULL, fold_sr))
+        {
+            expr->length = 1;
+            expr->instrs[0] = (Expr_instr){ .op = EXPR_PUSH_CONST };
+            Value_copy(&expr->instrs[0].value, result);
+        }
+        else
+        {
+            // Report the error during playback like the interpreter does
+            expr->is_const = false;
+        }
+    }
+
+    return expr;
+}
+
+
+static bool compile_expr_(
+        Streader* sr,
+        Expr_builder* eb,
+        int depth,
+        bool func_arg)
+{
+    assert(sr != NULL);
+    assert(eb != NULL);
+    assert(depth >= 0);
+
+    if (Streader_is_error_set(sr))
+        return false;
+
+    if (depth >= STACK_SIZE)
+    {
+        Streader_set_error(sr, "Maximum recursion depth exceeded");
+        return false;
+    }
+
+    Operator op_stack[STACK_SIZE] = { { .name = NULL } };
+    int osi = 0;
+    int operand_count = 0;
+    char token[ENV_VAR_NAME_MAX + 4] = ""; // + 4 for delimiting \"s
+    bool expect_operand = true;
+    bool found_not = false;
+    bool found_minus = false;
+
+    size_t prev_pos = sr->pos;
+    while (get_token(sr, token) &&
+            !string_eq(token, "") &&
+            !string_eq(token, ")") &&
+            (!func_arg || !string_eq(token, ",")))
+    {
+        Value* operand = VALUE_AUTO;
+        Operator* op = OPERATOR_AUTO;
+        Func func = NULL;
+
+        if (string_eq(token, "("))
+        {
+            if (!expect_operand)
+            {
+                Streader_set_error(sr, "Unexpected operand");
+                return false;
+            }
+
+            if (!compile_expr_(sr, eb, depth + 1, false) ||
+                    !Expr_builder_emit_unary(eb, found_not, found_minus, sr))
+                return false;
+
+            found_not = found_minus = false;
+            ++operand_count;
+            expect_operand = false;
+        }
+        else if (token_is_func(token, &func))
+        {
+            if (!expect_operand)
+            {
+                Streader_set_error(sr, "Unexpected function");
+                return false;
+            }
+
+            assert(func != NULL);
+            if (!Streader_match_char(sr, '('))
+                return false;
+
+            int i = 0;
+            if (!Streader_try_match_char(sr, ')'))
+            {
+                for (i = 0; i < FUNC_ARGS_MAX; ++i)
+                {
+                    if (!compile_expr_(sr, eb, depth + 1, true))
+                        return false;
+
+                    if (Streader_try_match_char(sr, ')'))
+                    {
+                        ++i;
+                        break;
+                    }
+
+                    if (!Streader_match_char(sr, ','))
+                        return false;
+                }
+            }
+
+            // NOTE: unary operators are not applied to function results
+            if (!Expr_builder_emit(
+                        eb,
+                        &(Expr_instr){
+                            .op = EXPR_CALL, .func = func, .arg_count = i },
+                        sr))
+                return false;
+
+            found_not = found_minus = false;
+            ++operand_count;
+            expect_operand = false;
+        }
+        else if (string_eq(token, "$") ||
+                (!string_eq(token, "true") &&
+                 !string_eq(token, "false") &&
+                 strchr(ENV_VAR_INIT_CHARS, token[0]) != NULL))
+        {
+            if (!expect_operand)
+            {
+                Streader_set_error(sr, "Unexpected operand");
+                return false;
+            }
+
+            Expr_instr* instr = &(Expr_instr){ .op = EXPR_PUSH_META };
+            if (!string_eq(token, "$"))
+            {
+                instr->op = EXPR_PUSH_VAR;
+                instr->value.type = VALUE_TYPE_STRING;
+                strcpy(instr->value.value.string_type, token);
+            }
+
+            if (!Expr_builder_emit(eb, instr, sr) ||
+                    !Expr_builder_emit_unary(eb, found_not, found_minus, sr))
+                return false;
+
+            found_not = found_minus = false;
+            ++operand_count;
+            expect_operand = false;
+        }
+        else if (Value_from_token(operand, token, NULL, NULL))
+        {
+            if (!expect_operand)
+            {
+                Streader_set_error(sr, "Unexpected operand");
+                return false;
+            }
+
+            assert(operand->type != VALUE_TYPE_NONE);
+            if (!handle_unary(operand, found_not, found_minus, sr))
+                return false;
+
+            Expr_instr* instr = &(Expr_instr){ .op = EXPR_PUSH_CONST };
+            Value_copy(&instr->value, operand);
+            if (!Expr_builder_emit(eb, instr, sr))
+                return false;
+
+            found_not = found_minus = false;
+            ++operand_count;
+            expect_operand = false;
+        }
+        else if (Operator_from_token(op, token))
+        {
+            assert(op->name != NULL);
+            if (expect_operand)
+            {
+                if (string_eq(op->name, "!"))
+                {
+                    found_not = true;
+                }
+                else if (string_eq(op->name, "-"))
+                {
+                    found_minus = true;
+                }
+                else
+                {
+                    Streader_set_error(sr, "Unexpected binary operator");
+                    return false;
+                }
+
+                prev_pos = sr->pos;
+                continue;
+            }
+
+            if (string_eq(op->name, "!"))
+            {
+                Streader_set_error(sr, "Unexpected boolean not");
+                return false;
+            }
+
+            while (osi > 0 && op->preced <= op_stack[osi - 1].preced)
+            {
+                Operator* top = &op_stack[osi - 1];
+                assert(top->name != NULL);
+                assert(top->func != NULL);
+
+                if (operand_count < 2)
+                {
+                    Streader_set_error(sr, "Not enough operands");
+                    return false;
+                }
+
+                if (!Expr_builder_emit(
+                            eb,
+                            &(Expr_instr){
+                                .op = EXPR_BINARY, .binary = top->func },
+                            sr))
+                    return false;
+
+                --operand_count;
+                top->name = NULL;
+                --osi;
+            }
+
+            if (osi >= STACK_SIZE)
+            {
+                Streader_set_error(sr, "Stack overflow");
+                return false;
+            }
+
+            memcpy(&op_stack[osi], op, sizeof(Operator));
+            ++osi;
+            expect_operand = true;
+        }
+        else
+        {
+            Streader_set_error(sr, "Unrecognised token");
+            return false;
+        }
+
+        prev_pos = sr->pos;
+    }
+
+    if (Streader_is_error_set(sr))
+        return false;
+
+    assert(string_eq(token, "") || string_eq(token, ")") ||
+            (func_arg && string_eq(token, ",")));
+    if (operand_count == 0)
+    {
+        Streader_set_error(sr, "Empty expression");
+        return false;
+    }
+
+    if ((depth == 0) != string_eq(token, ""))
+    {
+        Streader_set_error(
+                sr,
+                "Unmatched %s parenthesis",
+                (depth == 0) ? "right" : "left");
+        return false;
+    }
+
+    while (osi > 0)
+    {
+        Operator* top = &op_stack[osi - 1];
+        assert(top->name != NULL);
+        assert(top->func != NULL);
+
+        if (operand_count < 2)
+        {
+            Streader_set_error(sr, "Not enough operands");
+            return false;
+        }
+
+        if (!Expr_builder_emit(
+                    eb,
+                    &(Expr_instr){ .op = EXPR_BINARY, .binary = top->func },
+                    sr))
+            return false;
+
+        --operand_count;
+        top->name = NULL;
+        --osi;
+    }
+
+    if (func_arg)
+        sr->pos = prev_pos;
+
+    return true;
+}
+
+
+const Value* Expr_get_const_value(const Expr* expr)
+{
+    assert(expr != NULL);
+
+    if (!expr->is_const)
+        return NULL;
+
+    assert(expr->length == 1);
+    assert(expr->instrs[0].op == EXPR_PUSH_CONST);
+
+    return &expr->instrs[0].value;
+}
+
+
+bool Expr_evaluate(
+        const Expr* expr,
+        Env_state* estate,
+        const Value* meta,
+        Value* res,
+        Random* rand,
+        Streader* sr)
+{
+    assert(expr != NULL);
+    assert(expr->length > 0);
+    assert(estate != NULL || expr->is_const);
+    assert(res != NULL);
+    assert(rand != NULL || expr->is_const);
+    assert(sr != NULL);
+
+    if (Streader_is_error_set(sr))
+        return false;
+
+    if (meta == NULL)
+        meta = VALUE_AUTO;
+
+    Value val_stack[STACK_SIZE] = { { .type = VALUE_TYPE_NONE } };
+    int vsi = 0;
+
+    for (int i = 0; i < expr->length; ++i)
+    {
+        const Expr_instr* instr = &expr->instrs[i];
+
+        switch (instr->op)
+        {
+            case EXPR_PUSH_CONST:
+            {
+                assert(vsi < STACK_SIZE);
+                Value_copy(&val_stack[vsi], &instr->value);
+                ++vsi;
+            }
+            break;
+
+            case EXPR_PUSH_VAR:
+            {
+                assert(vsi < STACK_SIZE);
+                const Env_var* ev = Env_state_get_var(
+                        estate, instr->value.value.string_type);
+                if (ev == NULL)
+                {
+                    Streader_set_error(sr, "Unrecognised token");
+                    return false;
+                }
+
+                assert(Env_var_get_type(ev) == VALUE_TYPE_BOOL ||
+                        Env_var_get_type(ev) == VALUE_TYPE_INT ||
+                        Env_var_get_type(ev) == VALUE_TYPE_FLOAT);
+
+                Value_copy(&val_stack[vsi], Env_var_get_value(ev));
+                ++vsi;
+            }
+            break;
+
+            case EXPR_PUSH_META:
+            {
+                assert(vsi < STACK_SIZE);
+                Value_copy(&val_stack[vsi], meta);
+                ++vsi;
+            }
+            break;
+
+            case EXPR_NOT:
+            case EXPR_NEG:
+            {
+                assert(vsi >= 1);
+                if (!handle_unary(
+                            &val_stack[vsi - 1],
+                            instr->op == EXPR_NOT,
+                            instr->op == EXPR_NEG,
+                            sr))
+                    return false;
+            }
+            break;
+
+            case EXPR_BINARY:
+            {
+                assert(vsi >= 2);
+                Value* result = VALUE_AUTO;
+                if (!instr->binary(
+                            &val_stack[vsi - 2],
+                            &val_stack[vsi - 1],
+                            result,
+                            sr))
+                {
+                    assert(Streader_is_error_set(sr));
+                    return false;
+                }
+
+                assert(result->type != VALUE_TYPE_NONE);
+                --vsi;
+                memcpy(&val_stack[vsi - 1], result, sizeof(Value));
+            }
+            break;
+
+            case EXPR_CALL:
+            {
+                assert(vsi >= instr->arg_count);
+                Value func_args[FUNC_ARGS_MAX] = { { .type = VALUE_TYPE_NONE } };
+                vsi -= instr->arg_count;
+                for (int k = 0; k < instr->arg_count; ++k)
+                    memcpy(&func_args[k], &val_stack[vsi + k], sizeof(Value));
+
+                Value* result = VALUE_AUTO;
+                if (!instr->func(func_args, result, rand, sr))
+                {
+                    assert(Streader_is_error_set(sr));
+                    return false;
+                }
+
+                assert(result->type != VALUE_TYPE_NONE);
+                assert(vsi < STACK_SIZE);
+                memcpy(&val_stack[vsi], result, sizeof(Value));
+                ++vsi;
+            }
+            break;
+
+            default:
+                assert(false);
+        }
+    }
+
+    assert(vsi == 1);
+    memcpy(res, &val_stack[0], sizeof(Value));
+    assert(res->type != VALUE_TYPE_NONE);
+
+    return true;
+}
+
+
+void del_Expr(Expr* expr)
+{
+    if (expr == NULL)
+        return;
+
+    memory_free(expr->instrs);
+    memory_free(expr);
+
+    return;
+}
+
+
 static bool token_is_func(const char* token, Func* res)
 {
     assert(token != NULL);
@@ -570,8 +1186,6 @@ static bool Value_from_token(
 {
     assert(val != NULL);
     assert(token != NULL);
-    assert(estate != NULL);
-    assert(meta != NULL);
 
     if (isdigit(token[0]) || token[0] == '.')
     {
@@ -630,11 +1244,13 @@ static bool Value_from_token(
     }
     else if (string_eq(token, "$"))
     {
+        assert(meta != NULL);
         Value_copy(val, meta);
         return true;
     }
     else if (strchr(ENV_VAR_INIT_CHARS, token[0]) != NULL)
     {
+        assert(estate != NULL);
         const Env_var* ev = Env_state_get_var(estate, token);
         if (ev == NULL)
             return false;
@@ -43,6 +43,70 @@ bool evaluate_expr(
         Random* rand);
 
 
+/**
+ * A compiled expression.
+ *
+ * An Expr stores an expression as a sequence of stack machine instructions
+ * so that it can be evaluated repeatedly without tokenising the source
+ * text. Subexpressions that do not depend on the Environment state, the meta
+ * variable or random numbers are folded into constants.
+ */
+typedef struct Expr Expr;
+
+
+/**
+ * Create a new Expr from an expression string.
+ *
+ * \param sr   The Streader of the expression, including the enclosing
+ *             quotation marks -- must not be \c NULL.
+ *
+ * \return   The new Expr if successful, otherwise \c NULL.
+ */
+Expr* new_Expr_from_string(Streader* sr);
+
+
+/**
+ * Get the constant value of the Expr.
+ *
+ * \param expr   The Expr -- must not be \c NULL.
+ *
+ * \return   The constant value, or \c NULL if the result of \a expr depends
+ *           on the playback state.
+ */
+const Value* Expr_get_const_value(const Expr* expr);
+
+
+/**
+ * Evaluate the Expr.
+ *
+ * \param expr     The Expr -- must not be \c NULL.
+ * \param estate   The Environment state -- must not be \c NULL.
+ * \param meta     The meta variable, or \c NULL if not used.
+ * \param res      A memory location for the result Value --
+ *                 must not be \c NULL.
+ * \param rand     A Random source -- must not be \c NULL.
+ * \param sr       A Streader used for reporting errors -- must not be
+ *                 \c NULL.
+ *
+ * \return   \c true if successful, or \c false if evaluation failed.
+ */
+bool Expr_evaluate(
+        const Expr* expr,
+        Env_state* estate,
+        const Value* meta,
+        Value* res,
+        Random* rand,
+        Streader* sr);
+
+
+/**
+ * Destroy an existing Expr.
+ *
+ * \param expr   The Expr, or \c NULL.
+ */
+void del_Expr(Expr* expr);
+
+
 #endif // K_EXPR_H
 
 
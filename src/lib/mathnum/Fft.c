@@ -0,0 +1,185 @@
+
+
+/*
+ * Author: Tomi Jylhä-Ollila, Finland 2014
+ *
+ * This file is part of Kunquat.
+ *
+ * CC0 1.0 Universal, http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * To the extent possible under law, Kunquat Affirmers have waived all
+ * copyright and related or neighboring rights to Kunquat.
+ */
+
+
+#include <math.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include <debug/assert.h>
+#include <mathnum/common.h>
+#include <mathnum/Fft.h>
+#include <memory.h>
+
+
+struct Fft
+{
+    int32_t size;
+    int32_t* bit_rev;
+    float* cos_table;
+    float* sin_table;
+};
+
+
+Fft* new_Fft(int32_t size)
+{
+    assert(size >= 2);
+    assert(is_p2(size));
+
+    Fft* fft = memory_alloc_item(Fft);
+    if (fft == NULL)
+        return NULL;
+
+    fft->size = size;
+    fft->bit_rev = memory_alloc_items(int32_t, size);
+    fft->cos_table = memory_alloc_items(float, size / 2);
+    fft->sin_table = memory_alloc_items(float, size / 2);
+    if (fft->bit_rev == NULL ||
+            fft->cos_table == NULL ||
+            fft->sin_table == NULL)
+    {
+        del_Fft(fft);
+        return NULL;
+    }
+
+    int bits = 0;
+    while ((1 << bits) < size)
+        ++bits;
+
+    for (int32_t i = 0; i < size; ++i)
+    {
+        int32_t rev = 0;
+        for (int b = 0; b < bits; ++b)
+        {
+            if (i & (1 << b))
+                rev |= 1 << (bits - 1 - b);
+        }
+        fft->bit_rev[i] = rev;
+    }
+
+    for (int32_t i = 0; i < size / 2; ++i)
+    {
+        const double angle = -2 * PI * i / size;
+        fft->cos_table[i] = cos(angle);
+        fft->sin_table[i] = sin(angle);
+    }
+
+    return fft;
+}
+
+
+int32_t Fft_get_size(const Fft* fft)
+{
+    assert(fft != NULL);
+    return fft->size;
+}
+
+
+static void Fft_transform(const Fft* fft, float* re, float* im, float sin_sign)
+{
+    assert(fft != NULL);
+    assert(re != NULL);
+    assert(im != NULL);
+
+    const int32_t size = fft->size;
+
+    // Reorder input
+    for (int32_t i = 0; i < size; ++i)
+    {
+        const int32_t j = fft->bit_rev[i];
+        if (i < j)
+        {
+            const float tmp_re = re[i];
+            const float tmp_im = im[i];
+            re[i] = re[j];
+            im[i] = im[j];
+            re[j] = tmp_re;
+            im[j] = tmp_im;
+        }
+    }
+
+    // Butterflies
+    for (int32_t half = 1; half < size; half *= 2)
+    {
+        const int32_t table_step = size / (half * 2);
+
+        for (int32_t group = 0; group < size; group += half * 2)
+        {
+            for (int32_t k = 0; k < half; ++k)
+            {
+                const float w_re = fft->cos_table[k * table_step];
+                const float w_im = sin_sign * fft->sin_table[k * table_step];
+
+                const int32_t a = group + k;
+                const int32_t b = a + half;
+
+                const float t_re = re[b] * w_re - im[b] * w_im;
+                const float t_im = re[b] * w_im + im[b] * w_re;
+
+                re[b] = re[a] - t_re;
+                im[b] = im[a] - t_im;
+                re[a] += t_re;
+                im[a] += t_im;
+            }
+        }
+    }
+
+    return;
+}
+
+
+void Fft_forward(const Fft* fft, float* re, float* im)
+{
+    assert(fft != NULL);
+    assert(re != NULL);
+    assert(im != NULL);
+
+    Fft_transform(fft, re, im, 1);
+
+    return;
+}
+
+
+void Fft_inverse(const Fft* fft, float* re, float* im)
+{
+    assert(fft != NULL);
+    assert(re != NULL);
+    assert(im != NULL);
+
+    Fft_transform(fft, re, im, -1);
+
+    const float scale = 1.0f / fft->size;
+    for (int32_t i = 0; i < fft->size; ++i)
+    {
+        re[i] *= scale;
+        im[i] *= scale;
+    }
+
+    return;
+}
+
+
+void del_Fft(Fft* fft)
+{
+    if (fft == NULL)
+        return;
+
+    memory_free(fft->bit_rev);
+    memory_free(fft->cos_table);
+    memory_free(fft->sin_table);
+    memory_free(fft);
+
+    return;
+}
+
+
@@ -0,0 +1,91 @@
+
+
+/*
+ * Author: Tomi Jylhä-Ollila, Finland 2014
+ *
+ * This file is part of Kunquat.
+ *
+ * CC0 1.0 Universal, http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * To the extent possible under law, Kunquat Affirmers have waived all
+ * copyright and related or neighboring rights to Kunquat.
+ */
+
+
+#ifndef K_FFT_H
+#define K_FFT_H
+
+
+#include <stdlib.h>
+#include <stdint.h>
+
+
+/**
+ * A radix-2 complex FFT of a fixed power-of-2 size.
+ *
+ * The transform tables are computed once when the Fft is created, so the
+ * transform functions do not allocate memory and may be called from the
+ * rendering path.
+ */
+typedef struct Fft Fft;
+
+
+/**
+ * Create a new Fft.
+ *
+ * \param size   The transform size -- must be a power of 2 and >= \c 2.
+ *
+ * \return   The new Fft if successful, or \c NULL if memory allocation
+ *           failed.
+ */
+Fft* new_Fft(int32_t size);
+
+
+/**
+ * Get the transform size of the Fft.
+ *
+ * \param fft   The Fft -- must not be \c NULL.
+ *
+ * \return   The transform size.
+ */
+int32_t Fft_get_size(const Fft* fft);
+
+
+/**
+ * Perform a forward transform in place.
+ *
+ * \param fft   The Fft -- must not be \c NULL.
+ * \param re    The real parts -- must not be \c NULL and must contain
+ *              at least as many items as the transform size.
+ * \param im    The imaginary parts -- must not be \c NULL and must contain
+ *              at least as many items as the transform size.
+ */
+void Fft_forward(const Fft* fft, float* re, float* im);
+
+
+/**
+ * Perform an inverse transform in place.
+ *
+ * The result is scaled by 1 / size so that an inverse transform of a
+ * forward transform returns the original data.
+ *
+ * \param fft   The Fft -- must not be \c NULL.
+ * \param re    The real parts -- must not be \c NULL and must contain
+ *              at least as many items as the transform size.
+ * \param im    The imaginary parts -- must not be \c NULL and must contain
+ *              at least as many items as the transform size.
+ */
+void Fft_inverse(const Fft* fft, float* re, float* im);
+
+
+/**
+ * Destroy an existing Fft.
+ *
+ * \param fft   The Fft, or \c NULL.
+ */
+void del_Fft(Fft* fft);
+
+
+#endif // K_FFT_H
+
+
@@ -0,0 +1,401 @@
+
+
+/*
+ * Author: Tomi Jylhä-Ollila, Finland 2014
+ *
+ * This file is part of Kunquat.
+ *
+ * CC0 1.0 Universal, http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * To the extent possible under law, Kunquat Affirmers have waived all
+ * copyright and related or neighboring rights to Kunquat.
+ */
+
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include <debug/assert.h>
+#include <mathnum/common.h>
+#include <mathnum/Fft.h>
+#include <mathnum/Part_conv.h>
+#include <memory.h>
+
+
+#define FFT_SIZE (PART_CONV_SIZE * 2)
+#define BINS (PART_CONV_SIZE + 1)
+
+
+struct Part_conv
+{
+    Fft* fft;
+
+    // Partitioned impulse response
+    int32_t part_count;
+    int32_t tail_capacity;
+    float head[2][PART_CONV_SIZE];
+    float* part_re[2];
+    float* part_im[2];
+
+    // Frequency-domain delay line of previous input blocks
+    int32_t fdl_pos;
+    float* fdl_re[2];
+    float* fdl_im[2];
+
+    float window[2][FFT_SIZE];
+    float tail[2][PART_CONV_SIZE];
+    int32_t block_pos;
+};
+
+
+Part_conv* new_Part_conv(void)
+{
+    Part_conv* pc = memory_alloc_item(Part_conv);
+    if (pc == NULL)
+        return NULL;
+
+    pc->part_count = 0;
+    pc->tail_capacity = 0;
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        pc->part_re[ch] = NULL;
+        pc->part_im[ch] = NULL;
+        pc->fdl_re[ch] = NULL;
+        pc->fdl_im[ch] = NULL;
+    }
+
+    pc->fft = new_Fft(FFT_SIZE);
+    if (pc->fft == NULL)
+    {
+        del_Part_conv(pc);
+        return NULL;
+    }
+
+    Part_conv_clear(pc);
+
+    return pc;
+}
+
+
+static bool Part_conv_reserve_tail(Part_conv* pc, int32_t tail_count)
+{
+    assert(pc != NULL);
+    assert(tail_count >= 0);
+
+    if (tail_count <= pc->tail_capacity)
+        return true;
+
+    float** arrays[] =
+    {
+        &pc->part_re[0], &pc->part_re[1],
+        &pc->part_im[0], &pc->part_im[1],
+        &pc->fdl_re[0], &pc->fdl_re[1],
+        &pc->fdl_im[0], &pc->fdl_im[1],
+    };
+
+    for (size_t i = 0; i < sizeof(arrays) / sizeof(*arrays); ++i)
+    {
+        float* new_array = memory_realloc_items(
+                float, tail_count * BINS, *arrays[i]);
+        if (new_array == NULL)
+            return false;
+        *arrays[i] = new_array;
+    }
+
+    pc->tail_capacity = tail_count;
+
+    return true;
+}
+
+
+/**
+ * Separate the spectra of two real signals transformed as one complex signal.
+ */
+static void separate_spectra(
+        const float* z_re,
+        const float* z_im,
+        float* l_re,
+        float* l_im,
+        float* r_re,
+        float* r_im)
+{
+    assert(z_re != NULL);
+    assert(z_im != NULL);
+    assert(l_re != NULL);
+    assert(l_im != NULL);
+    assert(r_re != NULL);
+    assert(r_im != NULL);
+
+    for (int32_t k = 0; k < BINS; ++k)
+    {
+        const int32_t mirror = (FFT_SIZE - k) % FFT_SIZE;
+        l_re[k] = (z_re[k] + z_re[mirror]) * 0.5f;
+        l_im[k] = (z_im[k] - z_im[mirror]) * 0.5f;
+        r_re[k] = (z_im[k] + z_im[mirror]) * 0.5f;
+        r_im[k] = (z_re[mirror] - z_re[k]) * 0.5f;
+    }
+
+    return;
+}
+
+
+bool Part_conv_set_ir(Part_conv* pc, float* ir[2], int32_t tap_count)
+{
+    assert(pc != NULL);
+    assert(ir != NULL);
+    assert(tap_count == 0 || (ir[0] != NULL && ir[1] != NULL));
+    assert(tap_count >= 0);
+
+    pc->part_count = 0;
+
+    const int32_t part_count =
+        (tap_count + PART_CONV_SIZE - 1) / PART_CONV_SIZE;
+    const bool reserved = Part_conv_reserve_tail(
+            pc, max(0, part_count - 1));
+    Part_conv_clear(pc);
+    if (!reserved)
+        return false;
+
+    float part_re[FFT_SIZE] = { 0 };
+    float part_im[FFT_SIZE] = { 0 };
+
+    for (int32_t part = 0; part < part_count; ++part)
+    {
+        for (int32_t i = 0; i < FFT_SIZE; ++i)
+        {
+            part_re[i] = 0;
+            part_im[i] = 0;
+        }
+
+        const int32_t first = part * PART_CONV_SIZE;
+        const int32_t count = min(PART_CONV_SIZE, tap_count - first);
+        for (int32_t i = 0; i < count; ++i)
+        {
+            part_re[i] = ir[0][first + i];
+            part_im[i] = ir[1][first + i];
+        }
+
+        if (part == 0)
+        {
+            // Store the first partition reversed for the direct path
+            for (int32_t i = 0; i < PART_CONV_SIZE; ++i)
+            {
+                pc->head[0][i] = part_re[PART_CONV_SIZE - 1 - i];
+                pc->head[1][i] = part_im[PART_CONV_SIZE - 1 - i];
+            }
+            continue;
+        }
+
+        Fft_forward(pc->fft, part_re, part_im);
+
+        const int32_t offset = (part - 1) * BINS;
+        separate_spectra(
+                part_re,
+                part_im,
+                &pc->part_re[0][offset],
+                &pc->part_im[0][offset],
+                &pc->part_re[1][offset],
+                &pc->part_im[1][offset]);
+    }
+
+    pc->part_count = part_count;
+
+    return true;
+}
+
+
+void Part_conv_clear(Part_conv* pc)
+{
+    assert(pc != NULL);
+
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        for (int32_t i = 0; i < pc->tail_capacity * BINS; ++i)
+        {
+            pc->fdl_re[ch][i] = 0;
+            pc->fdl_im[ch][i] = 0;
+        }
+
+        for (int32_t i = 0; i < FFT_SIZE; ++i)
+            pc->window[ch][i] = 0;
+
+        for (int32_t i = 0; i < PART_CONV_SIZE; ++i)
+            pc->tail[ch][i] = 0;
+    }
+
+    pc->fdl_pos = 0;
+    pc->block_pos = 0;
+
+    return;
+}
+
+
+static void Part_conv_process_block(Part_conv* pc)
+{
+    assert(pc != NULL);
+
+    const int32_t tail_count = pc->part_count - 1;
+
+    if (tail_count > 0)
+    {
+        // Transform the latest input window and add it to the delay line
+        float z_re[FFT_SIZE];
+        float z_im[FFT_SIZE];
+        for (int32_t i = 0; i < FFT_SIZE; ++i)
+        {
+            z_re[i] = pc->window[0][i];
+            z_im[i] = pc->window[1][i];
+        }
+
+        Fft_forward(pc->fft, z_re, z_im);
+
+        pc->fdl_pos = (pc->fdl_pos + tail_count - 1) % tail_count;
+        const int32_t fdl_offset = pc->fdl_pos * BINS;
+        separate_spectra(
+                z_re,
+                z_im,
+                &pc->fdl_re[0][fdl_offset],
+                &pc->fdl_im[0][fdl_offset],
+                &pc->fdl_re[1][fdl_offset],
+                &pc->fdl_im[1][fdl_offset]);
+
+        // Multiply-accumulate the delayed input spectra with the partitions
+        float y_re[2][BINS] = { { 0 } };
+        float y_im[2][BINS] = { { 0 } };
+
+        for (int32_t part = 0; part < tail_count; ++part)
+        {
+            const int32_t x_offset =
+                ((pc->fdl_pos + part) % tail_count) * BINS;
+            const int32_t h_offset = part * BINS;
+
+            for (int ch = 0; ch < 2; ++ch)
+            {
+                const float* x_re = &pc->fdl_re[ch][x_offset];
+                const float* x_im = &pc->fdl_im[ch][x_offset];
+                const float* h_re = &pc->part_re[ch][h_offset];
+                const float* h_im = &pc->part_im[ch][h_offset];
+
+                for (int32_t k = 0; k < BINS; ++k)
+                {
+                    y_re[ch][k] += x_re[k] * h_re[k] - x_im[k] * h_im[k];
+                    y_im[ch][k] += x_re[k] * h_im[k] + x_im[k] * h_re[k];
+                }
+            }
+        }
+
+        // Combine the two real output spectra into one complex spectrum
+        for (int32_t k = 0; k < BINS; ++k)
+        {
+            z_re[k] = y_re[0][k] - y_im[1][k];
+            z_im[k] = y_im[0][k] + y_re[1][k];
+        }
+        for (int32_t k = BINS; k < FFT_SIZE; ++k)
+        {
+            const int32_t mirror = FFT_SIZE - k;
+            z_re[k] = y_re[0][mirror] + y_im[1][mirror];
+            z_im[k] = y_re[1][mirror] - y_im[0][mirror];
+        }
+
+        Fft_inverse(pc->fft, z_re, z_im);
+
+        for (int32_t i = 0; i < PART_CONV_SIZE; ++i)
+        {
+            pc->tail[0][i] = z_re[PART_CONV_SIZE + i];
+            pc->tail[1][i] = z_im[PART_CONV_SIZE + i];
+        }
+    }
+
+    // Shift the completed block to the first half of the window
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        for (int32_t i = 0; i < PART_CONV_SIZE; ++i)
+            pc->window[ch][i] = pc->window[ch][PART_CONV_SIZE + i];
+    }
+
+    pc->block_pos = 0;
+
+    return;
+}
+
+
+void Part_conv_process(
+        Part_conv* pc,
+        float* in[2],
+        float* out[2],
+        int32_t start,
+        int32_t until,
+        float scale)
+{
+    assert(pc != NULL);
+    assert(in != NULL);
+    assert(out != NULL);
+    assert(start >= 0);
+    assert(until >= start);
+
+    if (pc->part_count <= 0)
+        return;
+
+    int32_t out_pos = start;
+    while (out_pos < until)
+    {
+        // Process frames until the end of the current block
+        const int32_t block_until = min(
+                until, out_pos + PART_CONV_SIZE - pc->block_pos);
+
+        for (int ch = 0; ch < 2; ++ch)
+        {
+            float* window = pc->window[ch];
+            const float* head = pc->head[ch];
+            const float* tail = pc->tail[ch];
+            const float* in_ch = in[ch];
+            float* out_ch = out[ch];
+
+            int32_t block_pos = pc->block_pos;
+            for (int32_t i = out_pos; i < block_until; ++i)
+            {
+                const int32_t window_pos = PART_CONV_SIZE + block_pos;
+                window[window_pos] = in_ch[i];
+
+                // Apply the first partition directly
+                const float* x = &window[window_pos - PART_CONV_SIZE + 1];
+                float sum = 0;
+                for (int32_t k = 0; k < PART_CONV_SIZE; ++k)
+                    sum += head[k] * x[k];
+
+                out_ch[i] += (sum + tail[block_pos]) * scale;
+                ++block_pos;
+            }
+        }
+
+        pc->block_pos += block_until - out_pos;
+        out_pos = block_until;
+
+        if (pc->block_pos >= PART_CONV_SIZE)
+            Part_conv_process_block(pc);
+    }
+
+    return;
+}
+
+
+void del_Part_conv(Part_conv* pc)
+{
+    if (pc == NULL)
+        return;
+
+    del_Fft(pc->fft);
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        memory_free(pc->part_re[ch]);
+        memory_free(pc->part_im[ch]);
+        memory_free(pc->fdl_re[ch]);
+        memory_free(pc->fdl_im[ch]);
+    }
+    memory_free(pc);
+
+    return;
+}
+
+
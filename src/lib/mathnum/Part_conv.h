@@ -0,0 +1,107 @@
+
+
+/*
+ * Author: Tomi Jylhä-Ollila, Finland 2014
+ *
+ * This file is part of Kunquat.
+ *
+ * CC0 1.0 Universal, http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * To the extent possible under law, Kunquat Affirmers have waived all
+ * copyright and related or neighboring rights to Kunquat.
+ */
+
+
+#ifndef K_PART_CONV_H
+#define K_PART_CONV_H
+
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+
+/**
+ * Uniformly partitioned FFT convolution of a stereo signal.
+ *
+ * The impulse response is split into partitions of \a PART_CONV_SIZE taps.
+ * The first partition is applied directly in the time domain so that the
+ * output has no additional latency, and the remaining partitions are applied
+ * to whole input blocks by overlap-save convolution. The left and right
+ * channels share one complex transform.
+ */
+typedef struct Part_conv Part_conv;
+
+
+#define PART_CONV_SIZE 128
+
+
+/**
+ * Create a new Part_conv.
+ *
+ * The new Part_conv has an empty impulse response.
+ *
+ * \return   The new Part_conv if successful, or \c NULL if memory allocation
+ *           failed.
+ */
+Part_conv* new_Part_conv(void);
+
+
+/**
+ * Set the impulse response of the Part_conv.
+ *
+ * This function also clears the input history.
+ *
+ * \param pc          The Part_conv -- must not be \c NULL.
+ * \param ir          The impulse response channels -- must not be \c NULL.
+ *                    Each channel must contain at least \a tap_count items
+ *                    unless \a tap_count is \c 0.
+ * \param tap_count   The number of taps -- must be >= \c 0.
+ *
+ * \return   \c true if successful, or \c false if memory allocation failed.
+ *           The impulse response is empty after a failed call.
+ */
+bool Part_conv_set_ir(Part_conv* pc, float* ir[2], int32_t tap_count);
+
+
+/**
+ * Clear the input history of the Part_conv.
+ *
+ * \param pc   The Part_conv -- must not be \c NULL.
+ */
+void Part_conv_clear(Part_conv* pc);
+
+
+/**
+ * Convolve input frames and add the result to the output.
+ *
+ * This function does not allocate memory.
+ *
+ * \param pc      The Part_conv -- must not be \c NULL.
+ * \param in      The input channels -- must not be \c NULL.
+ * \param out     The output channels -- must not be \c NULL.
+ * \param start   The first frame to process -- must be >= \c 0.
+ * \param until   The first frame not to be processed -- must be
+ *                >= \a start.
+ * \param scale   The scale factor applied to the result.
+ */
+void Part_conv_process(
+        Part_conv* pc,
+        float* in[2],
+        float* out[2],
+        int32_t start,
+        int32_t until,
+        float scale);
+
+
+/**
+ * Destroy an existing Part_conv.
+ *
+ * \param pc   The Part_conv, or \c NULL.
+ */
+void del_Part_conv(Part_conv* pc);
+
+
+#endif // K_PART_CONV_H
+
+
@@ -55,6 +55,18 @@ void Random_set_context(Random* random, const char* context)
 }
 
 
+Random* Random_copy(Random* restrict dest, const Random* restrict src)
+{
+    assert(dest != NULL);
+    assert(src != NULL);
+    assert(dest != src);
+
+    memcpy(dest, src, sizeof(Random));
+
+    return dest;
+}
+
+
 void Random_set_seed(Random* random, uint64_t seed)
 {
     assert(random != NULL);
@@ -67,6 +67,17 @@ Random* new_Random(void);
 void Random_set_context(Random* random, const char* context);
 
 
+/**
+ * Copy the state of a Random generator.
+ *
+ * \param dest   The destination Random -- must not be \c NULL.
+ * \param src    The source Random -- must not be \c NULL or \a dest.
+ *
+ * \return   The parameter \a dest.
+ */
+Random* Random_copy(Random* restrict dest, const Random* restrict src);
+
+
 /**
  * Set the random seed in the Random.
  *
@@ -216,8 +216,9 @@ Event_cache* Bind_create_cache(const Bind* map)
     if (cache == NULL)
         return NULL;
 
-    AAiter_change_tree(map->iter, map->cblists);
-    Cblist* cblist = AAiter_get_at_least(map->iter, "");
+    AAiter* iter = AAITER_AUTO;
+    AAiter_change_tree(iter, map->cblists);
+    Cblist* cblist = AAiter_get_at_least(iter, "");
     while (cblist != NULL)
     {
         Cblist_item* item = cblist->first;
@@ -235,7 +236,7 @@ Event_cache* Bind_create_cache(const Bind* map)
             }
             item = item->next;
         }
-        cblist = AAiter_get_next(map->iter);
+        cblist = AAiter_get_next(iter);
     }
 
     return cache;
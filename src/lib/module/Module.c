@@ -18,6 +18,7 @@
 #include <inttypes.h>
 #include <stdio.h>
 #include <math.h>
+#include <pthread.h>
 
 #include <debug/assert.h>
 #include <mathnum/common.h>
@@ -27,6 +28,10 @@
 #include <string/common.h>
 
 
+// Protects the Handle counts of all Modules
+static pthread_mutex_t handle_count_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
 /**
  * Resets the Module.
  *
@@ -92,10 +97,13 @@ Module* new_Module(void)
     module->random = NULL;
     module->env = NULL;
     module->bind = NULL;
+    module->sample_cache = NULL;
+    module->handle_count = 0;
     module->album_is_existent = false;
     module->track_list = NULL;
     for (int i = 0; i < KQT_SONGS_MAX; ++i)
         module->order_lists[i] = NULL;
+    module->pat_inst_index = NULL;
     for (int i = 0; i < KQT_SCALES_MAX; ++i)
         module->scales[i] = NULL;
 
@@ -103,15 +111,19 @@ Module* new_Module(void)
     module->random = new_Random();
     module->songs = new_Song_table();
     module->pats = new_Pat_table(KQT_PATTERNS_MAX);
+    module->pat_inst_index = new_Pat_inst_index();
     module->ins_controls = new_Bit_array(KQT_CONTROLS_MAX);
     module->insts = new_Ins_table(KQT_INSTRUMENTS_MAX);
     module->effects = new_Effect_table(KQT_EFFECTS_MAX);
-    if (module->random == NULL           ||
-            module->songs == NULL        ||
-            module->pats == NULL         ||
-            module->ins_controls == NULL ||
-            module->insts == NULL        ||
-            module->effects == NULL)
+    module->sample_cache = new_Sample_cache(0);
+    if (module->random == NULL             ||
+            module->songs == NULL          ||
+            module->pats == NULL           ||
+            module->pat_inst_index == NULL ||
+            module->ins_controls == NULL   ||
+            module->insts == NULL          ||
+            module->effects == NULL        ||
+            module->sample_cache == NULL)
     {
         del_Module(module);
         return NULL;
@@ -286,6 +298,24 @@ const Order_list* Module_get_order_list(const Module* module, int16_t song)
 }
 
 
+bool Module_set_order_list(Module* module, int16_t song, Order_list* ol)
+{
+    assert(module != NULL);
+    assert(song >= 0);
+    assert(song < KQT_SONGS_MAX);
+    assert(ol != NULL);
+
+    if (!Pat_inst_index_update(
+                module->pat_inst_index, song, module->order_lists[song], ol))
+        return false;
+
+    del_Order_list(module->order_lists[song]);
+    module->order_lists[song] = ol;
+
+    return true;
+}
+
+
 const Pattern* Module_get_pattern(
         const Module* module,
         const Pat_inst_ref* piref)
@@ -321,27 +351,19 @@ bool Module_find_pattern_location(
     assert(track != NULL);
     assert(system != NULL);
 
-    // Linear search all track lists
-    for (int ti = 0; ti < KQT_SONGS_MAX; ++ti)
+    // Find the first location in an existing song
+    const Pat_inst_location* loc = Pat_inst_index_get_at_least(
+            module->pat_inst_index, piref, 0);
+    while (loc != NULL && Pat_inst_ref_cmp(&loc->piref, piref) == 0)
     {
-        if (!Song_table_get_existent(module->songs, ti))
-            continue;
-
-        const Order_list* ol = module->order_lists[ti];
-        assert(ol != NULL);
-
-        for (size_t i = 0; i < Order_list_get_len(ol); ++i)
+        if (Song_table_get_existent(module->songs, loc->song))
         {
-            const Pat_inst_ref* cur_piref = Order_list_get_pat_inst_ref(ol, i);
-            assert(cur_piref != NULL);
-
-            if (cur_piref->pat == piref->pat && cur_piref->inst == piref->inst)
-            {
-                *track = ti;
-                *system = i;
-                return true;
-            }
+            *track = loc->song;
+            *system = (int16_t)loc->system;
+            return true;
         }
+
+        loc = Pat_inst_index_get_next(module->pat_inst_index, loc);
     }
 
     return false;
@@ -557,8 +579,6 @@ static void Module_reset(const Device* device, Device_states* dstates)
             Device_reset((const Device*)eff, dstates);
     }
 
-    Random_reset(module->random);
-
     return;
 }
 
@@ -665,6 +685,44 @@ static bool Module_set_buffer_size(
 }
 
 
+void Module_add_handle(Module* module)
+{
+    assert(module != NULL);
+
+    pthread_mutex_lock(&handle_count_lock);
+    ++module->handle_count;
+    pthread_mutex_unlock(&handle_count_lock);
+
+    return;
+}
+
+
+bool Module_remove_handle(Module* module)
+{
+    assert(module != NULL);
+
+    pthread_mutex_lock(&handle_count_lock);
+    assert(module->handle_count > 0);
+    --module->handle_count;
+    const bool is_last = (module->handle_count == 0);
+    pthread_mutex_unlock(&handle_count_lock);
+
+    return is_last;
+}
+
+
+bool Module_is_shared(const Module* module)
+{
+    assert(module != NULL);
+
+    pthread_mutex_lock(&handle_count_lock);
+    const bool is_shared = (module->handle_count > 1);
+    pthread_mutex_unlock(&handle_count_lock);
+
+    return is_shared;
+}
+
+
 void del_Module(Module* module)
 {
     if (module == NULL)
@@ -682,12 +740,14 @@ void del_Module(Module* module)
 
     for (int i = 0; i < KQT_SONGS_MAX; ++i)
         del_Order_list(module->order_lists[i]);
+    del_Pat_inst_index(module->pat_inst_index);
 
     for (int i = 0; i < KQT_SCALES_MAX; ++i)
         del_Scale(module->scales[i]);
 
     del_Random(module->random);
     del_Bind(module->bind);
+    del_Sample_cache(module->sample_cache);
 
     Device_deinit(&module->parent);
     memory_free(module);
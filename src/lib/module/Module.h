@@ -21,6 +21,7 @@
 #include <Connections.h>
 #include <Decl.h>
 #include <devices/Device.h>
+#include <devices/param_types/Sample_cache.h>
 #include <frame.h>
 #include <kunquat/limits.h>
 #include <mathnum/Random.h>
@@ -31,6 +32,7 @@
 #include <module/Ins_table.h>
 #include <module/Scale.h>
 #include <module/sheet/Order_list.h>
+#include <module/sheet/Pat_inst_index.h>
 #include <module/sheet/Pat_table.h>
 #include <module/sheet/Song_table.h>
 #include <module/sheet/Track_list.h>
@@ -46,6 +48,7 @@ struct Module
     bool album_is_existent;             ///< Album existence status.
     Track_list* track_list;             ///< Track list.
     Order_list* order_lists[KQT_SONGS_MAX]; ///< Order lists.
+    Pat_inst_index* pat_inst_index;     ///< Pattern instance locations.
     Pat_table* pats;                    ///< The Patterns.
     Input_map* ins_map;                 ///< Instrument input map.
     Bit_array* ins_controls;            ///< Existent instrument controls.
@@ -57,6 +60,8 @@ struct Module
     double mix_vol;                     ///< Mixing volume.
     Environment* env;                   ///< Environment variables.
     Bind* bind;
+    Sample_cache* sample_cache;         ///< Decoded data of lazily decoded Samples.
+    int handle_count;                   ///< Number of Handles, see Module_add_handle.
 };
 
 
@@ -119,6 +124,21 @@ const Track_list* Module_get_track_list(const Module* module);
 const Order_list* Module_get_order_list(const Module* module, int16_t song);
 
 
+/**
+ * Set an order list of the Module.
+ *
+ * The pattern instance locations of the Module are updated accordingly.
+ *
+ * \param module   The Module -- must not be \c NULL.
+ * \param song     The song number -- must be >= \c 0 and < \c KQT_SONGS_MAX.
+ * \param ol       The new order list -- must not be \c NULL.
+ *
+ * \return   \c true if successful, or \c false if memory allocation failed.
+ *           The Module is not changed in case of failure.
+ */
+bool Module_set_order_list(Module* module, int16_t song, Order_list* ol);
+
+
 /**
  * Get a pattern of the Module.
  *
@@ -320,6 +340,40 @@ bool Module_create_scale(Module* module, int index);
 void Module_remove_scale(Module* module, int index);
 
 
+/**
+ * Register a Handle that uses the Module.
+ *
+ * Handles in different threads may share the Module, so the Handle count
+ * must only be accessed through these functions.
+ *
+ * \param module   The Module -- must not be \c NULL.
+ */
+void Module_add_handle(Module* module);
+
+
+/**
+ * Unregister a Handle that uses the Module.
+ *
+ * \param module   The Module -- must not be \c NULL and must have at least
+ *                 one registered Handle.
+ *
+ * \return   \c true if this was the last Handle using the Module, otherwise
+ *           \c false. The caller shall destroy the Module if \c true is
+ *           returned.
+ */
+bool Module_remove_handle(Module* module);
+
+
+/**
+ * Tell whether the Module is shared by several Handles.
+ *
+ * \param module   The Module -- must not be \c NULL.
+ *
+ * \return   \c true if the Module is shared, otherwise \c false.
+ */
+bool Module_is_shared(const Module* module);
+
+
 /**
  * Destroy an existing Module.
  *
@@ -17,6 +17,7 @@
 #include <string.h>
 #include <ctype.h>
 #include <inttypes.h>
+#include <pthread.h>
 
 #include <Connections.h>
 #include <debug/assert.h>
@@ -24,12 +25,16 @@
 #include <devices/Device_params.h>
 #include <devices/dsps/DSP_type.h>
 #include <devices/generators/Gen_type.h>
+#include <devices/param_types/Sample_cache.h>
+#include <devices/param_types/Wavpack.h>
 #include <Handle_private.h>
+#include <mathnum/common.h>
 #include <memory.h>
 #include <module/Bind.h>
 #include <module/Environment.h>
 #include <module/manifest.h>
 #include <module/Parse_manager.h>
+#include <player/Thread_pool.h>
 #include <string/Streader.h>
 #include <string/common.h>
 
@@ -125,10 +130,29 @@ static bool parse_subsong_level(
     } else (void)0
 
 
+static bool key_affects_sequencing(const char* key)
+{
+    assert(key != NULL);
+
+    return string_has_prefix(key, "album/") ||
+        string_has_prefix(key, "song_") ||
+        string_has_prefix(key, "pat_") ||
+        string_eq(key, "p_environment.json") ||
+        string_eq(key, "p_bind.json") ||
+        string_eq(key, "p_random_seed.json");
+}
+
+
 static bool prepare_connections(Handle* handle)
 {
     assert(handle != NULL);
 
+    if (handle->defer_connections)
+    {
+        handle->connections_changed = true;
+        return true;
+    }
+
     Module* module = Handle_get_module(handle);
     Connections* graph = module->connections;
 
@@ -178,6 +202,9 @@ bool parse_data(
         return true;
     }
 
+    if (key_affects_sequencing(key))
+        Handle_clear_sequence_caches(handle);
+
     Streader* sr = Streader_init(STREADER_AUTO, data, length);
 
     if (last_index == 0)
@@ -314,6 +341,375 @@ bool parse_data(
 }
 
 
+static bool key_is_wavpack_data(const char* key)
+{
+    assert(key != NULL);
+
+    const char* last_element = strrchr(key, '/');
+    last_element = (last_element != NULL) ? last_element + 1 : key;
+
+    return string_has_prefix(last_element, "p_") &&
+        string_has_suffix(last_element, ".wv");
+}
+
+
+typedef struct Decode_job
+{
+    const char* data;
+    long length;
+    Sample* sample;
+} Decode_job;
+
+
+typedef struct Decode_batch
+{
+    pthread_mutex_t lock;
+    int next_job;
+    int job_count;
+    Decode_job* jobs;
+} Decode_batch;
+
+
+static void decode_samples(void* data, int index)
+{
+    assert(data != NULL);
+    (void)index;
+
+    Decode_batch* batch = data;
+
+    while (true)
+    {
+        pthread_mutex_lock(&batch->lock);
+        const int job_index = batch->next_job;
+        if (job_index < batch->job_count)
+            ++batch->next_job;
+        pthread_mutex_unlock(&batch->lock);
+
+        if (job_index >= batch->job_count)
+            break;
+
+        // Decoding errors are reported when the key is parsed
+        Decode_job* job = &batch->jobs[job_index];
+        Sample* sample = new_Sample();
+        if (sample == NULL)
+            continue;
+
+        Streader* sr = Streader_init(STREADER_AUTO, job->data, job->length);
+        if (!Sample_parse_wavpack(sample, sr))
+        {
+            del_Sample(sample);
+            continue;
+        }
+
+        job->sample = sample;
+    }
+
+    return;
+}
+
+
+static int count_sample_jobs(
+        long count, const char* const keys[], const long lengths[])
+{
+    assert(count >= 0);
+
+    int job_count = 0;
+    for (long i = 0; i < count; ++i)
+    {
+        if (lengths[i] > 0 && key_is_wavpack_data(keys[i]))
+            ++job_count;
+    }
+
+    return job_count;
+}
+
+
+static void decode_data_samples(
+        Handle* handle,
+        long count,
+        const char* const keys[],
+        const void* const data[],
+        const long lengths[],
+        Sample* samples[])
+{
+    assert(handle != NULL);
+    assert(count >= 0);
+    assert(count == 0 || samples != NULL);
+
+    for (long i = 0; i < count; ++i)
+        samples[i] = NULL;
+
+    const int job_count = count_sample_jobs(count, keys, lengths);
+    if (job_count == 0)
+        return;
+
+    Decode_batch* batch = &(Decode_batch){ .next_job = 0, .job_count = 0 };
+    batch->jobs = memory_alloc_items(Decode_job, job_count);
+    if (batch->jobs == NULL)
+        return;
+
+    for (long i = 0; i < count; ++i)
+    {
+        if (lengths[i] > 0 && key_is_wavpack_data(keys[i]))
+        {
+            Decode_job* job = &batch->jobs[batch->job_count];
+            job->data = data[i];
+            job->length = lengths[i];
+            job->sample = NULL;
+            ++batch->job_count;
+        }
+    }
+    assert(batch->job_count == job_count);
+
+    // Decoding is only an optimisation, so we give up quietly on failure
+    if (pthread_mutex_init(&batch->lock, NULL) == 0)
+    {
+        const int max_threads = Player_get_thread_count(handle->player);
+        Thread_pool* pool = NULL;
+        if (max_threads > 1 && job_count > 1)
+            pool = new_Thread_pool(min(max_threads, job_count));
+
+        if (pool != NULL)
+        {
+            Thread_pool_run(pool, decode_samples, batch);
+            del_Thread_pool(pool);
+        }
+        else
+        {
+            decode_samples(batch, 0);
+        }
+
+        pthread_mutex_destroy(&batch->lock);
+    }
+
+    int job_index = 0;
+    for (long i = 0; i < count; ++i)
+    {
+        if (lengths[i] > 0 && key_is_wavpack_data(keys[i]))
+        {
+            samples[i] = batch->jobs[job_index].sample;
+            ++job_index;
+        }
+    }
+
+    memory_free(batch->jobs);
+
+    return;
+}
+
+
+static void add_decoded_samples(
+        Handle* handle,
+        long count,
+        const void* const data[],
+        const long lengths[],
+        Sample* samples[])
+{
+    assert(handle != NULL);
+    assert(count >= 0);
+
+    Sample_cache* cache = Handle_get_module(handle)->sample_cache;
+    for (long i = 0; i < count; ++i)
+    {
+        if (samples[i] != NULL && !Sample_cache_add_decoded(
+                    cache, data[i], (size_t)lengths[i], samples[i]))
+            del_Sample(samples[i]);
+        samples[i] = NULL;
+    }
+
+    return;
+}
+
+
+static void decode_samples_in_advance(
+        Handle* handle,
+        long count,
+        const char* const keys[],
+        const void* const data[],
+        const long lengths[])
+{
+    assert(handle != NULL);
+    assert(count >= 0);
+
+    // Decoding in advance only pays off if it can be done in parallel
+    if (Player_get_thread_count(handle->player) <= 1 ||
+            count_sample_jobs(count, keys, lengths) <= 1)
+        return;
+
+    Sample** samples = memory_alloc_items(Sample*, count);
+    if (samples == NULL)
+        return;
+
+    decode_data_samples(handle, count, keys, data, lengths, samples);
+    add_decoded_samples(handle, count, data, lengths, samples);
+
+    memory_free(samples);
+
+    return;
+}
+
+
+static bool parse_data_list(
+        Handle* handle,
+        long count,
+        const char* const keys[],
+        const void* const data[],
+        const long lengths[])
+{
+    assert(handle != NULL);
+    assert(count >= 0);
+
+    handle->defer_connections = true;
+    handle->connections_changed = false;
+
+    bool success = true;
+    for (long i = 0; i < count && success; ++i)
+        success = parse_data(handle, keys[i], data[i], lengths[i]);
+
+    handle->defer_connections = false;
+    Sample_cache_clear_decoded(Handle_get_module(handle)->sample_cache);
+
+    if (handle->connections_changed && !prepare_connections(handle))
+        return false;
+
+    return success;
+}
+
+
+bool parse_data_batch(
+        Handle* handle,
+        long count,
+        const char* const keys[],
+        const void* const data[],
+        const long lengths[])
+{
+    assert(handle != NULL);
+    assert(count >= 0);
+    assert(count == 0 || keys != NULL);
+    assert(count == 0 || data != NULL);
+    assert(count == 0 || lengths != NULL);
+
+    Sample_cache* cache = Handle_get_module(handle)->sample_cache;
+
+    // Lazily decoded samples are not decoded while loading
+    if (Sample_cache_get_limit(cache) == 0)
+        decode_samples_in_advance(handle, count, keys, data, lengths);
+
+    return parse_data_list(handle, count, keys, data, lengths);
+}
+
+
+bool find_pattern_edit(Pattern_edit* edit, const char* key)
+{
+    assert(edit != NULL);
+    assert(key != NULL);
+
+    edit->type = PATTERN_EDIT_NONE;
+    edit->pat_index = -1;
+    edit->col_index = -1;
+    Tstamp_init(&edit->length);
+    edit->col = NULL;
+
+    const char* last_element = strrchr(key, '/');
+    last_element = (last_element != NULL) ? last_element + 1 : key;
+    if (!string_has_prefix(last_element, "p_"))
+        return true;
+
+    const int index = string_extract_index(key, "pat_", 3, "/");
+    if (index < 0)
+        return false;
+
+    if (index >= KQT_PATTERNS_MAX)
+        return true;
+
+    const char* subkey = strchr(key, '/') + 1;
+    if (string_eq(subkey, "p_pattern.json"))
+    {
+        edit->type = PATTERN_EDIT_LENGTH;
+        edit->pat_index = index;
+        return true;
+    }
+
+    const char* second_element = strchr(subkey, '/');
+    if (second_element == NULL)
+        return !string_eq(subkey, "p_manifest.json");
+
+    ++second_element;
+    const int sub_index = string_extract_index(subkey, "col_", 2, "/");
+    if (sub_index >= 0 && string_eq(second_element, "p_triggers.json"))
+    {
+        if (sub_index < KQT_COLUMNS_MAX)
+        {
+            edit->type = PATTERN_EDIT_COLUMN;
+            edit->pat_index = index;
+            edit->col_index = sub_index;
+        }
+        return true;
+    }
+
+    return string_extract_index(subkey, "instance_", 3, "/") < 0;
+}
+
+
+bool parse_pattern_edit(
+        Handle* handle,
+        Pattern_edit* edit,
+        const void* data,
+        long length,
+        const Tstamp* pat_length,
+        Error* error)
+{
+    assert(handle != NULL);
+    assert(edit != NULL);
+    assert(edit->col == NULL);
+    assert(data != NULL || length == 0);
+    assert(length >= 0);
+    assert(pat_length != NULL);
+    assert(error != NULL);
+
+    if (length == 0)
+        data = NULL;
+
+    Streader* sr = Streader_init(STREADER_AUTO, data, length);
+
+    if (edit->type == PATTERN_EDIT_LENGTH)
+    {
+        Pattern* pat = new_Pattern();
+        if (pat == NULL)
+        {
+            Error_set(error, ERROR_MEMORY, "Couldn't allocate memory");
+            return false;
+        }
+
+        if (!Pattern_parse_header(pat, sr))
+        {
+            Error_copy(error, &sr->error);
+            del_Pattern(pat);
+            return false;
+        }
+
+        Tstamp_copy(&edit->length, Pattern_get_length(pat));
+        del_Pattern(pat);
+    }
+    else if (edit->type == PATTERN_EDIT_COLUMN)
+    {
+        const Event_handler* handler = Player_get_event_handler(handle->player);
+        const Event_names* event_names = Event_handler_get_names(handler);
+        edit->col = new_Column_from_string(sr, pat_length, event_names);
+        if (edit->col == NULL)
+        {
+            if (Streader_is_error_set(sr))
+                Error_copy(error, &sr->error);
+            else
+                Error_set(error, ERROR_MEMORY, "Couldn't allocate memory");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
 static bool parse_module_level(
         Handle* handle,
         const char* key,
@@ -436,6 +832,7 @@ static bool parse_album_level(
             return false;
         }
         module->album_is_existent = existent;
+        handle->validate_all = true;
     }
     else if (string_eq(subkey, "p_tracks.json"))
     {
@@ -447,6 +844,7 @@ static bool parse_album_level(
         }
         del_Track_list(module->track_list);
         module->track_list = tl;
+        handle->validate_all = true;
     }
     return true;
 }
@@ -490,6 +888,10 @@ static Instrument* add_instrument(Handle* handle, int index)
         return NULL;
     }
 
+    // Mixing plans refer to the Devices directly
+    if (!prepare_connections(handle))
+        return NULL;
+
     return ins;
 }
 
@@ -731,6 +1133,12 @@ static Generator* add_generator(
         return NULL;
     }
 
+    Device_params_set_sample_cache(
+            gen->parent.dparams, Handle_get_module(handle)->sample_cache);
+
+    if (!prepare_connections(handle))
+        return NULL;
+
     return gen;
 }
 
@@ -794,8 +1202,12 @@ static bool parse_generator_level(
             {
                 //Connections_disconnect(module->connections,
                 //                       (Device*)gen);
+                Player_reset_gen_voices(handle->player, gen);
+                Player_reset_gen_voices(handle->length_counter, gen);
             }
             Gen_table_remove_gen(table, gen_index);
+            if (!prepare_connections(handle))
+                return false;
         }
         else
         {
@@ -817,6 +1229,12 @@ static bool parse_generator_level(
                         "Unsupported Generator type: %s", type);
                 return false;
             }
+            // The Voice states of the old implementation become invalid
+            Player_reset_gen_voices(handle->player, gen);
+            Player_reset_gen_voices(handle->length_counter, gen);
+            gen->init_vstate = NULL;
+            gen->clear_vstate = NULL;
+
             Device_impl* gen_impl = cons(gen);
             if (gen_impl == NULL)
             {
@@ -1008,6 +1426,9 @@ static Effect* add_effect(Handle* handle, int index, Effect_table* table)
         }
     }
 
+    if (!prepare_connections(handle))
+        return NULL;
+
     return eff;
 }
 
@@ -1166,6 +1587,12 @@ static DSP* add_dsp(
         return NULL;
     }
 
+    Device_params_set_sample_cache(
+            dsp->parent.dparams, Handle_get_module(handle)->sample_cache);
+
+    if (!prepare_connections(handle))
+        return NULL;
+
     return dsp;
 }
 
@@ -1216,6 +1643,8 @@ static bool parse_dsp_level(
         if (!Streader_has_data(sr))
         {
             DSP_table_remove_dsp(dsp_table, dsp_index);
+            if (!prepare_connections(handle))
+                return false;
         }
         else
         {
@@ -1365,6 +1794,7 @@ static bool parse_pattern_level(
         return true;
 
     Module* module = Handle_get_module(handle);
+    handle->changed_pats[index] = true;
 
     if (string_eq(subkey, "p_manifest.json"))
     {
@@ -1609,6 +2039,7 @@ static bool parse_subsong_level(
         }
 
         Song_table_set_existent(module->songs, index, existent);
+        handle->changed_songs[index] = true;
     }
     else if (string_eq(subkey, "p_song.json"))
     {
@@ -1661,10 +2092,27 @@ static bool parse_subsong_level(
         }
 #endif
 
-        if (module->order_lists[index] != NULL)
-            del_Order_list(module->order_lists[index]);
+        // Patterns of the old Order list must be validated again
+        const Order_list* old_ol = module->order_lists[index];
+        if (old_ol != NULL)
+        {
+            for (size_t i = 0; i < Order_list_get_len(old_ol); ++i)
+            {
+                const Pat_inst_ref* piref =
+                    Order_list_get_pat_inst_ref(old_ol, i);
+                handle->changed_pats[piref->pat] = true;
+            }
+        }
+
+        if (!Module_set_order_list(module, index, ol))
+        {
+            Handle_set_error(handle, ERROR_MEMORY,
+                    "Couldn't allocate memory");
+            del_Order_list(ol);
+            return false;
+        }
 
-        module->order_lists[index] = ol;
+        handle->changed_songs[index] = true;
     }
 
     return true;
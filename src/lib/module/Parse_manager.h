@@ -18,7 +18,10 @@
 
 #include <stdbool.h>
 
+#include <Error.h>
 #include <Handle_private.h>
+#include <module/sheet/Column.h>
+#include <Tstamp.h>
 
 
 /**
@@ -44,6 +47,96 @@ bool parse_data(
         long length);
 
 
+/**
+ * Parse a batch of data.
+ *
+ * The keys are parsed in the given order with the same effect as separate
+ * calls of parse_data. Compressed samples in the batch are decoded in
+ * parallel beforehand, and Device connections are prepared only once after
+ * all the keys have been parsed.
+ *
+ * \param handle    The Kunquat Handle -- must not be \c NULL.
+ * \param count     The number of keys -- must be >= \c 0.
+ * \param keys      The keys of the data -- must not be \c NULL if
+ *                  \a count > \c 0.
+ * \param data      The data of each key -- must not be \c NULL if
+ *                  \a count > \c 0.
+ * \param lengths   The lengths of the data -- must not be \c NULL if
+ *                  \a count > \c 0.
+ *
+ * \return   \c true if all the keys were parsed successfully, otherwise
+ *           \c false. Parsing stops at the first failed key.
+ */
+bool parse_data_batch(
+        Handle* handle,
+        long count,
+        const char* const keys[],
+        const void* const data[],
+        const long lengths[]);
+
+
+/**
+ * The type of a Pattern edit.
+ */
+typedef enum
+{
+    PATTERN_EDIT_NONE,      ///< The key does not contain player data.
+    PATTERN_EDIT_LENGTH,    ///< The Pattern header is replaced.
+    PATTERN_EDIT_COLUMN,    ///< A Column is replaced.
+} Pattern_edit_type;
+
+
+/**
+ * A change in the contents of a Pattern that is parsed apart from the
+ * composition so that it can be taken into use later.
+ */
+typedef struct Pattern_edit
+{
+    Pattern_edit_type type;
+    int pat_index;
+    int col_index;
+    Tstamp length;  ///< The new length if the header is replaced.
+    Column* col;    ///< The Column that is not in use by the composition.
+} Pattern_edit;
+
+
+/**
+ * Find the Pattern contents that a key refers to.
+ *
+ * \param edit   The Pattern edit -- must not be \c NULL.
+ * \param key    The key of the data -- must not be \c NULL.
+ *
+ * \return   \c true if the data of \a key can be parsed into \a edit, or
+ *           \c false if the key changes the structure of the composition.
+ */
+bool find_pattern_edit(Pattern_edit* edit, const char* key);
+
+
+/**
+ * Parse data into a Pattern edit without modifying the composition.
+ *
+ * \param handle       The Kunquat Handle -- must not be \c NULL.
+ * \param edit         The Pattern edit returned by find_pattern_edit -- must
+ *                     not be \c NULL.
+ * \param data         The data -- must not be \c NULL if it has a non-zero
+ *                     length.
+ * \param length       The length -- must be >= \c 0.
+ * \param pat_length   The length of the Pattern -- must not be \c NULL.
+ * \param error        Destination for the error description -- must not be
+ *                     \c NULL.
+ *
+ * \return   \c true if successful. Otherwise, \c false is returned and
+ *           \a error is set to indicate the error.
+ */
+bool parse_pattern_edit(
+        Handle* handle,
+        Pattern_edit* edit,
+        const void* data,
+        long length,
+        const Tstamp* pat_length,
+        Error* error);
+
+
 #endif // K_PARSE_MANAGER_H
 
 
@@ -170,6 +170,18 @@ Pat_inst_ref* Order_list_get_pat_inst_ref(const Order_list* ol, size_t index)
 }
 
 
+bool Order_list_contains(const Order_list* ol, const Pat_inst_ref* piref)
+{
+    assert(ol != NULL);
+    assert(piref != NULL);
+
+    Index_mapping* key = INDEX_MAPPING_AUTO;
+    key->p = *piref;
+
+    return AAtree_contains(ol->index_map, key);
+}
+
+
 void del_Order_list(Order_list* ol)
 {
     if (ol == NULL)
@@ -16,6 +16,7 @@
 #define K_ORDER_LIST_H
 
 
+#include <stdbool.h>
 #include <stdlib.h>
 
 #include <string/Streader.h>
@@ -60,6 +61,17 @@ size_t Order_list_get_len(const Order_list* ol);
 Pat_inst_ref* Order_list_get_pat_inst_ref(const Order_list* ol, size_t index);
 
 
+/**
+ * Find out whether the Order list contains a Pattern instance.
+ *
+ * \param ol      The Order list -- must not be \c NULL.
+ * \param piref   The Pattern instance reference -- must not be \c NULL.
+ *
+ * \return   \c true if \a piref is included in \a ol, otherwise \c false.
+ */
+bool Order_list_contains(const Order_list* ol, const Pat_inst_ref* piref);
+
+
 /**
  * Destroy an existing Order list.
  *
@@ -0,0 +1,215 @@
+
+
+/*
+ * Author: Tomi Jylhä-Ollila, Finland 2014
+ *
+ * This file is part of Kunquat.
+ *
+ * CC0 1.0 Universal, http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * To the extent possible under law, Kunquat Affirmers have waived all
+ * copyright and related or neighboring rights to Kunquat.
+ */
+
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <containers/AAtree.h>
+#include <debug/assert.h>
+#include <kunquat/limits.h>
+#include <memory.h>
+#include <module/sheet/Pat_inst_index.h>
+
+
+struct Pat_inst_index
+{
+    AAtree* locations;
+};
+
+
+#define PAT_INST_LOCATION_AUTO (&(Pat_inst_location){ .song = 0, .system = 0 })
+
+
+static int Pat_inst_location_cmp(
+        const Pat_inst_location* loc1, const Pat_inst_location* loc2)
+{
+    assert(loc1 != NULL);
+    assert(loc2 != NULL);
+
+    const int piref_cmp = Pat_inst_ref_cmp(&loc1->piref, &loc2->piref);
+    if (piref_cmp != 0)
+        return piref_cmp;
+
+    if (loc1->song < loc2->song)
+        return -1;
+    else if (loc1->song > loc2->song)
+        return 1;
+    return 0;
+}
+
+
+Pat_inst_index* new_Pat_inst_index(void)
+{
+    Pat_inst_index* index = memory_alloc_item(Pat_inst_index);
+    if (index == NULL)
+        return NULL;
+
+    index->locations = new_AAtree(
+            (int (*)(const void*, const void*))Pat_inst_location_cmp,
+            memory_free);
+    if (index->locations == NULL)
+    {
+        memory_free(index);
+        return NULL;
+    }
+
+    return index;
+}
+
+
+static bool is_added(
+        const Order_list* old_ol, const Order_list* new_ol, size_t system)
+{
+    assert(new_ol != NULL);
+    assert(system < Order_list_get_len(new_ol));
+
+    if (old_ol == NULL)
+        return true;
+
+    return !Order_list_contains(
+            old_ol, Order_list_get_pat_inst_ref(new_ol, system));
+}
+
+
+static void remove_location(
+        Pat_inst_index* index, const Pat_inst_ref* piref, int16_t song)
+{
+    assert(index != NULL);
+    assert(piref != NULL);
+
+    Pat_inst_location* key = PAT_INST_LOCATION_AUTO;
+    key->piref = *piref;
+    key->song = song;
+
+    Pat_inst_location* loc = AAtree_remove(index->locations, key);
+    assert(loc != NULL);
+    memory_free(loc);
+
+    return;
+}
+
+
+bool Pat_inst_index_update(
+        Pat_inst_index* index,
+        int16_t song,
+        const Order_list* old_ol,
+        const Order_list* new_ol)
+{
+    assert(index != NULL);
+    assert(song >= 0);
+    assert(song < KQT_SONGS_MAX);
+
+    const size_t old_len = (old_ol != NULL) ? Order_list_get_len(old_ol) : 0;
+    const size_t new_len = (new_ol != NULL) ? Order_list_get_len(new_ol) : 0;
+
+    // Add the Pattern instances that are not in the old Order list
+    for (size_t system = 0; system < new_len; ++system)
+    {
+        if (!is_added(old_ol, new_ol, system))
+            continue;
+
+        Pat_inst_location* loc = memory_alloc_item(Pat_inst_location);
+        if (loc != NULL)
+        {
+            loc->piref = *Order_list_get_pat_inst_ref(new_ol, system);
+            loc->song = song;
+            loc->system = system;
+        }
+
+        if (loc == NULL || !AAtree_ins(index->locations, loc))
+        {
+            memory_free(loc);
+
+            // Roll back the additions
+            for (size_t added = 0; added < system; ++added)
+            {
+                if (is_added(old_ol, new_ol, added))
+                    remove_location(
+                            index,
+                            Order_list_get_pat_inst_ref(new_ol, added),
+                            song);
+            }
+
+            return false;
+        }
+    }
+
+    // Update the positions of the Pattern instances in both lists
+    for (size_t system = 0; system < new_len; ++system)
+    {
+        Pat_inst_location* key = PAT_INST_LOCATION_AUTO;
+        key->piref = *Order_list_get_pat_inst_ref(new_ol, system);
+        key->song = song;
+
+        Pat_inst_location* loc = AAtree_get_exact(index->locations, key);
+        assert(loc != NULL);
+        loc->system = system;
+    }
+
+    // Remove the Pattern instances that are not in the new Order list
+    for (size_t system = 0; system < old_len; ++system)
+    {
+        const Pat_inst_ref* piref = Order_list_get_pat_inst_ref(old_ol, system);
+        if (new_ol == NULL || !Order_list_contains(new_ol, piref))
+            remove_location(index, piref, song);
+    }
+
+    return true;
+}
+
+
+const Pat_inst_location* Pat_inst_index_get_at_least(
+        const Pat_inst_index* index, const Pat_inst_ref* piref, int16_t song)
+{
+    assert(index != NULL);
+    assert(piref != NULL);
+    assert(song >= 0);
+    assert(song < KQT_SONGS_MAX);
+
+    Pat_inst_location* key = PAT_INST_LOCATION_AUTO;
+    key->piref = *piref;
+    key->song = song;
+
+    return AAtree_get_at_least(index->locations, key);
+}
+
+
+const Pat_inst_location* Pat_inst_index_get_next(
+        const Pat_inst_index* index, const Pat_inst_location* loc)
+{
+    assert(index != NULL);
+    assert(loc != NULL);
+
+    // Song numbers past the last song sort after all songs of the instance
+    Pat_inst_location* key = PAT_INST_LOCATION_AUTO;
+    key->piref = loc->piref;
+    key->song = (int16_t)(loc->song + 1);
+
+    return AAtree_get_at_least(index->locations, key);
+}
+
+
+void del_Pat_inst_index(Pat_inst_index* index)
+{
+    if (index == NULL)
+        return;
+
+    del_AAtree(index->locations);
+    memory_free(index);
+
+    return;
+}
+
+
@@ -0,0 +1,110 @@
+
+
+/*
+ * Author: Tomi Jylhä-Ollila, Finland 2014
+ *
+ * This file is part of Kunquat.
+ *
+ * CC0 1.0 Universal, http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * To the extent possible under law, Kunquat Affirmers have waived all
+ * copyright and related or neighboring rights to Kunquat.
+ */
+
+
+#ifndef K_PAT_INST_INDEX_H
+#define K_PAT_INST_INDEX_H
+
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <module/sheet/Order_list.h>
+#include <Pat_inst_ref.h>
+
+
+/**
+ * Pattern instance index maps Pattern instances to their positions in the
+ * Order lists of all songs.
+ */
+typedef struct Pat_inst_index Pat_inst_index;
+
+
+/**
+ * A position of a Pattern instance in an Order list.
+ */
+typedef struct Pat_inst_location
+{
+    Pat_inst_ref piref;
+    int16_t song;
+    size_t system;
+} Pat_inst_location;
+
+
+/**
+ * Create a new Pattern instance index.
+ *
+ * \return   The new Pattern instance index if successful, or \c NULL if
+ *           memory allocation failed.
+ */
+Pat_inst_index* new_Pat_inst_index(void);
+
+
+/**
+ * Replace the Order list of a song in the Pattern instance index.
+ *
+ * The index is left unchanged if memory allocation fails.
+ *
+ * \param index    The Pattern instance index -- must not be \c NULL.
+ * \param song     The song number -- must be >= \c 0 and < \c KQT_SONGS_MAX.
+ * \param old_ol   The Order list currently indexed for \a song, or \c NULL.
+ * \param new_ol   The new Order list of \a song, or \c NULL.
+ *
+ * \return   \c true if successful, or \c false if memory allocation failed.
+ */
+bool Pat_inst_index_update(
+        Pat_inst_index* index,
+        int16_t song,
+        const Order_list* old_ol,
+        const Order_list* new_ol);
+
+
+/**
+ * Get the first location at or after a Pattern instance in a song.
+ *
+ * The locations are ordered by Pattern instance and then by song number.
+ *
+ * \param index   The Pattern instance index -- must not be \c NULL.
+ * \param piref   The Pattern instance reference -- must not be \c NULL.
+ * \param song    The song number -- must be >= \c 0 and < \c KQT_SONGS_MAX.
+ *
+ * \return   The location if one exists, otherwise \c NULL.
+ */
+const Pat_inst_location* Pat_inst_index_get_at_least(
+        const Pat_inst_index* index, const Pat_inst_ref* piref, int16_t song);
+
+
+/**
+ * Get the location following another location.
+ *
+ * \param index   The Pattern instance index -- must not be \c NULL.
+ * \param loc     The current location -- must not be \c NULL.
+ *
+ * \return   The next location if one exists, otherwise \c NULL.
+ */
+const Pat_inst_location* Pat_inst_index_get_next(
+        const Pat_inst_index* index, const Pat_inst_location* loc);
+
+
+/**
+ * Destroy an existing Pattern instance index.
+ *
+ * \param index   The Pattern instance index, or \c NULL.
+ */
+void del_Pat_inst_index(Pat_inst_index* index);
+
+
+#endif // K_PAT_INST_INDEX_H
+
+
@@ -159,6 +159,20 @@ bool Pattern_set_column(Pattern* pat, int index, Column* col)
 }
 
 
+Column* Pattern_swap_column(Pattern* pat, int index, Column* col)
+{
+    assert(pat != NULL);
+    assert(index >= 0);
+    assert(index < KQT_COLUMNS_MAX);
+    assert(col != NULL);
+
+    Column* old_col = pat->cols[index];
+    pat->cols[index] = col;
+
+    return old_col;
+}
+
+
 Column* Pattern_get_column(const Pattern* pat, int index)
 {
     assert(pat != NULL);
@@ -94,6 +94,18 @@ bool Pattern_get_inst_existent(const Pattern* pat, int index);
 bool Pattern_set_column(Pattern* pat, int index, Column* col);
 
 
+/**
+ * Replace a Column of the Pattern without destroying the old Column.
+ *
+ * \param pat     The Pattern -- must not be \c NULL.
+ * \param index   The Column index -- must be >= \c 0 and < \c KQT_COLUMNS_MAX.
+ * \param col     The Column -- must not be \c NULL.
+ *
+ * \return   The old Column. The caller must destroy it.
+ */
+Column* Pattern_swap_column(Pattern* pat, int index, Column* col);
+
+
 /**
  * Return a column of the Pattern.
  *
@@ -17,9 +17,11 @@
 #include <stdio.h>
 
 #include <debug/assert.h>
+#include <Error.h>
 #include <kunquat/limits.h>
 #include <memory.h>
 #include <module/sheet/Trigger.h>
+#include <string/common.h>
 
 
 Trigger* new_Trigger(Event_type type, Tstamp* pos)
@@ -35,10 +37,70 @@ Trigger* new_Trigger(Event_type type, Tstamp* pos)
     Tstamp_copy(&trigger->pos, pos);
     trigger->desc = NULL;
 
+    trigger->name[0] = '\0';
+    trigger->arg_type = TRIGGER_ARG_DESC;
+    trigger->param_type = VALUE_TYPE_NONE;
+    trigger->arg = *VALUE_AUTO;
+    trigger->expr = NULL;
+
     return trigger;
 }
 
 
+static bool Trigger_compile_arg(Trigger* trigger, const char* str, size_t len)
+{
+    assert(trigger != NULL);
+    assert(str != NULL);
+
+    if (trigger->param_type == VALUE_TYPE_NONE)
+    {
+        trigger->arg_type = TRIGGER_ARG_NONE;
+        return true;
+    }
+
+    Streader* sr = Streader_init(STREADER_AUTO, str, len);
+
+    if (string_has_suffix(trigger->name, "\""))
+    {
+        // Quoted string arguments are used as is
+        if (trigger->param_type == VALUE_TYPE_STRING &&
+                Streader_read_string(
+                    sr, ENV_VAR_NAME_MAX, trigger->arg.value.string_type))
+        {
+            trigger->arg.type = VALUE_TYPE_STRING;
+            trigger->arg_type = TRIGGER_ARG_CONST;
+        }
+
+        return true;
+    }
+
+    Expr* expr = new_Expr_from_string(sr);
+    if (expr == NULL)
+    {
+        // Invalid expressions are reported when the Trigger is fired
+        return (Error_get_type(&sr->error) != ERROR_MEMORY);
+    }
+
+    const Value* const_value = Expr_get_const_value(expr);
+    if (const_value != NULL &&
+            Value_convert(
+                Value_copy(&trigger->arg, const_value),
+                &trigger->arg,
+                trigger->param_type))
+    {
+        del_Expr(expr);
+        trigger->arg_type = TRIGGER_ARG_CONST;
+        return true;
+    }
+
+    trigger->arg = *VALUE_AUTO;
+    trigger->expr = expr;
+    trigger->arg_type = TRIGGER_ARG_EXPR;
+
+    return true;
+}
+
+
 Trigger* new_Trigger_from_string(Streader* sr, const Event_names* names)
 {
     assert(sr != NULL);
@@ -73,6 +135,9 @@ Trigger* new_Trigger_from_string(Streader* sr, const Event_names* names)
     Value_type field_type = VALUE_TYPE_NONE;
     field_type = Event_names_get_param_type(names, type_str);
 
+    Streader_skip_whitespace(sr);
+    const size_t arg_start = sr->pos;
+
     if (field_type == VALUE_TYPE_NONE)
         Streader_read_null(sr);
     else
@@ -80,6 +145,8 @@ Trigger* new_Trigger_from_string(Streader* sr, const Event_names* names)
     if (Streader_is_error_set(sr))
         return NULL;
 
+    const size_t arg_len = sr->pos - arg_start;
+
     // End of event description
     Streader_match_char(sr, ']');
     if (Streader_is_error_set(sr))
@@ -105,6 +172,19 @@ Trigger* new_Trigger_from_string(Streader* sr, const Event_names* names)
 
     strncpy(trigger->desc, event_desc, &sr->str[sr->pos] - event_desc);
 
+    // Compile the event argument
+    assert(strlen(type_str) <= EVENT_NAME_MAX);
+    strcpy(trigger->name, type_str);
+    trigger->param_type = field_type;
+
+    if (!Trigger_compile_arg(trigger, &sr->str[arg_start], arg_len))
+    {
+        Streader_set_memory_error(
+                sr, "Could not allocate memory for a trigger");
+        del_Trigger(trigger);
+        return NULL;
+    }
+
     // End of trigger
     Streader_match_char(sr, ']');
     if (Streader_is_error_set(sr))
@@ -138,12 +218,52 @@ const char* Trigger_get_desc(const Trigger* trigger)
 }
 
 
+const char* Trigger_get_name(const Trigger* trigger)
+{
+    assert(trigger != NULL);
+    return trigger->name;
+}
+
+
+Trigger_arg_type Trigger_get_arg_type(const Trigger* trigger)
+{
+    assert(trigger != NULL);
+    return trigger->arg_type;
+}
+
+
+Value_type Trigger_get_param_type(const Trigger* trigger)
+{
+    assert(trigger != NULL);
+    return trigger->param_type;
+}
+
+
+const Value* Trigger_get_const_arg(const Trigger* trigger)
+{
+    assert(trigger != NULL);
+    assert(trigger->arg_type == TRIGGER_ARG_CONST);
+
+    return &trigger->arg;
+}
+
+
+const Expr* Trigger_get_expr(const Trigger* trigger)
+{
+    assert(trigger != NULL);
+    assert(trigger->arg_type == TRIGGER_ARG_EXPR);
+
+    return trigger->expr;
+}
+
+
 void del_Trigger(Trigger* trigger)
 {
     if (trigger == NULL)
         return;
 
     assert(Event_is_valid(trigger->type));
+    del_Expr(trigger->expr);
     memory_free(trigger->desc);
     memory_free(trigger);
 
@@ -20,11 +20,25 @@
 #include <stdbool.h>
 #include <stdio.h>
 
+#include <expr.h>
 #include <kunquat/limits.h>
 #include <player/Event_names.h>
 #include <player/Event_type.h>
 #include <string/Streader.h>
 #include <Tstamp.h>
+#include <Value.h>
+
+
+/**
+ * The form in which the argument of a Trigger is stored.
+ */
+typedef enum
+{
+    TRIGGER_ARG_DESC = 0, ///< Not compiled, evaluated from the description.
+    TRIGGER_ARG_NONE,     ///< No argument.
+    TRIGGER_ARG_CONST,    ///< A constant argument.
+    TRIGGER_ARG_EXPR,     ///< A compiled expression.
+} Trigger_arg_type;
 
 
 /**
@@ -36,6 +50,12 @@ typedef struct Trigger
     int ch_index;       ///< Channel number.
     Event_type type;    ///< The event type.
     char* desc;         ///< Trigger description in JSON format.
+
+    char name[EVENT_NAME_MAX + 1];  ///< The event name.
+    Trigger_arg_type arg_type;      ///< The argument form.
+    Value_type param_type;          ///< The event parameter type.
+    Value arg;                      ///< The constant argument.
+    Expr* expr;                     ///< The compiled argument expression.
 } Trigger;
 
 
@@ -92,6 +112,61 @@ Event_type Trigger_get_type(const Trigger* trigger);
 const char* Trigger_get_desc(const Trigger* trigger);
 
 
+/**
+ * Get the event name of the Trigger.
+ *
+ * \param trigger   The Trigger -- must not be \c NULL.
+ *
+ * \return   The event name.
+ */
+const char* Trigger_get_name(const Trigger* trigger);
+
+
+/**
+ * Get the form of the Trigger argument.
+ *
+ * If the type is \c TRIGGER_ARG_DESC, the argument must be evaluated from the
+ * description returned by Trigger_get_desc.
+ *
+ * \param trigger   The Trigger -- must not be \c NULL.
+ *
+ * \return   The argument type.
+ */
+Trigger_arg_type Trigger_get_arg_type(const Trigger* trigger);
+
+
+/**
+ * Get the parameter type of the Trigger event.
+ *
+ * \param trigger   The Trigger -- must not be \c NULL.
+ *
+ * \return   The parameter type.
+ */
+Value_type Trigger_get_param_type(const Trigger* trigger);
+
+
+/**
+ * Get the constant argument of the Trigger.
+ *
+ * \param trigger   The Trigger -- must not be \c NULL and must have a
+ *                  constant argument.
+ *
+ * \return   The argument, already converted to the parameter type.
+ */
+const Value* Trigger_get_const_arg(const Trigger* trigger);
+
+
+/**
+ * Get the compiled argument expression of the Trigger.
+ *
+ * \param trigger   The Trigger -- must not be \c NULL and must have an
+ *                  argument of type \c TRIGGER_ARG_EXPR.
+ *
+ * \return   The Expr.
+ */
+const Expr* Trigger_get_expr(const Trigger* trigger);
+
+
 /**
  * Destroy an existing Trigger.
  *
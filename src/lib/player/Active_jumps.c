@@ -20,7 +20,7 @@
 struct Active_jumps
 {
     AAtree* jumps;
-    size_t use_count; //< for debug checking
+    size_t use_count;
 };
 
 
@@ -134,6 +134,42 @@ void Active_jumps_reset(Active_jumps* jumps, Jump_cache* jcache)
 }
 
 
+int Active_jumps_get_count(const Active_jumps* jumps)
+{
+    assert(jumps != NULL);
+    return (int)jumps->use_count;
+}
+
+
+void Active_jumps_get_contexts(
+        const Active_jumps* jumps,
+        Jump_context* contexts)
+{
+    assert(jumps != NULL);
+    assert(contexts != NULL);
+
+    Jump_context* key = JUMP_CONTEXT_AUTO;
+    key->piref.pat = -1;
+    key->piref.inst = -1;
+
+    AAiter* iter = AAITER_AUTO;
+    AAiter_change_tree(iter, jumps->jumps);
+
+    int index = 0;
+    const Jump_context* jc = AAiter_get_at_least(iter, key);
+    while (jc != NULL)
+    {
+        contexts[index] = *jc;
+        ++index;
+        jc = AAiter_get_next(iter);
+    }
+
+    assert(index == (int)jumps->use_count);
+
+    return;
+}
+
+
 void del_Active_jumps(Active_jumps* jumps)
 {
     if (jumps == NULL)
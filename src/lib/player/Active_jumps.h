@@ -99,6 +99,28 @@ AAnode* Active_jumps_remove_context(
 void Active_jumps_reset(Active_jumps* jumps, Jump_cache* jcache);
 
 
+/**
+ * Get the number of Jump contexts in the Active jumps.
+ *
+ * \param jumps   The Active jumps -- must not be \c NULL.
+ *
+ * \return   The number of Jump contexts.
+ */
+int Active_jumps_get_count(const Active_jumps* jumps);
+
+
+/**
+ * Copy the Jump contexts of the Active jumps in order.
+ *
+ * \param jumps      The Active jumps -- must not be \c NULL.
+ * \param contexts   The destination array -- must not be \c NULL and must
+ *                   have space for Active_jumps_get_count(\a jumps) contexts.
+ */
+void Active_jumps_get_contexts(
+        const Active_jumps* jumps,
+        Jump_context* contexts);
+
+
 /**
  * Destroy existing Active jumps.
  *
@@ -78,6 +78,17 @@ void Active_names_reset(Active_names* names)
 }
 
 
+void Active_names_copy(Active_names* dest, const Active_names* src)
+{
+    assert(dest != NULL);
+    assert(src != NULL);
+
+    memcpy(dest->names, src->names, sizeof(dest->names));
+
+    return;
+}
+
+
 void del_Active_names(Active_names* names)
 {
     if (names == NULL)
@@ -93,6 +93,15 @@ const char* Active_names_get(
 void Active_names_reset(Active_names* names);
 
 
+/**
+ * Copy Active names.
+ *
+ * \param dest   The destination Active names -- must not be \c NULL.
+ * \param src    The source Active names -- must not be \c NULL.
+ */
+void Active_names_copy(Active_names* dest, const Active_names* src);
+
+
 /**
  * Destroy existing Active names.
  *
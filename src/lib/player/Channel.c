@@ -176,6 +176,72 @@ void Channel_reset(Channel* ch)
 }
 
 
+bool Channel_copy_state(Channel* restrict dest, const Channel* restrict src)
+{
+    assert(dest != NULL);
+    assert(src != NULL);
+    assert(dest != src);
+
+    if (src->event_cache != NULL)
+    {
+        if (dest->event_cache == NULL)
+        {
+            dest->event_cache = new_Event_cache();
+            if (dest->event_cache == NULL)
+                return false;
+        }
+
+        if (!Event_cache_copy(dest->event_cache, src->event_cache))
+            return false;
+    }
+
+    if (!Channel_gen_state_copy(dest->cgstate, src->cgstate))
+        return false;
+
+    Random_copy(dest->rand, src->rand);
+
+    dest->ins_input = src->ins_input;
+    dest->generator = src->generator;
+    dest->effect = src->effect;
+    dest->inst_effects = src->inst_effects;
+    dest->dsp = src->dsp;
+
+    dest->volume = src->volume;
+
+    Tstamp_copy(&dest->force_slide_length, &src->force_slide_length);
+    LFO_copy(&dest->tremolo, &src->tremolo);
+    dest->tremolo_speed = src->tremolo_speed;
+    Tstamp_copy(&dest->tremolo_speed_slide, &src->tremolo_speed_slide);
+    dest->tremolo_depth = src->tremolo_depth;
+    Tstamp_copy(&dest->tremolo_depth_slide, &src->tremolo_depth_slide);
+
+    Tstamp_copy(&dest->pitch_slide_length, &src->pitch_slide_length);
+    LFO_copy(&dest->vibrato, &src->vibrato);
+    dest->vibrato_speed = src->vibrato_speed;
+    Tstamp_copy(&dest->vibrato_speed_slide, &src->vibrato_speed_slide);
+    dest->vibrato_depth = src->vibrato_depth;
+    Tstamp_copy(&dest->vibrato_depth_slide, &src->vibrato_depth_slide);
+
+    Tstamp_copy(&dest->filter_slide_length, &src->filter_slide_length);
+    LFO_copy(&dest->autowah, &src->autowah);
+    dest->autowah_speed = src->autowah_speed;
+    Tstamp_copy(&dest->autowah_speed_slide, &src->autowah_speed_slide);
+    dest->autowah_depth = src->autowah_depth;
+    Tstamp_copy(&dest->autowah_depth_slide, &src->autowah_depth_slide);
+
+    dest->panning = src->panning;
+    Slider_copy(&dest->panning_slider, &src->panning_slider);
+
+    dest->arpeggio_ref = src->arpeggio_ref;
+    dest->arpeggio_speed = src->arpeggio_speed;
+    dest->arpeggio_edit_pos = src->arpeggio_edit_pos;
+    for (int i = 0; i < KQT_ARPEGGIO_NOTES_MAX; ++i)
+        dest->arpeggio_tones[i] = src->arpeggio_tones[i];
+
+    return true;
+}
+
+
 double Channel_get_fg_force(Channel* ch, int gen_index)
 {
     assert(ch != NULL);
@@ -141,6 +141,22 @@ void Channel_set_event_cache(Channel* ch, Event_cache* cache);
 void Channel_reset(Channel* ch);
 
 
+/**
+ * Copy the playback state of a Channel.
+ *
+ * The copied state contains the parameters carried to new notes, the LFOs
+ * and Sliders, the random source, the Event cache and the Channel-specific
+ * Generator state. The General state and the foreground Voices are not
+ * copied.
+ *
+ * \param dest   The destination Channel -- must not be \c NULL.
+ * \param src    The source Channel -- must not be \c NULL or \a dest.
+ *
+ * \return   \c true if successful, or \c false if memory allocation failed.
+ */
+bool Channel_copy_state(Channel* restrict dest, const Channel* restrict src);
+
+
 /**
  * Return an actual force of a current foreground Voice.
  *
@@ -164,6 +164,71 @@ bool Channel_gen_state_alloc_keys(Channel_gen_state* cgstate, Streader* sr)
 }
 
 
+bool Channel_gen_state_copy_keys(
+        Channel_gen_state* cgstate, const Channel_gen_state* src)
+{
+    assert(cgstate != NULL);
+    assert(src != NULL);
+    assert(cgstate != src);
+
+    AAiter* iter = AAITER_AUTO;
+    AAiter_change_tree(iter, src->tree);
+
+    const Entry* src_entry = AAiter_get_at_least(iter, ENTRY_AUTO);
+    while (src_entry != NULL)
+    {
+        if (!AAtree_contains(cgstate->tree, src_entry))
+        {
+            Entry* new_entry = memory_alloc_item(Entry);
+            if (new_entry == NULL)
+                return false;
+
+            strcpy(new_entry->key, src_entry->key);
+            new_entry->value = *VALUE_AUTO;
+            new_entry->value.type = src_entry->value.type;
+            new_entry->is_empty = true;
+            if (!AAtree_ins(cgstate->tree, new_entry))
+            {
+                memory_free(new_entry);
+                return false;
+            }
+        }
+
+        src_entry = AAiter_get_next(iter);
+    }
+
+    return true;
+}
+
+
+bool Channel_gen_state_copy(
+        Channel_gen_state* cgstate, const Channel_gen_state* src)
+{
+    assert(cgstate != NULL);
+    assert(src != NULL);
+    assert(cgstate != src);
+
+    if (!Channel_gen_state_copy_keys(cgstate, src))
+        return false;
+
+    AAiter* iter = AAITER_AUTO;
+    AAiter_change_tree(iter, src->tree);
+
+    const Entry* src_entry = AAiter_get_at_least(iter, ENTRY_AUTO);
+    while (src_entry != NULL)
+    {
+        Entry* entry = AAtree_get_exact(cgstate->tree, src_entry);
+        assert(entry != NULL);
+        Value_copy(&entry->value, &src_entry->value);
+        entry->is_empty = src_entry->is_empty;
+
+        src_entry = AAiter_get_next(iter);
+    }
+
+    return true;
+}
+
+
 bool Channel_gen_state_modify_value(
         Channel_gen_state* cgstate,
         const char* key,
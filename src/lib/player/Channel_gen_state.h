@@ -50,6 +50,32 @@ Channel_gen_state* new_Channel_gen_state(void);
 bool Channel_gen_state_alloc_keys(Channel_gen_state* cgstate, Streader* sr);
 
 
+/**
+ * Allocate memory for the keys of another Channel gen state.
+ *
+ * The values of the copied keys are left empty.
+ *
+ * \param cgstate   The destination Channel gen state -- must not be \c NULL.
+ * \param src       The source Channel gen state -- must not be \c NULL.
+ *
+ * \return   \c true if successful, or \c false if memory allocation failed.
+ */
+bool Channel_gen_state_copy_keys(
+        Channel_gen_state* cgstate, const Channel_gen_state* src);
+
+
+/**
+ * Copy the keys and values of another Channel gen state.
+ *
+ * \param cgstate   The destination Channel gen state -- must not be \c NULL.
+ * \param src       The source Channel gen state -- must not be \c NULL.
+ *
+ * \return   \c true if successful, or \c false if memory allocation failed.
+ */
+bool Channel_gen_state_copy(
+        Channel_gen_state* cgstate, const Channel_gen_state* src);
+
+
 /**
  * Modify an existing parameter value.
  *
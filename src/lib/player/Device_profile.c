@@ -0,0 +1,61 @@
+
+
+/*
+ * Author: Tomi Jylhä-Ollila, Finland 2014
+ *
+ * This file is part of Kunquat.
+ *
+ * CC0 1.0 Universal, http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * To the extent possible under law, Kunquat Affirmers have waived all
+ * copyright and related or neighboring rights to Kunquat.
+ */
+
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <debug/assert.h>
+#include <player/Device_profile.h>
+
+
+Device_profile* Device_profile_init(Device_profile* profile)
+{
+    assert(profile != NULL);
+
+    profile->nanoseconds = 0;
+    profile->call_count = 0;
+    profile->frame_count = 0;
+
+    return profile;
+}
+
+
+void Device_profile_add(
+        Device_profile* profile, int64_t nanoseconds, int64_t frames)
+{
+    assert(profile != NULL);
+    assert(nanoseconds >= 0);
+    assert(frames >= 0);
+
+    profile->nanoseconds += nanoseconds;
+    ++profile->call_count;
+    profile->frame_count += frames;
+
+    return;
+}
+
+
+int64_t Device_profile_get_time(void)
+{
+    struct timespec ts;
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0)
+        return 0;
+
+    return (int64_t)ts.tv_sec * 1000000000LL + (int64_t)ts.tv_nsec;
+}
+
+
@@ -0,0 +1,68 @@
+
+
+/*
+ * Author: Tomi Jylhä-Ollila, Finland 2014
+ *
+ * This file is part of Kunquat.
+ *
+ * CC0 1.0 Universal, http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * To the extent possible under law, Kunquat Affirmers have waived all
+ * copyright and related or neighboring rights to Kunquat.
+ */
+
+
+#ifndef K_DEVICE_PROFILE_H
+#define K_DEVICE_PROFILE_H
+
+
+#include <stdint.h>
+
+
+/**
+ * Processing time statistics of a Device.
+ */
+typedef struct Device_profile
+{
+    int64_t nanoseconds;
+    int64_t call_count;
+    int64_t frame_count;
+} Device_profile;
+
+
+#define DEVICE_PROFILE_AUTO \
+    (&(Device_profile){ .nanoseconds = 0, .call_count = 0, .frame_count = 0 })
+
+
+/**
+ * Initialise a Device profile.
+ *
+ * \param profile   The Device profile -- must not be \c NULL.
+ *
+ * \return   The parameter \a profile.
+ */
+Device_profile* Device_profile_init(Device_profile* profile);
+
+
+/**
+ * Add a processing call to the Device profile.
+ *
+ * \param profile       The Device profile -- must not be \c NULL.
+ * \param nanoseconds   The time spent in the call -- must be >= \c 0.
+ * \param frames        The number of frames processed -- must be >= \c 0.
+ */
+void Device_profile_add(
+        Device_profile* profile, int64_t nanoseconds, int64_t frames);
+
+
+/**
+ * Get the current time of a monotonic clock.
+ *
+ * \return   The time in nanoseconds from an unspecified starting point.
+ */
+int64_t Device_profile_get_time(void);
+
+
+#endif // K_DEVICE_PROFILE_H
+
+
@@ -12,6 +12,7 @@
  */
 
 
+#include <Connections.h>
 #include <debug/assert.h>
 #include <devices/Device.h>
 #include <mathnum/common.h>
@@ -35,12 +36,13 @@ void Device_state_init(
     ds->audio_rate = audio_rate;
     ds->audio_buffer_size = audio_buffer_size;
 
-    for (int port = 0; port < KQT_DEVICE_PORTS_MAX; ++port)
-    {
-        for (Device_port_type type = DEVICE_PORT_TYPE_RECEIVE;
-                type < DEVICE_PORT_TYPES; ++type)
-            ds->buffers[type][port] = NULL;
-    }
+    ds->buffer_count = 0;
+    ds->buffer_capacity = 0;
+    ds->buffers = NULL;
+
+    ds->graph_state = NULL;
+
+    Device_profile_init(&ds->profile);
 
     ds->destroy = NULL;
 
@@ -108,14 +110,10 @@ bool Device_state_set_audio_buffer_size(Device_state* ds, int32_t size)
 
     ds->audio_buffer_size = min(ds->audio_buffer_size, size);
 
-    for (int port = 0; port < KQT_DEVICE_PORTS_MAX; ++port)
+    for (int i = 0; i < ds->buffer_count; ++i)
     {
-        for (Device_port_type type = DEVICE_PORT_TYPE_RECEIVE;
-                type < DEVICE_PORT_TYPES; ++type)
-        {
-            if (!Audio_buffer_resize(ds->buffers[type][port], size))
-                return false;
-        }
+        if (!Audio_buffer_resize(ds->buffers[i].buffer, size))
+            return false;
     }
 
     ds->audio_buffer_size = size;
@@ -134,6 +132,51 @@ bool Device_state_allocate_space(Device_state* ds, char* key)
 }
 
 
+/**
+ * Find the position of a port in the buffer list.
+ *
+ * \return   The index of the port if it exists, otherwise the index where
+ *           the port should be inserted.
+ */
+static int Device_state_find_buffer(
+        const Device_state* ds,
+        Device_port_type type,
+        int port)
+{
+    assert(ds != NULL);
+
+    int low = 0;
+    int high = ds->buffer_count;
+
+    while (low < high)
+    {
+        const int mid = low + (high - low) / 2;
+        const Device_port_buffer* pb = &ds->buffers[mid];
+        if (pb->type < type || (pb->type == type && pb->port < port))
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    return low;
+}
+
+
+static bool Device_state_has_buffer_at(
+        const Device_state* ds,
+        int index,
+        Device_port_type type,
+        int port)
+{
+    assert(ds != NULL);
+    assert(index >= 0);
+
+    return (index < ds->buffer_count) &&
+        (ds->buffers[index].type == type) &&
+        (ds->buffers[index].port == port);
+}
+
+
 bool Device_state_add_audio_buffer(
         Device_state* ds,
         Device_port_type type,
@@ -144,13 +187,36 @@ bool Device_state_add_audio_buffer(
     assert(port >= 0);
     assert(port < KQT_DEVICE_PORTS_MAX);
 
-    if (ds->buffers[type][port] != NULL)
+    const int index = Device_state_find_buffer(ds, type, port);
+    if (Device_state_has_buffer_at(ds, index, type, port))
         return true;
 
-    ds->buffers[type][port] = new_Audio_buffer(ds->audio_buffer_size);
-    if (ds->buffers[type][port] == NULL)
+    if (ds->buffer_count >= ds->buffer_capacity)
+    {
+        const int new_capacity = (ds->buffer_capacity > 0) ?
+            ds->buffer_capacity * 2 : 2;
+        Device_port_buffer* new_buffers = memory_realloc_items(
+                Device_port_buffer, new_capacity, ds->buffers);
+        if (new_buffers == NULL)
+            return false;
+
+        ds->buffers = new_buffers;
+        ds->buffer_capacity = new_capacity;
+    }
+
+    Audio_buffer* buffer = new_Audio_buffer(ds->audio_buffer_size);
+    if (buffer == NULL)
         return false;
 
+    for (int i = ds->buffer_count; i > index; --i)
+        ds->buffers[i] = ds->buffers[i - 1];
+
+    Device_port_buffer* pb = &ds->buffers[index];
+    pb->type = type;
+    pb->port = port;
+    pb->buffer = buffer;
+    ++ds->buffer_count;
+
     return true;
 }
 
@@ -162,16 +228,10 @@ void Device_state_clear_audio_buffers(
 {
     assert(ds != NULL);
 
-    for (int port = 0; port < KQT_DEVICE_PORTS_MAX; ++port)
-    {
-        for (Device_port_type type = DEVICE_PORT_TYPE_RECEIVE;
-                type < DEVICE_PORT_TYPES; ++type)
-        {
-            Audio_buffer* buffer = ds->buffers[type][port];
-            if (buffer != NULL)
-                Audio_buffer_clear(buffer, start, stop);
-        }
-    }
+    for (int i = 0; i < ds->buffer_count; ++i)
+        Audio_buffer_clear(ds->buffers[i].buffer, start, stop);
+
+    return;
 }
 
 
@@ -185,7 +245,39 @@ Audio_buffer* Device_state_get_audio_buffer(
     assert(port >= 0);
     assert(port < KQT_DEVICE_PORTS_MAX);
 
-    return ds->buffers[type][port];
+    const int index = Device_state_find_buffer(ds, type, port);
+    if (!Device_state_has_buffer_at(ds, index, type, port))
+        return NULL;
+
+    return ds->buffers[index].buffer;
+}
+
+
+int Device_state_get_audio_buffer_count(const Device_state* ds)
+{
+    assert(ds != NULL);
+    return ds->buffer_count;
+}
+
+
+Audio_buffer* Device_state_get_audio_buffer_at(
+        const Device_state* ds,
+        int index,
+        Device_port_type* type,
+        int* port)
+{
+    assert(ds != NULL);
+    assert(index >= 0);
+    assert(index < ds->buffer_count);
+
+    const Device_port_buffer* pb = &ds->buffers[index];
+
+    if (type != NULL)
+        *type = pb->type;
+    if (port != NULL)
+        *port = pb->port;
+
+    return pb->buffer;
 }
 
 
@@ -206,12 +298,10 @@ void del_Device_state(Device_state* ds)
     if (ds->destroy != NULL)
         ds->destroy(ds);
 
-    for (int port = 0; port < KQT_DEVICE_PORTS_MAX; ++port)
-    {
-        for (Device_port_type type = DEVICE_PORT_TYPE_RECEIVE;
-                type < DEVICE_PORT_TYPES; ++type)
-            del_Audio_buffer(ds->buffers[type][port]);
-    }
+    for (int i = 0; i < ds->buffer_count; ++i)
+        del_Audio_buffer(ds->buffers[i].buffer);
+    memory_free(ds->buffers);
+    del_Connections_state(ds->graph_state);
     memory_free(ds);
 
     return;
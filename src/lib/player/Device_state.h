@@ -23,6 +23,7 @@
 #include <Audio_buffer.h>
 #include <Decl.h>
 #include <kunquat/limits.h>
+#include <player/Device_profile.h>
 
 
 // FIXME: Figure out where we should define this
@@ -34,6 +35,17 @@ typedef enum
 } Device_port_type;
 
 
+/**
+ * An audio buffer attached to a port of a Device state.
+ */
+typedef struct Device_port_buffer
+{
+    Device_port_type type;
+    int port;
+    Audio_buffer* buffer;
+} Device_port_buffer;
+
+
 /**
  * Transient state of a Device.
  */
@@ -45,7 +57,16 @@ typedef struct Device_state
     int32_t audio_rate;
     int32_t audio_buffer_size;
 
-    Audio_buffer* buffers[DEVICE_PORT_TYPES][KQT_DEVICE_PORTS_MAX];
+    // Existing buffers sorted by port type and port number
+    int buffer_count;
+    int buffer_capacity;
+    Device_port_buffer* buffers;
+
+    // Playback state of the Connections inside the Device
+    Connections_state* graph_state;
+
+    // Processing statistics, only updated while profiling is enabled
+    Device_profile profile;
 
     // Virtual functions
     void (*destroy)(struct Device_state* ds);
@@ -192,6 +213,37 @@ Audio_buffer* Device_state_get_audio_buffer(
         int port);
 
 
+/**
+ * Get the number of audio buffers in the Device state.
+ *
+ * \param ds   The Device state -- must not be \c NULL.
+ *
+ * \return   The number of audio buffers.
+ */
+int Device_state_get_audio_buffer_count(const Device_state* ds);
+
+
+/**
+ * Return an audio buffer of the Device state by index.
+ *
+ * The audio buffers are ordered by port type and port number, so all
+ * receive buffers precede the send buffers.
+ *
+ * \param ds      The Device state -- must not be \c NULL.
+ * \param index   The buffer index -- must be >= \c 0 and less than the
+ *                number of audio buffers.
+ * \param type    Destination for the port type, or \c NULL.
+ * \param port    Destination for the port number, or \c NULL.
+ *
+ * \return   The Audio buffer.
+ */
+Audio_buffer* Device_state_get_audio_buffer_at(
+        const Device_state* ds,
+        int index,
+        Device_port_type* type,
+        int* port);
+
+
 /**
  * Reset the Device state.
  *
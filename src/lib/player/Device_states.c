@@ -14,14 +14,23 @@
 
 #include <containers/AAtree.h>
 #include <debug/assert.h>
+#include <mathnum/common.h>
+#include <memory.h>
 #include <player/Device_state.h>
 #include <player/Device_states.h>
-#include <memory.h>
 
 
 struct Device_states
 {
     AAtree* states;
+    uint64_t generation;
+
+    // Direct lookup table indexed by (device ID - index_base)
+    uint32_t index_base;
+    uint32_t index_size;
+    Device_state** index;
+
+    bool profiling_enabled;
 };
 
 
@@ -32,6 +41,11 @@ Device_states* new_Device_states(void)
         return NULL;
 
     states->states = NULL;
+    states->generation = 0;
+    states->index_base = 0;
+    states->index_size = 0;
+    states->index = NULL;
+    states->profiling_enabled = false;
 
     states->states = new_AAtree(
             (int (*)(const void*, const void*))Device_state_cmp,
@@ -46,13 +60,83 @@ Device_states* new_Device_states(void)
 }
 
 
+static bool Device_states_index_contains(
+        const Device_states* states, uint32_t id)
+{
+    assert(states != NULL);
+    assert(id > 0);
+
+    return (id >= states->index_base &&
+            id - states->index_base < states->index_size);
+}
+
+
+static bool Device_states_fit_index(Device_states* states, uint32_t id)
+{
+    assert(states != NULL);
+    assert(id > 0);
+
+    if (Device_states_index_contains(states, id))
+        return true;
+
+    // Cover the old range and the new ID with some room for new devices
+    const uint32_t old_stop = states->index_base + states->index_size;
+    uint32_t new_base = id;
+    uint32_t new_stop = id + 1;
+    if (states->index_size > 0)
+    {
+        new_base = min(states->index_base, id);
+        new_stop = max(old_stop, id + 1);
+    }
+    const uint32_t new_size = (new_stop - new_base) * 2;
+
+    Device_state** new_index = memory_alloc_items(Device_state*, new_size);
+    if (new_index == NULL)
+        return false;
+
+    for (uint32_t i = 0; i < new_size; ++i)
+        new_index[i] = NULL;
+    for (uint32_t i = 0; i < states->index_size; ++i)
+        new_index[states->index_base - new_base + i] = states->index[i];
+
+    memory_free(states->index);
+    states->index = new_index;
+    states->index_base = new_base;
+    states->index_size = new_size;
+
+    return true;
+}
+
+
 bool Device_states_add_state(Device_states* states, Device_state* state)
 {
     assert(states != NULL);
     assert(state != NULL);
     assert(!AAtree_contains(states->states, state));
 
-    return AAtree_ins(states->states, state);
+    const uint32_t id = state->device_id;
+    if (!Device_states_fit_index(states, id))
+        return false;
+
+    if (!AAtree_ins(states->states, state))
+        return false;
+
+    states->index[id - states->index_base] = state;
+    ++states->generation;
+
+    return true;
+}
+
+
+bool Device_states_has_state(const Device_states* states, uint32_t id)
+{
+    assert(states != NULL);
+    assert(id > 0);
+
+    if (!Device_states_index_contains(states, id))
+        return false;
+
+    return (states->index[id - states->index_base] != NULL);
 }
 
 
@@ -63,10 +147,23 @@ Device_state* Device_states_get_state(
     assert(states != NULL);
     assert(id > 0);
 
-    const Device_state* key = DEVICE_STATE_KEY(id);
-    assert(AAtree_contains(states->states, key));
+    if (!Device_states_index_contains(states, id))
+    {
+        assert(false);
+        return NULL;
+    }
 
-    return AAtree_get_exact(states->states, key);
+    Device_state* state = states->index[id - states->index_base];
+    assert(state != NULL);
+
+    return state;
+}
+
+
+uint64_t Device_states_get_generation(const Device_states* states)
+{
+    assert(states != NULL);
+    return states->generation;
 }
 
 
@@ -78,6 +175,11 @@ void Device_states_remove_state(Device_states* states, uint32_t id)
     const Device_state* key = DEVICE_STATE_KEY(id);
     del_Device_state(AAtree_remove(states->states, key));
 
+    if (Device_states_index_contains(states, id))
+        states->index[id - states->index_base] = NULL;
+
+    ++states->generation;
+
     return;
 }
 
@@ -187,12 +289,59 @@ void Device_states_reset(Device_states* states)
 }
 
 
+void Device_states_set_profiling_enabled(Device_states* states, bool enabled)
+{
+    assert(states != NULL);
+
+    states->profiling_enabled = enabled;
+
+    AAiter* iter = AAITER_AUTO;
+    AAiter_change_tree(iter, states->states);
+
+    Device_state* ds = AAiter_get_at_least(iter, DEVICE_STATE_KEY(0));
+
+    while (ds != NULL)
+    {
+        Device_profile_init(&ds->profile);
+
+        ds = AAiter_get_next(iter);
+    }
+
+    return;
+}
+
+
+bool Device_states_is_profiling_enabled(const Device_states* states)
+{
+    assert(states != NULL);
+    return states->profiling_enabled;
+}
+
+
+void Device_states_add_profile(
+        Device_states* states,
+        uint32_t id,
+        int64_t nanoseconds,
+        int64_t frames)
+{
+    assert(states != NULL);
+    assert(id > 0);
+    assert(states->profiling_enabled);
+
+    Device_state* ds = Device_states_get_state(states, id);
+    Device_profile_add(&ds->profile, nanoseconds, frames);
+
+    return;
+}
+
+
 void del_Device_states(Device_states* states)
 {
     if (states == NULL)
         return;
 
     del_AAtree(states->states);
+    memory_free(states->index);
     memory_free(states);
     return;
 }
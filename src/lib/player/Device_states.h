@@ -16,6 +16,9 @@
 #define K_DEVICE_STATES_H
 
 
+#include <stdbool.h>
+#include <stdint.h>
+
 #include <player/Device_state.h>
 
 typedef struct Device_states Device_states;
@@ -42,6 +45,18 @@ Device_states* new_Device_states(void);
 bool Device_states_add_state(Device_states* states, Device_state* state);
 
 
+/**
+ * Find out whether the Device state collection contains a Device state.
+ *
+ * \param states   The Device states -- must not be \c NULL.
+ * \param id       The Device ID -- must be > \c 0.
+ *
+ * \return   \c true if a Device state matching \a id exists, otherwise
+ *           \c false.
+ */
+bool Device_states_has_state(const Device_states* states, uint32_t id);
+
+
 /**
  * Get a Device state.
  *
@@ -56,6 +71,20 @@ Device_state* Device_states_get_state(
         uint32_t id);
 
 
+/**
+ * Get the generation number of the Device state collection.
+ *
+ * The generation number changes whenever a Device state is added or removed.
+ * Cached Device state pointers are valid as long as the generation number
+ * stays the same.
+ *
+ * \param states   The Device states -- must not be \c NULL.
+ *
+ * \return   The generation number.
+ */
+uint64_t Device_states_get_generation(const Device_states* states);
+
+
 /**
  * Remove a Device state in the Device state collection.
  *
@@ -109,6 +138,45 @@ void Device_states_clear_audio_buffers(
 void Device_states_reset(Device_states* states);
 
 
+/**
+ * Enable or disable profiling of Device processing.
+ *
+ * The collected profiles are cleared in either case.
+ *
+ * \param states    The Device states -- must not be \c NULL.
+ * \param enabled   \c true if profiling should be enabled, otherwise
+ *                  \c false.
+ */
+void Device_states_set_profiling_enabled(Device_states* states, bool enabled);
+
+
+/**
+ * Find out whether profiling of Device processing is enabled.
+ *
+ * \param states   The Device states -- must not be \c NULL.
+ *
+ * \return   \c true if profiling is enabled, otherwise \c false.
+ */
+bool Device_states_is_profiling_enabled(const Device_states* states);
+
+
+/**
+ * Add a processing call to the profile of a Device.
+ *
+ * \param states        The Device states -- must not be \c NULL and must have
+ *                      profiling enabled.
+ * \param id            The Device ID -- must be > \c 0 and must match an
+ *                      existing Device state.
+ * \param nanoseconds   The time spent in the call -- must be >= \c 0.
+ * \param frames        The number of frames processed -- must be >= \c 0.
+ */
+void Device_states_add_profile(
+        Device_states* states,
+        uint32_t id,
+        int64_t nanoseconds,
+        int64_t frames);
+
+
 /**
  * Destroy a Device state collection.
  *
@@ -22,12 +22,30 @@
 #include <string/common.h>
 
 
+typedef struct Event_entry
+{
+    int ch;
+    int event;
+    char name[EVENT_NAME_MAX + 1];
+    Value arg;
+} Event_entry;
+
+
 struct Event_buffer
 {
     size_t size;
-    size_t write_pos;
+    size_t reserved;
+
+    int entry_count;
+    int entries_max;
+    Event_entry* entries;
+
+    bool is_json_valid;
     char* buf;
 
+    bool are_records_valid;
+    kqt_Event_record* records;
+
     int32_t events_added;
     bool is_skipping;
     int32_t events_skipped;
@@ -37,6 +55,10 @@ struct Event_buffer
 static const char EMPTY_BUFFER[] = "[]";
 
 
+// The smallest possible space reserved for an event
+#define EVENT_LEN_MIN 18
+
+
 Event_buffer* new_Event_buffer(size_t size)
 {
     Event_buffer* ebuf = memory_alloc_item(Event_buffer);
@@ -45,16 +67,24 @@ Event_buffer* new_Event_buffer(size_t size)
 
     // Sanitise fields
     ebuf->size = max(strlen(EMPTY_BUFFER) + 1, size);
-    ebuf->write_pos = 0;
+    ebuf->reserved = 0;
+    ebuf->entry_count = 0;
+    ebuf->entries_max = (int)(ebuf->size / EVENT_LEN_MIN) + 1;
+    ebuf->entries = NULL;
+    ebuf->is_json_valid = false;
     ebuf->buf = NULL;
+    ebuf->are_records_valid = false;
+    ebuf->records = NULL;
 
     ebuf->events_added = 0;
     ebuf->is_skipping = false;
     ebuf->events_skipped = 0;
 
     // Init fields
+    ebuf->entries = memory_alloc_items(Event_entry, ebuf->entries_max);
+    ebuf->records = memory_alloc_items(kqt_Event_record, ebuf->entries_max);
     ebuf->buf = memory_calloc_items(char, ebuf->size + 1);
-    if (ebuf->buf == NULL)
+    if (ebuf->entries == NULL || ebuf->records == NULL || ebuf->buf == NULL)
     {
         del_Event_buffer(ebuf);
         return NULL;
@@ -68,7 +98,7 @@ Event_buffer* new_Event_buffer(size_t size)
 bool Event_buffer_is_empty(const Event_buffer* ebuf)
 {
     assert(ebuf != NULL);
-    return string_eq(ebuf->buf, EMPTY_BUFFER);
+    return (ebuf->entry_count == 0);
 }
 
 
@@ -76,7 +106,7 @@ bool Event_buffer_is_full(const Event_buffer* ebuf)
 {
     assert(ebuf != NULL);
     return (ebuf->size < EVENT_LEN_MAX) ||
-        (ebuf->write_pos >= ebuf->size - EVENT_LEN_MAX);
+        (ebuf->reserved >= ebuf->size - EVENT_LEN_MAX);
 }
 
 
@@ -112,59 +142,29 @@ bool Event_buffer_is_skipping(const Event_buffer* ebuf)
 }
 
 
-const char* Event_buffer_get_events(const Event_buffer* ebuf)
+static int serialise_entry(Event_entry* entry, bool is_first, char* str)
 {
-    assert(ebuf != NULL);
-    return ebuf->buf;
-}
-
-
-void Event_buffer_add(
-        Event_buffer* ebuf,
-        int ch,
-        const char* name,
-        Value* arg)
-{
-    assert(ebuf != NULL);
-    assert(!Event_buffer_is_full(ebuf));
-    assert(ch >= 0);
-    assert(ch < KQT_CHANNELS_MAX);
-    assert(name != NULL);
-    assert(arg != NULL);
-
-    // Skipping mode
-    if (ebuf->is_skipping)
-    {
-        // This event has already been processed
-        assert(ebuf->events_skipped < ebuf->events_added);
-
-        ++ebuf->events_skipped;
-        if (ebuf->events_skipped >= ebuf->events_added)
-        {
-            assert(ebuf->events_skipped == ebuf->events_added);
-            ebuf->is_skipping = false;
-        }
-
-        return;
-    }
+    assert(entry != NULL);
+    assert(str != NULL);
 
     int advance = 0;
 
     // Everything before the name
     advance += sprintf(
-            ebuf->buf + ebuf->write_pos + advance,
+            str + advance,
             "%s[%d, [",
-            ebuf->write_pos == 1 ? "" : ", ",
-            ch);
+            is_first ? "" : ", ",
+            entry->ch);
 
     // Name
+    const char* name = entry->name;
     const size_t len = strlen(name);
     assert(len > 0);
     if (name[len - 1] == '"')
     {
         // Print with properly escaped trailing double quote
         advance += sprintf(
-                ebuf->buf + ebuf->write_pos + advance,
+                str + advance,
                 "\"%.*s\\\"\", ",
                 (int)(len - 1),
                 name);
@@ -173,7 +173,7 @@ void Event_buffer_add(
     {
         // Print name as-is
         advance += sprintf(
-                ebuf->buf + ebuf->write_pos + advance,
+                str + advance,
                 "\"%s\", ",
                 name);
     }
@@ -183,22 +183,222 @@ void Event_buffer_add(
     // Value
     const int max_value_bytes = EVENT_LEN_MAX - advance - strlen(closing_str);
     advance += Value_serialise(
-            arg,
+            &entry->arg,
             max_value_bytes,
-            ebuf->buf + ebuf->write_pos + advance);
+            str + advance);
 
     // Close the event
     advance += sprintf(
-            ebuf->buf + ebuf->write_pos + advance,
+            str + advance,
             "%s",
             closing_str);
 
-    // Update the write position
-    ebuf->write_pos += advance;
-    assert(ebuf->write_pos < ebuf->size);
+    return advance;
+}
+
+
+const char* Event_buffer_get_events(Event_buffer* ebuf)
+{
+    assert(ebuf != NULL);
+
+    if (ebuf->is_json_valid)
+        return ebuf->buf;
+
+    size_t write_pos = 1;
+    for (int i = 0; i < ebuf->entry_count; ++i)
+    {
+        write_pos += serialise_entry(
+                &ebuf->entries[i], (i == 0), ebuf->buf + write_pos);
+        assert(write_pos < ebuf->size);
+    }
 
     // Close the list
-    strcpy(ebuf->buf + ebuf->write_pos, "]");
+    strcpy(ebuf->buf + write_pos, "]");
+
+    ebuf->is_json_valid = true;
+
+    return ebuf->buf;
+}
+
+
+static void Event_entry_get_record(
+        const Event_entry* entry, kqt_Event_record* record)
+{
+    assert(entry != NULL);
+    assert(record != NULL);
+
+    record->channel = entry->ch;
+    record->event = entry->event;
+
+    const Value* arg = &entry->arg;
+    switch (arg->type)
+    {
+        case VALUE_TYPE_NONE:
+        {
+            record->arg_type = KQT_EVENT_ARG_NONE;
+        }
+        break;
+
+        case VALUE_TYPE_BOOL:
+        {
+            record->arg_type = KQT_EVENT_ARG_BOOL;
+            record->arg.bool_value = arg->value.bool_type;
+        }
+        break;
+
+        case VALUE_TYPE_INT:
+        {
+            record->arg_type = KQT_EVENT_ARG_INT;
+            record->arg.int_value = arg->value.int_type;
+        }
+        break;
+
+        case VALUE_TYPE_FLOAT:
+        {
+            record->arg_type = KQT_EVENT_ARG_FLOAT;
+            record->arg.float_value = arg->value.float_type;
+        }
+        break;
+
+        case VALUE_TYPE_REAL:
+        {
+            record->arg_type = KQT_EVENT_ARG_FLOAT;
+            record->arg.float_value = Real_get_double(&arg->value.Real_type);
+        }
+        break;
+
+        case VALUE_TYPE_TSTAMP:
+        {
+            record->arg_type = KQT_EVENT_ARG_TSTAMP;
+            record->arg.tstamp_value[0] =
+                Tstamp_get_beats(&arg->value.Tstamp_type);
+            record->arg.tstamp_value[1] =
+                Tstamp_get_rem(&arg->value.Tstamp_type);
+        }
+        break;
+
+        case VALUE_TYPE_STRING:
+        {
+            record->arg_type = KQT_EVENT_ARG_STRING;
+            strcpy(record->arg.string_value, arg->value.string_type);
+        }
+        break;
+
+        case VALUE_TYPE_PAT_INST_REF:
+        {
+            record->arg_type = KQT_EVENT_ARG_PAT;
+            record->arg.pat_value[0] = arg->value.Pat_inst_ref_type.pat;
+            record->arg.pat_value[1] = arg->value.Pat_inst_ref_type.inst;
+        }
+        break;
+
+        default:
+            assert(false);
+    }
+
+    return;
+}
+
+
+const kqt_Event_record* Event_buffer_get_records(
+        Event_buffer* ebuf, int* count)
+{
+    assert(ebuf != NULL);
+    assert(count != NULL);
+
+    if (!ebuf->are_records_valid)
+    {
+        for (int i = 0; i < ebuf->entry_count; ++i)
+            Event_entry_get_record(&ebuf->entries[i], &ebuf->records[i]);
+
+        ebuf->are_records_valid = true;
+    }
+
+    *count = ebuf->entry_count;
+
+    return ebuf->records;
+}
+
+
+static size_t get_reserved_len(const char* name, const Value* arg)
+{
+    assert(name != NULL);
+    assert(arg != NULL);
+
+    // Separator, channel, brackets, quotes and an escaped quote in the name
+    size_t len = 15 + strlen(name);
+
+    switch (arg->type)
+    {
+        case VALUE_TYPE_NONE:           len += 4; break;
+        case VALUE_TYPE_BOOL:           len += 5; break;
+        case VALUE_TYPE_INT:            len += 20; break;
+        case VALUE_TYPE_FLOAT:          len += 31; break;
+        case VALUE_TYPE_TSTAMP:         len += 44; break;
+        case VALUE_TYPE_PAT_INST_REF:   len += 16; break;
+
+        case VALUE_TYPE_STRING:
+            len += strlen(arg->value.string_type) + 2;
+            break;
+
+        default:
+            len = EVENT_LEN_MAX;
+            break;
+    }
+
+    assert(len >= EVENT_LEN_MIN);
+
+    return min(len, (size_t)EVENT_LEN_MAX);
+}
+
+
+void Event_buffer_add(
+        Event_buffer* ebuf,
+        int ch,
+        int event,
+        const char* name,
+        Value* arg)
+{
+    assert(ebuf != NULL);
+    assert(!Event_buffer_is_full(ebuf));
+    assert(ch >= 0);
+    assert(ch < KQT_CHANNELS_MAX);
+    assert(event >= 0);
+    assert(name != NULL);
+    assert(strlen(name) <= EVENT_NAME_MAX);
+    assert(arg != NULL);
+
+    // Skipping mode
+    if (ebuf->is_skipping)
+    {
+        // This event has already been processed
+        assert(ebuf->events_skipped < ebuf->events_added);
+
+        ++ebuf->events_skipped;
+        if (ebuf->events_skipped >= ebuf->events_added)
+        {
+            assert(ebuf->events_skipped == ebuf->events_added);
+            ebuf->is_skipping = false;
+        }
+
+        return;
+    }
+
+    assert(ebuf->entry_count < ebuf->entries_max);
+
+    // Store the event, its serialisation is done on demand
+    Event_entry* entry = &ebuf->entries[ebuf->entry_count];
+    entry->ch = ch;
+    entry->event = event;
+    strcpy(entry->name, name);
+    Value_copy(&entry->arg, arg);
+    ++ebuf->entry_count;
+
+    ebuf->reserved += get_reserved_len(name, arg);
+    assert(ebuf->reserved < ebuf->size);
+
+    ebuf->is_json_valid = false;
+    ebuf->are_records_valid = false;
 
     ++ebuf->events_added;
 
@@ -211,7 +411,10 @@ void Event_buffer_clear(Event_buffer* ebuf)
     assert(ebuf != NULL);
 
     strcpy(ebuf->buf, EMPTY_BUFFER);
-    ebuf->write_pos = 1;
+    ebuf->is_json_valid = true;
+    ebuf->are_records_valid = true;
+    ebuf->entry_count = 0;
+    ebuf->reserved = 1;
 
     return;
 }
@@ -222,6 +425,8 @@ void del_Event_buffer(Event_buffer* ebuf)
     if (ebuf == NULL)
         return;
 
+    memory_free(ebuf->entries);
+    memory_free(ebuf->records);
     memory_free(ebuf->buf);
     memory_free(ebuf);
 
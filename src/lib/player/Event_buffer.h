@@ -19,6 +19,8 @@
 #include <stdlib.h>
 
 #include <kunquat/limits.h>
+#include <kunquat/Player.h>
+#include <player/Event_names.h>
 #include <Value.h>
 
 
@@ -101,27 +103,46 @@ bool Event_buffer_is_skipping(const Event_buffer* ebuf);
 
 
 /**
- * Get the Event buffer contents.
+ * Get the Event buffer contents in JSON format.
+ *
+ * The JSON string is created when this function is called for the first
+ * time after the contents of the Event buffer have changed.
  *
  * \param ebuf   The Event buffer -- must not be \c NULL.
  *
  * \return   The events.
  */
-const char* Event_buffer_get_events(const Event_buffer* ebuf);
+const char* Event_buffer_get_events(Event_buffer* ebuf);
+
+
+/**
+ * Get the Event buffer contents as event records.
+ *
+ * \param ebuf    The Event buffer -- must not be \c NULL.
+ * \param count   A location where the number of records is stored --
+ *                must not be \c NULL.
+ *
+ * \return   The event records.
+ */
+const kqt_Event_record* Event_buffer_get_records(
+        Event_buffer* ebuf, int* count);
 
 
 /**
  * Add an event to the Event buffer.
  *
- * \param ebuf   The Event buffer -- must not be \c NULL and must not be full.
- * \param ch     The channel number -- must be >= \c 0 and
- *               < \c KQT_CHANNELS_MAX.
- * \param name   The event name -- must not be \c NULL.
- * \param arg    The event argument -- must not be \c NULL.
+ * \param ebuf    The Event buffer -- must not be \c NULL and must not be full.
+ * \param ch      The channel number -- must be >= \c 0 and
+ *                < \c KQT_CHANNELS_MAX.
+ * \param event   The event index as returned by Event_names_get_index --
+ *                must be >= \c 0.
+ * \param name    The event name -- must not be \c NULL.
+ * \param arg     The event argument -- must not be \c NULL.
  */
 void Event_buffer_add(
         Event_buffer* ebuf,
         int ch,
+        int event,
         const char* name,
         Value* arg);
 
@@ -113,6 +113,37 @@ const Value* Event_cache_get_value(const Event_cache* cache, const char* event_n
 }
 
 
+bool Event_cache_copy(
+        Event_cache* restrict dest, const Event_cache* restrict src)
+{
+    assert(dest != NULL);
+    assert(src != NULL);
+    assert(dest != src);
+
+    AAiter* iter = AAITER_AUTO;
+    AAiter_change_tree(iter, src->cache);
+    const Event_state* src_es = AAiter_get_at_least(iter, "");
+    while (src_es != NULL)
+    {
+        Event_state* es = AAtree_get_exact(dest->cache, src_es->event_name);
+        if (es == NULL)
+        {
+            es = new_Event_state(src_es->event_name);
+            if (es == NULL || !AAtree_ins(dest->cache, es))
+            {
+                del_Event_state(es);
+                return false;
+            }
+        }
+
+        Value_copy(&es->value, &src_es->value);
+        src_es = AAiter_get_next(iter);
+    }
+
+    return true;
+}
+
+
 void Event_cache_reset(Event_cache* cache)
 {
     assert(cache != NULL);
@@ -70,6 +70,20 @@ void Event_cache_update(Event_cache* cache, const char* event_name, Value* value
 const Value* Event_cache_get_value(const Event_cache* cache, const char* event_name);
 
 
+/**
+ * Copy the contents of an Event cache.
+ *
+ * Events missing from the destination Event cache are added.
+ *
+ * \param dest   The destination Event cache -- must not be \c NULL.
+ * \param src    The source Event cache -- must not be \c NULL or \a dest.
+ *
+ * \return   \c true if successful, or \c false if memory allocation failed.
+ */
+bool Event_cache_copy(
+        Event_cache* restrict dest, const Event_cache* restrict src);
+
+
 /**
  * Reset the Event cache.
  *
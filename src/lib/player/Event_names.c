@@ -155,6 +155,18 @@ Value_type Event_names_get_param_type(
 }
 
 
+int Event_names_get_index(const Event_names* names, const char* name)
+{
+    assert(names != NULL);
+    assert(name != NULL);
+
+    const Name_info* info = AAtree_get_exact(names->names, name);
+    assert(info != NULL);
+
+    return (int)(info - event_specs);
+}
+
+
 void del_Event_names(Event_names* names)
 {
     if (names == NULL)
@@ -86,6 +86,20 @@ Value_type Event_names_get_param_type(
         const char* name);
 
 
+/**
+ * Retrieve the index of the given event name.
+ *
+ * The index matches the position of the name in the list returned by
+ * kqt_get_event_names.
+ *
+ * \param names   The Event name collection -- must not be \c NULL.
+ * \param name    The Event name -- must be a supported name.
+ *
+ * \return   The index of the name.
+ */
+int Event_names_get_index(const Event_names* names, const char* name);
+
+
 /**
  * Destroy an existing Event name collection.
  *
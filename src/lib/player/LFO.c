@@ -25,6 +25,9 @@
 #include <player/Player.h>
 
 
+#define LFO_OSCILLATOR_LENGTH_MAX 256
+
+
 static void LFO_update_time(
         LFO* lfo,
         uint32_t mix_rate,
@@ -304,6 +307,100 @@ double LFO_skip(LFO* lfo, uint64_t steps)
 }
 
 
+/**
+ * Fill a buffer with steps of an LFO that has a constant speed and depth.
+ *
+ * \return   The number of values written. This is less than \a count if the
+ *           LFO stops.
+ */
+static int32_t LFO_fill_oscillator(LFO* lfo, double* values, int32_t count)
+{
+    assert(lfo != NULL);
+    assert(lfo->update > 0);
+    assert(!Slider_in_progress(&lfo->speed_slider));
+    assert(!Slider_in_progress(&lfo->depth_slider));
+    assert(values != NULL);
+    assert(count > 0);
+
+    // sin(phase + update) = 2 * cos(update) * sin(phase) - sin(phase - update)
+    const double coeff = 2 * cos(lfo->update);
+    double prev_sin = sin(lfo->phase - lfo->update);
+    double cur_sin = sin(lfo->phase);
+
+    int32_t filled = 0;
+    while (filled < count)
+    {
+        double new_phase = lfo->phase + lfo->update;
+        if (new_phase >= (2 * PI))
+            new_phase = fmod(new_phase, 2 * PI);
+
+        if (!lfo->on && (new_phase < lfo->phase ||
+                    (new_phase >= PI && lfo->phase < PI)))
+        {
+            // Same as the final step in LFO_step
+            lfo->phase = 0;
+            lfo->update = 0;
+            Slider_break(&lfo->speed_slider);
+            Slider_break(&lfo->depth_slider);
+            values[filled] = 0;
+            ++filled;
+            break;
+        }
+
+        lfo->phase = new_phase;
+
+        const double next_sin = coeff * cur_sin - prev_sin;
+        prev_sin = cur_sin;
+        cur_sin = next_sin;
+
+        values[filled] = cur_sin * lfo->depth;
+        ++filled;
+    }
+
+    if (lfo->mode == LFO_MODE_EXP)
+    {
+        for (int32_t i = 0; i < filled; ++i)
+            values[i] = exp2(values[i]);
+    }
+
+    return filled;
+}
+
+
+void LFO_fill(LFO* lfo, double* values, int32_t count)
+{
+    assert(lfo != NULL);
+    assert(lfo->mix_rate > 0);
+    assert(isfinite(lfo->tempo));
+    assert(lfo->tempo > 0);
+    assert(values != NULL);
+    assert(count >= 0);
+
+    int32_t i = 0;
+    while (i < count && LFO_active(lfo))
+    {
+        // Slides change the oscillator on every step
+        if (Slider_in_progress(&lfo->speed_slider) ||
+                Slider_in_progress(&lfo->depth_slider))
+        {
+            values[i] = LFO_step(lfo);
+            ++i;
+            continue;
+        }
+
+        // Restart the oscillator regularly to keep rounding errors small
+        const int32_t osc_count = min(count - i, LFO_OSCILLATOR_LENGTH_MAX);
+        i += LFO_fill_oscillator(lfo, values + i, osc_count);
+    }
+
+    const double neutral = (lfo->mode == LFO_MODE_EXP) ? 1 : 0;
+    for (; i < count; ++i)
+        values[i] = neutral;
+
+    return;
+}
+
+
 static void LFO_update_time(LFO* lfo, uint32_t mix_rate, double tempo)
 {
     assert(lfo != NULL);
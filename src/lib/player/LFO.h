@@ -180,6 +180,20 @@ double LFO_step(LFO* lfo);
 double LFO_skip(LFO* lfo, uint64_t steps);
 
 
+/**
+ * Fill a buffer with the following steps of the LFO.
+ *
+ * The result matches calling \a LFO_step \a count times within rounding
+ * error. The values are generated with a recursive sine oscillator while the
+ * speed and depth of the LFO stay constant.
+ *
+ * \param lfo      The LFO -- must not be \c NULL.
+ * \param values   The destination buffer -- must not be \c NULL.
+ * \param count    The number of steps -- must be >= \c 0.
+ */
+void LFO_fill(LFO* lfo, double* values, int32_t count);
+
+
 /**
  * Find out whether the LFO is still providing non-trivial values.
  *
@@ -13,6 +13,7 @@
 
 
 #include <debug/assert.h>
+#include <kunquat/limits.h>
 #include <module/Module.h>
 #include <module/sheet/Track_list.h>
 #include <player/Master_params.h>
@@ -128,9 +129,11 @@ void Master_params_set_starting_tempo(Master_params* params)
 }
 
 
-void Master_params_reset(Master_params* params)
+void Master_params_reset(Master_params* params, int track)
 {
     assert(params != NULL);
+    assert(track >= 0);
+    assert(track < KQT_TRACKS_MAX);
 
     ++params->playback_id;
 
@@ -138,7 +141,7 @@ void Master_params_reset(Master_params* params)
 
     General_state_reset(&params->parent);
 
-    params->start_pos.track = 0; // TODO: init start_pos from argument
+    params->start_pos.track = track;
     params->cur_pos = params->start_pos;
 
     Master_params_set_starting_tempo(params);
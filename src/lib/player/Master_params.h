@@ -125,9 +125,10 @@ void Master_params_set_starting_tempo(Master_params* params);
  * Reset the Master params.
  *
  * \param params   The Master params -- must not be \c NULL.
- * \param module   The Module -- must not be \c NULL.
+ * \param track    The track to start from -- must be >= \c 0 and
+ *                 < \c KQT_TRACKS_MAX.
  */
-void Master_params_reset(Master_params* params);
+void Master_params_reset(Master_params* params, int track);
 
 
 /**
@@ -22,6 +22,7 @@
 #include <mathnum/common.h>
 #include <memory.h>
 #include <Pat_inst_ref.h>
+#include <player/Device_profile.h>
 #include <player/Player.h>
 #include <player/Player_private.h>
 #include <player/Player_seq.h>
@@ -29,6 +30,9 @@
 #include <string/common.h>
 
 
+#define SEEK_CACHE_INTERVAL_SECONDS 10
+
+
 static void Player_update_sliders_and_lfos_audio_rate(Player* player)
 {
     assert(player != NULL);
@@ -87,6 +91,20 @@ Player* new_Player(
         player->channels[i] = NULL;
     player->event_handler = NULL;
 
+    player->thread_pool = NULL;
+    for (int i = 0; i < KQT_THREADS_MAX; ++i)
+    {
+        for (int k = 0; k < 2; ++k)
+        {
+            player->thread_buffers[i][k] = NULL;
+            player->thread_targets[i][k] = NULL;
+        }
+    }
+    for (int i = 0; i <= KQT_THREADS_MAX; ++i)
+        player->thread_job_starts[i] = 0;
+    player->job_render_start = 0;
+    player->job_render_stop = 0;
+
     player->frame_remainder = 0.0;
 
     player->cgiters_accessed = false;
@@ -95,6 +113,7 @@ Player* new_Player(
 
     player->audio_frames_processed = 0;
     player->nanoseconds_history = 0;
+    player->seek_cache = NULL;
 
     player->events_returned = false;
 
@@ -210,6 +229,17 @@ bool Player_reserve_voice_state_space(Player* player, size_t size)
 }
 
 
+void Player_reset_gen_voices(Player* player, const Generator* gen)
+{
+    assert(player != NULL);
+    assert(gen != NULL);
+
+    Voice_pool_reset_gen(player->voices, gen);
+
+    return;
+}
+
+
 bool Player_alloc_channel_gen_state_keys(Player* player, Streader* sr)
 {
     assert(player != NULL);
@@ -257,24 +287,165 @@ bool Player_refresh_bind_state(Player* player)
 }
 
 
-void Player_reset(Player* player)
+static bool Player_add_device_state(Player* player, const Device* device)
 {
     assert(player != NULL);
+    assert(device != NULL);
 
-    // TODO: playback mode and start pos as arguments
+    if (Device_states_has_state(player->device_states, Device_get_id(device)))
+        return true;
 
-    Master_params_reset(&player->master_params);
+    Device_state* ds = Device_create_state(
+            device, player->audio_rate, player->audio_buffer_size);
+    if (ds == NULL || !Device_states_add_state(player->device_states, ds))
+    {
+        del_Device_state(ds);
+        return false;
+    }
 
-    Player_update_sliders_and_lfos_audio_rate(player);
-    Player_update_sliders_and_lfos_tempo(player);
+    return true;
+}
+
+
+static bool Player_add_effect_states(Player* player, const Effect* eff)
+{
+    assert(player != NULL);
+    assert(eff != NULL);
+
+    if (!Player_add_device_state(player, (const Device*)eff) ||
+            !Player_add_device_state(
+                player, Effect_get_input_interface(eff)) ||
+            !Player_add_device_state(
+                player, Effect_get_output_interface(eff)))
+        return false;
+
+    for (int i = 0; i < KQT_DSPS_MAX; ++i)
+    {
+        const DSP* dsp = Effect_get_dsp(eff, i);
+        if (dsp == NULL || !Device_has_complete_type((const Device*)dsp))
+            continue;
+
+        if (!Player_add_device_state(player, (const Device*)dsp) ||
+                !Device_sync_states((const Device*)dsp, player->device_states))
+            return false;
+    }
+
+    return true;
+}
+
+
+bool Player_prepare_shared_module(Player* player, const Player* source)
+{
+    assert(player != NULL);
+    assert(source != NULL);
+    assert(player != source);
+    assert(player->module == source->module);
+
+    const Module* module = player->module;
+
+    if (!Voice_pool_reserve_state_space(
+                player->voices, source->voices->state_size))
+        return false;
+
+    for (int i = 0; i < KQT_CHANNELS_MAX; ++i)
+    {
+        if (!Channel_gen_state_copy_keys(
+                    player->channels[i]->cgstate,
+                    source->channels[i]->cgstate))
+            return false;
+    }
+
+    if (!Player_refresh_env_state(player))
+        return false;
+
+    if (module->bind != NULL && !Player_refresh_bind_state(player))
+        return false;
+
+    // Players without audio buffers do not render audio
+    if (player->audio_buffer_size == 0)
+        return true;
+
+    // Create the Device states that are normally added during loading
+    for (int i = 0; i < KQT_INSTRUMENTS_MAX; ++i)
+    {
+        const Instrument* ins = Ins_table_get(module->insts, i);
+        if (ins == NULL)
+            continue;
+
+        if (!Player_add_device_state(player, (const Device*)ins))
+            return false;
+
+        for (int k = 0; k < KQT_GENERATORS_MAX; ++k)
+        {
+            const Generator* gen = Instrument_get_gen(ins, k);
+            if (gen == NULL || !Device_has_complete_type((const Device*)gen))
+                continue;
+
+            if (!Player_add_device_state(player, (const Device*)gen) ||
+                    !Device_sync_states(
+                        (const Device*)gen, player->device_states))
+                return false;
+        }
+
+        for (int k = 0; k < KQT_INST_EFFECTS_MAX; ++k)
+        {
+            const Effect* eff = Instrument_get_effect(ins, k);
+            if (eff != NULL && !Player_add_effect_states(player, eff))
+                return false;
+        }
+    }
+
+    for (int i = 0; i < KQT_EFFECTS_MAX; ++i)
+    {
+        const Effect* eff = Effect_table_get(module->effects, i);
+        if (eff != NULL && !Player_add_effect_states(player, eff))
+            return false;
+    }
+
+    // Set up Device resources and audio buffers
+    if (!Device_set_audio_rate(
+                (const Device*)module,
+                player->device_states,
+                player->audio_rate))
+        return false;
+
+    if (!Device_set_buffer_size(
+                (const Device*)module,
+                player->device_states,
+                player->audio_buffer_size))
+        return false;
+
+    if (module->connections != NULL &&
+            !Connections_init_buffers(
+                module->connections, player->device_states))
+        return false;
+
+    return true;
+}
+
+
+void Player_reset(Player* player, int track)
+{
+    assert(player != NULL);
+    assert(track >= -1);
+    assert(track < KQT_TRACKS_MAX);
+
+    // TODO: playback mode as an argument
+
+    Master_params_reset(&player->master_params, max(track, 0));
 
     player->frame_remainder = 0.0;
 
     for (int i = 0; i < KQT_CHANNELS_MAX; ++i)
     {
         Cgiter_reset(&player->cgiters[i], &player->master_params.cur_pos);
+        Channel_reset(player->channels[i]);
     }
 
+    // Channel_reset restores the default timing of the sliders and LFOs
+    Player_update_sliders_and_lfos_audio_rate(player);
+    Player_update_sliders_and_lfos_tempo(player);
+
     Event_buffer_clear(player->event_buffer);
 
     player->audio_frames_processed = 0;
@@ -298,6 +469,18 @@ bool Player_set_audio_rate(Player* player, int32_t rate)
     if (player->audio_rate == rate)
         return true;
 
+    // Snapshot positions depend on the audio rate
+    if (player->seek_cache != NULL)
+    {
+        Seek_cache* cache = new_Seek_cache(
+                (int64_t)rate * SEEK_CACHE_INTERVAL_SECONDS);
+        if (cache == NULL)
+            return false;
+
+        del_Seek_cache(player->seek_cache);
+        player->seek_cache = cache;
+    }
+
     // Add current playback frame count to nanoseconds history
     player->nanoseconds_history +=
         player->audio_frames_processed * 1000000000LL / player->audio_rate;
@@ -356,6 +539,17 @@ bool Player_set_audio_buffer_size(Player* player, int32_t size)
     // Set final supported buffer size
     player->audio_buffer_size = size;
 
+    // Resize scratch buffers of voice rendering threads
+    for (int i = 0; i < KQT_THREADS_MAX; ++i)
+    {
+        for (int k = 0; k < 2; ++k)
+        {
+            if (player->thread_buffers[i][k] != NULL &&
+                    !Audio_buffer_resize(player->thread_buffers[i][k], size))
+                return false;
+        }
+    }
+
     return true;
 }
 
@@ -367,16 +561,382 @@ int32_t Player_get_audio_buffer_size(const Player* player)
 }
 
 
+bool Player_set_thread_count(Player* player, int count)
+{
+    assert(player != NULL);
+    assert(count > 0);
+    assert(count <= KQT_THREADS_MAX);
+
+    if (Player_get_thread_count(player) == count)
+        return true;
+
+    // Allocate scratch buffers
+    if (count > 1)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            for (int k = 0; k < 2; ++k)
+            {
+                if (player->thread_buffers[i][k] == NULL)
+                {
+                    player->thread_buffers[i][k] = new_Audio_buffer(
+                            player->audio_buffer_size);
+                    if (player->thread_buffers[i][k] == NULL)
+                        return false;
+                }
+            }
+        }
+    }
+
+    Thread_pool* pool = NULL;
+    if (count > 1)
+    {
+        pool = new_Thread_pool(count);
+        if (pool == NULL)
+            return false;
+    }
+
+    del_Thread_pool(player->thread_pool);
+    player->thread_pool = pool;
+
+    // Remove unused scratch buffers
+    for (int i = (count > 1) ? count : 0; i < KQT_THREADS_MAX; ++i)
+    {
+        for (int k = 0; k < 2; ++k)
+        {
+            del_Audio_buffer(player->thread_buffers[i][k]);
+            player->thread_buffers[i][k] = NULL;
+        }
+    }
+
+    return true;
+}
+
+
+int Player_get_thread_count(const Player* player)
+{
+    assert(player != NULL);
+
+    if (player->thread_pool == NULL)
+        return 1;
+
+    return Thread_pool_get_thread_count(player->thread_pool);
+}
+
+
+bool Player_set_seek_cache_enabled(Player* player, bool enabled)
+{
+    assert(player != NULL);
+
+    if (!enabled)
+    {
+        del_Seek_cache(player->seek_cache);
+        player->seek_cache = NULL;
+        return true;
+    }
+
+    if (player->seek_cache != NULL)
+        return true;
+
+    player->seek_cache = new_Seek_cache(
+            (int64_t)player->audio_rate * SEEK_CACHE_INTERVAL_SECONDS);
+
+    return (player->seek_cache != NULL);
+}
+
+
+bool Player_get_seek_cache_enabled(const Player* player)
+{
+    assert(player != NULL);
+    return (player->seek_cache != NULL);
+}
+
+
+void Player_clear_seek_cache(Player* player)
+{
+    assert(player != NULL);
+
+    if (player->seek_cache != NULL)
+        Seek_cache_clear(player->seek_cache);
+
+    return;
+}
+
+
 int64_t Player_get_nanoseconds(const Player* player)
 {
     assert(player != NULL);
 
-    const int32_t ns_this_audio_rate =
+    const int64_t ns_this_audio_rate =
         player->audio_frames_processed * 1000000000LL / player->audio_rate;
     return player->nanoseconds_history + ns_this_audio_rate;
 }
 
 
+static int Voice_job_cmp(const void* v1, const void* v2)
+{
+    assert(v1 != NULL);
+    assert(v2 != NULL);
+
+    const Voice_job* job1 = v1;
+    const Voice_job* job2 = v2;
+
+    if (job1->gen_id < job2->gen_id)
+        return -1;
+    else if (job1->gen_id > job2->gen_id)
+        return 1;
+
+    if (job1->order < job2->order)
+        return -1;
+    else if (job1->order > job2->order)
+        return 1;
+
+    return 0;
+}
+
+
+static int Player_get_job_thread(const Player* player, int job_index)
+{
+    assert(player != NULL);
+    assert(player->thread_pool != NULL);
+    assert(job_index >= 0);
+
+    const int thread_count = Thread_pool_get_thread_count(player->thread_pool);
+    for (int i = 0; i < thread_count; ++i)
+    {
+        if (job_index < player->thread_job_starts[i + 1])
+            return i;
+    }
+
+    assert(false);
+    return thread_count - 1;
+}
+
+
+static void Player_render_voice_jobs_in_thread(void* data, int index)
+{
+    assert(data != NULL);
+    assert(index >= 0);
+
+    Player* player = data;
+    const int32_t render_start = player->job_render_start;
+    const int32_t render_stop = player->job_render_stop;
+    const bool profiling_enabled =
+        Device_states_is_profiling_enabled(player->device_states);
+
+    for (int i = 0; i < 2; ++i)
+    {
+        if (player->thread_targets[index][i] != NULL)
+            Audio_buffer_clear(
+                    player->thread_buffers[index][i],
+                    render_start,
+                    render_stop);
+    }
+
+    for (int i = player->thread_job_starts[index];
+            i < player->thread_job_starts[index + 1]; ++i)
+    {
+        Voice_job* job = &player->voice_jobs[i];
+        if (job->buffer_index >= 0)
+            job->voice->state->out_buffer =
+                player->thread_buffers[index][job->buffer_index];
+
+        // Profiles are shared by threads, so they are updated after mixing
+        const int64_t start_time =
+            profiling_enabled ? Device_profile_get_time() : 0;
+
+        Voice_mix(
+                job->voice,
+                player->device_states,
+                render_stop,
+                render_start,
+                player->audio_rate,
+                player->master_params.tempo);
+
+        if (profiling_enabled)
+            job->nanoseconds = max(Device_profile_get_time() - start_time, 0);
+
+        job->voice->state->out_buffer = NULL;
+    }
+
+    return;
+}
+
+
+static void Player_render_voice_jobs(
+        Player* player,
+        int job_count,
+        int32_t render_start,
+        int32_t render_stop)
+{
+    assert(player != NULL);
+    assert(player->thread_pool != NULL);
+    assert(job_count >= 0);
+    assert(render_start < render_stop);
+
+    if (job_count == 0)
+        return;
+
+    // Group the Voices by Generator, retaining the serial mixing order
+    qsort(player->voice_jobs, (size_t)job_count, sizeof(Voice_job), Voice_job_cmp);
+
+    const int thread_count = Thread_pool_get_thread_count(player->thread_pool);
+    for (int i = 0; i <= thread_count; ++i)
+        player->thread_job_starts[i] =
+            (int)((int64_t)job_count * i / thread_count);
+
+    for (int i = 0; i < thread_count; ++i)
+    {
+        player->thread_targets[i][0] = NULL;
+        player->thread_targets[i][1] = NULL;
+    }
+
+    // Redirect Generators shared by several threads to scratch buffers.
+    // Only the first and the last Generator of a thread can be shared,
+    // so each thread needs at most two scratch buffers.
+    int group_start = 0;
+    while (group_start < job_count)
+    {
+        const uint32_t gen_id = player->voice_jobs[group_start].gen_id;
+        int group_stop = group_start + 1;
+        while (group_stop < job_count &&
+                player->voice_jobs[group_stop].gen_id == gen_id)
+            ++group_stop;
+
+        Audio_buffer* target = NULL;
+        if (Player_get_job_thread(player, group_start) !=
+                Player_get_job_thread(player, group_stop - 1))
+        {
+            Device_state* gen_state = Device_states_get_state(
+                    player->device_states, gen_id);
+            target = Device_state_get_audio_buffer(
+                    gen_state, DEVICE_PORT_TYPE_SEND, 0);
+        }
+
+        for (int i = group_start; i < group_stop; ++i)
+        {
+            Voice_job* job = &player->voice_jobs[i];
+            job->buffer_index = -1;
+
+            if (target != NULL)
+            {
+                const int thread = Player_get_job_thread(player, i);
+                job->buffer_index =
+                    (group_start <= player->thread_job_starts[thread]) ? 0 : 1;
+                player->thread_targets[thread][job->buffer_index] = target;
+            }
+        }
+
+        group_start = group_stop;
+    }
+
+    player->job_render_start = render_start;
+    player->job_render_stop = render_stop;
+
+    Thread_pool_run(
+            player->thread_pool, Player_render_voice_jobs_in_thread, player);
+
+    if (Device_states_is_profiling_enabled(player->device_states))
+    {
+        for (int i = 0; i < job_count; ++i)
+            Device_states_add_profile(
+                    player->device_states,
+                    player->voice_jobs[i].gen_id,
+                    player->voice_jobs[i].nanoseconds,
+                    render_stop - render_start);
+    }
+
+    // Mix scratch buffers to Generator outputs in thread order
+    for (int i = 0; i < thread_count; ++i)
+    {
+        for (int k = 0; k < 2; ++k)
+        {
+            Audio_buffer* target = player->thread_targets[i][k];
+            if (target == NULL)
+                continue;
+
+            for (int ch = 0; ch < KQT_BUFFERS_MAX; ++ch)
+            {
+                kqt_frame* out = Audio_buffer_get_buffer(target, ch);
+                const kqt_frame* in = Audio_buffer_get_buffer(
+                        player->thread_buffers[i][k], ch);
+                for (int32_t f = render_start; f < render_stop; ++f)
+                    out[f] += in[f];
+            }
+        }
+    }
+
+    return;
+}
+
+
+static void Player_process_voices_parallel(
+        Player* player,
+        int32_t render_start,
+        int32_t render_stop)
+{
+    assert(player != NULL);
+    assert(player->thread_pool != NULL);
+    assert(render_start < render_stop);
+
+    // Foreground voices
+    int job_count = 0;
+    for (int i = 0; i < KQT_CHANNELS_MAX; ++i)
+    {
+        Channel* ch = player->channels[i];
+        for (int k = 0; k < KQT_GENERATORS_MAX; ++k)
+        {
+            if (ch->fg[k] != NULL)
+            {
+                // Verify voice ownership
+                ch->fg[k] = Voice_pool_get_voice(
+                        player->voices,
+                        ch->fg[k],
+                        ch->fg_id[k]);
+
+                if (ch->fg[k] != NULL)
+                {
+                    assert(ch->fg[k]->prio > VOICE_PRIO_INACTIVE);
+                    assert(job_count < KQT_VOICES_MAX);
+                    Voice_job* job = &player->voice_jobs[job_count];
+                    job->voice = ch->fg[k];
+                    job->gen_id = Device_get_id((const Device*)ch->fg[k]->gen);
+                    job->order = job_count;
+                    job->buffer_index = -1;
+                    ++job_count;
+                }
+            }
+        }
+    }
+
+    Player_render_voice_jobs(player, job_count, render_start, render_stop);
+
+    // Background voices
+    Voice* bg_voices[KQT_VOICES_MAX] = { NULL };
+    int bg_count = 0;
+    const uint16_t active_voices = Voice_pool_collect_bg(
+            player->voices, bg_voices, &bg_count);
+
+    job_count = 0;
+    for (int i = 0; i < bg_count; ++i)
+    {
+        Voice_job* job = &player->voice_jobs[job_count];
+        job->voice = bg_voices[i];
+        job->gen_id = Device_get_id((const Device*)bg_voices[i]->gen);
+        job->order = job_count;
+        job->buffer_index = -1;
+        ++job_count;
+    }
+
+    Player_render_voice_jobs(player, job_count, render_start, render_stop);
+
+    player->master_params.active_voices =
+        max(player->master_params.active_voices, active_voices);
+
+    return;
+}
+
+
 static void Player_process_voices(
         Player* player,
         int32_t render_start,
@@ -391,6 +951,12 @@ static void Player_process_voices(
 
     const int32_t render_stop = render_start + nframes;
 
+    if (player->thread_pool != NULL)
+    {
+        Player_process_voices_parallel(player, render_start, render_stop);
+        return;
+    }
+
     // Foreground voices
     for (int i = 0; i < KQT_CHANNELS_MAX; ++i)
     {
@@ -409,7 +975,7 @@ static void Player_process_voices(
                 {
                     // Render
                     assert(ch->fg[k]->prio > VOICE_PRIO_INACTIVE);
-                    Voice_mix(
+                    Voice_mix_profiled(
                             ch->fg[k],
                             player->device_states,
                             render_stop,
@@ -516,7 +1082,6 @@ void Player_play(Player* player, int32_t nframes)
 
     nframes = min(nframes, player->audio_buffer_size);
 
-    // TODO: separate data and playback state in connections
     Connections* connections = player->module->connections;
 
     Device_states_clear_audio_buffers(player->device_states, 0, nframes);
@@ -584,6 +1149,7 @@ void Player_play(Player* player, int32_t nframes)
             Connections_mix(
                     connections,
                     player->device_states,
+                    player->thread_pool,
                     rendered,
                     rendered + to_be_rendered,
                     player->audio_rate,
@@ -727,6 +1293,40 @@ void Player_skip(Player* player, int64_t nframes)
 }
 
 
+void Player_seek(Player* player, int64_t nframes)
+{
+    assert(player != NULL);
+    assert(player->audio_frames_processed == 0);
+    assert(nframes >= 0);
+
+    if (player->seek_cache == NULL)
+    {
+        Player_skip(player, nframes);
+        return;
+    }
+
+    int64_t pos = Seek_cache_restore(player->seek_cache, player, nframes);
+
+    // Skip the rest and store snapshots on the way
+    while (pos < nframes)
+    {
+        const int64_t next_pos = Seek_cache_get_next_pos(player->seek_cache);
+        assert(next_pos > pos);
+        const int64_t stop = min(next_pos, nframes);
+
+        Player_skip(player, stop - pos);
+        if (player->audio_frames_processed == pos)
+            break;
+
+        pos = player->audio_frames_processed;
+        if (pos == next_pos)
+            Seek_cache_store(player->seek_cache, player);
+    }
+
+    return;
+}
+
+
 int32_t Player_get_frames_available(const Player* player)
 {
     assert(player != NULL);
@@ -758,6 +1358,23 @@ const char* Player_get_events(Player* player)
 }
 
 
+const kqt_Event_record* Player_get_event_records(Player* player, int* count)
+{
+    assert(player != NULL);
+    assert(count != NULL);
+
+    if (player->events_returned)
+    {
+        // Get more events if row processing was interrupted
+        Player_update_receive(player);
+    }
+
+    player->events_returned = true;
+
+    return Event_buffer_get_records(player->event_buffer, count);
+}
+
+
 bool Player_has_stopped(const Player* player)
 {
     assert(player != NULL);
@@ -876,6 +1493,15 @@ void del_Player(Player* player)
     del_Env_state(player->estate);
     del_Device_states(player->device_states);
 
+    del_Thread_pool(player->thread_pool);
+    for (int i = 0; i < KQT_THREADS_MAX; ++i)
+    {
+        for (int k = 0; k < 2; ++k)
+            del_Audio_buffer(player->thread_buffers[i][k]);
+    }
+
+    del_Seek_cache(player->seek_cache);
+
     for (int i = 0; i < KQT_BUFFERS_MAX; ++i)
         memory_free(player->audio_buffers[i]);
 
@@ -21,6 +21,7 @@
 #include <stdlib.h>
 
 #include <kunquat/limits.h>
+#include <kunquat/Player.h>
 #include <module/Module.h>
 #include <player/Event_handler.h>
 #include <string/Streader.h>
@@ -82,6 +83,17 @@ Device_states* Player_get_device_states(const Player* player);
 bool Player_reserve_voice_state_space(Player* player, size_t size);
 
 
+/**
+ * Stop the Voices of a Generator.
+ *
+ * This must be called before the Generator is removed or its type changes.
+ *
+ * \param player   The Player -- must not be \c NULL.
+ * \param gen      The Generator -- must not be \c NULL.
+ */
+void Player_reset_gen_voices(Player* player, const Generator* gen);
+
+
 /**
  * Allocate memory for a list of Channel-specific generator variables.
  *
@@ -113,6 +125,25 @@ bool Player_refresh_env_state(Player* player);
 bool Player_refresh_bind_state(Player* player);
 
 
+/**
+ * Prepare the Player for a Module that has been loaded through another Player.
+ *
+ * This allocates the playback state that is normally created while the
+ * Module is being loaded, such as Device states and Voice state space.
+ * Device states are only created if the Player has audio buffers.
+ * The Module itself is not modified apart from rebuilding Effect
+ * connections, so the caller must make sure that no Player of the Module
+ * is running in another thread during the call.
+ *
+ * \param player   The Player -- must not be \c NULL.
+ * \param source   The Player used for loading the Module -- must not be
+ *                 \c NULL and must use the same Module as \a player.
+ *
+ * \return   \c true if successful, or \c false if memory allocation failed.
+ */
+bool Player_prepare_shared_module(Player* player, const Player* source);
+
+
 /**
  * Set audio rate.
  *
@@ -155,6 +186,64 @@ bool Player_set_audio_buffer_size(Player* player, int32_t size);
 int32_t Player_get_audio_buffer_size(const Player* player);
 
 
+/**
+ * Set the number of threads used for rendering Voices.
+ *
+ * \param player   The Player -- must not be \c NULL.
+ * \param count    The number of threads -- must be > \c 0 and
+ *                 <= \c KQT_THREADS_MAX.
+ *
+ * \return   \c true if successful, or \c false if memory allocation or
+ *           thread creation failed.
+ */
+bool Player_set_thread_count(Player* player, int count);
+
+
+/**
+ * Get the number of threads used for rendering Voices.
+ *
+ * \param player   The Player -- must not be \c NULL.
+ *
+ * \return   The number of threads.
+ */
+int Player_get_thread_count(const Player* player);
+
+
+/**
+ * Enable or disable the seek cache.
+ *
+ * The seek cache stores snapshots of the playback state during Player_seek
+ * so that subsequent seeks can start from the nearest earlier snapshot.
+ *
+ * \param player    The Player -- must not be \c NULL.
+ * \param enabled   \c true if the seek cache should be used, otherwise
+ *                  \c false.
+ *
+ * \return   \c true if successful, or \c false if memory allocation failed.
+ */
+bool Player_set_seek_cache_enabled(Player* player, bool enabled);
+
+
+/**
+ * Tell whether the seek cache is enabled.
+ *
+ * \param player   The Player -- must not be \c NULL.
+ *
+ * \return   \c true if the seek cache is enabled, otherwise \c false.
+ */
+bool Player_get_seek_cache_enabled(const Player* player);
+
+
+/**
+ * Remove all snapshots from the seek cache.
+ *
+ * This must be called whenever the composition changes.
+ *
+ * \param player   The Player -- must not be \c NULL.
+ */
+void Player_clear_seek_cache(Player* player);
+
+
 /**
  * Return the length of music rendered or skipped after the last reset.
  *
@@ -169,8 +258,10 @@ int64_t Player_get_nanoseconds(const Player* player);
  * Reset the Player state.
  *
  * \param player   The Player -- must not be \c NULL.
+ * \param track    The track to be played -- must be >= \c -1 and
+ *                 < \c KQT_TRACKS_MAX. \c -1 starts from the first track.
  */
-void Player_reset(Player* player);
+void Player_reset(Player* player, int track);
 
 
 /**
@@ -194,6 +285,17 @@ void Player_play(Player* player, int32_t nframes);
 void Player_skip(Player* player, int64_t nframes);
 
 
+/**
+ * Move to a position after a reset.
+ *
+ * This is equivalent to Player_skip, but uses the seek cache if enabled.
+ *
+ * \param player    The Player -- must not be \c NULL and must be reset.
+ * \param nframes   The position in frames -- must be >= \c 0.
+ */
+void Player_seek(Player* player, int64_t nframes);
+
+
 /**
  * Get the number of frames available in the internal audio chunk.
  *
@@ -225,6 +327,18 @@ const float* Player_get_audio(const Player* player, int channel);
 const char* Player_get_events(Player* player);
 
 
+/**
+ * Return the contents of the internal event buffer as event records.
+ *
+ * \param player   The Player -- must not be \c NULL.
+ * \param count    A location where the number of records is stored --
+ *                 must not be \c NULL.
+ *
+ * \return   The event records.
+ */
+const kqt_Event_record* Player_get_event_records(Player* player, int* count);
+
+
 /**
  * Tell whether the Player has reached the end of playback.
  *
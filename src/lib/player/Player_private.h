@@ -19,6 +19,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include <Audio_buffer.h>
 #include <module/Environment.h>
 #include <player/Cgiter.h>
 #include <player/Channel.h>
@@ -28,9 +29,25 @@
 #include <player/Event_handler.h>
 #include <player/Master_params.h>
 #include <player/Player.h>
+#include <player/Seek_cache.h>
+#include <player/Thread_pool.h>
+#include <player/Voice.h>
 #include <player/Voice_pool.h>
 
 
+/**
+ * A Voice scheduled for rendering in a worker thread.
+ */
+typedef struct Voice_job
+{
+    Voice* voice;
+    uint32_t gen_id;
+    int order;
+    int buffer_index;    ///< Scratch buffer of the thread, or \c -1 if direct.
+    int64_t nanoseconds; ///< Mixing time, set if profiling is enabled.
+} Voice_job;
+
+
 struct Player
 {
     const Module* module;
@@ -48,6 +65,15 @@ struct Player
     Channel*       channels[KQT_CHANNELS_MAX];
     Event_handler* event_handler;
 
+    // Voice rendering threads, NULL if rendering serially
+    Thread_pool*  thread_pool;
+    Audio_buffer* thread_buffers[KQT_THREADS_MAX][2];
+    Audio_buffer* thread_targets[KQT_THREADS_MAX][2];
+    int           thread_job_starts[KQT_THREADS_MAX + 1];
+    int32_t       job_render_start;
+    int32_t       job_render_stop;
+    Voice_job     voice_jobs[KQT_VOICES_MAX];
+
     double frame_remainder; // used for sub-frame time tracking
 
     bool cgiters_accessed;
@@ -56,6 +82,7 @@ struct Player
     // Position tracking
     int64_t audio_frames_processed;
     int64_t nanoseconds_history;
+    Seek_cache* seek_cache;
 
     bool events_returned;
 
@@ -141,7 +141,12 @@ void Player_process_event(
     }
 
     if (!skip)
-        Event_buffer_add(player->event_buffer, ch_num, event_name, arg);
+        Event_buffer_add(
+                player->event_buffer,
+                ch_num,
+                Event_names_get_index(event_names, event_name),
+                event_name,
+                arg);
 
     // Handle bind
     if (player->module->bind != NULL)
@@ -326,6 +331,79 @@ static void Player_process_expr_event(
 }
 
 
+static void Player_process_trigger(
+        Player* player,
+        int ch_num,
+        const Trigger* trigger,
+        bool skip)
+{
+    assert(player != NULL);
+    assert(!Event_buffer_is_full(player->event_buffer));
+    assert(ch_num >= 0);
+    assert(ch_num < KQT_CHANNELS_MAX);
+    assert(trigger != NULL);
+
+    Value* arg = VALUE_AUTO;
+
+    switch (Trigger_get_arg_type(trigger))
+    {
+        case TRIGGER_ARG_DESC:
+        {
+            Player_process_expr_event(
+                    player,
+                    ch_num,
+                    Trigger_get_desc(trigger),
+                    NULL, // no meta value
+                    skip);
+        }
+        return;
+
+        case TRIGGER_ARG_NONE:
+        {
+            arg->type = VALUE_TYPE_NONE;
+        }
+        break;
+
+        case TRIGGER_ARG_CONST:
+        {
+            Value_copy(arg, Trigger_get_const_arg(trigger));
+        }
+        break;
+
+        case TRIGGER_ARG_EXPR:
+        {
+            Streader* sr = Streader_init(STREADER_AUTO, "", 0);
+            if (Expr_evaluate(
+                        Trigger_get_expr(trigger),
+                        player->estate,
+                        NULL, // no meta value
+                        arg,
+                        player->channels[ch_num]->rand,
+                        sr) &&
+                    !Value_convert(arg, arg, Trigger_get_param_type(trigger)))
+                Streader_set_error(sr, "Type mismatch");
+
+            if (Streader_is_error_set(sr))
+            {
+                fprintf(stderr,
+                        "Couldn't parse `%s`: %s\n",
+                        Trigger_get_desc(trigger),
+                        Streader_get_error_desc(sr));
+                return;
+            }
+        }
+        break;
+
+        default:
+            assert(false);
+    }
+
+    Player_process_event(player, ch_num, Trigger_get_name(trigger), arg, skip);
+
+    return;
+}
+
+
 void Player_process_cgiters(Player* player, Tstamp* limit, bool skip)
 {
     assert(player != NULL);
@@ -448,12 +526,7 @@ void Player_process_cgiters(Player* player, Tstamp* limit, bool skip)
                             return;
                         }
 
-                        Player_process_expr_event(
-                                player,
-                                i,
-                                Trigger_get_desc(trl->trigger),
-                                NULL, // no meta value
-                                skip);
+                        Player_process_trigger(player, i, trl->trigger, skip);
 
                         // Break if started event skipping
                         if (Event_buffer_is_skipping(player->event_buffer))
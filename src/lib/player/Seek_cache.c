@@ -0,0 +1,392 @@
+
+
+/*
+ * Author: Tomi Jylhä-Ollila, Finland 2014
+ *
+ * This file is part of Kunquat.
+ *
+ * CC0 1.0 Universal, http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * To the extent possible under law, Kunquat Affirmers have waived all
+ * copyright and related or neighboring rights to Kunquat.
+ */
+
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <debug/assert.h>
+#include <kunquat/limits.h>
+#include <mathnum/common.h>
+#include <memory.h>
+#include <module/Environment.h>
+#include <module/Env_var.h>
+#include <player/Active_jumps.h>
+#include <player/Active_names.h>
+#include <player/Player_private.h>
+#include <player/Seek_cache.h>
+#include <Value.h>
+
+
+typedef struct Checkpoint
+{
+    double frame_remainder;
+    bool cgiters_accessed;
+    Cgiter cgiters[KQT_CHANNELS_MAX];
+
+    Master_params master_params;
+    General_state channel_states[KQT_CHANNELS_MAX];
+    Channel* channels[KQT_CHANNELS_MAX];
+    Active_names* names[KQT_CHANNELS_MAX + 1]; ///< The last one is global.
+
+    int jump_count;
+    Jump_context* jumps;
+
+    int env_count;
+    Value* env_values;
+} Checkpoint;
+
+
+static void del_Checkpoint(Checkpoint* cp);
+
+
+static Checkpoint* new_Checkpoint(const Player* player)
+{
+    assert(player != NULL);
+
+    Checkpoint* cp = memory_alloc_item(Checkpoint);
+    if (cp == NULL)
+        return NULL;
+
+    cp->jump_count = 0;
+    cp->jumps = NULL;
+    cp->env_count = 0;
+    cp->env_values = NULL;
+    for (int i = 0; i <= KQT_CHANNELS_MAX; ++i)
+        cp->names[i] = NULL;
+    for (int i = 0; i < KQT_CHANNELS_MAX; ++i)
+        cp->channels[i] = NULL;
+
+    // Count environment variables
+    Environment_iter* iter = Environment_iter_init(
+            ENVIRONMENT_ITER_AUTO, player->module->env);
+    while (Environment_iter_get_next_name(iter) != NULL)
+        ++cp->env_count;
+
+    cp->jump_count = Active_jumps_get_count(
+            player->master_params.active_jumps);
+
+    if (cp->jump_count > 0)
+    {
+        cp->jumps = memory_alloc_items(Jump_context, cp->jump_count);
+        if (cp->jumps == NULL)
+        {
+            del_Checkpoint(cp);
+            return NULL;
+        }
+    }
+
+    if (cp->env_count > 0)
+    {
+        cp->env_values = memory_alloc_items(Value, cp->env_count);
+        if (cp->env_values == NULL)
+        {
+            del_Checkpoint(cp);
+            return NULL;
+        }
+    }
+
+    for (int i = 0; i <= KQT_CHANNELS_MAX; ++i)
+    {
+        cp->names[i] = new_Active_names();
+        if (cp->names[i] == NULL)
+        {
+            del_Checkpoint(cp);
+            return NULL;
+        }
+    }
+
+    for (int i = 0; i < KQT_CHANNELS_MAX; ++i)
+    {
+        const Channel* ch = player->channels[i];
+        cp->channels[i] = new_Channel(
+                player->module,
+                i,
+                ch->insts,
+                player->estate,
+                ch->pool,
+                ch->tempo,
+                ch->freq);
+        if (cp->channels[i] == NULL ||
+                !Channel_copy_state(cp->channels[i], ch))
+        {
+            del_Checkpoint(cp);
+            return NULL;
+        }
+    }
+
+    // Store the playback state
+    cp->frame_remainder = player->frame_remainder;
+    cp->cgiters_accessed = player->cgiters_accessed;
+    for (int i = 0; i < KQT_CHANNELS_MAX; ++i)
+        cp->cgiters[i] = player->cgiters[i];
+
+    cp->master_params = player->master_params;
+    for (int i = 0; i < KQT_CHANNELS_MAX; ++i)
+    {
+        const General_state* gstate = &player->channels[i]->parent;
+        cp->channel_states[i] = *gstate;
+        Active_names_copy(cp->names[i], gstate->active_names);
+    }
+    Active_names_copy(
+            cp->names[KQT_CHANNELS_MAX],
+            player->master_params.parent.active_names);
+
+    if (cp->jump_count > 0)
+        Active_jumps_get_contexts(
+                player->master_params.active_jumps, cp->jumps);
+
+    iter = Environment_iter_init(ENVIRONMENT_ITER_AUTO, player->module->env);
+    for (int i = 0; i < cp->env_count; ++i)
+    {
+        const char* name = Environment_iter_get_next_name(iter);
+        assert(name != NULL);
+        const Env_var* var = Env_state_get_var(player->estate, name);
+        if (var != NULL)
+            Value_copy(&cp->env_values[i], Env_var_get_value(var));
+        else
+            cp->env_values[i] = *VALUE_AUTO;
+    }
+
+    return cp;
+}
+
+
+static void General_state_restore(
+        General_state* gstate,
+        const General_state* saved,
+        const Active_names* names)
+{
+    assert(gstate != NULL);
+    assert(saved != NULL);
+    assert(names != NULL);
+
+    gstate->pause = saved->pause;
+    gstate->cond_level_index = saved->cond_level_index;
+    gstate->last_cond_match = saved->last_cond_match;
+    for (int i = 0; i < COND_LEVELS_MAX; ++i)
+        gstate->cond_levels[i] = saved->cond_levels[i];
+
+    Active_names_copy(gstate->active_names, names);
+
+    return;
+}
+
+
+static bool Checkpoint_restore(const Checkpoint* cp, Player* player)
+{
+    assert(cp != NULL);
+    assert(player != NULL);
+
+    player->frame_remainder = cp->frame_remainder;
+    player->cgiters_accessed = cp->cgiters_accessed;
+    for (int i = 0; i < KQT_CHANNELS_MAX; ++i)
+        player->cgiters[i] = cp->cgiters[i];
+
+    // Restore Master params without replacing the resources it owns
+    Master_params* params = &player->master_params;
+    Active_jumps_reset(params->active_jumps, params->jump_cache);
+
+    const uint32_t playback_id = params->playback_id;
+    const General_state parent = params->parent;
+    Active_jumps* active_jumps = params->active_jumps;
+    Jump_cache* jump_cache = params->jump_cache;
+
+    *params = cp->master_params;
+    params->parent = parent;
+    params->playback_id = playback_id;
+    params->active_jumps = active_jumps;
+    params->jump_cache = jump_cache;
+
+    General_state_restore(
+            &params->parent,
+            &cp->master_params.parent,
+            cp->names[KQT_CHANNELS_MAX]);
+
+    for (int i = 0; i < cp->jump_count; ++i)
+    {
+        AAnode* handle = Jump_cache_acquire_context(params->jump_cache);
+        if (handle == NULL)
+            return false;
+
+        Jump_context* jc = AAnode_get_data(handle);
+        *jc = cp->jumps[i];
+        Active_jumps_add_context(params->active_jumps, handle);
+    }
+
+    for (int i = 0; i < KQT_CHANNELS_MAX; ++i)
+    {
+        General_state_restore(
+                &player->channels[i]->parent,
+                &cp->channel_states[i],
+                cp->names[i]);
+
+        if (!Channel_copy_state(player->channels[i], cp->channels[i]))
+            return false;
+    }
+
+    Environment_iter* iter = Environment_iter_init(
+            ENVIRONMENT_ITER_AUTO, player->module->env);
+    for (int i = 0; i < cp->env_count; ++i)
+    {
+        const char* name = Environment_iter_get_next_name(iter);
+        if (name == NULL)
+            return false;
+
+        Env_var* var = Env_state_get_var(player->estate, name);
+        if (var != NULL && cp->env_values[i].type != VALUE_TYPE_NONE)
+            Env_var_set_value(var, &cp->env_values[i]);
+    }
+
+    return true;
+}
+
+
+static void del_Checkpoint(Checkpoint* cp)
+{
+    if (cp == NULL)
+        return;
+
+    for (int i = 0; i <= KQT_CHANNELS_MAX; ++i)
+        del_Active_names(cp->names[i]);
+    for (int i = 0; i < KQT_CHANNELS_MAX; ++i)
+        del_Channel(cp->channels[i]);
+    memory_free(cp->env_values);
+    memory_free(cp->jumps);
+    memory_free(cp);
+
+    return;
+}
+
+
+struct Seek_cache
+{
+    int64_t interval;
+    int count;
+    int capacity;
+    Checkpoint** checkpoints;
+};
+
+
+Seek_cache* new_Seek_cache(int64_t interval)
+{
+    assert(interval > 0);
+
+    Seek_cache* cache = memory_alloc_item(Seek_cache);
+    if (cache == NULL)
+        return NULL;
+
+    cache->interval = interval;
+    cache->count = 0;
+    cache->capacity = 0;
+    cache->checkpoints = NULL;
+
+    return cache;
+}
+
+
+int64_t Seek_cache_get_interval(const Seek_cache* cache)
+{
+    assert(cache != NULL);
+    return cache->interval;
+}
+
+
+int64_t Seek_cache_get_next_pos(const Seek_cache* cache)
+{
+    assert(cache != NULL);
+    return (cache->count + 1) * cache->interval;
+}
+
+
+bool Seek_cache_store(Seek_cache* cache, const Player* player)
+{
+    assert(cache != NULL);
+    assert(player != NULL);
+    assert(player->audio_frames_processed == Seek_cache_get_next_pos(cache));
+
+    if (cache->count >= cache->capacity)
+    {
+        const int new_capacity = (cache->capacity > 0) ?
+            cache->capacity * 2 : 16;
+        Checkpoint** new_checkpoints = memory_realloc_items(
+                Checkpoint*, new_capacity, cache->checkpoints);
+        if (new_checkpoints == NULL)
+            return false;
+
+        cache->checkpoints = new_checkpoints;
+        cache->capacity = new_capacity;
+    }
+
+    Checkpoint* cp = new_Checkpoint(player);
+    if (cp == NULL)
+        return false;
+
+    cache->checkpoints[cache->count] = cp;
+    ++cache->count;
+
+    return true;
+}
+
+
+int64_t Seek_cache_restore(Seek_cache* cache, Player* player, int64_t pos)
+{
+    assert(cache != NULL);
+    assert(player != NULL);
+    assert(player->audio_frames_processed == 0);
+    assert(pos >= 0);
+
+    const int64_t index = min(pos / cache->interval, cache->count) - 1;
+    if (index < 0)
+        return 0;
+
+    if (!Checkpoint_restore(cache->checkpoints[index], player))
+    {
+        // Should not happen, but start over if it does
+        Player_reset(player, player->master_params.start_pos.track);
+        return 0;
+    }
+
+    const int64_t cp_pos = (index + 1) * cache->interval;
+    player->audio_frames_processed = cp_pos;
+
+    return cp_pos;
+}
+
+
+void Seek_cache_clear(Seek_cache* cache)
+{
+    assert(cache != NULL);
+
+    for (int i = 0; i < cache->count; ++i)
+        del_Checkpoint(cache->checkpoints[i]);
+    cache->count = 0;
+
+    return;
+}
+
+
+void del_Seek_cache(Seek_cache* cache)
+{
+    if (cache == NULL)
+        return;
+
+    Seek_cache_clear(cache);
+    memory_free(cache->checkpoints);
+    memory_free(cache);
+
+    return;
+}
+
+
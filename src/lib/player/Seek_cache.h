@@ -0,0 +1,114 @@
+
+
+/*
+ * Author: Tomi Jylhä-Ollila, Finland 2014
+ *
+ * This file is part of Kunquat.
+ *
+ * CC0 1.0 Universal, http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * To the extent possible under law, Kunquat Affirmers have waived all
+ * copyright and related or neighboring rights to Kunquat.
+ */
+
+
+#ifndef K_SEEK_CACHE_H
+#define K_SEEK_CACHE_H
+
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <player/Player.h>
+
+
+/**
+ * Seek cache stores snapshots of the Player playback state at regular
+ * intervals so that seeking does not need to skip from the beginning.
+ *
+ * A snapshot contains the state that is modified while skipping, i.e. the
+ * Master params, the General and playback states of the Channels including
+ * their random sources, the Environment state, the jump state and the column
+ * iterators. The Seek cache
+ * must be cleared whenever the composition or the audio rate changes.
+ */
+typedef struct Seek_cache Seek_cache;
+
+
+/**
+ * Create a new Seek cache.
+ *
+ * \param interval   The distance between snapshots in frames -- must be
+ *                   > \c 0.
+ *
+ * \return   The new Seek cache if successful, or \c NULL if memory
+ *           allocation failed.
+ */
+Seek_cache* new_Seek_cache(int64_t interval);
+
+
+/**
+ * Get the distance between snapshots.
+ *
+ * \param cache   The Seek cache -- must not be \c NULL.
+ *
+ * \return   The interval in frames.
+ */
+int64_t Seek_cache_get_interval(const Seek_cache* cache);
+
+
+/**
+ * Get the position of the next snapshot to be stored.
+ *
+ * \param cache   The Seek cache -- must not be \c NULL.
+ *
+ * \return   The position in frames.
+ */
+int64_t Seek_cache_get_next_pos(const Seek_cache* cache);
+
+
+/**
+ * Store a snapshot of the Player.
+ *
+ * \param cache    The Seek cache -- must not be \c NULL.
+ * \param player   The Player -- must not be \c NULL and must be located at
+ *                 the position returned by Seek_cache_get_next_pos.
+ *
+ * \return   \c true if successful, or \c false if memory allocation failed.
+ *           The Seek cache remains valid in both cases.
+ */
+bool Seek_cache_store(Seek_cache* cache, const Player* player);
+
+
+/**
+ * Restore the Player from the latest snapshot before a given position.
+ *
+ * \param cache    The Seek cache -- must not be \c NULL.
+ * \param player   The Player -- must not be \c NULL and must be reset.
+ * \param pos      The target position in frames -- must be >= \c 0.
+ *
+ * \return   The position of the restored snapshot in frames, or \c 0 if
+ *           no snapshot was restored.
+ */
+int64_t Seek_cache_restore(Seek_cache* cache, Player* player, int64_t pos);
+
+
+/**
+ * Remove all snapshots from the Seek cache.
+ *
+ * \param cache   The Seek cache -- must not be \c NULL.
+ */
+void Seek_cache_clear(Seek_cache* cache);
+
+
+/**
+ * Destroy an existing Seek cache.
+ *
+ * \param cache   The Seek cache, or \c NULL.
+ */
+void del_Seek_cache(Seek_cache* cache);
+
+
+#endif // K_SEEK_CACHE_H
+
+
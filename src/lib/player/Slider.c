@@ -19,6 +19,7 @@
 #include <math.h>
 
 #include <debug/assert.h>
+#include <mathnum/common.h>
 #include <player/Player.h>
 #include <player/Slider.h>
 
@@ -186,6 +187,86 @@ double Slider_skip(Slider* slider, uint64_t steps)
 }
 
 
+void Slider_fill(Slider* slider, double* values, int32_t count)
+{
+    assert(slider != NULL);
+    assert(values != NULL);
+    assert(count >= 0);
+
+    int32_t i = 0;
+
+    if (slider->dir != 0 && count > 0)
+    {
+        // Every slide takes at least one step, see Slider_step
+        int32_t slide_count = count;
+        if (slider->steps_left < count)
+            slide_count = max(1, (int32_t)ceil(slider->steps_left));
+
+        const double start = slider->current_value;
+        if (slider->mode == SLIDE_MODE_EXP)
+        {
+            double value = start;
+            for (; i < slide_count; ++i)
+            {
+                value *= slider->update;
+                values[i] = value;
+            }
+        }
+        else
+        {
+            assert(slider->mode == SLIDE_MODE_LINEAR);
+            for (; i < slide_count; ++i)
+                values[i] = start + slider->update * (i + 1);
+        }
+
+        slider->steps_left -= slide_count;
+        bool finished = (slider->steps_left <= 0);
+
+        // Stop at the target value if we overshoot
+        const double target = slider->target_value;
+        if (slider->dir == 1)
+        {
+            for (int32_t k = 0; k < slide_count; ++k)
+            {
+                if (values[k] > target)
+                {
+                    values[k] = target;
+                    finished = true;
+                }
+            }
+        }
+        else
+        {
+            assert(slider->dir == -1);
+            for (int32_t k = 0; k < slide_count; ++k)
+            {
+                if (values[k] < target)
+                {
+                    values[k] = target;
+                    finished = true;
+                }
+            }
+        }
+
+        if (finished)
+        {
+            values[slide_count - 1] = target;
+            slider->current_value = target;
+            slider->dir = 0;
+        }
+        else
+        {
+            slider->current_value = values[slide_count - 1];
+        }
+    }
+
+    for (; i < count; ++i)
+        values[i] = slider->target_value;
+
+    return;
+}
+
+
 void Slider_break(Slider* slider)
 {
     assert(slider != NULL);
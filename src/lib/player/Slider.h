@@ -100,6 +100,19 @@ double Slider_step(Slider* slider);
 double Slider_skip(Slider* slider, uint64_t steps);
 
 
+/**
+ * Fill a buffer with the following steps of the Slider.
+ *
+ * The result is the same as calling \a Slider_step \a count times, except
+ * that linear slides are calculated in closed form.
+ *
+ * \param slider   The Slider -- must not be \c NULL.
+ * \param values   The destination buffer -- must not be \c NULL.
+ * \param count    The number of steps -- must be >= \c 0.
+ */
+void Slider_fill(Slider* slider, double* values, int32_t count);
+
+
 /**
  * Explicitly break a slide in the Slider.
  *
@@ -0,0 +1,204 @@
+
+
+/*
+ * Author: Tomi Jylhä-Ollila, Finland 2014
+ *
+ * This file is part of Kunquat.
+ *
+ * CC0 1.0 Universal, http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * To the extent possible under law, Kunquat Affirmers have waived all
+ * copyright and related or neighboring rights to Kunquat.
+ */
+
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <debug/assert.h>
+#include <kunquat/limits.h>
+#include <memory.h>
+#include <player/Thread_pool.h>
+
+
+typedef struct Worker
+{
+    Thread_pool* pool;
+    int index;
+    pthread_t thread;
+} Worker;
+
+
+struct Thread_pool
+{
+    int thread_count;
+    int workers_started;
+    Worker workers[KQT_THREADS_MAX];
+
+    pthread_mutex_t lock;
+    pthread_cond_t start_cond;
+    pthread_cond_t done_cond;
+
+    uint64_t generation;
+    int pending;
+    bool quit;
+
+    Thread_pool_task* task;
+    void* data;
+};
+
+
+static void* Worker_main(void* arg)
+{
+    assert(arg != NULL);
+
+    Worker* worker = arg;
+    Thread_pool* pool = worker->pool;
+
+    // Generation 0 is never run, so we cannot miss the first task
+    uint64_t seen_generation = 0;
+
+    pthread_mutex_lock(&pool->lock);
+
+    while (true)
+    {
+        while (pool->generation == seen_generation && !pool->quit)
+            pthread_cond_wait(&pool->start_cond, &pool->lock);
+
+        if (pool->quit)
+            break;
+
+        seen_generation = pool->generation;
+        Thread_pool_task* task = pool->task;
+        void* data = pool->data;
+        pthread_mutex_unlock(&pool->lock);
+
+        task(data, worker->index);
+
+        pthread_mutex_lock(&pool->lock);
+        --pool->pending;
+        if (pool->pending == 0)
+            pthread_cond_signal(&pool->done_cond);
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+}
+
+
+Thread_pool* new_Thread_pool(int thread_count)
+{
+    assert(thread_count > 0);
+    assert(thread_count <= KQT_THREADS_MAX);
+
+    Thread_pool* pool = memory_alloc_item(Thread_pool);
+    if (pool == NULL)
+        return NULL;
+
+    pool->thread_count = thread_count;
+    pool->workers_started = 0;
+    pool->generation = 0;
+    pool->pending = 0;
+    pool->quit = false;
+    pool->task = NULL;
+    pool->data = NULL;
+
+    if (pthread_mutex_init(&pool->lock, NULL) != 0)
+    {
+        memory_free(pool);
+        return NULL;
+    }
+    if (pthread_cond_init(&pool->start_cond, NULL) != 0)
+    {
+        pthread_mutex_destroy(&pool->lock);
+        memory_free(pool);
+        return NULL;
+    }
+    if (pthread_cond_init(&pool->done_cond, NULL) != 0)
+    {
+        pthread_cond_destroy(&pool->start_cond);
+        pthread_mutex_destroy(&pool->lock);
+        memory_free(pool);
+        return NULL;
+    }
+
+    // The calling thread is used as thread 0
+    for (int i = 1; i < thread_count; ++i)
+    {
+        Worker* worker = &pool->workers[i];
+        worker->pool = pool;
+        worker->index = i;
+        if (pthread_create(&worker->thread, NULL, Worker_main, worker) != 0)
+        {
+            del_Thread_pool(pool);
+            return NULL;
+        }
+        ++pool->workers_started;
+    }
+
+    return pool;
+}
+
+
+int Thread_pool_get_thread_count(const Thread_pool* pool)
+{
+    assert(pool != NULL);
+    return pool->thread_count;
+}
+
+
+void Thread_pool_run(Thread_pool* pool, Thread_pool_task* task, void* data)
+{
+    assert(pool != NULL);
+    assert(task != NULL);
+
+    if (pool->thread_count == 1)
+    {
+        task(data, 0);
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->task = task;
+    pool->data = data;
+    pool->pending = pool->thread_count - 1;
+    ++pool->generation;
+    pthread_cond_broadcast(&pool->start_cond);
+    pthread_mutex_unlock(&pool->lock);
+
+    task(data, 0);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->pending > 0)
+        pthread_cond_wait(&pool->done_cond, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+
+    return;
+}
+
+
+void del_Thread_pool(Thread_pool* pool)
+{
+    if (pool == NULL)
+        return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->quit = true;
+    pthread_cond_broadcast(&pool->start_cond);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 1; i <= pool->workers_started; ++i)
+        pthread_join(pool->workers[i].thread, NULL);
+
+    pthread_cond_destroy(&pool->done_cond);
+    pthread_cond_destroy(&pool->start_cond);
+    pthread_mutex_destroy(&pool->lock);
+    memory_free(pool);
+
+    return;
+}
+
+
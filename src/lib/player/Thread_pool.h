@@ -0,0 +1,85 @@
+
+
+/*
+ * Author: Tomi Jylhä-Ollila, Finland 2014
+ *
+ * This file is part of Kunquat.
+ *
+ * CC0 1.0 Universal, http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * To the extent possible under law, Kunquat Affirmers have waived all
+ * copyright and related or neighboring rights to Kunquat.
+ */
+
+
+#ifndef K_THREAD_POOL_H
+#define K_THREAD_POOL_H
+
+
+#include <stdbool.h>
+
+
+/**
+ * Thread pool runs a task simultaneously in a fixed number of threads.
+ *
+ * The calling thread always participates as the thread with index \c 0,
+ * so a Thread pool with one thread does not create any worker threads.
+ */
+typedef struct Thread_pool Thread_pool;
+
+
+/**
+ * A task run by the Thread pool.
+ *
+ * \param data    The user data passed to Thread_pool_run.
+ * \param index   The index of the running thread -- >= \c 0 and < the number
+ *                of threads in the Thread pool.
+ */
+typedef void Thread_pool_task(void* data, int index);
+
+
+/**
+ * Create a new Thread pool.
+ *
+ * \param thread_count   The number of threads -- must be > \c 0 and
+ *                       <= \c KQT_THREADS_MAX.
+ *
+ * \return   The new Thread pool if successful, or \c NULL if memory
+ *           allocation or thread creation failed.
+ */
+Thread_pool* new_Thread_pool(int thread_count);
+
+
+/**
+ * Get the number of threads in the Thread pool.
+ *
+ * \param pool   The Thread pool -- must not be \c NULL.
+ *
+ * \return   The number of threads, including the calling thread.
+ */
+int Thread_pool_get_thread_count(const Thread_pool* pool);
+
+
+/**
+ * Run a task in all threads of the Thread pool.
+ *
+ * This function returns after the task has finished in every thread.
+ *
+ * \param pool   The Thread pool -- must not be \c NULL.
+ * \param task   The task -- must not be \c NULL.
+ * \param data   The user data passed to \a task.
+ */
+void Thread_pool_run(Thread_pool* pool, Thread_pool_task* task, void* data);
+
+
+/**
+ * Destroy an existing Thread pool.
+ *
+ * \param pool   The Thread pool, or \c NULL.
+ */
+void del_Thread_pool(Thread_pool* pool);
+
+
+#endif // K_THREAD_POOL_H
+
+
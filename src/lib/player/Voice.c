@@ -16,34 +16,50 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <inttypes.h>
+#include <string.h>
 
 #include <debug/assert.h>
 #include <mathnum/common.h>
 #include <memory.h>
+#include <player/Device_profile.h>
+#include <player/Device_states.h>
 #include <player/Voice.h>
 #include <player/Voice_state.h>
 
 
-Voice* new_Voice(void)
+/**
+ * Release the resources held by the Generator of an initialised Voice.
+ */
+static void Voice_clear_gen_state(Voice* voice)
 {
-    Voice* voice = memory_alloc_item(Voice);
-    if (voice == NULL)
-        return NULL;
+    assert(voice != NULL);
+
+    if (voice->gen != NULL && voice->gen->clear_vstate != NULL)
+        voice->gen->clear_vstate(voice->gen, voice->state);
+
+    voice->gen = NULL;
+
+    return;
+}
+
+
+Voice* Voice_preinit(Voice* voice, Voice_state* state, size_t state_size)
+{
+    assert(voice != NULL);
+    assert(state != NULL);
+    assert(state_size >= sizeof(Voice_state));
 
     voice->id = 0;
     voice->prio = VOICE_PRIO_INACTIVE;
     voice->gen = NULL;
-    voice->state_size = 0;
-    voice->state = NULL;
+    voice->state_size = state_size;
+    voice->state = state;
 
-    voice->state_size = sizeof(Voice_state);
-    voice->state = memory_alloc_item(Voice_state);
     voice->rand_p = new_Random();
     voice->rand_s = new_Random();
-    if (voice->state == NULL || voice->rand_p == NULL ||
-            voice->rand_s == NULL)
+    if (voice->rand_p == NULL || voice->rand_s == NULL)
     {
-        del_Voice(voice);
+        Voice_deinit(voice);
         return NULL;
     }
 
@@ -55,21 +71,18 @@ Voice* new_Voice(void)
 }
 
 
-bool Voice_reserve_state_space(Voice* voice, size_t state_size)
+void Voice_move_state(Voice* voice, Voice_state* state, size_t state_size)
 {
     assert(voice != NULL);
+    assert(voice->state != NULL);
+    assert(state != NULL);
+    assert(state_size >= voice->state_size);
 
-    if (state_size <= voice->state_size)
-        return true;
-
-    Voice_state* new_state = memory_realloc_items(char, state_size, voice->state);
-    if (new_state == NULL)
-        return false;
-
+    memcpy(state, voice->state, voice->state_size);
     voice->state_size = state_size;
-    voice->state = new_state;
+    voice->state = state;
 
-    return true;
+    return;
 }
 
 
@@ -105,6 +118,9 @@ void Voice_init(
     assert(freq > 0);
     assert(tempo > 0);
 
+    // A Voice taken from another note has not been reset
+    Voice_clear_gen_state(voice);
+
     voice->prio = VOICE_PRIO_NEW;
     voice->gen = gen;
     Random_set_seed(voice->rand_p, seed);
@@ -131,8 +147,8 @@ void Voice_reset(Voice* voice)
 
     voice->id = 0;
     voice->prio = VOICE_PRIO_INACTIVE;
+    Voice_clear_gen_state(voice);
     Voice_state_clear(voice->state);
-    voice->gen = NULL;
     Random_reset(voice->rand_p);
     Random_reset(voice->rand_s);
 
@@ -176,6 +192,43 @@ void Voice_mix(
 }
 
 
+void Voice_mix_profiled(
+        Voice* voice,
+        Device_states* states,
+        uint32_t amount,
+        uint32_t offset,
+        uint32_t freq,
+        double tempo)
+{
+    assert(voice != NULL);
+    assert(voice->gen != NULL);
+    assert(states != NULL);
+    assert(freq > 0);
+
+    if (!Device_states_is_profiling_enabled(states) ||
+            voice->prio == VOICE_PRIO_INACTIVE)
+    {
+        Voice_mix(voice, states, amount, offset, freq, tempo);
+        return;
+    }
+
+    // Voice_mix may reset the Voice, so get the Generator ID in advance
+    const uint32_t gen_id = Device_get_id((const Device*)voice->gen);
+
+    const int64_t start_time = Device_profile_get_time();
+    Voice_mix(voice, states, amount, offset, freq, tempo);
+    const int64_t elapsed = Device_profile_get_time() - start_time;
+
+    Device_states_add_profile(
+            states,
+            gen_id,
+            max(elapsed, 0),
+            (amount > offset) ? (int64_t)(amount - offset) : 0);
+
+    return;
+}
+
+
 double Voice_get_actual_force(const Voice* voice)
 {
     assert(voice != NULL);
@@ -187,15 +240,17 @@ double Voice_get_actual_force(const Voice* voice)
 }
 
 
-void del_Voice(Voice* voice)
+void Voice_deinit(Voice* voice)
 {
     if (voice == NULL)
         return;
 
+    Voice_clear_gen_state(voice);
+
     del_Random(voice->rand_p);
     del_Random(voice->rand_s);
-    memory_free(voice->state);
-    memory_free(voice);
+    voice->rand_p = NULL;
+    voice->rand_s = NULL;
 
     return;
 }
@@ -52,25 +52,30 @@ typedef struct Voice
 
 
 /**
- * Create a new Voice.
+ * Initialise a Voice in storage provided by the caller.
  *
- * \param state_size   The amount of bytes to reserve for Voice states.
+ * \param voice        The Voice -- must not be \c NULL.
+ * \param state        The storage of the Voice state -- must not be \c NULL.
+ * \param state_size   The size of \a state in bytes -- must be at least the
+ *                     size of a Voice state.
  *
- * \return   The new Voice if successful, or \c NULL if memory allocation
- *           failed.
+ * \return   The parameter \a voice, or \c NULL if memory allocation failed.
  */
-Voice* new_Voice(void);
+Voice* Voice_preinit(Voice* voice, Voice_state* state, size_t state_size);
 
 
 /**
- * Reserve space for the Voice state.
+ * Move the Voice state to new storage.
  *
- * \param voice        The Voice -- must not be \c NULL.
- * \param state_size   The amount of bytes to reserve for the Voice state.
+ * The contents of the current Voice state are copied to \a state.
  *
- * \return   \c true if successful, or \c false if memory allocation failed.
+ * \param voice        The Voice -- must not be \c NULL.
+ * \param state        The new storage of the Voice state -- must not be
+ *                     \c NULL.
+ * \param state_size   The size of \a state in bytes -- must be at least the
+ *                     current state size of \a voice.
  */
-bool Voice_reserve_state_space(Voice* voice, size_t state_size);
+void Voice_move_state(Voice* voice, Voice_state* state, size_t state_size);
 
 
 /**
@@ -156,6 +161,28 @@ void Voice_mix(
         double tempo);
 
 
+/**
+ * Mix the Voice and add the time spent to the profile of its Generator.
+ *
+ * The Voice is mixed without profiling if profiling is disabled in \a states.
+ * Only one thread may mix Voices of the same Generator at a time.
+ *
+ * \param voice    The Voice -- must not be \c NULL.
+ * \param states   The Device states -- must not be \c NULL.
+ * \param amount   The number of frames to be mixed.
+ * \param offset   The buffer offset.
+ * \param freq     The mixing frequency -- must be > \c 0.
+ * \param tempo    The current tempo -- must be > \c 0.
+ */
+void Voice_mix_profiled(
+        Voice* voice,
+        Device_states* states,
+        uint32_t amount,
+        uint32_t offset,
+        uint32_t freq,
+        double tempo);
+
+
 /**
  * Return the actual current force of the Voice.
  *
@@ -167,11 +194,13 @@ double Voice_get_actual_force(const Voice* voice);
 
 
 /**
- * Destroy an existing Voice.
+ * Deinitialise a Voice initialised with \a Voice_preinit.
+ *
+ * The storage of the Voice state is not released.
  *
  * \param voice   The Voice, or \c NULL.
  */
-void del_Voice(Voice* voice);
+void Voice_deinit(Voice* voice);
 
 
 #endif // K_VOICE_H
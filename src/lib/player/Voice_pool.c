@@ -15,127 +15,322 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
 
 #include <debug/assert.h>
+#include <mathnum/common.h>
 #include <memory.h>
 #include <player/Voice_pool.h>
 
 
-Voice_pool* new_Voice_pool(uint16_t size)
+#define VOICE_POOL_ALIGNMENT 64
+
+
+/**
+ * Rebuild the free and active lists from the priorities of the Voices.
+ */
+static void Voice_pool_rebuild_lists(Voice_pool* pool)
 {
-    //assert(size >= 0);
+    assert(pool != NULL);
 
-    Voice_pool* pool = memory_alloc_item(Voice_pool);
-    if (pool == NULL)
-        return NULL;
+    pool->free_count = 0;
+    pool->active_count = 0;
 
-    pool->size = size;
-    pool->state_size = 0;
-    pool->voices = NULL;
+    // Put the first Voices at the end of the free list so that they are used
+    // first
+    for (int i = pool->size - 1; i >= 0; --i)
+    {
+        Voice* voice = pool->voices[i];
+        if (voice->prio == VOICE_PRIO_INACTIVE)
+        {
+            pool->free_voices[pool->free_count] = voice;
+            ++pool->free_count;
+        }
+    }
 
-    if (size > 0)
+    for (uint16_t i = 0; i < pool->size; ++i)
     {
-        pool->voices = memory_alloc_items(Voice, size);
-        if (pool->voices == NULL)
+        Voice* voice = pool->voices[i];
+        if (voice->prio != VOICE_PRIO_INACTIVE)
         {
-            memory_free(pool);
-            return NULL;
+            pool->active_voices[pool->active_count] = voice;
+            ++pool->active_count;
         }
     }
 
-    for (int i = 0; i < size; ++i)
+    assert(pool->free_count + pool->active_count == pool->size);
+
+    return;
+}
+
+
+/**
+ * Move the Voices that have become inactive from the active list to the free
+ * list.
+ */
+static void Voice_pool_release_inactive(Voice_pool* pool)
+{
+    assert(pool != NULL);
+
+    uint16_t kept_count = 0;
+    for (uint16_t i = 0; i < pool->active_count; ++i)
     {
-        pool->voices[i] = new_Voice();
-        if (pool->voices[i] == NULL)
+        Voice* voice = pool->active_voices[i];
+        if (voice->prio == VOICE_PRIO_INACTIVE)
         {
-            for (--i; i >= 0; --i)
-            {
-                del_Voice(pool->voices[i]);
-            }
-            memory_free(pool->voices);
-            memory_free(pool);
-            return NULL;
+            pool->free_voices[pool->free_count] = voice;
+            ++pool->free_count;
+        }
+        else
+        {
+            pool->active_voices[kept_count] = voice;
+            ++kept_count;
         }
     }
 
-    return pool;
+    pool->active_count = kept_count;
+    assert(pool->free_count + pool->active_count == pool->size);
+
+    return;
 }
 
 
-bool Voice_pool_reserve_state_space(Voice_pool* pool, size_t state_size)
+/**
+ * Allocate a block of memory aligned to a cache line.
+ *
+ * \param size      The amount of bytes to be allocated -- must be > \c 0.
+ * \param storage   Destination for the address to be passed to
+ *                  \a memory_free -- must not be \c NULL.
+ *
+ * \return   The aligned address, or \c NULL if memory allocation failed.
+ */
+static char* alloc_aligned(size_t size, void** storage)
+{
+    assert(size > 0);
+    assert(storage != NULL);
+
+    *storage = memory_alloc(size + VOICE_POOL_ALIGNMENT - 1);
+    if (*storage == NULL)
+        return NULL;
+
+    const uintptr_t addr = (uintptr_t)*storage;
+    const uintptr_t aligned_addr =
+        (addr + VOICE_POOL_ALIGNMENT - 1) &
+        ~(uintptr_t)(VOICE_POOL_ALIGNMENT - 1);
+
+    return (char*)*storage + (aligned_addr - addr);
+}
+
+
+static size_t get_state_stride(size_t state_size)
+{
+    assert(state_size > 0);
+
+    return (state_size + VOICE_POOL_ALIGNMENT - 1) &
+        ~(size_t)(VOICE_POOL_ALIGNMENT - 1);
+}
+
+
+/**
+ * Replace the arenas of the Voice pool.
+ *
+ * Existing Voices are moved to the new arenas and excess Voices are removed.
+ */
+static bool Voice_pool_set_arenas(
+        Voice_pool* pool, uint16_t size, size_t state_size)
 {
     assert(pool != NULL);
+    assert(size > 0);
+    assert(state_size >= sizeof(Voice_state));
+
+    const size_t state_stride = get_state_stride(state_size);
+
+    Voice** voices = memory_alloc_items(Voice*, size);
+    Voice** free_voices = memory_alloc_items(Voice*, size);
+    Voice** active_voices = memory_alloc_items(Voice*, size);
+    void* voice_storage = NULL;
+    Voice* voice_arena = (Voice*)alloc_aligned(
+            sizeof(Voice) * size, &voice_storage);
+    void* state_storage = NULL;
+    char* state_arena = alloc_aligned(state_stride * size, &state_storage);
+    if (voices == NULL || free_voices == NULL || active_voices == NULL ||
+            voice_arena == NULL || state_arena == NULL)
+    {
+        memory_free(voices);
+        memory_free(free_voices);
+        memory_free(active_voices);
+        memory_free(voice_storage);
+        memory_free(state_storage);
+        return false;
+    }
 
-    if (state_size <= pool->state_size)
-        return true;
+    const uint16_t kept_count = min(size, pool->size);
 
-    for (uint16_t i = 0; i < pool->size; ++i)
+    // Create the new Voices
+    for (uint16_t i = kept_count; i < size; ++i)
     {
-        if (!Voice_reserve_state_space(pool->voices[i], state_size))
+        Voice_state* state = (Voice_state*)(state_arena + i * state_stride);
+        if (Voice_preinit(&voice_arena[i], state, state_stride) == NULL)
+        {
+            for (uint16_t k = kept_count; k < i; ++k)
+                Voice_deinit(&voice_arena[k]);
+
+            memory_free(voices);
+            memory_free(free_voices);
+            memory_free(active_voices);
+            memory_free(voice_storage);
+            memory_free(state_storage);
             return false;
+        }
+
+        voices[i] = &voice_arena[i];
     }
 
+    // Move the existing Voices
+    for (uint16_t i = 0; i < kept_count; ++i)
+    {
+        voice_arena[i] = *pool->voices[i];
+        Voice_move_state(
+                &voice_arena[i],
+                (Voice_state*)(state_arena + i * state_stride),
+                state_stride);
+        voices[i] = &voice_arena[i];
+    }
+
+    for (uint16_t i = kept_count; i < pool->size; ++i)
+        Voice_deinit(pool->voices[i]);
+
+    memory_free(pool->voices);
+    memory_free(pool->free_voices);
+    memory_free(pool->active_voices);
+    memory_free(pool->voice_storage);
+    memory_free(pool->state_storage);
+
+    pool->size = size;
     pool->state_size = state_size;
+    pool->voices = voices;
+    pool->free_voices = free_voices;
+    pool->active_voices = active_voices;
+    pool->voice_storage = voice_storage;
+    pool->state_storage = state_storage;
+
+    Voice_pool_rebuild_lists(pool);
+
     return true;
 }
 
 
-bool Voice_pool_resize(Voice_pool* pool, uint16_t size)
+/**
+ * Move the Voice states to a new state arena without moving the Voices.
+ */
+static bool Voice_pool_set_state_arena(Voice_pool* pool, size_t state_size)
 {
     assert(pool != NULL);
+    assert(pool->size > 0);
+    assert(state_size > pool->state_size);
+
+    const size_t state_stride = get_state_stride(state_size);
+
+    void* state_storage = NULL;
+    char* state_arena = alloc_aligned(
+            state_stride * pool->size, &state_storage);
+    if (state_arena == NULL)
+        return false;
+
+    for (uint16_t i = 0; i < pool->size; ++i)
+        Voice_move_state(
+                pool->voices[i],
+                (Voice_state*)(state_arena + i * state_stride),
+                state_stride);
+
+    memory_free(pool->state_storage);
+
+    pool->state_size = state_size;
+    pool->state_storage = state_storage;
+
+    return true;
+}
+
+
+Voice_pool* new_Voice_pool(uint16_t size)
+{
     //assert(size >= 0);
 
-    uint16_t new_size = size;
-    if (new_size == pool->size)
-        return true;
+    Voice_pool* pool = memory_alloc_item(Voice_pool);
+    if (pool == NULL)
+        return NULL;
 
-    // Remove excess voices if any
-    for (uint16_t i = new_size; i < pool->size; ++i)
+    pool->size = 0;
+    pool->state_size = sizeof(Voice_state);
+    pool->new_id = 1;
+    pool->voices = NULL;
+    pool->free_count = 0;
+    pool->free_voices = NULL;
+    pool->active_count = 0;
+    pool->active_voices = NULL;
+    pool->voice_storage = NULL;
+    pool->state_storage = NULL;
+
+    if (size > 0 && !Voice_pool_set_arenas(pool, size, pool->state_size))
     {
-        del_Voice(pool->voices[i]);
-        pool->voices[i] = NULL;
+        memory_free(pool);
+        return NULL;
     }
 
-    if (new_size < pool->size)
-        pool->size = new_size;
+    return pool;
+}
 
-    // Handle 0 voices
-    if (new_size == 0)
+
+bool Voice_pool_reserve_state_space(Voice_pool* pool, size_t state_size)
+{
+    assert(pool != NULL);
+
+    if (state_size <= pool->state_size)
+        return true;
+
+    if (pool->size == 0)
     {
-        memory_free(pool->voices);
-        pool->voices = NULL;
+        pool->state_size = state_size;
         return true;
     }
 
-    // Resize voice array
-    Voice** new_voices = memory_realloc_items(Voice*, new_size, pool->voices);
-    if (new_voices == NULL)
-        return false;
+    // Voices keep their addresses, only the states are moved
+    return Voice_pool_set_state_arena(pool, state_size);
+}
 
-    pool->voices = new_voices;
 
-    // Sanitise new fields if any
-    for (uint16_t i = pool->size; i < new_size; ++i)
-        pool->voices[i] = NULL;
+bool Voice_pool_resize(Voice_pool* pool, uint16_t size)
+{
+    assert(pool != NULL);
+    //assert(size >= 0);
+
+    if (size == pool->size)
+        return true;
 
-    // Allocate new voices
-    for (uint16_t i = pool->size; i < new_size; ++i)
+    // Handle 0 voices
+    if (size == 0)
     {
-        pool->voices[i] = new_Voice();
-        if (pool->voices[i] == NULL ||
-                !Voice_reserve_state_space(pool->voices[i], pool->state_size))
-        {
-            for (--i; i >= pool->size; --i)
-            {
-                del_Voice(pool->voices[i]);
-                pool->voices[i] = NULL;
-            }
-            return false;
-        }
+        for (uint16_t i = 0; i < pool->size; ++i)
+            Voice_deinit(pool->voices[i]);
+
+        memory_free(pool->voices);
+        memory_free(pool->free_voices);
+        memory_free(pool->active_voices);
+        memory_free(pool->voice_storage);
+        memory_free(pool->state_storage);
+        pool->size = 0;
+        pool->voices = NULL;
+        pool->free_voices = NULL;
+        pool->active_voices = NULL;
+        pool->voice_storage = NULL;
+        pool->state_storage = NULL;
+        pool->free_count = 0;
+        pool->active_count = 0;
+        return true;
     }
 
-    pool->size = new_size;
-    return true;
+    return Voice_pool_set_arenas(pool, size, pool->state_size);
 }
 
 
@@ -155,19 +350,44 @@ Voice* Voice_pool_get_voice(Voice_pool* pool, Voice* voice, uint64_t id)
 
     if (voice == NULL)
     {
-        // Find a voice of lowest priority available
-        Voice* new_voice = pool->voices[0];
-        for (uint16_t i = 1; i < pool->size; ++i)
+        if (pool->free_count == 0)
+            Voice_pool_release_inactive(pool);
+
+        Voice* new_voice = NULL;
+        if (pool->free_count > 0)
         {
-            if (Voice_cmp(pool->voices[i], new_voice) < 0)
-                new_voice = pool->voices[i];
+            // Take a free voice
+            --pool->free_count;
+            new_voice = pool->free_voices[pool->free_count];
+            pool->active_voices[pool->active_count] = new_voice;
+            ++pool->active_count;
+        }
+        else
+        {
+            // Find the oldest voice of lowest priority
+            assert(pool->active_count == pool->size);
+            uint16_t index = 0;
+            for (uint16_t i = 1; i < pool->active_count; ++i)
+            {
+                const Voice* cur_voice = pool->active_voices[i];
+                const Voice* best_voice = pool->active_voices[index];
+                const int cmp = Voice_cmp(cur_voice, best_voice);
+                if (cmp < 0 || (cmp == 0 && cur_voice->id < best_voice->id))
+                    index = i;
+            }
+
+            // Move the voice to the end of the active list
+            new_voice = pool->active_voices[index];
+            memmove(&pool->active_voices[index],
+                    &pool->active_voices[index + 1],
+                    (size_t)(pool->active_count - index - 1) * sizeof(Voice*));
+            pool->active_voices[pool->active_count - 1] = new_voice;
         }
 
         // Pre-init the voice
-        static uint64_t running_id = 1;
-        new_voice->id = running_id;
+        new_voice->id = pool->new_id;
         new_voice->prio = VOICE_PRIO_INACTIVE;
-        ++running_id;
+        ++pool->new_id;
 
         return new_voice;
     }
@@ -183,10 +403,10 @@ void Voice_pool_prepare(Voice_pool* pool)
 {
     assert(pool != NULL);
 
-    for (uint16_t i = 0; i < pool->size; ++i)
+    for (uint16_t i = 0; i < pool->active_count; ++i)
     {
-        if (pool->voices[i]->prio != VOICE_PRIO_INACTIVE)
-            Voice_prepare(pool->voices[i]);
+        if (pool->active_voices[i]->prio != VOICE_PRIO_INACTIVE)
+            Voice_prepare(pool->active_voices[i]);
     }
 
     return;
@@ -208,25 +428,49 @@ uint16_t Voice_pool_mix_bg(
     if (pool->size == 0)
         return 0;
 
+    Voice_pool_release_inactive(pool);
+
     uint16_t active_voices = 0;
-    for (uint16_t i = 0; i < pool->size; ++i)
+    for (uint16_t i = 0; i < pool->active_count; ++i)
     {
-        if (pool->voices[i]->prio != VOICE_PRIO_INACTIVE)
+        Voice* voice = pool->active_voices[i];
+        if (voice->prio <= VOICE_PRIO_BG)
         {
-            if (pool->voices[i]->prio <= VOICE_PRIO_BG)
-            {
-//                fprintf(stderr, "Background mix start\n");
-                Voice_mix(pool->voices[i], states, amount, offset, freq, tempo);
-//                fprintf(stderr, "Background mix end\n");
-            }
-            ++active_voices;
+//            fprintf(stderr, "Background mix start\n");
+            Voice_mix_profiled(voice, states, amount, offset, freq, tempo);
+//            fprintf(stderr, "Background mix end\n");
         }
+        ++active_voices;
     }
 
     return active_voices;
 }
 
 
+uint16_t Voice_pool_collect_bg(Voice_pool* pool, Voice** voices, int* bg_count)
+{
+    assert(pool != NULL);
+    assert(voices != NULL);
+    assert(bg_count != NULL);
+
+    *bg_count = 0;
+
+    Voice_pool_release_inactive(pool);
+
+    for (uint16_t i = 0; i < pool->active_count; ++i)
+    {
+        Voice* voice = pool->active_voices[i];
+        if (voice->prio <= VOICE_PRIO_BG)
+        {
+            voices[*bg_count] = voice;
+            ++*bg_count;
+        }
+    }
+
+    return pool->active_count;
+}
+
+
 void Voice_pool_reset(Voice_pool* pool)
 {
     assert(pool != NULL);
@@ -234,6 +478,24 @@ void Voice_pool_reset(Voice_pool* pool)
     for (uint16_t i = 0; i < pool->size; ++i)
         Voice_reset(pool->voices[i]);
 
+    if (pool->size > 0)
+        Voice_pool_rebuild_lists(pool);
+
+    return;
+}
+
+
+void Voice_pool_reset_gen(Voice_pool* pool, const Generator* gen)
+{
+    assert(pool != NULL);
+    assert(gen != NULL);
+
+    for (uint16_t i = 0; i < pool->size; ++i)
+    {
+        if (pool->voices[i]->gen == gen)
+            Voice_reset(pool->voices[i]);
+    }
+
     return;
 }
 
@@ -244,11 +506,13 @@ void del_Voice_pool(Voice_pool* pool)
         return;
 
     for (uint16_t i = 0; i < pool->size; ++i)
-    {
-        del_Voice(pool->voices[i]);
-        pool->voices[i] = NULL;
-    }
+        Voice_deinit(pool->voices[i]);
+
     memory_free(pool->voices);
+    memory_free(pool->free_voices);
+    memory_free(pool->active_voices);
+    memory_free(pool->voice_storage);
+    memory_free(pool->state_storage);
     memory_free(pool);
 
     return;
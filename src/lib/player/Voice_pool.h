@@ -24,13 +24,27 @@
 
 /**
  * Voice pool manages the allocation of Voices.
+ *
+ * Each Voice is either in the free list or in the active list. Voices that
+ * finish during mixing are moved to the free list on the next pass over the
+ * active list, so the active list may contain inactive Voices in between.
+ *
+ * The Voices and their states are stored in two contiguous arenas aligned to
+ * cache lines.
  */
 typedef struct Voice_pool
 {
     uint16_t size;
     uint8_t events;
     size_t state_size;
+    uint64_t new_id;
     Voice** voices;
+    uint16_t free_count;
+    Voice** free_voices;    ///< Inactive Voices, the next one at the end.
+    uint16_t active_count;
+    Voice** active_voices;  ///< Voices in the order of activation.
+    void* voice_storage;    ///< The memory block of the Voice arena.
+    void* state_storage;    ///< The memory block of the Voice state arena.
 } Voice_pool;
 
 
@@ -62,9 +76,11 @@ bool Voice_pool_reserve_state_space(Voice_pool* pool, size_t state_size);
  * \param pool   The Voice pool -- must not be \c NULL.
  * \param size   The new size -- must be > \c 0.
  *
+ * The Voices are moved to new storage, so Voices retrieved from the Voice
+ * pool before resizing must not be accessed afterwards.
+ *
  * \return   \c true if resizing succeeded, or \c false if memory allocation
- *           failed. Note that decreasing the number of Voices may still have
- *           occurred even if the operation fails.
+ *           failed. The Voice pool is not changed if the operation fails.
  */
 bool Voice_pool_resize(Voice_pool* pool, uint16_t size);
 
@@ -83,7 +99,8 @@ uint16_t Voice_pool_get_size(const Voice_pool* pool);
  * Get a Voice from the Voice pool.
  *
  * In case all the Voices are in use, the Voice considered least important is
- * reinitialised and returned.
+ * reinitialised and returned. Of Voices with the same priority, the oldest
+ * one is chosen.
  *
  * If the caller gives an existing Voice as a parameter, no new Voice will be
  * returned. Instead, the Voice pool will check whether this Voice has the
@@ -131,6 +148,23 @@ uint16_t Voice_pool_mix_bg(
         double tempo);
 
 
+/**
+ * Collect the background Voices in the Voice pool.
+ *
+ * The Voices are stored in the order in which Voice_pool_mix_bg would mix
+ * them.
+ *
+ * \param pool       The Voice pool -- must not be \c NULL.
+ * \param voices     The destination array -- must not be \c NULL and must
+ *                   have space for all Voices in \a pool.
+ * \param bg_count   The destination for the number of background Voices
+ *                   -- must not be \c NULL.
+ *
+ * \return   The number of active Voices.
+ */
+uint16_t Voice_pool_collect_bg(Voice_pool* pool, Voice** voices, int* bg_count);
+
+
 /**
  * Reset all Voices in the Voice pool.
  *
@@ -139,6 +173,15 @@ uint16_t Voice_pool_mix_bg(
 void Voice_pool_reset(Voice_pool* pool);
 
 
+/**
+ * Reset the Voices of a Generator in the Voice pool.
+ *
+ * \param pool   The Voice pool -- must not be \c NULL.
+ * \param gen    The Generator -- must not be \c NULL.
+ */
+void Voice_pool_reset_gen(Voice_pool* pool, const Generator* gen);
+
+
 /**
  * Destroy an existing Voice pool.
  *
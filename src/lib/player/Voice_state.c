@@ -70,6 +70,7 @@ Voice_state* Voice_state_clear(Voice_state* state)
 {
     assert(state != NULL);
     state->cgstate = NULL;
+    state->out_buffer = NULL;
 
     state->active = false;
     state->freq = 0;
@@ -19,6 +19,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include <Audio_buffer.h>
 #include <frame.h>
 #include <kunquat/limits.h>
 #include <mathnum/Random.h>
@@ -49,6 +50,7 @@ typedef struct Voice_state
     Channel_gen_state* cgstate;    ///< Channel-specific Generator parameters.
     Random* rand_p;                ///< Parameter random source.
     Random* rand_s;                ///< Signal random source.
+    Audio_buffer* out_buffer;      ///< Output override, or \c NULL for the Generator output.
 
     double ramp_attack;            ///< The current state of volume ramp during attack.
     double ramp_release;           ///< The current state of volume ramp during release.
@@ -0,0 +1,234 @@
+
+
+/*
+ * Author: Tomi Jylhä-Ollila, Finland 2014
+ *
+ * This file is part of Kunquat.
+ *
+ * CC0 1.0 Universal, http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * To the extent possible under law, Kunquat Affirmers have waived all
+ * copyright and related or neighboring rights to Kunquat.
+ */
+
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <debug/assert.h>
+#include <string/Tar_reader.h>
+
+
+#define BLOCK_SIZE 512
+
+#define NAME_OFFSET 0
+#define NAME_LENGTH 100
+#define SIZE_OFFSET 124
+#define SIZE_LENGTH 12
+#define CHKSUM_OFFSET 148
+#define CHKSUM_LENGTH 8
+#define TYPE_OFFSET 156
+#define MAGIC_OFFSET 257
+#define PREFIX_OFFSET 345
+#define PREFIX_LENGTH 155
+
+
+Tar_reader* Tar_reader_init(Tar_reader* reader, const char* data, size_t len)
+{
+    assert(reader != NULL);
+    assert(data != NULL || len == 0);
+
+    reader->data = data;
+    reader->len = len;
+    reader->pos = 0;
+    reader->error = *ERROR_AUTO;
+
+    return reader;
+}
+
+
+bool Tar_reader_is_error_set(const Tar_reader* reader)
+{
+    assert(reader != NULL);
+    return Error_is_set(&reader->error);
+}
+
+
+const Error* Tar_reader_get_error(const Tar_reader* reader)
+{
+    assert(reader != NULL);
+    return &reader->error;
+}
+
+
+static bool read_octal(const char* field, int length, uint64_t* result)
+{
+    assert(field != NULL);
+    assert(length > 0);
+    assert(result != NULL);
+
+    int i = 0;
+    while (i < length && field[i] == ' ')
+        ++i;
+
+    if (i >= length || field[i] < '0' || field[i] > '7')
+        return false;
+
+    uint64_t value = 0;
+    while (i < length && field[i] >= '0' && field[i] <= '7')
+    {
+        value = value * 8 + (uint64_t)(field[i] - '0');
+        ++i;
+    }
+
+    if (i < length && field[i] != ' ' && field[i] != '\0')
+        return false;
+
+    *result = value;
+    return true;
+}
+
+
+static bool block_is_zero(const char* block)
+{
+    assert(block != NULL);
+
+    for (int i = 0; i < BLOCK_SIZE; ++i)
+    {
+        if (block[i] != '\0')
+            return false;
+    }
+
+    return true;
+}
+
+
+static bool header_checksum_is_valid(const char* header)
+{
+    assert(header != NULL);
+
+    uint64_t expected = 0;
+    if (!read_octal(&header[CHKSUM_OFFSET], CHKSUM_LENGTH, &expected))
+        return false;
+
+    // The checksum field itself is counted as spaces
+    uint64_t sum = 0;
+    for (int i = 0; i < BLOCK_SIZE; ++i)
+    {
+        if (i >= CHKSUM_OFFSET && i < CHKSUM_OFFSET + CHKSUM_LENGTH)
+            sum += (unsigned char)' ';
+        else
+            sum += (unsigned char)header[i];
+    }
+
+    return sum == expected;
+}
+
+
+static size_t copy_field(char* dest, const char* field, size_t length)
+{
+    assert(dest != NULL);
+    assert(field != NULL);
+
+    size_t copied = 0;
+    while (copied < length && field[copied] != '\0')
+    {
+        dest[copied] = field[copied];
+        ++copied;
+    }
+
+    return copied;
+}
+
+
+bool Tar_reader_read_entry(Tar_reader* reader, Tar_entry* entry)
+{
+    assert(reader != NULL);
+    assert(entry != NULL);
+
+    if (Tar_reader_is_error_set(reader))
+        return false;
+
+    if (reader->pos >= reader->len)
+        return false;
+
+    if (reader->len - reader->pos < BLOCK_SIZE)
+    {
+        Error_set(&reader->error, ERROR_FORMAT, "Truncated archive header");
+        return false;
+    }
+
+    const char* header = &reader->data[reader->pos];
+
+    // The archive ends with zero blocks
+    if (block_is_zero(header))
+        return false;
+
+    if (!header_checksum_is_valid(header))
+    {
+        Error_set(&reader->error, ERROR_FORMAT,
+                "Invalid archive header checksum at offset %lu",
+                (unsigned long)reader->pos);
+        return false;
+    }
+
+    if ((header[SIZE_OFFSET] & 0x80) != 0)
+    {
+        Error_set(&reader->error, ERROR_FORMAT,
+                "Archive entry at offset %lu is too large",
+                (unsigned long)reader->pos);
+        return false;
+    }
+
+    uint64_t size = 0;
+    if (!read_octal(&header[SIZE_OFFSET], SIZE_LENGTH, &size))
+    {
+        Error_set(&reader->error, ERROR_FORMAT,
+                "Invalid archive entry size at offset %lu",
+                (unsigned long)reader->pos);
+        return false;
+    }
+
+    const size_t data_pos = reader->pos + BLOCK_SIZE;
+    if (size > reader->len - data_pos)
+    {
+        Error_set(&reader->error, ERROR_FORMAT,
+                "Truncated archive entry at offset %lu",
+                (unsigned long)reader->pos);
+        return false;
+    }
+
+    // Build the path, the prefix field is only used by ustar archives
+    size_t path_len = 0;
+    if (strncmp(&header[MAGIC_OFFSET], "ustar", 5) == 0 &&
+            header[PREFIX_OFFSET] != '\0')
+    {
+        path_len = copy_field(
+                entry->path, &header[PREFIX_OFFSET], PREFIX_LENGTH);
+        entry->path[path_len] = '/';
+        ++path_len;
+    }
+    path_len += copy_field(
+            &entry->path[path_len], &header[NAME_OFFSET], NAME_LENGTH);
+    assert(path_len <= TAR_PATH_LENGTH_MAX);
+    entry->path[path_len] = '\0';
+
+    const char type = header[TYPE_OFFSET];
+    entry->is_file = (type == '0' || type == '\0' || type == '7');
+    entry->data = &reader->data[data_pos];
+    entry->size = (size_t)size;
+
+    // Skip the data padded to full blocks
+    const size_t padded_size =
+        ((size_t)size + BLOCK_SIZE - 1) / BLOCK_SIZE * BLOCK_SIZE;
+    if (padded_size > reader->len - data_pos)
+        reader->pos = reader->len;
+    else
+        reader->pos = data_pos + padded_size;
+
+    return true;
+}
+
+
@@ -0,0 +1,108 @@
+
+
+/*
+ * Author: Tomi Jylhä-Ollila, Finland 2014
+ *
+ * This file is part of Kunquat.
+ *
+ * CC0 1.0 Universal, http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * To the extent possible under law, Kunquat Affirmers have waived all
+ * copyright and related or neighboring rights to Kunquat.
+ */
+
+
+#ifndef K_TAR_READER_H
+#define K_TAR_READER_H
+
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include <Error.h>
+
+
+/**
+ * The maximum length of an entry path in a ustar archive.
+ */
+#define TAR_PATH_LENGTH_MAX 256
+
+
+/**
+ * An entry in a tar archive.
+ *
+ * The data of the entry points directly to the archive data.
+ */
+typedef struct Tar_entry
+{
+    char path[TAR_PATH_LENGTH_MAX + 1];
+    bool is_file;
+    const char* data;
+    size_t size;
+} Tar_entry;
+
+
+/**
+ * A reader of uncompressed ustar archives stored in memory.
+ */
+typedef struct Tar_reader
+{
+    const char* data;
+    size_t len;
+    size_t pos;
+    Error error;
+} Tar_reader;
+
+
+#define TAR_READER_AUTO (&(Tar_reader){ .data = NULL, .len = 0, .pos = 0 })
+
+
+/**
+ * Initialise a Tar reader.
+ *
+ * \param reader   The Tar reader -- must not be \c NULL.
+ * \param data     The archive data -- must not be \c NULL unless \a len is
+ *                 \c 0.
+ * \param len      The length of the data.
+ *
+ * \return   The parameter \a reader.
+ */
+Tar_reader* Tar_reader_init(Tar_reader* reader, const char* data, size_t len);
+
+
+/**
+ * Find out if the Tar reader error is set.
+ *
+ * \param reader   The Tar reader -- must not be \c NULL.
+ *
+ * \return   \c true if the error is set, otherwise \c false.
+ */
+bool Tar_reader_is_error_set(const Tar_reader* reader);
+
+
+/**
+ * Get the error of the Tar reader.
+ *
+ * \param reader   The Tar reader -- must not be \c NULL.
+ *
+ * \return   The error.
+ */
+const Error* Tar_reader_get_error(const Tar_reader* reader);
+
+
+/**
+ * Read the next entry from the archive.
+ *
+ * \param reader   The Tar reader -- must not be \c NULL.
+ * \param entry    The destination entry -- must not be \c NULL.
+ *
+ * \return   \c true if an entry was read, or \c false if the end of the
+ *           archive was reached or an error occurred. Check
+ *           Tar_reader_is_error_set to distinguish between the two.
+ */
+bool Tar_reader_read_entry(Tar_reader* reader, Tar_entry* entry);
+
+
+#endif // K_TAR_READER_H
+
+
@@ -146,6 +146,63 @@ START_TEST(Effect_with_double_volume_dsp_and_bypass_triples_volume)
 END_TEST
 
 
+START_TEST(Parallel_effects_mix_correctly_with_multiple_threads)
+{
+    const int thread_count = _i;
+
+    set_audio_rate(220);
+    set_mix_volume(0);
+    pause();
+
+    set_data("p_control_map.json", "[ [0, 0] ]");
+    set_data("control_00/p_manifest.json", "{}");
+
+    set_data("ins_00/p_manifest.json", "{}");
+    set_data("ins_00/p_connections.json",
+            "[ [\"gen_00/C/out_00\", \"out_00\"] ]");
+    set_data("ins_00/gen_00/p_manifest.json", "{}");
+    set_data("ins_00/gen_00/p_gen_type.json", "\"debug\"");
+
+    set_data("eff_00/p_manifest.json", "{}");
+    set_data("eff_00/dsp_00/p_manifest.json", "{}");
+    set_data("eff_00/dsp_00/p_dsp_type.json", "\"volume\"");
+    set_data("eff_00/dsp_00/c/p_f_volume.json", "6");
+    set_data("eff_00/p_connections.json",
+            "[ [\"in_00\", \"dsp_00/C/in_00\"],"
+            "  [\"dsp_00/C/out_00\", \"out_00\"] ]");
+
+    set_data("eff_01/p_manifest.json", "{}");
+    set_data("eff_01/dsp_00/p_manifest.json", "{}");
+    set_data("eff_01/dsp_00/p_dsp_type.json", "\"volume\"");
+    set_data("eff_01/p_connections.json",
+            "[ [\"in_00\", \"dsp_00/C/in_00\"],"
+            "  [\"dsp_00/C/out_00\", \"out_00\"] ]");
+
+    set_data("p_connections.json",
+            "[ [\"ins_00/out_00\", \"eff_00/in_00\"],"
+            "  [\"ins_00/out_00\", \"eff_01/in_00\"],"
+            "  [\"eff_00/out_00\", \"out_00\"],"
+            "  [\"eff_01/out_00\", \"out_00\"] ]");
+
+    validate();
+
+    kqt_Handle_set_thread_count(handle, thread_count);
+    check_unexpected_error();
+
+    float actual_buf[buf_len] = { 0.0f };
+    kqt_Handle_fire_event(handle, 0, Note_On_55_Hz);
+    check_unexpected_error();
+    mix_and_fill(actual_buf, buf_len);
+
+    float expected_buf[buf_len] = { 0.0f };
+    float seq[] = { 3.0f, 1.5f, 1.5f, 1.5f };
+    repeat_seq_local(expected_buf, 10, seq);
+
+    check_buffers_equal(expected_buf, actual_buf, buf_len, 0.0f);
+}
+END_TEST
+
+
 START_TEST(Connect_instrument_effect_with_unconnected_dsp_and_mix)
 {
     assert(handle != 0);
@@ -189,6 +246,10 @@ Suite* Connections_suite(void)
     tcase_add_test(
             tc_effects,
             Effect_with_double_volume_dsp_and_bypass_triples_volume);
+    tcase_add_loop_test(
+            tc_effects,
+            Parallel_effects_mix_correctly_with_multiple_threads,
+            1, 5);
     tcase_add_test(
             tc_effects,
             Connect_instrument_effect_with_unconnected_dsp_and_mix);
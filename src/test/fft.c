@@ -0,0 +1,149 @@
+
+
+/*
+ * Author: Tomi Jylhä-Ollila, Finland 2014
+ *
+ * This file is part of Kunquat.
+ *
+ * CC0 1.0 Universal, http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * To the extent possible under law, Kunquat Affirmers have waived all
+ * copyright and related or neighboring rights to Kunquat.
+ */
+
+
+#include <math.h>
+#include <stdint.h>
+
+#include <test_common.h>
+
+#include <mathnum/common.h>
+#include <mathnum/Fft.h>
+
+
+#define max_size 1024
+
+#define size_count 5
+
+
+static int32_t get_size(int index)
+{
+    return 4 << (index * 2);
+}
+
+
+static float test_signal(int32_t i, int seed)
+{
+    return (float)sin(i * 0.37 + seed) + (float)cos(i * i * 0.011 * seed);
+}
+
+
+START_TEST(Inverse_transform_restores_signal)
+{
+    const int32_t size = get_size(_i);
+    Fft* fft = new_Fft(size);
+    fail_if(fft == NULL, "Could not allocate Fft");
+
+    float re[max_size] = { 0 };
+    float im[max_size] = { 0 };
+    for (int32_t i = 0; i < size; ++i)
+    {
+        re[i] = test_signal(i, 1);
+        im[i] = test_signal(i, 2);
+    }
+
+    Fft_forward(fft, re, im);
+    Fft_inverse(fft, re, im);
+
+    for (int32_t i = 0; i < size; ++i)
+    {
+        fail_unless(fabs(re[i] - test_signal(i, 1)) < 0.0001,
+                "Real part at index %ld differs:" KT_VALUES("%.6f",
+                    test_signal(i, 1), re[i]),
+                (long)i);
+        fail_unless(fabs(im[i] - test_signal(i, 2)) < 0.0001,
+                "Imaginary part at index %ld differs:" KT_VALUES("%.6f",
+                    test_signal(i, 2), im[i]),
+                (long)i);
+    }
+
+    del_Fft(fft);
+}
+END_TEST
+
+
+START_TEST(Forward_transform_matches_dft)
+{
+    const int32_t size = get_size(_i);
+    Fft* fft = new_Fft(size);
+    fail_if(fft == NULL, "Could not allocate Fft");
+
+    float re[max_size] = { 0 };
+    float im[max_size] = { 0 };
+    for (int32_t i = 0; i < size; ++i)
+        re[i] = test_signal(i, 3);
+
+    Fft_forward(fft, re, im);
+
+    for (int32_t k = 0; k < size; k += max(1, size / 16))
+    {
+        double expected_re = 0;
+        double expected_im = 0;
+        for (int32_t i = 0; i < size; ++i)
+        {
+            const double angle = -2 * PI * k * i / size;
+            expected_re += test_signal(i, 3) * cos(angle);
+            expected_im += test_signal(i, 3) * sin(angle);
+        }
+
+        const double tolerance = 0.0001 * size;
+        fail_unless(fabs(re[k] - expected_re) < tolerance,
+                "Real part of bin %ld differs:" KT_VALUES("%.6f",
+                    expected_re, re[k]),
+                (long)k);
+        fail_unless(fabs(im[k] - expected_im) < tolerance,
+                "Imaginary part of bin %ld differs:" KT_VALUES("%.6f",
+                    expected_im, im[k]),
+                (long)k);
+    }
+
+    del_Fft(fft);
+}
+END_TEST
+
+
+Suite* Fft_suite(void)
+{
+    Suite* s = suite_create("Fft");
+
+    const int timeout = DEFAULT_TIMEOUT;
+
+    TCase* tc_transform = tcase_create("transform");
+    suite_add_tcase(s, tc_transform);
+    tcase_set_timeout(tc_transform, timeout);
+
+    tcase_add_loop_test(
+            tc_transform, Inverse_transform_restores_signal,
+            0, size_count);
+    tcase_add_loop_test(
+            tc_transform, Forward_transform_matches_dft,
+            0, size_count);
+
+    return s;
+}
+
+
+int main(void)
+{
+    Suite* suite = Fft_suite();
+    SRunner* sr = srunner_create(suite);
+#ifdef K_MEM_DEBUG
+    srunner_set_fork_status(sr, CK_NOFORK);
+#endif
+    srunner_run_all(sr, CK_NORMAL);
+    int fail_count = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    exit(fail_count > 0);
+}
+
+
@@ -115,9 +115,545 @@ START_TEST(Set_audio_rate)
 END_TEST
 
 
+START_TEST(Negative_sample_cache_limit_is_rejected)
+{
+    fail_if(kqt_Handle_set_sample_cache_limit(handle, -1) != 0,
+            "Negative sample cache limit was accepted");
+    kqt_Handle_clear_error(handle);
+
+    fail_if(kqt_Handle_set_sample_cache_limit(handle, 1 << 20) != 1,
+            "Couldn't set sample cache limit: %s",
+            kqt_Handle_get_error(handle));
+    fail_if(kqt_Handle_set_sample_cache_limit(handle, 0) != 1,
+            "Couldn't disable sample cache: %s",
+            kqt_Handle_get_error(handle));
+}
+END_TEST
+
+
 #define buf_len 128
 
 
+START_TEST(Shared_handle_renders_like_source)
+{
+    set_audio_rate(220);
+
+    kqt_Handle shared = kqt_new_Handle_shared(handle);
+    fail_if(shared == 0,
+            "Couldn't create shared handle:\n%s\n",
+            kqt_Handle_get_error(handle));
+
+    fail_unless(
+            kqt_Handle_get_audio_rate(shared) == 220,
+            "Wrong audio rate in shared handle"
+            KT_VALUES("%ld", 220L, kqt_Handle_get_audio_rate(shared)));
+
+    kqt_Handle_fire_event(handle, 0, Note_On_55_Hz);
+    check_unexpected_error();
+    kqt_Handle_fire_event(shared, 0, Note_On_55_Hz);
+    fail_unless(strcmp(kqt_Handle_get_error(shared), "") == 0,
+            "Unexpected error in shared handle: %s",
+            kqt_Handle_get_error(shared));
+
+    float expected[buf_len] = { 0.0f };
+    const long expected_len = mix_and_fill(expected, buf_len);
+
+    kqt_Handle_play(shared, buf_len);
+    const long actual_len = kqt_Handle_get_frames_available(shared);
+    fail_unless(actual_len == expected_len,
+            "Wrong number of frames rendered"
+            KT_VALUES("%ld", expected_len, actual_len));
+
+    const float* actual = kqt_Handle_get_audio(shared, 0);
+    fail_if(actual == NULL,
+            "Shared handle returned no audio: %s",
+            kqt_Handle_get_error(shared));
+    check_buffers_equal(expected, actual, expected_len, 0.0f);
+
+    kqt_del_Handle(shared);
+}
+END_TEST
+
+
+static const char* debug_keys[] =
+{
+    "p_connections.json",
+    "p_control_map.json",
+    "control_00/p_manifest.json",
+    "ins_00/p_manifest.json",
+    "ins_00/p_connections.json",
+    "ins_00/gen_00/p_manifest.json",
+    "ins_00/gen_00/p_gen_type.json",
+};
+
+static const char* debug_values[] =
+{
+    "[ [\"ins_00/out_00\", \"out_00\"] ]",
+    "[ [0, 0] ]",
+    "{}",
+    "{}",
+    "[ [\"gen_00/C/out_00\", \"out_00\"] ]",
+    "{}",
+    "\"debug\"",
+};
+
+#define DEBUG_KEY_COUNT ((long)(sizeof(debug_keys) / sizeof(debug_keys[0])))
+
+
+static long render_debug_reference(float* buf)
+{
+    assert(buf != NULL);
+
+    // Render the reference output from a Handle loaded key by key
+    kqt_Handle orig_handle = handle;
+    handle = kqt_new_Handle();
+    fail_if(handle == 0,
+            "Couldn't create handle:\n%s\n", kqt_Handle_get_error(0));
+    setup_debug_instrument();
+    set_audio_rate(220);
+    kqt_Handle_fire_event(handle, 0, Note_On_55_Hz);
+    check_unexpected_error();
+
+    const long len = mix_and_fill(buf, buf_len);
+    kqt_del_Handle(handle);
+    handle = orig_handle;
+
+    return len;
+}
+
+
+static void check_debug_render(const float* expected, long expected_len)
+{
+    assert(expected != NULL);
+
+    validate();
+    set_audio_rate(220);
+    kqt_Handle_fire_event(handle, 0, Note_On_55_Hz);
+    check_unexpected_error();
+
+    float actual[buf_len] = { 0.0f };
+    const long actual_len = mix_and_fill(actual, buf_len);
+    fail_unless(actual_len == expected_len,
+            "Wrong number of frames rendered"
+            KT_VALUES("%ld", expected_len, actual_len));
+    check_buffers_equal(expected, actual, expected_len, 0.0f);
+
+    return;
+}
+
+
+START_TEST(Batch_loading_renders_like_separate_keys)
+{
+    const void* data[DEBUG_KEY_COUNT] = { NULL };
+    long lengths[DEBUG_KEY_COUNT] = { 0 };
+    for (long i = 0; i < DEBUG_KEY_COUNT; ++i)
+    {
+        data[i] = debug_values[i];
+        lengths[i] = (long)strlen(debug_values[i]);
+    }
+
+    float expected[buf_len] = { 0.0f };
+    const long expected_len = render_debug_reference(expected);
+
+    kqt_Handle_set_thread_count(handle, 2);
+    check_unexpected_error();
+    fail_unless(kqt_Handle_set_data_batch(
+                handle, DEBUG_KEY_COUNT, debug_keys, data, lengths) == 1,
+            "Couldn't set data batch: %s",
+            kqt_Handle_get_error(handle));
+
+    check_debug_render(expected, expected_len);
+}
+END_TEST
+
+
+START_TEST(Batch_loading_reports_sample_decoding_errors)
+{
+    // Two samples make the batch decode them on a Thread pool
+    static const char* sample_keys[] =
+    {
+        "ins_00/gen_00/c/smp_000/p_sample.wv",
+        "ins_00/gen_00/c/smp_001/p_sample.wv",
+    };
+    static const char sample_data[] = "not WavPack data";
+
+    const char* keys[DEBUG_KEY_COUNT + 2] = { NULL };
+    const void* data[DEBUG_KEY_COUNT + 2] = { NULL };
+    long lengths[DEBUG_KEY_COUNT + 2] = { 0 };
+    for (long i = 0; i < DEBUG_KEY_COUNT; ++i)
+    {
+        keys[i] = debug_keys[i];
+        data[i] = debug_values[i];
+        lengths[i] = (long)strlen(debug_values[i]);
+    }
+    for (long i = 0; i < 2; ++i)
+    {
+        keys[DEBUG_KEY_COUNT + i] = sample_keys[i];
+        data[DEBUG_KEY_COUNT + i] = sample_data;
+        lengths[DEBUG_KEY_COUNT + i] = (long)strlen(sample_data);
+    }
+
+    // Get the error reported when the first sample is set separately
+    kqt_Handle ref_handle = kqt_new_Handle();
+    fail_if(ref_handle == 0,
+            "Couldn't create handle:\n%s\n", kqt_Handle_get_error(0));
+    fail_if(kqt_Handle_set_data(
+                ref_handle,
+                sample_keys[0],
+                sample_data,
+                (long)strlen(sample_data)) == 1,
+            "Invalid sample data was accepted");
+    fail_if(kqt_Handle_validate(ref_handle) == 1,
+            "Invalid sample data passed validation");
+    char expected_error[1024] = "";
+    strncpy(expected_error,
+            kqt_Handle_get_error(ref_handle),
+            sizeof(expected_error) - 1);
+    kqt_del_Handle(ref_handle);
+    fail_if(strcmp(expected_error, "") == 0,
+            "Invalid sample data did not set an error");
+
+    kqt_Handle_set_thread_count(handle, 2);
+    check_unexpected_error();
+    fail_if(kqt_Handle_set_data_batch(
+                handle, DEBUG_KEY_COUNT + 2, keys, data, lengths) == 1,
+            "Batch with invalid sample data was accepted");
+    fail_if(kqt_Handle_validate(handle) == 1,
+            "Batch with invalid sample data passed validation");
+
+    const char* actual_error = kqt_Handle_get_error(handle);
+    fail_unless(strcmp(actual_error, expected_error) == 0,
+            "Wrong error for invalid sample data"
+            KT_VALUES("%s", expected_error, actual_error));
+}
+END_TEST
+
+
+#define TAR_BLOCK 512
+
+
+static long add_tar_entry(
+        char* archive, long pos, const char* path, const char* data)
+{
+    assert(archive != NULL);
+    assert(pos >= 0);
+    assert(path != NULL);
+    assert(data != NULL);
+
+    const long length = (long)strlen(data);
+
+    char* header = &archive[pos];
+    memset(header, '\0', TAR_BLOCK);
+    strcpy(&header[0], path);
+    strcpy(&header[100], "0000644");
+    strcpy(&header[108], "0000000");
+    strcpy(&header[116], "0000000");
+    sprintf(&header[124], "%011lo", (unsigned long)length);
+    strcpy(&header[136], "00000000000");
+    header[156] = '0';
+    memcpy(&header[257], "ustar", 6);
+    memcpy(&header[263], "00", 2);
+
+    memset(&header[148], ' ', 8);
+    unsigned long sum = 0;
+    for (int i = 0; i < TAR_BLOCK; ++i)
+        sum += (unsigned char)header[i];
+    sprintf(&header[148], "%06lo", sum);
+
+    memcpy(&archive[pos + TAR_BLOCK], data, length);
+
+    return pos + TAR_BLOCK + (length + TAR_BLOCK - 1) / TAR_BLOCK * TAR_BLOCK;
+}
+
+
+START_TEST(Archive_loading_renders_like_separate_keys)
+{
+    static char archive[(DEBUG_KEY_COUNT * 2 + 2) * TAR_BLOCK];
+    memset(archive, '\0', sizeof(archive));
+
+    long pos = 0;
+    for (long i = 0; i < DEBUG_KEY_COUNT; ++i)
+    {
+        char path[128] = "kqtc00/";
+        strcat(path, debug_keys[i]);
+        pos = add_tar_entry(archive, pos, path, debug_values[i]);
+    }
+    pos += 2 * TAR_BLOCK;
+
+    float expected[buf_len] = { 0.0f };
+    const long expected_len = render_debug_reference(expected);
+
+    fail_unless(kqt_Handle_load_archive_data(handle, archive, pos) == 1,
+            "Couldn't load archive: %s",
+            kqt_Handle_get_error(handle));
+
+    check_debug_render(expected, expected_len);
+}
+END_TEST
+
+
+START_TEST(Compressed_archive_is_rejected)
+{
+    static const char data[] = "BZh91AY&SY";
+
+    fail_if(kqt_Handle_load_archive_data(handle, data, sizeof(data)) != 0,
+            "Compressed archive was accepted");
+    kqt_Handle_clear_error(handle);
+}
+END_TEST
+
+
+START_TEST(Shared_composition_is_read_only)
+{
+    kqt_Handle shared = kqt_new_Handle_shared(handle);
+    fail_if(shared == 0,
+            "Couldn't create shared handle:\n%s\n",
+            kqt_Handle_get_error(handle));
+
+    const char* data = "{ \"mix_vol\": 0 }";
+    const long length = (long)strlen(data);
+
+    fail_if(kqt_Handle_set_data(
+                handle, "p_composition.json", data, length) != 0,
+            "Shared composition was modified through the source handle");
+    fail_if(kqt_Handle_set_data(
+                shared, "p_composition.json", data, length) != 0,
+            "Shared composition was modified through the shared handle");
+    kqt_Handle_clear_error(handle);
+
+    kqt_del_Handle(shared);
+
+    set_data("p_composition.json", data);
+    validate();
+}
+END_TEST
+
+
+START_TEST(Profile_contains_processed_generators)
+{
+    set_audio_rate(220);
+
+    const char* empty_profile = kqt_Handle_get_profile(handle);
+    check_unexpected_error();
+    fail_unless(strcmp(empty_profile, "[]") == 0,
+            "Profile of an idle handle is not empty: %s", empty_profile);
+
+    fail_unless(kqt_Handle_set_profiling_enabled(handle, 1) == 1,
+            "Couldn't enable profiling: %s",
+            kqt_Handle_get_error(handle));
+    fail_unless(kqt_Handle_get_profiling_enabled(handle) == 1,
+            "Profiling was not enabled");
+
+    // Let the playback of the empty composition stop first
+    kqt_Handle_play(handle, 10);
+    check_unexpected_error();
+
+    kqt_Handle_fire_event(handle, 0, Note_On_55_Hz);
+    check_unexpected_error();
+    kqt_Handle_play(handle, 10);
+    check_unexpected_error();
+
+    const char* profile = kqt_Handle_get_profile(handle);
+    check_unexpected_error();
+    fail_unless(strstr(profile, "[\"ins_00/gen_00\", ") != NULL,
+            "Profile does not contain the debug generator: %s", profile);
+
+    fail_unless(kqt_Handle_set_profiling_enabled(handle, 0) == 1,
+            "Couldn't disable profiling: %s",
+            kqt_Handle_get_error(handle));
+    profile = kqt_Handle_get_profile(handle);
+    check_unexpected_error();
+    fail_unless(strcmp(profile, "[]") == 0,
+            "Profile was not cleared: %s", profile);
+}
+END_TEST
+
+
+static void setup_pulse_pattern(void)
+{
+    set_audio_rate(8);
+    set_mix_volume(0);
+    setup_debug_single_pulse();
+
+    set_data("album/p_manifest.json", "{}");
+    set_data("album/p_tracks.json", "[0]");
+    set_data("song_00/p_manifest.json", "{}");
+    set_data("song_00/p_order_list.json", "[ [0, 0] ]");
+    set_data("pat_000/p_manifest.json", "{}");
+    set_data("pat_000/p_pattern.json", "{ \"length\": [4, 0] }");
+    set_data("pat_000/instance_000/p_manifest.json", "{}");
+    set_data("pat_000/col_00/p_triggers.json",
+            "[ [[0, 0], [\"n+\", \"0\"]] ]");
+
+    validate();
+
+    return;
+}
+
+
+static void stage_data(const char* key, const char* data)
+{
+    assert(key != NULL);
+    assert(data != NULL);
+
+    fail_unless(kqt_Handle_stage_data(handle, key, data, strlen(data)) == 1,
+            "Couldn't stage data: %s",
+            kqt_Handle_get_edit_error(handle));
+
+    return;
+}
+
+
+static void check_pulses(int first_frame, int second_frame)
+{
+    float actual[16] = { 0.0f };
+    long frame_count = 0;
+    while (frame_count < 16)
+    {
+        const long frames = mix_and_fill(&actual[frame_count], 4);
+        fail_unless(frames == 4,
+                "Wrong number of frames rendered"
+                KT_VALUES("%ld", 4L, frames));
+        frame_count += frames;
+
+        // Stage the edit while the first beat is playing
+        if (frame_count == 4)
+        {
+            stage_data("pat_000/col_00/p_triggers.json",
+                    "[ [[0, 0], [\"n+\", \"0\"]], [[2, 0], [\"n+\", \"0\"]] ]");
+            kqt_Handle_commit_data(handle);
+        }
+    }
+
+    float expected[16] = { 0.0f };
+    expected[first_frame] = 1.0f;
+    if (second_frame >= 0)
+        expected[second_frame] = 1.0f;
+
+    check_buffers_equal(expected, actual, 16, 0.0f);
+
+    return;
+}
+
+
+START_TEST(Committed_column_is_applied_at_next_play)
+{
+    setup_pulse_pattern();
+    check_pulses(0, 8);
+
+    fail_unless(strcmp(kqt_Handle_get_edit_error(handle), "") == 0,
+            "Unexpected edit error: %s",
+            kqt_Handle_get_edit_error(handle));
+    check_unexpected_error();
+}
+END_TEST
+
+
+START_TEST(Committed_length_is_used_by_committed_column)
+{
+    setup_pulse_pattern();
+
+    stage_data("pat_000/p_pattern.json", "{ \"length\": [8, 0] }");
+    stage_data("pat_000/col_00/p_triggers.json",
+            "[ [[0, 0], [\"n+\", \"0\"]], [[6, 0], [\"n+\", \"0\"]] ]");
+    fail_unless(kqt_Handle_commit_data(handle) == 1,
+            "Couldn't commit data: %s",
+            kqt_Handle_get_edit_error(handle));
+
+    float actual[32] = { 0.0f };
+    for (long frame_count = 0; frame_count < 32; frame_count += 8)
+        mix_and_fill(&actual[frame_count], 8);
+
+    float expected[32] = { 0.0f };
+    expected[0] = 1.0f;
+    expected[24] = 1.0f;
+
+    check_buffers_equal(expected, actual, 32, 0.0f);
+}
+END_TEST
+
+
+START_TEST(Invalid_commit_is_rejected_as_a_whole)
+{
+    setup_pulse_pattern();
+
+    stage_data("pat_000/col_01/p_triggers.json",
+            "[ [[3, 0], [\"n+\", \"0\"]] ]");
+    stage_data("pat_000/col_00/p_triggers.json", "[ [[0, 0], ");
+    fail_if(kqt_Handle_commit_data(handle) != 0,
+            "Invalid committed data was accepted");
+    fail_if(strstr(kqt_Handle_get_edit_error(handle), "FormatError") == NULL,
+            "Wrong edit error: %s", kqt_Handle_get_edit_error(handle));
+
+    // The rejected data is discarded
+    fail_unless(kqt_Handle_commit_data(handle) == 1,
+            "Couldn't commit empty data: %s",
+            kqt_Handle_get_edit_error(handle));
+
+    check_pulses(0, 8);
+    check_unexpected_error();
+}
+END_TEST
+
+
+START_TEST(Structural_data_cannot_be_staged)
+{
+    setup_pulse_pattern();
+
+    static const char* keys[] =
+    {
+        "p_composition.json",
+        "pat_000/p_manifest.json",
+        "pat_000/instance_000/p_manifest.json",
+        "pat_001/col_00/p_triggers.json",
+        "ins_00/gen_00/c/p_b_single_pulse.json",
+    };
+
+    for (size_t i = 0; i < sizeof(keys) / sizeof(keys[0]); ++i)
+    {
+        stage_data("pat_000/col_00/p_triggers.json", "[]");
+        stage_data(keys[i], "{}");
+        fail_if(kqt_Handle_commit_data(handle) != 0,
+                "Key %s was staged", keys[i]);
+        fail_if(strstr(kqt_Handle_get_edit_error(handle),
+                    "ArgumentError") == NULL,
+                "Wrong edit error: %s", kqt_Handle_get_edit_error(handle));
+    }
+
+    check_pulses(0, 8);
+    check_unexpected_error();
+}
+END_TEST
+
+
+START_TEST(Shared_composition_cannot_be_staged)
+{
+    kqt_Handle shared = kqt_new_Handle_shared(handle);
+    fail_if(shared == 0,
+            "Couldn't create shared handle:\n%s\n",
+            kqt_Handle_get_error(handle));
+
+    const char* data = "[]";
+    const long length = (long)strlen(data);
+
+    fail_if(kqt_Handle_stage_data(
+                shared, "pat_000/col_00/p_triggers.json", data, length) != 0,
+            "Data was staged in a shared composition");
+    fail_if(strstr(kqt_Handle_get_edit_error(shared), "shared") == NULL,
+            "Wrong edit error: %s", kqt_Handle_get_edit_error(shared));
+    fail_if(kqt_Handle_commit_data(handle) != 0,
+            "Data was committed in a shared composition");
+
+    kqt_del_Handle(shared);
+
+    fail_unless(kqt_Handle_commit_data(handle) == 1,
+            "Couldn't commit data after the composition was released: %s",
+            kqt_Handle_get_edit_error(handle));
+    check_unexpected_error();
+}
+END_TEST
+
+
 Suite* Handle_suite(void)
 {
     Suite* s = suite_create("Handle");
@@ -144,6 +680,11 @@ Suite* Handle_suite(void)
     tcase_add_loop_test(
             tc_empty, Set_audio_rate,
             0, MIXING_RATE_COUNT);
+    tcase_add_test(tc_empty, Negative_sample_cache_limit_is_rejected);
+    tcase_add_test(tc_empty, Batch_loading_renders_like_separate_keys);
+    tcase_add_test(tc_empty, Batch_loading_reports_sample_decoding_errors);
+    tcase_add_test(tc_empty, Archive_loading_renders_like_separate_keys);
+    tcase_add_test(tc_empty, Compressed_archive_is_rejected);
 
     TCase* tc_render = tcase_create("render");
     suite_add_tcase(s, tc_render);
@@ -155,6 +696,14 @@ Suite* Handle_suite(void)
     tcase_add_loop_test(
             tc_render, Set_audio_rate,
             0, MIXING_RATE_COUNT);
+    tcase_add_test(tc_render, Shared_handle_renders_like_source);
+    tcase_add_test(tc_render, Shared_composition_is_read_only);
+    tcase_add_test(tc_render, Profile_contains_processed_generators);
+    tcase_add_test(tc_render, Committed_column_is_applied_at_next_play);
+    tcase_add_test(tc_render, Committed_length_is_used_by_committed_column);
+    tcase_add_test(tc_render, Invalid_commit_is_rejected_as_a_whole);
+    tcase_add_test(tc_render, Structural_data_cannot_be_staged);
+    tcase_add_test(tc_render, Shared_composition_cannot_be_staged);
 
     return s;
 }
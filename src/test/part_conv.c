@@ -0,0 +1,266 @@
+
+
+/*
+ * Author: Tomi Jylhä-Ollila, Finland 2014
+ *
+ * This file is part of Kunquat.
+ *
+ * CC0 1.0 Universal, http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * To the extent possible under law, Kunquat Affirmers have waived all
+ * copyright and related or neighboring rights to Kunquat.
+ */
+
+
+#include <math.h>
+#include <stdint.h>
+
+#include <test_common.h>
+
+#include <mathnum/common.h>
+#include <mathnum/Part_conv.h>
+
+
+#define max_tap_count 1000
+
+#define signal_len 2000
+
+#define tap_count_count 6
+
+
+static int32_t get_tap_count(int index)
+{
+    static const int32_t tap_counts[tap_count_count] =
+    {
+        1, 100, PART_CONV_SIZE, PART_CONV_SIZE + 1, 300, max_tap_count,
+    };
+
+    return tap_counts[index];
+}
+
+
+static float test_signal(int32_t i, int seed)
+{
+    return (float)sin(i * 0.37 + seed) + (float)cos(i * i * 0.011 * seed);
+}
+
+
+static void make_ir(float ir[2][max_tap_count], int32_t tap_count, int seed)
+{
+    // Decaying noise-like response that differs between the channels
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        for (int32_t i = 0; i < tap_count; ++i)
+            ir[ch][i] = test_signal(i, seed + ch) * (float)exp(-i * 0.004);
+    }
+
+    return;
+}
+
+
+static void convolve_direct(
+        float ir[2][max_tap_count],
+        int32_t tap_count,
+        float in[2][signal_len],
+        int32_t start,
+        int32_t until,
+        double expected[2][signal_len])
+{
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        for (int32_t i = start; i < until; ++i)
+        {
+            double sum = 0;
+            for (int32_t k = 0; k < tap_count && i - k >= start; ++k)
+                sum += (double)ir[ch][k] * in[ch][i - k];
+
+            expected[ch][i] = sum;
+        }
+    }
+
+    return;
+}
+
+
+static void process_in_chunks(
+        Part_conv* pc,
+        float in[2][signal_len],
+        float out[2][signal_len],
+        int32_t start,
+        int32_t until)
+{
+    static const int32_t chunk_sizes[] = { 1, 37, PART_CONV_SIZE, 200, 5 };
+    const int chunk_size_count = sizeof(chunk_sizes) / sizeof(*chunk_sizes);
+
+    float* in_data[] = { in[0], in[1] };
+    float* out_data[] = { out[0], out[1] };
+
+    int32_t pos = start;
+    int chunk_index = 0;
+    while (pos < until)
+    {
+        const int32_t chunk_until = min(until, pos + chunk_sizes[chunk_index]);
+        Part_conv_process(pc, in_data, out_data, pos, chunk_until, 1.0f);
+        pos = chunk_until;
+        chunk_index = (chunk_index + 1) % chunk_size_count;
+    }
+
+    return;
+}
+
+
+static void check_output(
+        double expected[2][signal_len],
+        float actual[2][signal_len],
+        int32_t start,
+        int32_t until)
+{
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        for (int32_t i = start; i < until; ++i)
+        {
+            const double tolerance = 0.0001 * (1 + fabs(expected[ch][i]));
+            fail_unless(fabs(actual[ch][i] - expected[ch][i]) < tolerance,
+                    "Output of channel %d at frame %ld differs:"
+                    KT_VALUES("%.6f", expected[ch][i], actual[ch][i]),
+                    ch, (long)i);
+        }
+    }
+
+    return;
+}
+
+
+static float ir[2][max_tap_count];
+static float in[2][signal_len];
+static float out[2][signal_len];
+static double expected[2][signal_len];
+
+
+static void setup_signal(void)
+{
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        for (int32_t i = 0; i < signal_len; ++i)
+        {
+            in[ch][i] = test_signal(i, 5 + ch);
+            out[ch][i] = 0;
+        }
+    }
+
+    return;
+}
+
+
+START_TEST(Partitioned_convolution_matches_direct_form)
+{
+    const int32_t tap_count = get_tap_count(_i);
+
+    Part_conv* pc = new_Part_conv();
+    fail_if(pc == NULL, "Could not allocate Part_conv");
+
+    make_ir(ir, tap_count, 1);
+    float* ir_data[] = { ir[0], ir[1] };
+    fail_if(!Part_conv_set_ir(pc, ir_data, tap_count),
+            "Could not set impulse response");
+
+    process_in_chunks(pc, in, out, 0, signal_len);
+
+    convolve_direct(ir, tap_count, in, 0, signal_len, expected);
+    check_output(expected, out, 0, signal_len);
+
+    del_Part_conv(pc);
+}
+END_TEST
+
+
+START_TEST(Replacing_impulse_response_clears_history)
+{
+    Part_conv* pc = new_Part_conv();
+    fail_if(pc == NULL, "Could not allocate Part_conv");
+
+    const int32_t first_tap_count = max_tap_count;
+    make_ir(ir, first_tap_count, 1);
+    float* ir_data[] = { ir[0], ir[1] };
+    fail_if(!Part_conv_set_ir(pc, ir_data, first_tap_count),
+            "Could not set impulse response");
+
+    const int32_t half = signal_len / 2;
+    process_in_chunks(pc, in, out, 0, half);
+
+    const int32_t second_tap_count = 300;
+    make_ir(ir, second_tap_count, 2);
+    fail_if(!Part_conv_set_ir(pc, ir_data, second_tap_count),
+            "Could not set impulse response");
+
+    process_in_chunks(pc, in, out, half, signal_len);
+
+    convolve_direct(ir, second_tap_count, in, half, signal_len, expected);
+    check_output(expected, out, half, signal_len);
+
+    del_Part_conv(pc);
+}
+END_TEST
+
+
+START_TEST(Empty_impulse_response_adds_nothing)
+{
+    Part_conv* pc = new_Part_conv();
+    fail_if(pc == NULL, "Could not allocate Part_conv");
+
+    make_ir(ir, max_tap_count, 1);
+    float* ir_data[] = { ir[0], ir[1] };
+    fail_if(!Part_conv_set_ir(pc, ir_data, max_tap_count),
+            "Could not set impulse response");
+    fail_if(!Part_conv_set_ir(pc, ir_data, 0),
+            "Could not set empty impulse response");
+
+    process_in_chunks(pc, in, out, 0, signal_len);
+
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        for (int32_t i = 0; i < signal_len; ++i)
+            expected[ch][i] = 0;
+    }
+    check_output(expected, out, 0, signal_len);
+
+    del_Part_conv(pc);
+}
+END_TEST
+
+
+Suite* Part_conv_suite(void)
+{
+    Suite* s = suite_create("Part_conv");
+
+    const int timeout = DEFAULT_TIMEOUT;
+
+    TCase* tc_convolve = tcase_create("convolve");
+    suite_add_tcase(s, tc_convolve);
+    tcase_set_timeout(tc_convolve, timeout);
+    tcase_add_checked_fixture(tc_convolve, setup_signal, NULL);
+
+    tcase_add_loop_test(
+            tc_convolve, Partitioned_convolution_matches_direct_form,
+            0, tap_count_count);
+    tcase_add_test(tc_convolve, Replacing_impulse_response_clears_history);
+    tcase_add_test(tc_convolve, Empty_impulse_response_adds_nothing);
+
+    return s;
+}
+
+
+int main(void)
+{
+    Suite* suite = Part_conv_suite();
+    SRunner* sr = srunner_create(suite);
+#ifdef K_MEM_DEBUG
+    srunner_set_fork_status(sr, CK_NOFORK);
+#endif
+    srunner_run_all(sr, CK_NORMAL);
+    int fail_count = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    exit(fail_count > 0);
+}
+
+
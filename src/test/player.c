@@ -19,6 +19,7 @@
 #include <test_common.h>
 
 #include <Handle_private.h>
+#include <kunquat/events.h>
 #include <kunquat/Handle.h>
 #include <player/Player.h>
 #include <string/Streader.h>
@@ -178,6 +179,50 @@ START_TEST(Independent_notes_mix_correctly)
 END_TEST
 
 
+START_TEST(Notes_mix_correctly_with_multiple_threads)
+{
+    const int thread_count = _i;
+
+    set_audio_rate(220);
+    set_mix_volume(0);
+    setup_debug_instrument();
+    pause();
+
+    kqt_Handle_set_thread_count(handle, thread_count);
+    check_unexpected_error();
+    fail_unless(kqt_Handle_get_thread_count(handle) == thread_count,
+            "Handle reported thread count %d instead of %d",
+            kqt_Handle_get_thread_count(handle), thread_count);
+
+    float actual_buf[buf_len] = { 0.0f };
+    const int note_count = 8;
+    const int note_interval = 2;
+
+    for (int i = 0; i < note_count; ++i)
+    {
+        kqt_Handle_fire_event(handle, i, Note_On_55_Hz);
+        check_unexpected_error();
+        mix_and_fill(actual_buf + i * note_interval, note_interval);
+    }
+    const int rendered = note_count * note_interval;
+    mix_and_fill(actual_buf + rendered, buf_len - rendered);
+
+    float single_buf[buf_len] = { 0.0f };
+    float single_seq[] = { 1.0f, 0.5f, 0.5f, 0.5f };
+    repeat_seq_local(single_buf, 10, single_seq);
+
+    float expected_buf[buf_len] = { 0.0f };
+    for (int i = 0; i < note_count; ++i)
+    {
+        for (int k = 0; k + i * note_interval < buf_len; ++k)
+            expected_buf[k + i * note_interval] += single_buf[k];
+    }
+
+    check_buffers_equal(expected_buf, actual_buf, buf_len, 0.0f);
+}
+END_TEST
+
+
 START_TEST(Debug_single_shot_renders_one_pulse)
 {
     set_mix_volume(0);
@@ -521,6 +566,207 @@ START_TEST(Skipping_moves_position_forwards)
 END_TEST
 
 
+START_TEST(Duration_is_calculated_for_each_track)
+{
+    set_data("album/p_manifest.json", "{}");
+    set_data("album/p_tracks.json", "[0, 1]");
+    set_data("song_00/p_manifest.json", "{}");
+    set_data("song_00/p_order_list.json", "[ [0, 0] ]");
+    set_data("song_01/p_manifest.json", "{}");
+    set_data("song_01/p_order_list.json", "[ [1, 0] ]");
+    set_data("pat_000/p_manifest.json", "{}");
+    set_data("pat_000/p_pattern.json", "{ \"length\": [4, 0] }");
+    set_data("pat_000/instance_000/p_manifest.json", "{}");
+    set_data("pat_001/p_manifest.json", "{}");
+    set_data("pat_001/p_pattern.json", "{ \"length\": [8, 0] }");
+    set_data("pat_001/instance_000/p_manifest.json", "{}");
+
+    validate();
+
+    const long long expected[] = { 2000000000LL, 4000000000LL };
+    for (int i = 0; i < 2; ++i)
+    {
+        const long long dur = kqt_Handle_get_duration(handle, i);
+        check_unexpected_error();
+        fail_unless(dur == expected[i],
+                "Wrong duration of track %d"
+                KT_VALUES("%lld", expected[i], dur),
+                i);
+    }
+
+    long long total = kqt_Handle_get_duration(handle, -1);
+    check_unexpected_error();
+    fail_unless(total == expected[0] + expected[1],
+            "Wrong total duration"
+            KT_VALUES("%lld", expected[0] + expected[1], total));
+
+    // Changing a pattern must invalidate the cached duration
+    set_data("pat_000/p_pattern.json", "{ \"length\": [6, 0] }");
+    validate();
+
+    const long long dur = kqt_Handle_get_duration(handle, 0);
+    check_unexpected_error();
+    fail_unless(dur == 3000000000LL,
+            "Wrong duration after pattern change"
+            KT_VALUES("%lld", 3000000000LL, dur));
+
+    total = kqt_Handle_get_duration(handle, -1);
+    check_unexpected_error();
+    fail_unless(total == 7000000000LL,
+            "Wrong total duration after pattern change"
+            KT_VALUES("%lld", 7000000000LL, total));
+}
+END_TEST
+
+
+START_TEST(Seeking_with_seek_cache_restores_playback_state)
+{
+    const bool use_cache = (_i != 0);
+
+    set_audio_rate(mixing_rates[MIXING_RATE_LOW]);
+    set_mix_volume(0);
+    setup_debug_instrument();
+    setup_debug_single_pulse();
+
+    set_data("album/p_manifest.json", "{}");
+    set_data("album/p_tracks.json", "[0]");
+    set_data("song_00/p_manifest.json", "{}");
+    set_data("song_00/p_order_list.json", "[ [0, 0] ]");
+    set_data("pat_000/p_manifest.json", "{}");
+    set_data("pat_000/p_pattern.json", "{ \"length\": [64, 0] }");
+    set_data("pat_000/instance_000/p_manifest.json", "{}");
+    set_data("pat_000/col_00/p_triggers.json",
+            "[ [[0, 0], [\"m.t\", \"240\"]],"
+            "  [[44, 0], [\"n+\", \"0\"]],"
+            "  [[46, 0], [\"n+\", \"0\"]],"
+            "  [[48, 0], [\"n+\", \"0\"]] ]");
+
+    validate();
+
+    kqt_Handle_set_seek_cache_enabled(handle, use_cache);
+    check_unexpected_error();
+    fail_unless(kqt_Handle_get_seek_cache_enabled(handle) == use_cache,
+            "Handle reported wrong seek cache status");
+
+    // Go past the first snapshot position and then back before it
+    kqt_Handle_set_position(handle, 0, 12000000000LL);
+    check_unexpected_error();
+    kqt_Handle_set_position(handle, 0, 11000000000LL);
+    check_unexpected_error();
+
+    fail_unless(kqt_Handle_get_position(handle) == 11000000000LL,
+            "Wrong position after seeking"
+            KT_VALUES("%lld", 11000000000LL, kqt_Handle_get_position(handle)));
+
+    float actual_buf[buf_len] = { 0.0f };
+    mix_and_fill(actual_buf, buf_len);
+
+    float expected_buf[buf_len] = { 0.0f };
+    for (int i = 0; i < 3; ++i)
+        expected_buf[i * mixing_rates[MIXING_RATE_LOW] / 2] = 1.0f;
+
+    check_buffers_equal(expected_buf, actual_buf, buf_len, 0.0f);
+}
+END_TEST
+
+
+START_TEST(Cached_seek_renders_like_uncached_seek)
+{
+    set_audio_rate(mixing_rates[MIXING_RATE_LOW]);
+    set_mix_volume(0);
+    setup_debug_instrument();
+
+    set_data("album/p_manifest.json", "{}");
+    set_data("album/p_tracks.json", "[0]");
+    set_data("song_00/p_manifest.json", "{}");
+    set_data("song_00/p_order_list.json", "[ [0, 0] ]");
+    set_data("pat_000/p_manifest.json", "{}");
+    set_data("pat_000/p_pattern.json", "{ \"length\": [64, 0] }");
+    set_data("pat_000/instance_000/p_manifest.json", "{}");
+
+    // Skipping draws from the random source of the Channel on both sides of
+    // the first snapshot, and the note force depends on the result
+    set_data("pat_000/col_00/p_triggers.json",
+            "[ [[0, 0], [\"m.t\", \"240\"]],"
+            "  [[2, 0], [\"callF\", \"rand(1)\"]],"
+            "  [[20, 0], [\"callF\", \"rand(1)\"]],"
+            "  [[42, 0], [\"callF\", \"rand(1)\"]],"
+            "  [[44, 0], [\"n+\", \"0\"]],"
+            "  [[44, 0], [\".f\", \"rand(-12)\"]] ]");
+
+    validate();
+
+    // Store a snapshot and restore it
+    kqt_Handle_set_seek_cache_enabled(handle, 1);
+    check_unexpected_error();
+    kqt_Handle_set_position(handle, 0, 12000000000LL);
+    check_unexpected_error();
+    kqt_Handle_set_position(handle, 0, 11000000000LL);
+    check_unexpected_error();
+
+    float actual_buf[buf_len] = { 0.0f };
+    mix_and_fill(actual_buf, buf_len);
+
+    kqt_Handle_set_seek_cache_enabled(handle, 0);
+    check_unexpected_error();
+    kqt_Handle_set_position(handle, 0, 11000000000LL);
+    check_unexpected_error();
+
+    float expected_buf[buf_len] = { 0.0f };
+    mix_and_fill(expected_buf, buf_len);
+
+    check_buffers_equal(expected_buf, actual_buf, buf_len, 0.0f);
+}
+END_TEST
+
+
+START_TEST(Seeking_keeps_slide_timing_at_current_audio_rate)
+{
+    set_mix_volume(0);
+
+    set_data("p_connections.json", "[ [\"ins_00/out_00\", \"out_00\"] ]");
+    set_data("p_control_map.json", "[ [0, 0] ]");
+    set_data("control_00/p_manifest.json", "{}");
+    set_data("ins_00/p_manifest.json", "{}");
+    set_data("ins_00/p_connections.json",
+            "[ [\"gen_00/C/out_00\", \"out_00\"] ]");
+    set_data("ins_00/gen_00/p_manifest.json", "{}");
+    set_data("ins_00/gen_00/p_gen_type.json", "\"pulse\"");
+
+    set_data("album/p_manifest.json", "{}");
+    set_data("album/p_tracks.json", "[0]");
+    set_data("song_00/p_manifest.json", "{}");
+    set_data("song_00/p_order_list.json", "[ [0, 0] ]");
+    set_data("pat_000/p_manifest.json", "{}");
+    set_data("pat_000/p_pattern.json", "{ \"length\": [16, 0] }");
+    set_data("pat_000/instance_000/p_manifest.json", "{}");
+    set_data("pat_000/col_00/p_triggers.json",
+            "[ [[0, 0], [\".P\", \"-1\"]],"
+            "  [[0, 0], [\"n+\", \"0\"]],"
+            "  [[0, 0], [\"/=P\", \"1\"]],"
+            "  [[0, 0], [\"/P\", \"1\"]],"
+            "  [[0, 0], [\"vs\", \"20\"]],"
+            "  [[0, 0], [\"vd\", \"200\"]] ]");
+
+    validate();
+
+    // Slides and LFOs must follow the audio rate after the Channels are reset
+    set_audio_rate(mixing_rates[MIXING_RATE_CD]);
+
+    float expected_buf[buf_len] = { 0.0f };
+    mix_and_fill(expected_buf, buf_len);
+
+    kqt_Handle_set_position(handle, 0, 0);
+    check_unexpected_error();
+
+    float actual_buf[buf_len] = { 0.0f };
+    mix_and_fill(actual_buf, buf_len);
+
+    check_buffers_equal(expected_buf, actual_buf, buf_len, 0.0f);
+}
+END_TEST
+
+
 START_TEST(Pattern_delay_extends_gap_between_trigger_rows)
 {
     set_audio_rate(mixing_rates[MIXING_RATE_LOW]);
@@ -783,6 +1029,85 @@ START_TEST(Events_appear_in_event_buffer)
 END_TEST
 
 
+START_TEST(Events_appear_as_event_records)
+{
+    setup_debug_instrument();
+    setup_debug_single_pulse();
+
+    kqt_Handle_fire_event(handle, 0, "[\"Ipause\", null]");
+    check_unexpected_error();
+    kqt_Handle_fire_event(handle, 2, "[\".arpi\", 3]");
+    check_unexpected_error();
+
+    long count = -1;
+    const kqt_Event_record* records =
+        kqt_Handle_receive_event_records(handle, &count);
+    check_unexpected_error();
+    fail_if(records == NULL, "No event records returned");
+    fail_if(count != 1,
+            "Received %ld instead of 1 event records", count);
+
+    const char** names = kqt_get_event_names();
+    fail_if(records[0].channel != 2,
+            "Wrong channel received"
+            KT_VALUES("%d", 2, records[0].channel));
+    fail_if(strcmp(names[records[0].event], ".arpi") != 0,
+            "Wrong event received"
+            KT_VALUES("%s", ".arpi", names[records[0].event]));
+    fail_if(records[0].arg_type != KQT_EVENT_ARG_INT,
+            "Wrong argument type received"
+            KT_VALUES("%d", KQT_EVENT_ARG_INT, records[0].arg_type));
+    fail_if(records[0].arg.int_value != 3,
+            "Wrong argument received"
+            KT_VALUES("%lld", 3LL, records[0].arg.int_value));
+
+    // Returned events are not returned again in JSON format
+    const char* events = kqt_Handle_receive_events(handle);
+    fail_if(strcmp(events, "[]") != 0,
+            "Received event list %s instead of []", events);
+}
+END_TEST
+
+
+START_TEST(Trigger_arguments_are_evaluated_from_expressions)
+{
+    set_audio_rate(220);
+    set_data("album/p_manifest.json", "{}");
+    set_data("album/p_tracks.json", "[0]");
+    set_data("song_00/p_manifest.json", "{}");
+    set_data("song_00/p_order_list.json", "[ [0, 0] ]");
+    set_data("pat_000/p_manifest.json", "{}");
+    set_data("pat_000/p_pattern.json", "{ \"length\": [4, 0] }");
+    set_data("pat_000/instance_000/p_manifest.json", "{}");
+    set_data("pat_000/col_00/p_triggers.json",
+            "[ [[0, 0], [\".arpi\", \"2 * (1 + 2)\"]],"
+            "  [[0, 0], [\".arpi\", \"rand(0) + 4\"]],"
+            "  [[1, 0], [\".arpi\", \"-3 * 2 + 7\"]] ]");
+
+    validate();
+
+    kqt_Handle_play(handle, 10);
+    check_unexpected_error();
+
+    const char* events = kqt_Handle_receive_events(handle);
+    const char* expected =
+        "[[0, [\".arpi\", 6]], [0, [\".arpi\", 4]]]";
+
+    fail_if(strcmp(events, expected) != 0,
+            "Received event list %s instead of %s", events, expected);
+
+    kqt_Handle_play(handle, 2048);
+    check_unexpected_error();
+
+    events = kqt_Handle_receive_events(handle);
+    expected = "[[0, [\".arpi\", 1]]]";
+
+    fail_if(strcmp(events, expected) != 0,
+            "Received event list %s instead of %s", events, expected);
+}
+END_TEST
+
+
 void setup_many_triggers(int event_count)
 {
     // Set up pattern essentials
@@ -1210,6 +1535,47 @@ START_TEST(Query_voice_count_with_note)
 END_TEST
 
 
+START_TEST(Voices_are_reused_when_all_are_in_use)
+{
+    set_audio_rate(220);
+    setup_debug_instrument();
+    pause();
+
+    // Each note moves the previous note of the channel to the background
+    const int note_count = 300;
+    for (int i = 0; i < note_count; ++i)
+    {
+        kqt_Handle_fire_event(handle, 0, Note_On_55_Hz);
+        check_unexpected_error();
+    }
+
+    kqt_Handle_play(handle, 1);
+    kqt_Handle_fire_event(handle, 0, "[\"qvoices\", null]");
+
+    const char* events1 = kqt_Handle_receive_events(handle);
+    const char* expected1 =
+        "[[0, [\"qvoices\", null]], [0, [\"Avoices\", 256]]]";
+
+    fail_if(strcmp(events1, expected1) != 0,
+            "Received event list %s instead of %s", events1, expected1);
+
+    // The reported count is the maximum since the previous query
+    kqt_Handle_play(handle, 2048);
+    kqt_Handle_fire_event(handle, 0, "[\"qvoices\", null]");
+    kqt_Handle_receive_events(handle);
+
+    kqt_Handle_play(handle, 2048);
+    kqt_Handle_fire_event(handle, 0, "[\"qvoices\", null]");
+
+    const char* events2 = kqt_Handle_receive_events(handle);
+    const char* expected2 = "[[0, [\"qvoices\", null]], [0, [\"Avoices\", 0]]]";
+
+    fail_if(strcmp(events2, expected2) != 0,
+            "Received event list %s instead of %s", events2, expected2);
+}
+END_TEST
+
+
 static bool test_reported_force(Streader* sr, double expected)
 {
     assert(sr != NULL);
@@ -1281,6 +1647,8 @@ Suite* Player_suite(void)
     tcase_add_test(tc_notes, Note_end_is_reached_correctly_during_note_off);
     tcase_add_test(tc_notes, Implicit_note_off_is_triggered_correctly);
     tcase_add_test(tc_notes, Independent_notes_mix_correctly);
+    tcase_add_loop_test(
+            tc_notes, Notes_mix_correctly_with_multiple_threads, 1, 5);
     tcase_add_test(tc_notes, Debug_single_shot_renders_one_pulse);
 
     // Patterns
@@ -1297,6 +1665,12 @@ Suite* Player_suite(void)
     tcase_add_loop_test(tc_songs, Initial_tempo_is_set_correctly, 0, 4);
     tcase_add_test(tc_songs, Infinite_mode_loops_composition);
     tcase_add_loop_test(tc_songs, Skipping_moves_position_forwards, 0, 4);
+    tcase_add_test(tc_songs, Duration_is_calculated_for_each_track);
+    tcase_add_loop_test(
+            tc_songs, Seeking_with_seek_cache_restores_playback_state, 0, 2);
+    tcase_add_test(tc_songs, Cached_seek_renders_like_uncached_seek);
+    tcase_add_test(
+            tc_songs, Seeking_keeps_slide_timing_at_current_audio_rate);
 
     // Events
     tcase_add_loop_test(
@@ -1315,6 +1689,8 @@ Suite* Player_suite(void)
             tc_events, Jump_backwards_creates_a_loop,
             0, 4);
     tcase_add_test(tc_events, Events_appear_in_event_buffer);
+    tcase_add_test(tc_events, Events_appear_as_event_records);
+    tcase_add_test(tc_events, Trigger_arguments_are_evaluated_from_expressions);
     tcase_add_test(
             tc_events,
             Events_from_many_triggers_can_be_retrieved_with_multiple_receives);
@@ -1331,6 +1707,7 @@ Suite* Player_suite(void)
     tcase_add_test(tc_events, Query_final_location);
     tcase_add_test(tc_events, Query_voice_count_with_silence);
     tcase_add_test(tc_events, Query_voice_count_with_note);
+    tcase_add_test(tc_events, Voices_are_reused_when_all_are_in_use);
     tcase_add_test(tc_events, Query_note_force);
 
     return s;
@@ -0,0 +1,220 @@
+
+
+/*
+ * Author: Tomi Jylhä-Ollila, Finland 2014
+ *
+ * This file is part of Kunquat.
+ *
+ * CC0 1.0 Universal, http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * To the extent possible under law, Kunquat Affirmers have waived all
+ * copyright and related or neighboring rights to Kunquat.
+ */
+
+
+#include <assert.h>
+#include <stdint.h>
+
+#include <test_common.h>
+
+#include <devices/param_types/Sample.h>
+#include <devices/param_types/Sample_cache.h>
+#include <memory.h>
+#include <string/Streader.h>
+
+
+#define sample_len 100
+
+#define sample_size (sample_len * (int)sizeof(int16_t))
+
+
+static int decode_count = 0;
+
+
+static bool decode_test_sample(Sample* sample, Streader* sr)
+{
+    assert(sample != NULL);
+    assert(sr != NULL);
+
+    int16_t* data = memory_alloc_items(int16_t, sample_len);
+    if (data == NULL)
+        return false;
+
+    for (int i = 0; i < sample_len; ++i)
+        data[i] = (int16_t)sr->str[0];
+
+    sample->channels = 1;
+    sample->bits = 16;
+    sample->is_float = false;
+    sample->len = sample_len;
+    sample->data[0] = data;
+
+    ++decode_count;
+
+    return true;
+}
+
+
+static Sample_cache* cache = NULL;
+
+
+static void setup_cache(void)
+{
+    decode_count = 0;
+    cache = new_Sample_cache(sample_size);
+    fail_if(cache == NULL, "Could not allocate Sample cache");
+    return;
+}
+
+
+static void teardown_cache(void)
+{
+    del_Sample_cache(cache);
+    cache = NULL;
+    return;
+}
+
+
+static Sample_source* make_source(char id)
+{
+    const char data[] = { id, '\0' };
+    Sample_source* source = new_Sample_source(
+            cache, data, sizeof(data), decode_test_sample);
+    fail_if(source == NULL, "Could not allocate Sample source");
+    return source;
+}
+
+
+static void check_sample(const Sample* sample, char id)
+{
+    fail_if(sample == NULL, "Could not acquire Sample");
+    fail_unless(sample->len == sample_len,
+            "Wrong Sample length"
+            KT_VALUES("%d", sample_len, (int)sample->len));
+
+    const int16_t* data = sample->data[0];
+    fail_unless(data[0] == id && data[sample_len - 1] == id,
+            "Wrong Sample data" KT_VALUES("%d", id, (int)data[0]));
+
+    return;
+}
+
+
+START_TEST(Acquired_sample_is_not_evicted)
+{
+    Sample_source* first = make_source(1);
+    Sample_source* second = make_source(2);
+
+    const Sample* first_sample = Sample_source_acquire(first);
+    check_sample(first_sample, 1);
+
+    // The limit only has room for one Sample
+    const Sample* second_sample = Sample_source_acquire(second);
+    check_sample(second_sample, 2);
+    check_sample(first_sample, 1);
+    fail_unless(Sample_cache_get_size(cache) == 2 * sample_size,
+            "Acquired Samples were evicted"
+            KT_VALUES("%d", 2 * sample_size,
+                (int)Sample_cache_get_size(cache)));
+
+    Sample_cache_set_limit(cache, 0);
+    check_sample(first_sample, 1);
+    check_sample(second_sample, 2);
+
+    Sample_source_release(first);
+    fail_unless(Sample_cache_get_size(cache) == sample_size,
+            "Released Sample was not evicted"
+            KT_VALUES("%d", sample_size, (int)Sample_cache_get_size(cache)));
+
+    Sample_source_release(second);
+    fail_unless(Sample_cache_get_size(cache) == 0,
+            "Released Sample was not evicted"
+            KT_VALUES("%d", 0, (int)Sample_cache_get_size(cache)));
+
+    del_Sample_source(first);
+    del_Sample_source(second);
+}
+END_TEST
+
+
+START_TEST(Released_sample_is_kept_until_limit_is_exceeded)
+{
+    Sample_source* first = make_source(1);
+    Sample_source* second = make_source(2);
+
+    check_sample(Sample_source_acquire(first), 1);
+    Sample_source_release(first);
+    check_sample(Sample_source_acquire(first), 1);
+    Sample_source_release(first);
+    fail_unless(decode_count == 1,
+            "Cached Sample was decoded again"
+            KT_VALUES("%d", 1, decode_count));
+
+    check_sample(Sample_source_acquire(second), 2);
+    Sample_source_release(second);
+    check_sample(Sample_source_acquire(first), 1);
+    Sample_source_release(first);
+    fail_unless(decode_count == 3,
+            "Evicted Sample was not decoded again"
+            KT_VALUES("%d", 3, decode_count));
+
+    del_Sample_source(first);
+    del_Sample_source(second);
+}
+END_TEST
+
+
+START_TEST(Destroying_acquired_source_is_deferred)
+{
+    Sample_source* source = make_source(3);
+
+    const Sample* sample = Sample_source_acquire(source);
+    check_sample(sample, 3);
+
+    del_Sample_source(source);
+    check_sample(sample, 3);
+    fail_unless(Sample_cache_get_size(cache) == sample_size,
+            "Acquired Sample was discarded"
+            KT_VALUES("%d", sample_size, (int)Sample_cache_get_size(cache)));
+
+    Sample_source_release(source);
+    fail_unless(Sample_cache_get_size(cache) == 0,
+            "Destroyed Sample was not discarded"
+            KT_VALUES("%d", 0, (int)Sample_cache_get_size(cache)));
+}
+END_TEST
+
+
+Suite* Sample_cache_suite(void)
+{
+    Suite* s = suite_create("Sample_cache");
+
+    const int timeout = DEFAULT_TIMEOUT;
+
+    TCase* tc_pins = tcase_create("pins");
+    suite_add_tcase(s, tc_pins);
+    tcase_set_timeout(tc_pins, timeout);
+    tcase_add_checked_fixture(tc_pins, setup_cache, teardown_cache);
+
+    tcase_add_test(tc_pins, Acquired_sample_is_not_evicted);
+    tcase_add_test(tc_pins, Released_sample_is_kept_until_limit_is_exceeded);
+    tcase_add_test(tc_pins, Destroying_acquired_source_is_deferred);
+
+    return s;
+}
+
+
+int main(void)
+{
+    Suite* suite = Sample_cache_suite();
+    SRunner* sr = srunner_create(suite);
+#ifdef K_MEM_DEBUG
+    srunner_set_fork_status(sr, CK_NOFORK);
+#endif
+    srunner_run_all(sr, CK_NORMAL);
+    int fail_count = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    exit(fail_count > 0);
+}
+
+
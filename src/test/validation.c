@@ -367,6 +367,28 @@ START_TEST(Validation_rejects_shared_pattern_instances_between_songs)
 END_TEST
 
 
+START_TEST(Validation_rejects_pattern_instances_of_removed_songs)
+{
+    set_silent_composition();
+    validate();
+
+    set_data("album/p_tracks.json", "[0, 1]");
+    set_data("song_01/p_manifest.json", "{}");
+    set_data("song_01/p_order_list.json", "[ [0, 1] ]");
+    set_data("pat_000/instance_001/p_manifest.json", "{}");
+    validate();
+
+    set_data("album/p_tracks.json", "[1]");
+    set_data("song_00/p_manifest.json", "");
+
+    kqt_Handle_validate(handle);
+
+    check_validation_error("instance",
+            "Handle accepts pattern instances only used in removed songs");
+}
+END_TEST
+
+
 START_TEST(Validation_rejects_nonexistent_controls_used_in_control_map)
 {
     set_data("p_control_map.json", "[ [0, 0] ]");
@@ -415,6 +437,8 @@ Suite* Validation_suite(void)
             Validation_rejects_reused_pattern_instances_in_song);
     tcase_add_test(tc_reject,
             Validation_rejects_shared_pattern_instances_between_songs);
+    tcase_add_test(tc_reject,
+            Validation_rejects_pattern_instances_of_removed_songs);
     tcase_add_test(tc_reject,
             Validation_rejects_nonexistent_controls_used_in_control_map);
 